@@ -57,6 +57,9 @@ void setup()
         ATKINSON_KERNEL: Atkinson
         BURKES_KERNEL: Burke
     The fifth parameter, depending on the Kernel just has the suffix '_SIZE', eg. FS_KERNEL_SIZE
+    Instead of 1, dither can also be set to the ordered dither (kernel is not needed, use NULL, 0):
+        INKPLATE_DITHER_BAYER_4X4, INKPLATE_DITHER_BAYER_8X8 or INKPLATE_DITHER_BLUE_NOISE
+    Ordered dither is much faster and the pattern does not change between frames (good for animations)
     */
 
     if (!inkplate.image.draw("image1.png", 0, 0, false, 1, FS_KERNEL, FS_KERNEL_SIZE))
@@ -0,0 +1,125 @@
+/**
+ **************************************************
+ *
+ * @file        Inkplate_6_Motion_Async_HTTP.ino
+ * @brief       Connect to your home Wi-Fi and get the weather forecast without blocking. WiFi
+ *              operations are started and then handled with WiFi.poll() in the loop(), so the
+ *              screen can be updated (time and received bytes) while the data is received.
+ *              Received JSON is parsed in the callback with the streaming JSON parser.
+ *
+ * For info on how to quickly get started with Inkplate 6MOTION visit docs.inkplate.com
+ *
+ * @authors     Borna Biro for soldered.com
+ * @date        October 2026
+ ***************************************************/
+
+// Add an Inkplate Motion Libray to the Sketch
+#include <InkplateMotion.h>
+
+// Change WiFi SSID and password here
+#define WIFI_SSID ""
+#define WIFI_PASS ""
+
+// Create an Inkplate Motion Object
+Inkplate inkplate;
+
+// Weather forecast URL (change latitude and longitude for your location)
+const char url[] = {"https://api.open-meteo.com/v1/"
+                    "forecast?latitude=45.81&longitude=15.98&daily=temperature_2m_max,temperature_2m_min&timezone=auto"};
+
+// Non-blocking operations - connect to the AP and HTTP GET
+WiFiOperation connectOp;
+WiFiOperation getOp;
+
+// Streaming JSON parser
+JsonStreamParser json;
+
+// Max. temperature of today
+float tempMax = 0;
+
+// Time of the last screen update and the start of the transfer
+unsigned long lastUpdate = 0;
+unsigned long startTime = 0;
+bool finished = false;
+
+// Called from the WiFi.poll() for each part of the received data
+void onData(WiFiOperation *op, const uint8_t *data, uint16_t len)
+{
+    json.feed((const char *)data, len);
+}
+
+// Called for the max. temperature of today (first element of the array)
+void onTempMax(const char *path, const char *value, uint8_t type)
+{
+    if (json.index() == 0)
+        tempMax = atof(value);
+}
+
+void setup()
+{
+    // Initialize the Inkplate Motion Library
+    inkplate.begin(INKPLATE_1BW);
+
+    // Clear the screen
+    inkplate.display();
+
+    // Set the text options
+    inkplate.setTextSize(3);
+    inkplate.setTextColor(BLACK, WHITE);
+
+    // Let's initialize the Wi-Fi library:
+    WiFi.init();
+
+    // Set mode to Station
+    WiFi.setMode(INKPLATE_WIFI_MODE_STA);
+
+    // Select the value from the JSON
+    json.addFilter("daily.temperature_2m_max[*]", onTempMax);
+
+    // Queue the operations. They are executed one by one in the WiFi.poll(), so the GET starts after the
+    // connection to the AP is done (if the connection fails, the GET will fail too)
+    connectOp.connect(WIFI_SSID, WIFI_PASS);
+    getOp.get(url, onData);
+
+    startTime = millis();
+}
+
+void loop()
+{
+    // Handle the WiFi operations, it returns immediately
+    WiFi.poll();
+
+    // Update the screen twice every second while operations are in progress
+    if (!finished && ((unsigned long)(millis() - lastUpdate) > 500))
+    {
+        lastUpdate = millis();
+
+        inkplate.fillRect(0, 0, inkplate.width(), 100, WHITE);
+        inkplate.setCursor(0, 0);
+        inkplate.printf("Time: %.1fs\n", (millis() - startTime) / 1000.0);
+        if (connectOp.busy())
+            inkplate.println("Wi-Fi: connecting...");
+        else
+            inkplate.println(connectOp.done() ? "Wi-Fi: connected" : "Wi-Fi: failed");
+        inkplate.printf("Received: %lu bytes\n", getOp.bytesReceived());
+        inkplate.partialUpdate(true);
+    }
+
+    // Show the result when everything is done
+    if (!finished && !WiFi.busy())
+    {
+        finished = true;
+
+        inkplate.setCursor(0, 120);
+        // All data is received, let the parser know the document has ended
+        if (getOp.done() && json.finish())
+        {
+            inkplate.printf("Max. temperature today: %.1fC", tempMax);
+        }
+        else
+        {
+            inkplate.printf("Failed to get the forecast, error: %d", getOp.error());
+        }
+        inkplate.display();
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ **************************************************
+ *
+ * @file        Inkplate_6_Motion_Download_To_SD.ino
+ * @brief       Connect to your home Wi-Fi and download a large file directly to the microSD card.
+ *              If the download is interrupted, run the sketch again and it will continue where it stopped
+ *
+ * For info on how to quickly get started with Inkplate 6MOTION visit docs.inkplate.com
+ *
+ * @authors     Borna Biro for soldered.com
+ * @date        October 2026
+ ***************************************************/
+
+// Add an Inkplate Motion Libray to the Sketch
+#include <InkplateMotion.h>
+
+// Change WiFi SSID and password here
+#define WIFI_SSID ""
+#define WIFI_PASS ""
+
+// Create an Inkplate Motion Object
+Inkplate inkplate;
+
+// File that will be downloaded and its path on the microSD card
+const char url[] = {"https://raw.githubusercontent.com/SolderedElectronics/Inkplate-Arduino-library/master/README.md"};
+const char path[] = {"download.bin"};
+
+// Object for the HTTP requests
+WiFiClient client;
+
+// Called after each received data chunk
+void downloadProgress(uint32_t downloaded, uint32_t total)
+{
+    // Print the progress to the serial (screen refresh would slow down the download)
+    Serial.printf("Downloaded %lu of %lu bytes\r\n", (unsigned long)downloaded, (unsigned long)total);
+}
+
+void setup()
+{
+    // Initialize serial communication for the download progress
+    Serial.begin(115200);
+
+    // Initialize the Inkplate Motion Library
+    inkplate.begin(INKPLATE_1BW);
+
+    // Clear the screen
+    inkplate.display();
+
+    // Set the text options
+    inkplate.setCursor(0, 0);
+    inkplate.setTextSize(2);
+    inkplate.setTextColor(BLACK, WHITE);
+    inkplate.setTextWrap(true);
+
+    // Initialize microSD card
+    if (!inkplate.microSDCardInit())
+    {
+        inkplate.println("Couldn't init SD card!");
+        inkplate.partialUpdate();
+        while (1)
+            ;
+    }
+
+    // Let's initialize the Wi-Fi library:
+    WiFi.init();
+
+    // Set mode to Station
+    WiFi.setMode(INKPLATE_WIFI_MODE_STA);
+
+    // Connect to WiFi:
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    // Wait until we're connected, this is strongly reccomended to do!
+    inkplate.print("Connecting to Wi-Fi...");
+    while (!WiFi.connected())
+    {
+        inkplate.print('.');
+        inkplate.partialUpdate(true);
+        delay(1000);
+    }
+    inkplate.println("\nSuccessfully connected to Wi-Fi!");
+    inkplate.partialUpdate(true);
+
+    // Download the file (or the rest of it, if it was already partially downloaded)
+    unsigned long startTime = millis();
+    uint32_t fileSize = client.downloadToFile(url, &inkplate.sdFat, path, true, downloadProgress);
+    if (fileSize != 0)
+    {
+        inkplate.printf("Downloaded %lu bytes in %lu ms\n", (unsigned long)fileSize, millis() - startTime);
+    }
+    else
+    {
+        inkplate.println("Download failed! Reset the board to continue the download.");
+    }
+
+    inkplate.display();
+}
+
+void loop()
+{
+    // Empty...
+}
@@ -0,0 +1,102 @@
+/**
+ **************************************************
+ *
+ * @file        Inkplate_6_Motion_HTTP_Keep_Alive.ino
+ * @brief       Connect to your home Wi-Fi and get multiple resources from the same web server
+ *              over one kept-alive connection (TCP and TLS handshake is done only once)
+ *
+ *
+ * For info on how to quickly get started with Inkplate 6MOTION visit docs.inkplate.com
+ *
+ * @authors     Borna Biro for soldered.com
+ * @date        October 2026
+ ***************************************************/
+
+// Add an Inkplate Motion Libray to the Sketch
+#include <InkplateMotion.h>
+
+// Change WiFi SSID and password here
+#define WIFI_SSID ""
+#define WIFI_PASS ""
+
+// Create an Inkplate Motion Object
+Inkplate inkplate;
+
+// Web server and resources that will be downloaded
+const char host[] = {"example.com"};
+const char *paths[] = {"/", "/index.html", "/", "/index.html", "/", "/index.html"};
+
+// Object for the HTTP requests with keep-alive
+WiFiHTTPSession session;
+
+// Buffer for the response body
+uint8_t buffer[1024];
+
+void setup()
+{
+    // Initialize the Inkplate Motion Library
+    inkplate.begin(INKPLATE_1BW);
+
+    // Clear the screen
+    inkplate.display();
+
+    // Set the text options
+    inkplate.setCursor(0, 0);
+    inkplate.setTextSize(2);
+    inkplate.setTextColor(BLACK, WHITE);
+    inkplate.setTextWrap(true);
+
+    // Let's initialize the Wi-Fi library:
+    WiFi.init();
+
+    // Set mode to Station
+    WiFi.setMode(INKPLATE_WIFI_MODE_STA);
+
+    // Connect to WiFi:
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    // Wait until we're connected, this is strongly reccomended to do!
+    inkplate.print("Connecting to Wi-Fi...");
+    while (!WiFi.connected())
+    {
+        inkplate.print('.');
+        inkplate.partialUpdate(true);
+        delay(1000);
+    }
+    inkplate.println("\nSuccessfully connected to Wi-Fi!");
+    inkplate.partialUpdate(true);
+
+    // Use HTTPS (port 443). Connection is opened with the first request
+    session.begin(host, 443, true);
+
+    // Get all resources, one after another
+    unsigned long startTime = millis();
+    for (int i = 0; i < (int)(sizeof(paths) / sizeof(paths[0])); i++)
+    {
+        int status = session.GET(paths[i]);
+
+        // Read the whole body (it must be read before the next request, otherwise it will be dropped)
+        uint32_t total = 0;
+        int len;
+        while ((len = session.read(buffer, sizeof(buffer))) > 0)
+        {
+            total += len;
+        }
+
+        inkplate.printf("GET %s -> %d, %lu bytes\n", paths[i], status, (unsigned long)total);
+        inkplate.partialUpdate(true);
+    }
+
+    // Print how many connections were needed for all requests
+    inkplate.printf("\n%d requests, %lu connection(s), %lu ms\n", (int)(sizeof(paths) / sizeof(paths[0])),
+                    (unsigned long)session.connectionCount(), (unsigned long)(millis() - startTime));
+
+    // Close the connection
+    session.end();
+
+    inkplate.display();
+}
+
+void loop()
+{
+    // Empty...
+}
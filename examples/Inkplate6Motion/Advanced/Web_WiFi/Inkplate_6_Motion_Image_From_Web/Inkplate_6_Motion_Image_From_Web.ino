@@ -69,6 +69,12 @@ void setup()
     The fifth parameter, depending on the Kernel just has the suffix '_SIZE', eg. FS_KERNEL_SIZE
     */
 
+    // If the same image is downloaded again and again (for example, after every wake up), it can be saved on the
+    // microSD card. Next time, the server is only asked if the image is changed; if not, it's loaded from the
+    // microSD card without downloading it. Uncomment these lines to use it:
+    // inkplate.microSDCardInit();
+    // inkplate.image.webCache.enable(&inkplate.sdFat);
+
     // Note that progressive-encoded jpg's aren't supported
     if (!inkplate.image.draw(imageUrl, 0, 0, false, 1, FS_KERNEL, FS_KERNEL_SIZE))
     {
@@ -0,0 +1,133 @@
+/**
+ **************************************************
+ *
+ * @file        Inkplate_6_Motion_JSON_Stream.ino
+ * @brief       Connect to your home Wi-Fi, get the weather forecast from Open-Meteo and show
+ *              min. and max. temperature for the next days. JSON is parsed while it's received,
+ *              only the needed values are picked out with the path filters (no large buffers needed)
+ *
+ * For info on how to quickly get started with Inkplate 6MOTION visit docs.inkplate.com
+ *
+ * @authors     Borna Biro for soldered.com
+ * @date        October 2026
+ ***************************************************/
+
+// Add an Inkplate Motion Libray to the Sketch
+#include <InkplateMotion.h>
+
+// Change WiFi SSID and password here
+#define WIFI_SSID ""
+#define WIFI_PASS ""
+
+// Max. number of the days in the forecast
+#define MAX_DAYS 7
+
+// Create an Inkplate Motion Object
+Inkplate inkplate;
+
+// Weather forecast URL (change latitude and longitude for your location)
+const char url[] = {"https://api.open-meteo.com/v1/"
+                    "forecast?latitude=45.81&longitude=15.98&daily=temperature_2m_max,temperature_2m_min&timezone=auto"};
+
+// Object for the HTTP requests
+WiFiClient client;
+
+// Streaming JSON parser
+JsonStreamParser json;
+
+// Forecast data
+char dates[MAX_DAYS][11];
+float tempMax[MAX_DAYS];
+float tempMin[MAX_DAYS];
+int days = 0;
+
+// Called for each date (daily.time[*])
+void onDate(const char *path, const char *value, uint8_t type)
+{
+    int i = json.index();
+    if (i < MAX_DAYS)
+    {
+        strncpy(dates[i], value, sizeof(dates[i]) - 1);
+        dates[i][sizeof(dates[i]) - 1] = '\0';
+        days = i + 1;
+    }
+}
+
+// Called for each max. temperature (daily.temperature_2m_max[*])
+void onTempMax(const char *path, const char *value, uint8_t type)
+{
+    int i = json.index();
+    if (i < MAX_DAYS)
+        tempMax[i] = atof(value);
+}
+
+// Called for each min. temperature (daily.temperature_2m_min[*])
+void onTempMin(const char *path, const char *value, uint8_t type)
+{
+    int i = json.index();
+    if (i < MAX_DAYS)
+        tempMin[i] = atof(value);
+}
+
+void setup()
+{
+    // Initialize the Inkplate Motion Library
+    inkplate.begin(INKPLATE_1BW);
+
+    // Clear the screen
+    inkplate.display();
+
+    // Set the text options
+    inkplate.setCursor(0, 0);
+    inkplate.setTextSize(3);
+    inkplate.setTextColor(BLACK, WHITE);
+    inkplate.setTextWrap(true);
+
+    // Let's initialize the Wi-Fi library:
+    WiFi.init();
+
+    // Set mode to Station
+    WiFi.setMode(INKPLATE_WIFI_MODE_STA);
+
+    // Connect to WiFi:
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    // Wait until we're connected, this is strongly reccomended to do!
+    inkplate.print("Connecting to Wi-Fi...");
+    while (!WiFi.connected())
+    {
+        inkplate.print('.');
+        inkplate.partialUpdate(true);
+        delay(1000);
+    }
+    inkplate.println("\nSuccessfully connected to Wi-Fi!");
+    inkplate.partialUpdate(true);
+
+    // Select the values from the JSON with path filters. "[*]" is any array element
+    json.addFilter("daily.time[*]", onDate);
+    json.addFilter("daily.temperature_2m_max[*]", onTempMax);
+    json.addFilter("daily.temperature_2m_min[*]", onTempMin);
+
+    // Send the request and parse the response while it's received
+    if (client.begin(url) && client.GET() && json.parse(&client))
+    {
+        inkplate.println();
+        for (int i = 0; i < days; i++)
+        {
+            inkplate.printf("%s  min %5.1fC  max %5.1fC\n", dates[i], tempMin[i], tempMax[i]);
+        }
+    }
+    else
+    {
+        inkplate.println("Failed to get the weather forecast!");
+    }
+
+    // End the HTTP transfer
+    client.end();
+
+    inkplate.display();
+}
+
+void loop()
+{
+    // Empty...
+}
@@ -0,0 +1,102 @@
+/**
+ **************************************************
+ *
+ * @file        Inkplate_6_Motion_Remote_Display.ino
+ * @brief       Connect to your home Wi-Fi and let the PC drive the screen. Changed parts of the
+ *              image (dirty rectangles) are received over UDP and shown with the partial update.
+ *              Use extras/tools/remoteDisplay/remote_display.py on the PC to send images:
+ *              python3 remote_display.py send <Inkplate IP address> --bpp 1
+ *
+ *
+ * For info on how to quickly get started with Inkplate 6MOTION visit docs.inkplate.com
+ *
+ * @authors     Borna Biro for soldered.com
+ * @date        October 2026
+ ***************************************************/
+
+// Add an Inkplate Motion Libray to the Sketch
+#include <InkplateMotion.h>
+
+// Change WiFi SSID and password here
+#define WIFI_SSID ""
+#define WIFI_PASS ""
+
+// UDP port for the remote display
+#define REMOTE_DISPLAY_PORT 5005
+
+// Create an Inkplate Motion Object
+Inkplate inkplate;
+
+// Variable for the statistics print
+unsigned long lastStats = 0;
+
+void setup()
+{
+    // Initialize serial communication for the statistics
+    Serial.begin(115200);
+
+    // Initialize the Inkplate Motion Library in 1 bit mode (use INKPLATE_GL16 and --bpp 4 for grayscale)
+    inkplate.begin(INKPLATE_1BW);
+
+    // Clear the screen
+    inkplate.display();
+
+    // Set the text options
+    inkplate.setCursor(0, 0);
+    inkplate.setTextSize(2);
+    inkplate.setTextColor(BLACK, WHITE);
+    inkplate.setTextWrap(true);
+
+    // Let's initialize the Wi-Fi library:
+    WiFi.init();
+
+    // Set mode to Station
+    WiFi.setMode(INKPLATE_WIFI_MODE_STA);
+
+    // Connect to WiFi:
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    // Wait until we're connected, this is strongly reccomended to do!
+    inkplate.print("Connecting to Wi-Fi...");
+    while (!WiFi.connected())
+    {
+        inkplate.print('.');
+        inkplate.partialUpdate(true);
+        delay(1000);
+    }
+    inkplate.println("\nSuccessfully connected to Wi-Fi!");
+
+    // Start the remote display service
+    if (!inkplate.remoteDisplay.start(REMOTE_DISPLAY_PORT))
+    {
+        inkplate.println("Remote display start failed!");
+        inkplate.partialUpdate(true);
+        while (1)
+            ;
+    }
+
+    // Show the address for the sender
+    inkplate.print("Waiting for frames on ");
+    inkplate.print(WiFi.localIP());
+    inkplate.printf(":%d\n", REMOTE_DISPLAY_PORT);
+    inkplate.partialUpdate(true);
+
+    // Frames received within 50 ms are shown with the same update (but not later than 500 ms after the first one)
+    inkplate.remoteDisplay.setCoalesceTime(50, 500);
+}
+
+void loop()
+{
+    // Receive the frames and update the screen
+    inkplate.remoteDisplay.loop();
+
+    // Print the statistics every 5 seconds
+    if ((unsigned long)(millis() - lastStats) > 5000UL)
+    {
+        lastStats = millis();
+        RemoteDisplayStats *stats = inkplate.remoteDisplay.stats();
+        Serial.printf("Frames: %lu, updates: %lu, NACKs: %lu, dropped: %lu, latency: %lu ms (max. %lu ms)\r\n",
+                      (unsigned long)stats->frames, (unsigned long)stats->updates, (unsigned long)stats->nacks,
+                      (unsigned long)stats->droppedFrames, (unsigned long)stats->lastLatency,
+                      (unsigned long)stats->maxLatency);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ **************************************************
+ *
+ * @file        Inkplate_6_Motion_WiFi_Fast_Reconnect.ino
+ * @brief       Connect to your home Wi-Fi as fast as possible after the wake up from the deep sleep.
+ *              AP BSSID and IP settings are stored in the RTC backup SRAM after the first connection,
+ *              so the next connection skips the full scan and DHCP
+ *
+ * For info on how to quickly get started with Inkplate 6MOTION visit docs.inkplate.com
+ *
+ * @authors     Borna Biro for soldered.com
+ * @date        October 2026
+ ***************************************************/
+
+// Add an Inkplate Motion Libray to the Sketch
+#include <InkplateMotion.h>
+
+// Change WiFi SSID and password here
+#define WIFI_SSID ""
+#define WIFI_PASS ""
+
+// Create an Inkplate Motion Object
+Inkplate inkplate;
+
+void setup()
+{
+    // Initialize the Inkplate Motion Library
+    inkplate.begin(INKPLATE_1BW);
+
+    // Initialize STM32 RTC (needed for Backup RAM) without reseting the whole RTC
+    inkplate.rtc.begin(RTC_HOURFORMAT_24);
+
+    // First start? Reset the RTC (otherwise backup RAM will return wrong values)
+    if (!inkplate.rtc.isRTCSet())
+    {
+        inkplate.rtc.begin(RTC_HOURFORMAT_24, true);
+        inkplate.rtc.rtcSetFlag();
+
+        // Make sure there is no old AP data in the backup RAM
+        WiFi.clearFastConnect(&inkplate.rtc);
+    }
+
+    // Set the text options
+    inkplate.setCursor(0, 0);
+    inkplate.setTextSize(2);
+    inkplate.setTextColor(BLACK, WHITE);
+    inkplate.setTextWrap(true);
+
+    // Power up the Wi-Fi and connect to the AP (use it instead of WiFi.init(), WiFi.setMode() and WiFi.begin())
+    unsigned long startTime = millis();
+    if (WiFi.fastConnect((char *)WIFI_SSID, (char *)WIFI_PASS, &inkplate.rtc))
+    {
+        // Print how long it took and was the cached data used
+        inkplate.printf("Connected in %lu ms (%s)\n", millis() - startTime,
+                        WiFi.fastConnectUsed() ? "fast reconnect" : "full scan and DHCP");
+        inkplate.print("IP: ");
+        inkplate.println(WiFi.localIP());
+    }
+    else
+    {
+        inkplate.println("Connection failed!");
+    }
+
+    // Wi-Fi is not needed anymore, turn it off
+    WiFi.power(false);
+
+    inkplate.println("Press the wake button to connect again.");
+    inkplate.display();
+
+    // Check if the wake up from sleep did reset the board. If so, clear the flags
+    if (__HAL_PWR_GET_FLAG(PWR_FLAG_SB) != RESET)
+    {
+        // Clear Standby flag
+        __HAL_PWR_CLEAR_FLAG(PWR_FLAG_SB);
+
+        // Wake-up button on Inkplate 6 Motion is PC13 = WAKEUP PIN 4.
+        HAL_PWR_DisableWakeUpPin(PWR_WAKEUP_PIN4);
+    }
+
+    // Enable wake up button. By setting PC13 to low (button press), Inkplate will wake up
+    HAL_PWR_EnableWakeUpPin(PWR_WAKEUP_PIN4_LOW);
+
+    // Go to deep sleep, code starts from the begining after the wake up
+    deepSleep(); // Code stops here!
+}
+
+void loop()
+{
+    // Nothing! Must be empty!
+}
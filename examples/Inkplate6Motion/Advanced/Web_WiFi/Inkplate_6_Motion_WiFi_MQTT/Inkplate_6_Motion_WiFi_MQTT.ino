@@ -83,8 +83,10 @@ void setup()
     delay(1000);
 
     // Initialize MQTT library and use internal dynalically buffer of
-    // 48 bytes for MQTT RX messages. Do the init. after WiFi connection.
-    mqtt.begin(48);
+    // 1024 bytes for MQTT RX messages. It's used as the queue, so more messages
+    // can be received before they are read (each message also stores its topic).
+    // Do the init. after WiFi connection.
+    mqtt.begin(1024);
 
     // Set the MQTT server data.
     mqtt.setServer(MQTT_SERVER, 1883);
@@ -6,6 +6,11 @@
  *
  * Download the image converter at: https://github.com/SolderedElectronics/Soldered-Image-Converter
  *
+ * Images can also be converted into native Inkplate image format (.ipi) with convert_ipi.py from this folder
+ * (python convert_ipi.py image.jpg image.ipi --bpp 4 --dither). These images are already dithered and packed
+ * the same way as the Inkplate framebuffer, so they are loaded from the microSD card without decoding.
+ * Copy image.ipi to the root of the microSD card to see it at the end of this example.
+ *
  * For info on how to quickly get started with Inkplate 6MOTION visit docs.inkplate.com
  *
  * @authors     Borna Biro and Robert Soric for soldered.com
@@ -23,9 +28,13 @@
 
 Inkplate inkplate; // Create Inkplate object
 
+// microSD card init. status (native image is drawn only if the card is there)
+bool sdCardOk = false;
+
 void setup()
 {
-    inkplate.begin(INKPLATE_BLACKWHITE); // Initialize Inkplate in black and white mode
+    inkplate.begin(INKPLATE_BLACKWHITE);   // Initialize Inkplate in black and white mode
+    sdCardOk = inkplate.microSDCardInit(); // Try to initialize the microSD card
 }
 
 void loop()
@@ -75,4 +84,17 @@ void loop()
     inkplate.display(); // Show it on the display
 
     delay(5000); // Wait for 5s so the image can be seen
+
+    // Native image from the microSD card is copied directly into the framebuffer
+    // Convert it in 4 bit mode for grayscale mode (1 bit mode for black and white mode)
+    // Dither and scale parameters are not used, image is already dithered by convert_ipi.py
+    if (sdCardOk)
+    {
+        inkplate.clearDisplay(); // Clear the display first
+        if (inkplate.image.draw("image.ipi", 0, 0, false, 0, NULL, 0))
+        {
+            inkplate.display(); // Show it on the display
+            delay(5000);        // Wait for 5s so the image can be seen
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+# This script is used to convert images to the native Inkplate image format (.ipi)
+# Native images are already dithered and packed in the same way as the Inkplate framebuffer,
+# so they can be loaded from the microSD card without decoding (inkplate.image.draw("image.ipi", x, y)).
+#
+# Usage: python convert_ipi.py input.jpg output.ipi [--bpp 1|2|4] [--dither] [--rle] [--width W] [--height H]
+
+import argparse
+import struct
+from PIL import Image
+
+# Header of the native image, see InkplateNativeImageHeader in the library.
+HEADER_FORMAT = "<4sBBBBHHHH"
+VERSION = 1
+FLAG_RLE = 0x01
+
+# Image data starts at the microSD sector boundary, so rows can be read directly from the card.
+DATA_OFFSET = 512
+
+
+def quantize(img, bpp, dither):
+    # Convert image to grayscale with the needed number of levels (white is always the highest level).
+    img = img.convert("L")
+    levels = 1 << bpp
+    palette = []
+    for i in range(levels):
+        v = (i * 255) // (levels - 1)
+        palette += [v, v, v]
+    # Unused palette entries are white (see pack_row).
+    palette += [255, 255, 255] * (256 - levels)
+    palette_img = Image.new("P", (1, 1))
+    palette_img.putpalette(palette)
+    return img.convert("RGB").quantize(
+        palette=palette_img, dither=Image.FLOYDSTEINBERG if dither else Image.NONE
+    )
+
+
+def pack_row(img, y, bpp, stride):
+    row = bytearray(stride)
+    width = img.size[0]
+    levels = 1 << bpp
+    for x in range(width):
+        # Unused palette entries are white as well.
+        level = min(img.getpixel((x, y)), levels - 1)
+        if bpp == 1:
+            # 1 bit - MSB first, 1 = black.
+            if level == 0:
+                row[x >> 3] |= 0x80 >> (x & 7)
+        elif bpp == 2:
+            # 2 bit - first pixel in the lowest bits.
+            row[x >> 2] |= level << ((x & 3) * 2)
+        else:
+            # 4 bit - first pixel in the lower nibble.
+            row[x >> 1] |= level << ((x & 1) * 4)
+    return row
+
+
+def pack_bits(row):
+    # PackBits compression, runs never cross the row boundary.
+    # Only runs of three or more bytes are repeated, so the row never grows more than one byte per 128 bytes.
+    out = bytearray()
+    i = 0
+    while i < len(row):
+        run = 1
+        while i + run < len(row) and run < 128 and row[i + run] == row[i]:
+            run += 1
+        if run > 2:
+            out += bytes([257 - run, row[i]])
+            i += run
+            continue
+        start = i
+        while i < len(row) and i - start < 128:
+            if i + 2 < len(row) and row[i] == row[i + 1] == row[i + 2]:
+                break
+            i += 1
+        out += bytes([i - start - 1]) + row[start:i]
+    return out
+
+
+def convert(input_path, output_path, bpp, dither, rle, width, height):
+    img = Image.open(input_path)
+
+    # Resize if needed.
+    if width or height:
+        w = width if width else img.size[0] * height // img.size[1]
+        h = height if height else img.size[1] * width // img.size[0]
+        img = img.resize((w, h), Image.LANCZOS)
+
+    img = quantize(img, bpp, dither)
+    width, height = img.size
+    stride = (width * bpp + 7) // 8
+
+    flags = FLAG_RLE if rle else 0
+    header = struct.pack(HEADER_FORMAT, b"IPIM", VERSION, bpp, flags, 0, width, height, stride, DATA_OFFSET)
+
+    with open(output_path, "wb") as f:
+        f.write(header)
+        f.write(bytes(DATA_OFFSET - len(header)))
+        for y in range(height):
+            row = pack_row(img, y, bpp, stride)
+            if rle:
+                packed = pack_bits(row)
+                f.write(struct.pack("<H", len(packed)))
+                f.write(packed)
+            else:
+                f.write(row)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Convert image to the native Inkplate image format (.ipi)")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument(
+        "--bpp", type=int, choices=[1, 2, 4], default=4, help="1 for black and white mode, 4 for grayscale mode"
+    )
+    parser.add_argument("--dither", action="store_true", help="Use Floyd-Steinberg dithering")
+    parser.add_argument("--rle", action="store_true", help="Compress rows (smaller file, slightly slower load)")
+    parser.add_argument("--width", type=int, default=0)
+    parser.add_argument("--height", type=int, default=0)
+    args = parser.parse_args()
+
+    convert(args.input, args.output, args.bpp, args.dither, args.rle, args.width, args.height)
@@ -0,0 +1,98 @@
+/**
+ **************************************************
+ *
+ * @file        Inkplate_6_Motion_WiFi_SPI_Benchmark.ino
+ * @brief       Measure the speed of the SPI link between the STM32 and the ESP32 Wi-Fi
+ *              module, with and without the DMA. AT command round trip time is measured
+ *              with AT pings, throughput is measured by downloading the same file into SDRAM.
+ *              Results are printed on the Serial Monitor.
+ *
+ * For info on how to quickly get started with Inkplate 6MOTION visit docs.inkplate.com
+ *
+ * @authors     Borna Biro and Robert Soric for soldered.com
+ * @date        January 2025
+ ***************************************************/
+
+// Include Inkplate Motion library
+#include <InkplateMotion.h>
+
+Inkplate inkplate; // Create Inkplate object
+
+// Change WiFi SSID and password here
+#define WIFI_SSID ""
+#define WIFI_PASS ""
+
+// File used for the throughput test (larger file gives more accurate result).
+char fileUrl[] = {"https://gssc.esa.int/navipedia/images/a/a9/Example.jpg"};
+
+// Number of AT pings for the round trip test.
+#define NUMBER_OF_PINGS 100
+
+// Free part of the SDRAM used for the downloaded file (4MB).
+volatile uint8_t *downloadBuffer = (volatile uint8_t *)0xD1800000;
+#define DOWNLOAD_BUFFER_SIZE (4 * 1024 * 1024)
+
+void setup()
+{
+    // Serial debugging.
+    Serial.begin(115200);
+    Serial.println("Inkplate 6 Motion Wi-Fi SPI benchmark");
+
+    // Initialize the library (needed for the SDRAM).
+    inkplate.begin(INKPLATE_BLACKWHITE);
+
+    // Let's initialize the Wi-Fi library:
+    WiFi.init();
+
+    // Set mode to Station
+    WiFi.setMode(INKPLATE_WIFI_MODE_STA);
+
+    // Connect to WiFi:
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    Serial.print("Connecting to Wi-Fi...");
+    while (!WiFi.connected())
+    {
+        Serial.print('.');
+        delay(1000);
+    }
+    Serial.println("\nSuccessfully connected to Wi-Fi!");
+
+    // Run the test without the DMA first, then with the DMA.
+    runBenchmark(false);
+    runBenchmark(true);
+}
+
+void loop()
+{
+    // Empty...
+}
+
+void runBenchmark(bool _dma)
+{
+    Serial.printf("\r\n--- SPI DMA %s ---\r\n", _dma ? "enabled" : "disabled");
+    WiFi.spiDma(_dma);
+
+    // Round trip time of the short AT command.
+    uint16_t _pingOk = 0;
+    unsigned long _time = micros();
+    for (int i = 0; i < NUMBER_OF_PINGS; i++)
+    {
+        if (WiFi.modemPing())
+            _pingOk++;
+    }
+    _time = micros() - _time;
+    Serial.printf("AT ping: %d/%d ok, %lu us per command\r\n", _pingOk, NUMBER_OF_PINGS, _time / NUMBER_OF_PINGS);
+
+    // Throughput of the HTTP download (network speed is included, so run it a few times).
+    WiFiClient _client;
+    _time = millis();
+    uint32_t _size = _client.downloadFile(fileUrl, downloadBuffer, DOWNLOAD_BUFFER_SIZE);
+    _time = millis() - _time;
+    if (_size == 0)
+    {
+        Serial.println("Download failed!");
+        return;
+    }
+    Serial.printf("Download: %lu bytes in %lu ms, %lu kB/s\r\n", (unsigned long)_size, _time,
+                  _time ? (unsigned long)(_size / _time) : 0UL);
+}
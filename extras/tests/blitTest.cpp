@@ -0,0 +1,169 @@
+/**
+ **************************************************
+ *
+ * @file        blitTest.cpp
+ * @brief       Host test for the software blit functions (fallback
+ *              of the DMA2D). Random rectangles with different strides
+ *              and alignments are checked against the simple per pixel
+ *              reference, also pixels outside the rectangle must not be
+ *              changed. Blend is checked bit-exact against the
+ *              round((src * mask + dst * (255 - mask)) / 255).
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+#include <string.h>
+
+#include "system/blitHelpers.h"
+#include "testHelpers.h"
+
+// Size of the test buffers.
+#define BUFFER_SIZE 4096
+
+static uint8_t src[BUFFER_SIZE];
+static uint8_t mask[BUFFER_SIZE];
+static uint8_t dst[BUFFER_SIZE];
+static uint8_t ref[BUFFER_SIZE];
+
+// Fill the buffer with pseudo-random bytes.
+static void randomFill(uint8_t *_buffer, uint32_t _len)
+{
+    for (uint32_t i = 0; i < _len; i++)
+        _buffer[i] = rand() & 0xFF;
+}
+
+// Pick the random rectangle that fits into the buffer.
+static void randomRect(uint32_t *_offset, uint32_t *_stride, uint16_t *_w, uint16_t *_h)
+{
+    *_stride = 1 + (rand() % 128);
+    *_w = rand() % (*_stride + 1);
+    *_h = rand() % ((BUFFER_SIZE / 2) / *_stride + 1);
+    *_offset = rand() % (BUFFER_SIZE - (*_stride * *_h) - *_w);
+}
+
+static void testFill()
+{
+    for (int n = 0; n < 2000; n++)
+    {
+        uint32_t _offset, _stride;
+        uint16_t _w, _h;
+        randomRect(&_offset, &_stride, &_w, &_h);
+        uint8_t _value = rand() & 0xFF;
+
+        randomFill(dst, BUFFER_SIZE);
+        memcpy(ref, dst, BUFFER_SIZE);
+
+        for (uint16_t y = 0; y < _h; y++)
+            for (uint16_t x = 0; x < _w; x++)
+                ref[_offset + (y * _stride) + x] = _value;
+
+        blitFill8bpp(dst + _offset, _stride, _w, _h, _value);
+        TEST_CHECK(memcmp(dst, ref, BUFFER_SIZE) == 0);
+    }
+}
+
+static void testCopy()
+{
+    for (int n = 0; n < 2000; n++)
+    {
+        uint32_t _srcOffset, _srcStride, _dstOffset, _dstStride;
+        uint16_t _w, _h, _w2, _h2;
+        randomRect(&_srcOffset, &_srcStride, &_w, &_h);
+        randomRect(&_dstOffset, &_dstStride, &_w2, &_h2);
+
+        // Rectangle must fit into both buffers.
+        if (_w > _w2)
+            _w = _w2;
+        if (_h > _h2)
+            _h = _h2;
+
+        randomFill(src, BUFFER_SIZE);
+        randomFill(dst, BUFFER_SIZE);
+        memcpy(ref, dst, BUFFER_SIZE);
+
+        for (uint16_t y = 0; y < _h; y++)
+            for (uint16_t x = 0; x < _w; x++)
+                ref[_dstOffset + (y * _dstStride) + x] = src[_srcOffset + (y * _srcStride) + x];
+
+        blitCopy8bpp(src + _srcOffset, _srcStride, dst + _dstOffset, _dstStride, _w, _h);
+        TEST_CHECK(memcmp(dst, ref, BUFFER_SIZE) == 0);
+    }
+}
+
+static void testBlendPixel()
+{
+    // Every source, destination and mask value against round((src * mask + dst * (255 - mask)) / 255).
+    for (uint32_t _m = 0; _m < 256; _m++)
+    {
+        for (uint32_t _s = 0; _s < 256; _s++)
+        {
+            for (uint32_t _d = 0; _d < 256; _d++)
+            {
+                uint32_t _exact = ((2 * ((_s * _m) + (_d * (255 - _m)))) + 255) / 510;
+                TEST_CHECK(blitBlendPixel(_s, _d, _m) == _exact);
+            }
+        }
+    }
+}
+
+static void testBlend()
+{
+    for (int n = 0; n < 2000; n++)
+    {
+        uint32_t _srcOffset, _srcStride, _maskOffset, _maskStride, _dstOffset, _dstStride;
+        uint16_t _w, _h, _w2, _h2, _w3, _h3;
+        randomRect(&_srcOffset, &_srcStride, &_w, &_h);
+        randomRect(&_maskOffset, &_maskStride, &_w2, &_h2);
+        randomRect(&_dstOffset, &_dstStride, &_w3, &_h3);
+
+        // Rectangle must fit into all three buffers.
+        if (_w > _w2)
+            _w = _w2;
+        if (_w > _w3)
+            _w = _w3;
+        if (_h > _h2)
+            _h = _h2;
+        if (_h > _h3)
+            _h = _h3;
+
+        // Mask has a lot of fully transparent and fully opaque pixels (like the sprites).
+        randomFill(src, BUFFER_SIZE);
+        randomFill(mask, BUFFER_SIZE);
+        for (uint32_t i = 0; i < BUFFER_SIZE; i++)
+        {
+            if ((mask[i] & 3) == 0)
+                mask[i] = 0;
+            else if ((mask[i] & 3) == 1)
+                mask[i] = 255;
+        }
+        randomFill(dst, BUFFER_SIZE);
+        memcpy(ref, dst, BUFFER_SIZE);
+
+        for (uint16_t y = 0; y < _h; y++)
+        {
+            for (uint16_t x = 0; x < _w; x++)
+            {
+                uint32_t _s = src[_srcOffset + (y * _srcStride) + x];
+                uint32_t _m = mask[_maskOffset + (y * _maskStride) + x];
+                uint8_t *_d = &ref[_dstOffset + (y * _dstStride) + x];
+                *_d = ((2 * ((_s * _m) + (*_d * (255 - _m)))) + 255) / 510;
+            }
+        }
+
+        blitBlend8bpp(src + _srcOffset, _srcStride, mask + _maskOffset, _maskStride, dst + _dstOffset, _dstStride, _w,
+                      _h);
+        TEST_CHECK(memcmp(dst, ref, BUFFER_SIZE) == 0);
+    }
+}
+
+int main()
+{
+    srand(1);
+    testFill();
+    testCopy();
+    testBlendPixel();
+    testBlend();
+    TEST_END("blitTest");
+}
@@ -0,0 +1,131 @@
+/**
+ **************************************************
+ *
+ * @file        framerTest.cpp
+ * @brief       Host test for the AT response framer. Recorded ESP32-AT
+ *              responses are fed in every possible split into two
+ *              packets and byte by byte, response must be complete at
+ *              the same place with the same result code.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+#include <string.h>
+
+#include "system/wifi/esp32SpiAtFramer.h"
+#include "testHelpers.h"
+
+// One recorded response.
+typedef struct
+{
+    const char *command;
+    const char *expected;
+    const char *response;
+    uint32_t completeAt;
+    uint8_t result;
+} Transcript;
+
+// completeAt is the length of the response when it must be complete (0 = never, ends with the timeout).
+static const Transcript transcripts[] = {
+    {"AT\r\n", NULL, "\r\nOK\r\n", 6, INKPLATE_ESP32_AT_RESULT_OK},
+    {"AT+CWJAP=\"ssid\",\"pass\"\r\n", NULL, "WIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n", 35,
+     INKPLATE_ESP32_AT_RESULT_OK},
+    {"AT+CWJAP=\"ssid\",\"pass\"\r\n", NULL, "+CWJAP:1\r\n\r\nERROR\r\n", 19, INKPLATE_ESP32_AT_RESULT_ERROR},
+    {"AT+CIPSTART=0,\"TCP\",\"soldered.com\",80\r\n", NULL, "0,CONNECT\r\n\r\nOK\r\n", 17, INKPLATE_ESP32_AT_RESULT_OK},
+    {"AT+CIPSEND=0,12\r\n", NULL, "\r\nOK\r\n\r\n>", 9, INKPLATE_ESP32_AT_RESULT_PROMPT},
+    {"AT+CIPSEND=0,12\r\n", NULL, "\r\nOK\r\n", 0, INKPLATE_ESP32_AT_RESULT_OK},
+    {"AT+CIPSEND=0,12\r\n", NULL, "link is not valid\r\n\r\nERROR\r\n", 28, INKPLATE_ESP32_AT_RESULT_ERROR},
+    {"AT+CIPSEND=0,12\r\n", ">", "\r\nOK\r\n\r\n> ", 9, INKPLATE_ESP32_AT_RESULT_PROMPT},
+    {"AT+HTTPURLCFG=20\r\n", "\r\nOK\r\n\r\n>", "\r\nOK\r\n\r\n>", 9, INKPLATE_ESP32_AT_RESULT_PROMPT},
+    {"AT+HTTPCHEAD=0\r\n", NULL, "\r\nOK\r\n", 6, INKPLATE_ESP32_AT_RESULT_OK},
+    {"AT+SYSMSGFILTERCFG=1,0,5\r\n", NULL, "\r\nOK\r\n\r\n>", 9, INKPLATE_ESP32_AT_RESULT_PROMPT},
+    {"AT+CIPSTATE?\r\n", "+CIPSTATE:", "\r\nOK\r\n", 0, INKPLATE_ESP32_AT_RESULT_OK},
+    {"AT+CIPSTATE?\r\n", "+CIPSTATE:", "+CIPSTATE:0,\"TCP\",\"1.2.3.4\",80,1234,0\r\n\r\nOK\r\n", 45,
+     INKPLATE_ESP32_AT_RESULT_OK},
+    {"AT+HTTPCLIENT=1,0,\"http://x\",,,1\r\n", NULL, "busy p...\r\n+HTTPCLIENT:5,hello\r\n\r\nSEND OK\r\n", 43,
+     INKPLATE_ESP32_AT_RESULT_OK},
+    {"AT+MQTTPUBRAW=0,\"t\",5,0,0\r\n", NULL, "\r\nOK\r\n\r\n>", 9, INKPLATE_ESP32_AT_RESULT_PROMPT},
+    {"AT+CWMODE=1\r\n", NULL, "\r\nFAIL\r\n\r\nOK\r\n", 8, INKPLATE_ESP32_AT_RESULT_ERROR},
+};
+
+// Feed the response in the packets that end at the given lengths and return the length when it was complete.
+static uint32_t feedSplit(const Transcript *_t, const uint32_t *_ends, uint32_t _numberOfEnds, uint8_t *_result)
+{
+    AtResponseFramer _framer;
+    _framer.begin(_t->response, _t->expected, AtResponseFramer::commandNeedsPrompt(_t->command));
+
+    for (uint32_t i = 0; i < _numberOfEnds; i++)
+    {
+        if (_framer.feed(_ends[i]))
+        {
+            *_result = _framer.result();
+            return _ends[i];
+        }
+    }
+
+    *_result = _framer.result();
+    return 0;
+}
+
+// Where the response must be complete if the packet ends at _end (complete at completeAt or later).
+static uint32_t expectedEnd(const Transcript *_t, uint32_t _end)
+{
+    if (_t->completeAt == 0)
+        return 0;
+    return (_end >= _t->completeAt) ? _end : 0;
+}
+
+int main()
+{
+    // Commands with the data phase.
+    TEST_CHECK(AtResponseFramer::commandNeedsPrompt("AT+CIPSEND=0,12\r\n"));
+    TEST_CHECK(AtResponseFramer::commandNeedsPrompt("AT+CIPSENDEX=0,12\r\n"));
+    TEST_CHECK(AtResponseFramer::commandNeedsPrompt("AT+CIPSEND\r\n"));
+    TEST_CHECK(AtResponseFramer::commandNeedsPrompt("AT+HTTPCPOST=\"\",10\r\n"));
+    TEST_CHECK(AtResponseFramer::commandNeedsPrompt("AT+HTTPCHEAD=12\r\n"));
+    TEST_CHECK(!AtResponseFramer::commandNeedsPrompt("AT+HTTPCHEAD=0\r\n"));
+    TEST_CHECK(!AtResponseFramer::commandNeedsPrompt("AT+CIPSTART=0,\"TCP\",\"x\",80\r\n"));
+    TEST_CHECK(!AtResponseFramer::commandNeedsPrompt("AT+CIPSTATE?\r\n"));
+    TEST_CHECK(!AtResponseFramer::commandNeedsPrompt("AT\r\n"));
+    TEST_CHECK(!AtResponseFramer::commandNeedsPrompt(NULL));
+
+    for (uint32_t n = 0; n < sizeof(transcripts) / sizeof(transcripts[0]); n++)
+    {
+        const Transcript *_t = &transcripts[n];
+        uint32_t _len = strlen(_t->response);
+        uint8_t _result;
+
+        // Whole response in one packet.
+        uint32_t _ends[64];
+        _ends[0] = _len;
+        uint32_t _at = feedSplit(_t, _ends, 1, &_result);
+        TEST_CHECK(_at == expectedEnd(_t, _len));
+        TEST_CHECK(_result == _t->result);
+        if ((_at != expectedEnd(_t, _len)) || (_result != _t->result))
+            printf("  transcript %u (whole)\n", n);
+
+        // Every split into two packets.
+        for (uint32_t _split = 1; _split < _len; _split++)
+        {
+            _ends[0] = _split;
+            _ends[1] = _len;
+            uint32_t _want = (expectedEnd(_t, _split) != 0) ? _split : expectedEnd(_t, _len);
+            _at = feedSplit(_t, _ends, 2, &_result);
+            TEST_CHECK(_at == _want);
+            TEST_CHECK(_result == _t->result);
+        }
+
+        // Byte by byte, it must be complete exactly at completeAt.
+        for (uint32_t i = 0; i < _len; i++)
+            _ends[i] = i + 1;
+        _at = feedSplit(_t, _ends, _len, &_result);
+        TEST_CHECK(_at == _t->completeAt);
+        TEST_CHECK(_result == _t->result);
+        if ((_at != _t->completeAt) || (_result != _t->result))
+            printf("  transcript %u (byte by byte): complete at %u, result %u\n", n, _at, _result);
+    }
+
+    TEST_END("framerTest");
+}
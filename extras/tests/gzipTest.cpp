@@ -0,0 +1,398 @@
+/**
+ **************************************************
+ *
+ * @file        gzipTest.cpp
+ * @brief       Host test for the streaming gzip decoder. gzip header
+ *              with every combination of the optional fields is parsed,
+ *              the stream is decoded in every possible split into two
+ *              chunks, byte by byte and in random chunks (decoded data
+ *              is larger than the dictionary, so the output wraps
+ *              around). Broken trailer (CRC32 or size) and broken
+ *              deflate data must be reported as an error.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "system/wifi/esp32SpiAtGzip.h"
+#include "testHelpers.h"
+
+// Raw deflate data of the test content (see makeContent()), compressed with zlib (level 9).
+static const uint8_t deflateData[] = {
+    0xED, 0xDB, 0x39, 0x72, 0x74, 0x2B, 0x0C, 0x86, 0xE1, 0x9C, 0x15, 0x92, 0x22, 0x06, 0x31, 0xB3,
+    0xFF, 0xEC, 0x7E, 0x7D, 0x57, 0xE0, 0xF4, 0xAF, 0xF3, 0xBA, 0xCA, 0x81, 0xDB, 0x67, 0x00, 0x21,
+    0xE9, 0xA9, 0x0E, 0x14, 0x9F, 0xED, 0xBD, 0xF3, 0xAE, 0x7E, 0xC3, 0x39, 0xD6, 0x2D, 0xD8, 0xF3,
+    0x1C, 0x7A, 0xF7, 0x3E, 0xD7, 0x38, 0x73, 0x79, 0xD9, 0xB9, 0xD9, 0x38, 0xB5, 0x85, 0xFE, 0xDA,
+    0x5E, 0x79, 0x8E, 0x53, 0x96, 0xBF, 0x30, 0x67, 0x08, 0xC1, 0x5F, 0x19, 0xF7, 0xAE, 0xE7, 0xAB,
+    0xFA, 0x3B, 0xF3, 0xBE, 0xE0, 0x96, 0xD2, 0x0E, 0x36, 0x5A, 0x6A, 0xF3, 0x94, 0xBB, 0xF6, 0x98,
+    0xB9, 0xE4, 0xEB, 0x61, 0xB5, 0xEC, 0x45, 0x7F, 0xD8, 0x3B, 0x79, 0xD8, 0xC9, 0xDE, 0xCC, 0x43,
+    0xF7, 0x79, 0x7D, 0x8D, 0xDA, 0xC6, 0xE9, 0xC7, 0xF6, 0xB5, 0x17, 0xD2, 0xEC, 0xB6, 0x43, 0xB9,
+    0x96, 0x6E, 0xBB, 0x77, 0x97, 0xFB, 0x5E, 0x78, 0x3E, 0xAA, 0x2F, 0x2B, 0xC5, 0x46, 0xED, 0x7B,
+    0xA5, 0x64, 0x25, 0xCC, 0xD4, 0x73, 0x69, 0xC9, 0xAC, 0xB7, 0xDC, 0x46, 0x78, 0x6F, 0xEE, 0x1A,
+    0xD2, 0x9D, 0x6F, 0x6D, 0x4F, 0x49, 0x8F, 0x3E, 0xDE, 0xB4, 0x83, 0x9D, 0x76, 0x9F, 0x55, 0x4B,
+    0x18, 0xA9, 0x79, 0x6F, 0xBD, 0x9F, 0x54, 0x77, 0xA9, 0x5A, 0xCB, 0x29, 0x4D, 0x17, 0xAF, 0x92,
+    0xEE, 0x36, 0xDD, 0x7D, 0xFA, 0xB4, 0xB2, 0x5E, 0x5B, 0xE5, 0x0C, 0x73, 0xDB, 0xAD, 0xD7, 0xA5,
+    0x2D, 0x7A, 0x4E, 0xD7, 0x5A, 0xEE, 0x8A, 0xC2, 0x0B, 0xD7, 0xC7, 0xD1, 0xE5, 0xD5, 0xCE, 0xEE,
+    0xB5, 0x97, 0x9B, 0x4B, 0xD5, 0x36, 0xCC, 0xC6, 0xE8, 0xC1, 0xEA, 0x6D, 0x3B, 0x85, 0xD2, 0xAA,
+    0x22, 0xA4, 0x30, 0xAC, 0xD2, 0xDB, 0xCE, 0x39, 0x97, 0x93, 0xDC, 0xBC, 0xDE, 0xBC, 0xCE, 0x75,
+    0x9B, 0x25, 0x5B, 0xD8, 0xCB, 0x8F, 0x22, 0x30, 0xF6, 0xAD, 0xA9, 0xB4, 0x95, 0x7D, 0xF9, 0xB8,
+    0xC7, 0xDA, 0x6B, 0x39, 0x95, 0xA0, 0x75, 0x95, 0x5D, 0x52, 0xBB, 0xCF, 0x93, 0x79, 0x2A, 0x16,
+    0xE6, 0x78, 0x53, 0xE1, 0x7E, 0x66, 0x73, 0x2B, 0x20, 0x21, 0xBC, 0xD6, 0x9A, 0x82, 0x15, 0x7E,
+    0x4F, 0xA9, 0x2B, 0x0C, 0xEF, 0xE6, 0x4F, 0xC1, 0xCB, 0xA1, 0xD4, 0x7E, 0x14, 0xA8, 0x33, 0x67,
+    0x1F, 0xEB, 0x8E, 0xB3, 0x92, 0xDD, 0xBD, 0x96, 0x9E, 0xE0, 0x55, 0xCB, 0x3B, 0xAF, 0x15, 0xBB,
+    0x76, 0xFA, 0x28, 0xA9, 0xA7, 0x71, 0xE7, 0x2C, 0x96, 0x57, 0xBF, 0xB7, 0x8E, 0xBE, 0x4A, 0xCE,
+    0xD3, 0x7B, 0xA8, 0x6F, 0x85, 0xA4, 0x2D, 0xE4, 0x35, 0x73, 0x4E, 0xF9, 0x59, 0x1D, 0x3E, 0xC3,
+    0x5D, 0xC3, 0xB6, 0x5E, 0x67, 0xF9, 0x76, 0xAD, 0xB4, 0xEC, 0x63, 0xA5, 0xDB, 0xED, 0x4D, 0xAB,
+    0x6A, 0xCF, 0x43, 0xFB, 0x1D, 0xA5, 0x6E, 0x3D, 0xAD, 0x3E, 0x6B, 0x23, 0xCD, 0x70, 0x94, 0x07,
+    0x0A, 0xCF, 0x3A, 0xB3, 0xDE, 0xF3, 0xDC, 0x75, 0xAF, 0x2E, 0x0A, 0xC1, 0x6E, 0x98, 0xBD, 0x5F,
+    0x45, 0xE1, 0xF4, 0xDB, 0xB4, 0xB1, 0x96, 0xB6, 0x76, 0xF1, 0x72, 0x55, 0x22, 0xE9, 0xAD, 0x7B,
+    0x37, 0xAF, 0x29, 0x34, 0x5F, 0x45, 0xD7, 0xAE, 0x1A, 0x8E, 0x3E, 0xED, 0xB3, 0xA7, 0x7E, 0xF6,
+    0xDD, 0x4F, 0x2F, 0xDE, 0xBD, 0x95, 0x31, 0x74, 0x96, 0x69, 0xB6, 0x50, 0xB4, 0xBA, 0x5C, 0xD2,
+    0xDA, 0xAF, 0x56, 0xE5, 0xB1, 0x2E, 0x69, 0x23, 0x97, 0x19, 0x72, 0x9A, 0x29, 0xEF, 0xA6, 0x27,
+    0x6C, 0x3F, 0x77, 0x28, 0x90, 0xF9, 0x2A, 0x5D, 0x94, 0x19, 0x56, 0x93, 0xD6, 0x3A, 0xC3, 0xE8,
+    0x37, 0xB5, 0xAE, 0x5C, 0x0B, 0xB5, 0x7B, 0x55, 0x94, 0x15, 0xFA, 0xD5, 0x82, 0x9D, 0x31, 0x7D,
+    0xCF, 0xA6, 0xED, 0x0C, 0xE5, 0x53, 0xBB, 0xFD, 0xA8, 0x06, 0x4E, 0xE8, 0xA9, 0xDA, 0x53, 0xDC,
+    0xD6, 0xDB, 0xF5, 0xF4, 0x9D, 0xC6, 0x7B, 0x5B, 0x09, 0x58, 0x9E, 0x4E, 0x51, 0x4F, 0x58, 0x35,
+    0xDB, 0xEA, 0xA6, 0xF4, 0x0F, 0x6D, 0xDD, 0x76, 0x52, 0x6E, 0x57, 0xE7, 0x57, 0xCF, 0x08, 0xA1,
+    0xE9, 0xEF, 0xB6, 0x6A, 0x4A, 0x23, 0xF4, 0x79, 0x46, 0x2A, 0xF5, 0x29, 0x4A, 0x73, 0x5D, 0xE5,
+    0xD5, 0xAC, 0xD5, 0xC7, 0xD6, 0xC2, 0x15, 0xF4, 0xD5, 0xE7, 0xFB, 0x2D, 0xD0, 0xC7, 0x5C, 0xB6,
+    0xCB, 0xD9, 0x2F, 0xA5, 0xAC, 0xFB, 0x74, 0x0E, 0x9E, 0xCF, 0xCD, 0x8A, 0xB7, 0xFE, 0xFF, 0xF2,
+    0xFD, 0x15, 0xE9, 0x9A, 0xDB, 0xAE, 0x0E, 0x36, 0x0F, 0x57, 0xCC, 0x56, 0x59, 0xC5, 0x6F, 0x51,
+    0x01, 0xB5, 0xB3, 0x74, 0x2C, 0xA6, 0xE7, 0xA6, 0xE1, 0xFB, 0x7A, 0xF5, 0x30, 0x4F, 0x9B, 0xAA,
+    0xC0, 0xE5, 0x21, 0xB9, 0x4F, 0xCB, 0x66, 0x9E, 0x6F, 0xBE, 0x65, 0x94, 0xD3, 0x95, 0xBC, 0xA5,
+    0xBF, 0xFA, 0x3B, 0x82, 0x51, 0xD6, 0x0E, 0x67, 0xA9, 0xFE, 0xE7, 0xCC, 0x2A, 0x9D, 0xAD, 0xF2,
+    0xBF, 0xD3, 0xDB, 0x3E, 0x53, 0x89, 0xA8, 0xB8, 0xDC, 0x33, 0xD3, 0xCA, 0xDA, 0x62, 0xEB, 0x23,
+    0x2C, 0xD7, 0x16, 0x53, 0xD7, 0x11, 0x6B, 0x83, 0xAD, 0x29, 0xC3, 0xEC, 0xDC, 0x9A, 0xC7, 0x38,
+    0xBE, 0x55, 0x7D, 0x57, 0x95, 0x7A, 0x56, 0x7E, 0x5B, 0x41, 0x98, 0x4A, 0x31, 0x2B, 0xF9, 0xF4,
+    0x56, 0x8F, 0x76, 0xAE, 0x46, 0x61, 0x7D, 0xE4, 0x5A, 0x94, 0xAE, 0xAB, 0xED, 0x30, 0x2C, 0x85,
+    0xA9, 0x0C, 0xD4, 0x5D, 0xC1, 0x95, 0xDF, 0x33, 0xEB, 0x02, 0x15, 0x64, 0xCA, 0x8A, 0xC5, 0x36,
+    0xC5, 0x44, 0x8D, 0x66, 0xAA, 0x3C, 0xEA, 0x54, 0xD9, 0xDF, 0xD1, 0xDE, 0xAC, 0xBF, 0x60, 0xED,
+    0xA7, 0xAD, 0xFE, 0x76, 0xF6, 0x5E, 0xF6, 0x91, 0x6F, 0x6D, 0xDA, 0xEF, 0xDD, 0x7A, 0x96, 0x9F,
+    0x70, 0xEA, 0x51, 0xFC, 0xD4, 0x5D, 0xD6, 0xAB, 0xA5, 0x2B, 0x50, 0xDA, 0xA4, 0xF6, 0x37, 0x55,
+    0xEB, 0xF7, 0x8E, 0x50, 0x9E, 0xBD, 0x95, 0x54, 0x6F, 0xEA, 0x51, 0xD5, 0xF5, 0x61, 0xDE, 0xE3,
+    0xBA, 0x56, 0xD8, 0x82, 0x62, 0xA2, 0x5D, 0xF9, 0x76, 0xD5, 0xEB, 0xBE, 0x63, 0xAB, 0x52, 0xCA,
+    0xD5, 0x3D, 0x65, 0xAA, 0x83, 0x2C, 0xF5, 0x48, 0x9D, 0x5A, 0x49, 0x0A, 0x8E, 0x8A, 0xC9, 0xB7,
+    0x29, 0xAC, 0xB3, 0xE7, 0x90, 0xAB, 0x5E, 0xF2, 0x94, 0xAD, 0x47, 0xC9, 0x79, 0xDA, 0xF0, 0x5C,
+    0x75, 0x02, 0xAB, 0xB5, 0x12, 0x14, 0x61, 0x25, 0x94, 0xDA, 0xA1, 0xEE, 0x50, 0x1E, 0x59, 0x3D,
+    0x39, 0xF5, 0x90, 0xF4, 0xC2, 0xF4, 0xEA, 0x55, 0x13, 0x74, 0xD3, 0xE1, 0xDC, 0x9D, 0x55, 0xD0,
+    0x2B, 0xA7, 0x7D, 0x97, 0x0A, 0xEC, 0xAA, 0x0F, 0xB6, 0xB5, 0x94, 0xAD, 0xDA, 0x68, 0xEF, 0xE5,
+    0xAC, 0xAD, 0xDE, 0x51, 0x4C, 0x0D, 0x48, 0xB5, 0xAF, 0xF6, 0xEC, 0x36, 0xFA, 0xF0, 0xA0, 0xF5,
+    0xD5, 0xF7, 0xDA, 0x1B, 0x5E, 0xF5, 0xAB, 0x23, 0xBF, 0xAF, 0xF6, 0x9C, 0xF4, 0x71, 0xA8, 0xF3,
+    0xD7, 0xDC, 0xD5, 0x22, 0xA6, 0x8A, 0xD8, 0x97, 0x7A, 0x9C, 0xBA, 0xE5, 0x48, 0xAE, 0xD5, 0x54,
+    0xED, 0x4C, 0xED, 0x47, 0x55, 0x68, 0x4A, 0x6C, 0x0B, 0xF5, 0x5E, 0x05, 0x44, 0x49, 0xD8, 0x57,
+    0x7A, 0x2A, 0x9E, 0xDD, 0x93, 0x9F, 0x93, 0xD4, 0x0B, 0x95, 0xEB, 0xC1, 0x94, 0x83, 0x6A, 0x52,
+    0xEA, 0xE8, 0x16, 0x8A, 0x0E, 0x49, 0xF7, 0xD6, 0x52, 0xD4, 0xB7, 0xEF, 0x5C, 0xFA, 0x99, 0xA1,
+    0xED, 0x36, 0x7B, 0x6D, 0xE5, 0x84, 0x71, 0xCE, 0x3A, 0xEA, 0x46, 0x69, 0x9F, 0xBB, 0x14, 0x6C,
+    0x69, 0x31, 0xBA, 0x0A, 0xA9, 0x69, 0x7B, 0x5D, 0xDD, 0x46, 0xC7, 0x1A, 0xE6, 0x52, 0x41, 0xE9,
+    0x58, 0xA7, 0xDA, 0xFA, 0xFA, 0x1D, 0xC3, 0xB8, 0x5B, 0x87, 0xB9, 0xAD, 0x2A, 0xBD, 0x6E, 0xF8,
+    0xB5, 0xFC, 0xAD, 0xFC, 0xAC, 0xF2, 0xC6, 0x54, 0xDB, 0xFD, 0xAA, 0x8E, 0xCB, 0x5E, 0x4A, 0x9C,
+    0x5F, 0x50, 0x45, 0x44, 0xBB, 0x75, 0xF6, 0xE0, 0xE9, 0x24, 0x1D, 0xD6, 0x54, 0x9F, 0x55, 0xF1,
+    0xE9, 0xC4, 0xEA, 0x30, 0xF5, 0xC4, 0x3D, 0xB7, 0xCF, 0xF4, 0xD4, 0xC9, 0xBA, 0xBA, 0xE8, 0xEE,
+    0x4A, 0xD8, 0x95, 0xF3, 0x49, 0x6B, 0xE9, 0x05, 0xFF, 0xEF, 0x5B, 0x61, 0x55, 0x9B, 0xAF, 0xF5,
+    0xD4, 0xB2, 0xC3, 0x3E, 0x49, 0xD5, 0xA6, 0x95, 0x3C, 0xB5, 0x02, 0x57, 0x3B, 0xBE, 0x7A, 0xE4,
+    0xB8, 0x02, 0xF1, 0xFD, 0xAA, 0x28, 0xFD, 0x00, 0x7B, 0x67, 0x3C, 0x75, 0x84, 0x37, 0x9F, 0x62,
+    0x55, 0xEB, 0x58, 0x5B, 0x98, 0x28, 0xEF, 0x42, 0x1E, 0x62, 0xD1, 0x87, 0xBD, 0xD4, 0x77, 0x3B,
+    0x73, 0xB8, 0xDF, 0x31, 0xB6, 0x29, 0xBE, 0x3A, 0x63, 0x75, 0xE1, 0xF7, 0x24, 0xE5, 0xCB, 0xAA,
+    0x29, 0x35, 0x63, 0xB5, 0x35, 0x6D, 0xF7, 0x57, 0xB8, 0xEA, 0x1A, 0x5A, 0xA1, 0x1A, 0x8B, 0xFA,
+    0x82, 0x4D, 0x55, 0x98, 0x97, 0x34, 0x8F, 0x9F, 0x66, 0x3F, 0x6F, 0xD5, 0x04, 0xB2, 0xB2, 0xB2,
+    0xAB, 0x00, 0x7A, 0x7D, 0x49, 0xFD, 0xBE, 0xAA, 0x11, 0xF8, 0x8F, 0x31, 0x7F, 0x55, 0x79, 0x34,
+    0x96, 0x16, 0x62, 0x45, 0xE1, 0xAF, 0xA5, 0xA9, 0xD7, 0x49, 0xB7, 0xA0, 0x78, 0xE9, 0xF9, 0xD3,
+    0xFF, 0xE2, 0x79, 0xC4, 0x73, 0x3C, 0xC7, 0x73, 0x3C, 0xC7, 0x73, 0x3C, 0xC7, 0xF3, 0x7F, 0xDE,
+    0xF3, 0x3F, 0x7D, 0x3F, 0x8F, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE,
+    0xCF, 0x7B, 0xFE, 0xA7, 0xEF, 0xE7, 0x11, 0xCF, 0xF1, 0x1C, 0xCF, 0xF1, 0x1C, 0xCF, 0xF1, 0x1C,
+    0xCF, 0xFF, 0x79, 0xCF, 0xFF, 0xF4, 0xFD, 0x3C, 0xE2, 0x39, 0x9E, 0xE3, 0x39, 0x9E, 0xE3, 0x39,
+    0x9E, 0xE3, 0xF9, 0x3F, 0xEF, 0xF9, 0x9F, 0xBE, 0x9F, 0x47, 0x3C, 0xC7, 0x73, 0x3C, 0xC7, 0x73,
+    0x3C, 0xC7, 0x73, 0x3C, 0xFF, 0xE7, 0x3D, 0xFF, 0xD3, 0xF7, 0xF3, 0x88, 0xE7, 0x78, 0x8E, 0xE7,
+    0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7,
+    0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7,
+    0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7,
+    0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7,
+    0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D,
+    0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57,
+    0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88,
+    0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E,
+    0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E,
+    0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E,
+    0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E,
+    0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E,
+    0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E,
+    0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE,
+    0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98,
+    0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5,
+    0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78,
+    0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78,
+    0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78,
+    0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78,
+    0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78,
+    0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78,
+    0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78,
+    0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF,
+    0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79,
+    0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B,
+    0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7,
+    0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7,
+    0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7,
+    0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7,
+    0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7,
+    0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7,
+    0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7,
+    0xDF, 0x98, 0x57, 0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D,
+    0x79, 0xB5, 0x88, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57,
+    0x8B, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0xFE, 0x8D, 0x79, 0xB5, 0x88,
+    0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0x78, 0x8E, 0xE7, 0xDF, 0x98, 0x57, 0x8B, 0x78, 0x5E,
+    0xE7, 0x7F,
+};
+
+// CRC32 and size of the test content.
+#define CONTENT_CRC  0x68A8371BUL
+#define CONTENT_SIZE 96000
+
+// Flags of the gzip header.
+#define FHCRC    0x02
+#define FEXTRA   0x04
+#define FNAME    0x08
+#define FCOMMENT 0x10
+
+static uint8_t content[CONTENT_SIZE];
+static uint8_t decoded[CONTENT_SIZE + 1];
+static uint8_t stream[sizeof(deflateData) + 128];
+static GzipInflater inflater;
+
+// Test content: 2000 pseudo-random chars repeated 48 times, each copy has one char changed.
+static void makeContent()
+{
+    uint8_t _base[2000];
+    uint32_t _x = 1;
+    for (int i = 0; i < 2000; i++)
+    {
+        _x = (_x * 1103515245UL) + 12345UL;
+        _base[i] = "abcdefghijklmno\n"[(_x >> 16) & 15];
+    }
+
+    for (int k = 0; k < 48; k++)
+    {
+        memcpy(content + (k * 2000), _base, 2000);
+        content[(k * 2000) + ((k * 37) % 2000)] = 'X';
+    }
+}
+
+// Put the 32 bit value as little endian.
+static void putLe32(uint8_t *_dst, uint32_t _value)
+{
+    for (int i = 0; i < 4; i++)
+        _dst[i] = (_value >> (8 * i)) & 0xFF;
+}
+
+// Make the gzip stream with the optional header fields. Returns the size, header size is stored in _headerSize.
+static uint32_t makeStream(uint8_t _flags, uint32_t _crc, uint32_t _size, uint32_t *_headerSize)
+{
+    uint32_t _pos = 0;
+    const uint8_t _fixed[10] = {0x1F, 0x8B, 8, _flags, 0, 0, 0, 0, 0, 3};
+    memcpy(stream, _fixed, sizeof(_fixed));
+    _pos += sizeof(_fixed);
+
+    if (_flags & FEXTRA)
+    {
+        const uint8_t _extra[] = {5, 0, 'A', 'P', 1, 0, 'x'};
+        memcpy(stream + _pos, _extra, sizeof(_extra));
+        _pos += sizeof(_extra);
+    }
+    if (_flags & FNAME)
+    {
+        memcpy(stream + _pos, "data.json", 10);
+        _pos += 10;
+    }
+    if (_flags & FCOMMENT)
+    {
+        memcpy(stream + _pos, "comment", 8);
+        _pos += 8;
+    }
+    if (_flags & FHCRC)
+    {
+        stream[_pos++] = 0x12;
+        stream[_pos++] = 0x34;
+    }
+    *_headerSize = _pos;
+
+    memcpy(stream + _pos, deflateData, sizeof(deflateData));
+    _pos += sizeof(deflateData);
+    putLe32(stream + _pos, _crc);
+    putLe32(stream + _pos + 4, _size);
+
+    return _pos + 8;
+}
+
+// Decode the data after the header in chunks (chunk sizes from the list, last one is repeated). Returns the number
+// of decoded bytes, decoded data is in decoded[].
+static uint32_t decodeChunks(const uint8_t *_data, uint32_t _len, const uint32_t *_chunks, int _chunkCount)
+{
+    uint32_t _pos = 0;
+    uint32_t _decodedLen = 0;
+    int _chunk = 0;
+
+    inflater.begin();
+    while ((_pos < _len) && !inflater.done() && !inflater.error())
+    {
+        // Next chunk, like the next packet from the modem.
+        uint32_t _chunkLen = _chunks[_chunk];
+        if (_chunk < (_chunkCount - 1))
+            _chunk++;
+        if (_chunkLen > (_len - _pos))
+            _chunkLen = _len - _pos;
+
+        // Decode until the whole chunk is used and there is no more output.
+        const uint8_t *_in = _data + _pos;
+        uint32_t _inLeft = _chunkLen;
+        while (true)
+        {
+            uint32_t _inBytes = _inLeft;
+            const uint8_t *_out = NULL;
+            uint32_t _outBytes = 0;
+            if (!inflater.decode(_in, &_inBytes, &_out, &_outBytes))
+                break;
+            if ((_decodedLen + _outBytes) > sizeof(decoded))
+                return 0;
+            memcpy(decoded + _decodedLen, _out, _outBytes);
+            _decodedLen += _outBytes;
+            _in += _inBytes;
+            _inLeft -= _inBytes;
+            if (inflater.done() || ((_inBytes == 0) && (_outBytes == 0)))
+                break;
+        }
+        _pos += _chunkLen;
+    }
+
+    return _decodedLen;
+}
+
+// Check that the stream is decoded to the test content.
+static bool decodedOk(uint32_t _len)
+{
+    return inflater.done() && !inflater.error() && (_len == CONTENT_SIZE) && (memcmp(decoded, content, _len) == 0);
+}
+
+static void testHeader()
+{
+    // Every combination of the optional fields.
+    for (uint8_t _flags = 0; _flags < 0x20; _flags += 2)
+    {
+        uint32_t _headerSize = 0;
+        uint32_t _len = makeStream(_flags, CONTENT_CRC, CONTENT_SIZE, &_headerSize);
+        TEST_CHECK(GzipInflater::headerSize(stream, _len) == _headerSize);
+
+        // Header that is not complete is not accepted.
+        for (uint32_t i = 0; i < _headerSize; i++)
+            TEST_CHECK(GzipInflater::headerSize(stream, i) == 0);
+    }
+
+    // Not a gzip data: signature, compression method and reserved flags.
+    uint32_t _headerSize = 0;
+    uint32_t _len = makeStream(0, CONTENT_CRC, CONTENT_SIZE, &_headerSize);
+    const uint8_t _bad[][2] = {{0, 0x1E}, {1, 0x8C}, {2, 7}, {3, 0x20}, {3, 0x80}};
+    for (unsigned int i = 0; i < (sizeof(_bad) / sizeof(_bad[0])); i++)
+    {
+        uint8_t _saved = stream[_bad[i][0]];
+        stream[_bad[i][0]] = _bad[i][1];
+        TEST_CHECK(GzipInflater::headerSize(stream, _len) == 0);
+        stream[_bad[i][0]] = _saved;
+    }
+    TEST_CHECK(GzipInflater::headerSize(NULL, _len) == 0);
+}
+
+static void testSplits()
+{
+    for (uint8_t _flags = 0; _flags < 0x20; _flags += 2)
+    {
+        uint32_t _headerSize = 0;
+        uint32_t _len = makeStream(_flags, CONTENT_CRC, CONTENT_SIZE, &_headerSize);
+        const uint8_t *_data = stream + _headerSize;
+        uint32_t _dataLen = _len - _headerSize;
+
+        // Whole stream at once and byte by byte.
+        uint32_t _whole[] = {_dataLen};
+        TEST_CHECK(decodedOk(decodeChunks(_data, _dataLen, _whole, 1)));
+        uint32_t _bytes[] = {1};
+        TEST_CHECK(decodedOk(decodeChunks(_data, _dataLen, _bytes, 1)));
+
+        // Every split into two chunks (with the first header only, it does not change the data).
+        if (_flags != 0)
+            continue;
+        for (uint32_t i = 1; i < _dataLen; i++)
+        {
+            uint32_t _two[] = {i, _dataLen};
+            TEST_CHECK(decodedOk(decodeChunks(_data, _dataLen, _two, 2)));
+        }
+    }
+
+    // Random chunk sizes (up to the modem packet size).
+    uint32_t _headerSize = 0;
+    uint32_t _len = makeStream(FNAME, CONTENT_CRC, CONTENT_SIZE, &_headerSize);
+    for (int n = 0; n < 200; n++)
+    {
+        uint32_t _chunks[64];
+        for (int i = 0; i < 64; i++)
+            _chunks[i] = 1 + (rand() % ((n & 1) ? 16 : 4096));
+        TEST_CHECK(decodedOk(decodeChunks(stream + _headerSize, _len - _headerSize, _chunks, 64)));
+    }
+}
+
+static void testBroken()
+{
+    uint32_t _headerSize = 0;
+    uint32_t _len = 0;
+    uint32_t _two[2];
+
+    // Wrong CRC32 or size in the trailer, in every split of the trailer.
+    const uint32_t _trailers[][2] = {{CONTENT_CRC ^ 1, CONTENT_SIZE}, {CONTENT_CRC, CONTENT_SIZE + 1}, {0, 0}};
+    for (int t = 0; t < 3; t++)
+    {
+        _len = makeStream(0, _trailers[t][0], _trailers[t][1], &_headerSize);
+        for (uint32_t i = _len - 16; i < _len; i++)
+        {
+            _two[0] = i - _headerSize;
+            _two[1] = _len;
+            decodeChunks(stream + _headerSize, _len - _headerSize, _two, 2);
+            TEST_CHECK(inflater.error() && !inflater.done());
+        }
+    }
+
+    // Stream without the whole trailer (or the deflate data) is not complete, but it's not an error until the stream
+    // ends (that is known only to the caller).
+    _len = makeStream(0, CONTENT_CRC, CONTENT_SIZE, &_headerSize);
+    for (uint32_t _cut = 1; _cut <= 16; _cut++)
+    {
+        _two[0] = _len - _headerSize - _cut;
+        decodeChunks(stream + _headerSize, _len - _headerSize - _cut, _two, 1);
+        TEST_CHECK(!inflater.done() && !inflater.error());
+    }
+
+    // Data after the end of the gzip stream is ignored.
+    memset(stream + _len, 0xAA, 16);
+    _two[0] = _len - _headerSize + 16;
+    TEST_CHECK(decodedOk(decodeChunks(stream + _headerSize, _len - _headerSize + 16, _two, 1)));
+
+    // Broken deflate data must never be reported as the complete stream.
+    for (int n = 0; n < 500; n++)
+    {
+        _len = makeStream(0, CONTENT_CRC, CONTENT_SIZE, &_headerSize);
+        uint32_t _bytePos = _headerSize + (rand() % sizeof(deflateData));
+        stream[_bytePos] ^= 1 << (rand() % 8);
+        uint32_t _chunks[] = {1 + (uint32_t)(rand() % 512)};
+        decodeChunks(stream + _headerSize, _len - _headerSize, _chunks, 1);
+        TEST_CHECK(!inflater.done());
+    }
+}
+
+int main()
+{
+    srand(1);
+    makeContent();
+    testHeader();
+    testSplits();
+    testBroken();
+    TEST_END("gzipTest");
+}
@@ -0,0 +1,244 @@
+/**
+ **************************************************
+ *
+ * @file        jsonStreamParserTest.cpp
+ * @brief       Host test for the streaming JSON parser. Each document
+ *              is fed in every possible split into two chunks and byte
+ *              by byte, the values sent to the callbacks and the result
+ *              must be the same as for the whole document. Covers the
+ *              path filters, number grammar, escapes, surrogate pairs
+ *              and top-level scalars.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+#include <string.h>
+
+#include "system/jsonStreamParser.h"
+#include "testHelpers.h"
+
+// One test document.
+typedef struct
+{
+    const char *filters;
+    const char *json;
+    bool valid;
+    const char *expected;
+} Document;
+
+// Filters are separated with '|'. Expected values are logged as "path=value:type;" (NULL = not checked).
+static const Document documents[] = {
+    // Path filters.
+    {"daily[*].temp.max|current.*|daily[1]",
+     "{\"current\":{\"temp\":21.5,\"rain\":null,\"desc\":\"sunny\"},\"daily\":[{\"temp\":{\"min\":10,\"max\":22}},"
+     "{\"temp\":{\"min\":-3,\"max\":-1.5e1}}],\"other\":[1,2]}",
+     true,
+     "current.temp=21.5:2;current.rain=null:0;current.desc=sunny:3;daily[0].temp.max=22:2;"
+     "daily[1].temp.max=-1.5e1:2;daily[1]=:4;"},
+    {"[*]|[2][*].a", " [ true , false ,[{\"a\":\"x\"},{\"b\":1}], [] ] ", true,
+     "[0]=true:1;[1]=false:1;[2][0].a=x:3;[2]=:5;[3]=:5;"},
+    {"a.*.c|a.b", "{\"a\":{\"b\":{\"c\":1},\"d\":{\"c\":2,\"e\":3},\"f\":[{\"c\":4}]}}", true,
+     "a.b.c=1:2;a.b=:4;a.d.c=2:2;"},
+    {"", "{}", true, "=:4;"},
+    {"x", "{\"x\":1,}", false, NULL},
+    {"x", "{\"x\":1]", false, NULL},
+    {"x", "{\"x\" 1}", false, NULL},
+    {"[*]", "[1,2", false, NULL},
+    {"[*]", "[1 2]", false, NULL},
+    {"", "{} {}", false, NULL},
+
+    // Numbers.
+    {"[*]", "[0,-0,1.5e+10,0e0,-12.5E-3,10,0.25]", true,
+     "[0]=0:2;[1]=-0:2;[2]=1.5e+10:2;[3]=0e0:2;[4]=-12.5E-3:2;[5]=10:2;[6]=0.25:2;"},
+    {"[*]", "[01]", false, NULL},
+    {"[*]", "[-01]", false, NULL},
+    {"[*]", "[1.]", false, NULL},
+    {"[*]", "[1.e5]", false, NULL},
+    {"[*]", "[-]", false, NULL},
+    {"[*]", "[1e]", false, NULL},
+    {"[*]", "[1e+-5]", false, NULL},
+    {"[*]", "[+1]", false, NULL},
+    {"[*]", "[--1]", false, NULL},
+    {"[*]", "[.5]", false, NULL},
+    {"[*]", "[1.2.3]", false, NULL},
+    {"[*]", "[1e5e5]", false, NULL},
+    {"[*]", "[1-2]", false, NULL},
+
+    // Escapes.
+    {"s", "{\"s\":\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\"}", true, "s=a\"b\\c/d\b\f\n\r\t:3;"},
+    {"s", "{\"s\":\"\\u0041\\u00e9\\u20AC\"}", true, "s=A\xC3\xA9\xE2\x82\xAC:3;"},
+    {"k\xC3\xA9y", "{\"k\\u00e9y\":1}", true, "k\xC3\xA9y=1:2;"},
+    {"s", "{\"s\":\"\\x\"}", false, NULL},
+    {"s", "{\"s\":\"\\'\"}", false, NULL},
+    {"s", "{\"s\":\"\\u12G4\"}", false, NULL},
+    {"s", "{\"s\":\"\\u123\"}", false, NULL},
+    {"s", "{\"s\":\"a\nb\"}", false, NULL},
+    {"s", "{\"s\":\"abc}", false, NULL},
+
+    // Surrogate pairs (surrogate without its pair is U+FFFD).
+    {"s", "{\"s\":\"\\ud83d\\ude00\"}", true, "s=\xF0\x9F\x98\x80:3;"},
+    {"s", "{\"s\":\"\\uD83D\\uDE00x\"}", true, "s=\xF0\x9F\x98\x80x:3;"},
+    {"s", "{\"s\":\"\\ud83dx\"}", true, "s=\xEF\xBF\xBDx:3;"},
+    {"s", "{\"s\":\"\\ud83d\\u0041\"}", true, "s=\xEF\xBF\xBD\x41:3;"},
+    {"s", "{\"s\":\"\\ud83d\\n\"}", true, "s=\xEF\xBF\xBD\n:3;"},
+    {"s", "{\"s\":\"\\ud83d\"}", true, "s=\xEF\xBF\xBD:3;"},
+    {"s", "{\"s\":\"\\ude00a\"}", true, "s=\xEF\xBF\xBD\x61:3;"},
+    {"s", "{\"s\":\"\\ud83d\\ud83d\\ude00\"}", true, "s=\xEF\xBF\xBD\xF0\x9F\x98\x80:3;"},
+    {"s|t", "{\"s\":\"\\ud83d\",\"t\":\"\\ude00\"}", true, "s=\xEF\xBF\xBD:3;t=\xEF\xBF\xBD:3;"},
+
+    // Top-level scalars (number and literal end with the document).
+    {"", "42", true, "=42:2;"},
+    {"", " -0.5e-2 ", true, "=-0.5e-2:2;"},
+    {"", "true", true, "=true:1;"},
+    {"", "null", true, "=null:0;"},
+    {"", "\"text\"", true, "=text:3;"},
+    {"", "tru", false, NULL},
+    {"", "nul1", false, NULL},
+    {"", "-", false, NULL},
+    {"", "1.", false, NULL},
+    {"", "42 x", false, NULL},
+    {"", "42,", false, NULL},
+    {"", "\"a\" \"b\"", false, NULL},
+    {"", "", false, NULL},
+    {"", "  ", false, NULL},
+};
+
+// Log of the values sent to the callbacks.
+static char valueLog[1024];
+
+// Callback for all filters, adds the value to the log.
+static void logValue(const char *_path, const char *_value, uint8_t _type)
+{
+    size_t _len = strlen(valueLog);
+    snprintf(valueLog + _len, sizeof(valueLog) - _len, "%s=%s:%u;", _path, _value, _type);
+}
+
+// Split the filters of the document and add them to the parser (strings must stay valid while parsing).
+static void addFilters(JsonStreamParser *_parser, const char *_filters, char _buffer[][64])
+{
+    int _n = 0;
+    const char *_start = _filters;
+    while (true)
+    {
+        const char *_end = strchr(_start, '|');
+        size_t _len = (_end != NULL) ? (size_t)(_end - _start) : strlen(_start);
+        memcpy(_buffer[_n], _start, _len);
+        _buffer[_n][_len] = '\0';
+        _parser->addFilter(_buffer[_n], logValue);
+        _n++;
+        if (_end == NULL)
+            break;
+        _start = _end + 1;
+    }
+}
+
+// Parse the document in the chunks that end at the given lengths. Returns the result of finish().
+static bool parseSplit(const Document *_d, const size_t *_ends, size_t _numberOfEnds)
+{
+    static JsonStreamParser _parser;
+    char _filters[JSON_STREAM_MAX_FILTERS][64];
+
+    _parser.clearFilters();
+    addFilters(&_parser, _d->filters, _filters);
+    _parser.begin();
+    valueLog[0] = '\0';
+
+    size_t _pos = 0;
+    for (size_t i = 0; i < _numberOfEnds; i++)
+    {
+        _parser.feed(_d->json + _pos, _ends[i] - _pos);
+        _pos = _ends[i];
+    }
+
+    bool _done = _parser.finish();
+
+    // Parser stays in the error state until begin(), only whitespace can follow the complete document.
+    TEST_CHECK(_done != _parser.error());
+    TEST_CHECK(_parser.feed(" ", 1) == _done);
+
+    return _done;
+}
+
+static void testDocument(const Document *_d)
+{
+    size_t _len = strlen(_d->json);
+    char _wholeLog[sizeof(valueLog)];
+
+    // Whole document at once.
+    size_t _whole[] = {_len};
+    bool _done = parseSplit(_d, _whole, 1);
+    TEST_CHECK(_done == _d->valid);
+    if (_done != _d->valid)
+        printf("  document: %s\n", _d->json);
+    if (_d->expected != NULL)
+    {
+        TEST_CHECK(strcmp(valueLog, _d->expected) == 0);
+        if (strcmp(valueLog, _d->expected) != 0)
+            printf("  got: %s\n  expected: %s\n", valueLog, _d->expected);
+    }
+    strcpy(_wholeLog, valueLog);
+
+    // Every split into two chunks (including the empty ones).
+    for (size_t i = 0; i <= _len; i++)
+    {
+        size_t _two[] = {i, _len};
+        TEST_CHECK(parseSplit(_d, _two, 2) == _done);
+        TEST_CHECK(strcmp(valueLog, _wholeLog) == 0);
+    }
+
+    // Byte by byte.
+    size_t _ends[512];
+    for (size_t i = 0; i < _len; i++)
+        _ends[i] = i + 1;
+    TEST_CHECK(parseSplit(_d, _ends, _len) == _done);
+    TEST_CHECK(strcmp(valueLog, _wholeLog) == 0);
+}
+
+static void testIncomplete()
+{
+    JsonStreamParser _parser;
+
+    // Top-level number is not complete until finish(), more digits could follow.
+    _parser.begin();
+    _parser.feed("42", 2);
+    TEST_CHECK(!_parser.done() && !_parser.error());
+    _parser.feed("0", 1);
+    TEST_CHECK(_parser.finish());
+
+    // Object or string is complete at its last char.
+    _parser.begin();
+    _parser.feed("{\"a\":[1]}", 9);
+    TEST_CHECK(_parser.done());
+    _parser.begin();
+    _parser.feed("\"\\ud83d", 7);
+    TEST_CHECK(!_parser.done() && !_parser.error());
+    _parser.feed("\"", 1);
+    TEST_CHECK(_parser.done());
+
+    // index() of the innermost array.
+    static int _indexes[8];
+    static int _indexCount;
+    static JsonStreamParser *_current;
+    _current = &_parser;
+    _indexCount = 0;
+    _parser.clearFilters();
+    _parser.addFilter("[*].v[*]", [](const char *, const char *, uint8_t) {
+        if (_indexCount < 8)
+            _indexes[_indexCount++] = _current->index();
+    });
+    _parser.begin();
+    const char *_json = "[{\"v\":[5]},{\"v\":[6,7]}]";
+    _parser.feed(_json, strlen(_json));
+    TEST_CHECK(_parser.finish());
+    TEST_CHECK((_indexCount == 3) && (_indexes[0] == 0) && (_indexes[1] == 0) && (_indexes[2] == 1));
+}
+
+int main()
+{
+    for (size_t i = 0; i < (sizeof(documents) / sizeof(documents[0])); i++)
+        testDocument(&documents[i]);
+    testIncomplete();
+    TEST_END("jsonStreamParserTest");
+}
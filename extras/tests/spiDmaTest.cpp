@@ -0,0 +1,414 @@
+/**
+ **************************************************
+ *
+ * @file        spiDmaTest.cpp
+ * @brief       Host test for the DMA transport of the ESP32 SPI. STM32
+ *              SPI, DMA and GPIO are mocked, the mock of the ESP32 SPI
+ *              slave is on the other side of the bus. Interrupts are
+ *              delivered only while the CPU sleeps in WFI and only when
+ *              they are not masked, same as on the STM32. Built twice,
+ *              with and without the registered HAL SPI callbacks.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+#include <string.h>
+
+#include "stm32System/stm32SpiDma.h"
+#include "system/wifi/esp32SpiAtTypedefs.h"
+#include "testHelpers.h"
+
+// Max. amount of data the slave mock can send or receive.
+#define SLAVE_BUFFER_SIZE 16384
+
+// Max. number of the packets the slave mock remembers.
+#define SLAVE_MAX_PACKETS 64
+
+// Mock of the ESP32 SPI slave. It only follows the packet format (3 byte header + data), handshake and
+// the slave status are not used by the DMA transport.
+static struct
+{
+    // Data received with INKPLATE_ESP32_SPI_CMD_MASTER_SEND.
+    uint8_t received[SLAVE_BUFFER_SIZE];
+    uint32_t receivedLen;
+
+    // Data sent with INKPLATE_ESP32_SPI_CMD_MASTER_READ_DATA.
+    uint8_t toSend[SLAVE_BUFFER_SIZE];
+    uint32_t sentLen;
+
+    // Command of every packet, in the order they came.
+    uint8_t commands[SLAVE_MAX_PACKETS];
+    uint32_t packets;
+
+    // Packets with the wrong header or without the chip select.
+    uint32_t badPackets;
+} slave;
+
+// Mock of the STM32 side.
+static SPI_HandleTypeDef hspi;
+static GPIO_TypeDef gpioF;
+uint32_t DMA1_Stream0_Instance;
+uint32_t DMA1_Stream1_Instance;
+static bool csLow = false;
+static uint32_t primask = 0;
+static unsigned long now = 0;
+
+// DMA transfer in progress (SPI reads TX buffer and writes RX buffer when it ends).
+static struct
+{
+    bool active;
+    uint8_t *tx;
+    uint8_t *rx;
+    uint16_t len;
+    bool failNext;
+} dma;
+
+// Interrupt that came while the CPU was sleeping (runs when the interrupts are unmasked).
+static bool irqPending = false;
+
+// Checks of the DMA buffer handling.
+static const uint8_t *cleanedAddress = NULL;
+static uint32_t cleanedLen = 0;
+static uint32_t invalidates = 0;
+static uint32_t notCleaned = 0;
+static uint32_t aborts = 0;
+
+#if (USE_HAL_SPI_REGISTER_CALLBACKS == 1)
+#define TEST_NAME "spiDmaCallbackTest"
+#else
+#define TEST_NAME "spiDmaTest"
+#endif
+
+// One SPI transfer, seen from the ESP32 side.
+static void slaveTransfer(const uint8_t *_mosi, uint8_t *_miso, uint16_t _len)
+{
+    if (!csLow || (_len < STM32_SPI_DMA_HEADER_SIZE) || (_mosi[1] != 0) || (_mosi[2] != 0))
+        slave.badPackets++;
+
+    uint8_t _cmd = _mosi[0];
+    uint16_t _dataLen = _len - STM32_SPI_DMA_HEADER_SIZE;
+    if (slave.packets < SLAVE_MAX_PACKETS)
+        slave.commands[slave.packets] = _cmd;
+    slave.packets++;
+
+    if (_cmd == INKPLATE_ESP32_SPI_CMD_MASTER_SEND)
+    {
+        memcpy(slave.received + slave.receivedLen, _mosi + STM32_SPI_DMA_HEADER_SIZE, _dataLen);
+        slave.receivedLen += _dataLen;
+    }
+
+    if (_miso != NULL)
+    {
+        // Nothing is sent during the header.
+        memset(_miso, 0xFF, STM32_SPI_DMA_HEADER_SIZE);
+        if (_cmd == INKPLATE_ESP32_SPI_CMD_MASTER_READ_DATA)
+        {
+            memcpy(_miso + STM32_SPI_DMA_HEADER_SIZE, slave.toSend + slave.sentLen, _dataLen);
+            slave.sentLen += _dataLen;
+        }
+    }
+}
+
+// Ends the DMA transfer (same order as the STM32: data is moved, then the state is set and callbacks are called).
+static void dmaEnd(bool _error)
+{
+    dma.active = false;
+    if (_error)
+    {
+        hspi.ErrorCode = HAL_SPI_ERROR_DMA;
+        hspi.State = HAL_SPI_STATE_READY;
+#if (USE_HAL_SPI_REGISTER_CALLBACKS == 1)
+        if (hspi.ErrorCallback)
+            hspi.ErrorCallback(&hspi);
+#endif
+        return;
+    }
+
+    // Data is sent and received at the same time, copy TX first since it can be the same buffer.
+    static uint8_t _mosi[STM32_SPI_DMA_BUFFER_SIZE];
+    memcpy(_mosi, dma.tx, dma.len);
+    slaveTransfer(_mosi, dma.rx, dma.len);
+
+    HAL_SPI_StateTypeDef _state = hspi.State;
+    hspi.ErrorCode = HAL_SPI_ERROR_NONE;
+    hspi.State = HAL_SPI_STATE_READY;
+#if (USE_HAL_SPI_REGISTER_CALLBACKS == 1)
+    if ((_state == HAL_SPI_STATE_BUSY_TX) && hspi.TxCpltCallback)
+        hspi.TxCpltCallback(&hspi);
+    if ((_state == HAL_SPI_STATE_BUSY_TX_RX) && hspi.TxRxCpltCallback)
+        hspi.TxRxCpltCallback(&hspi);
+#else
+    (void)_state;
+#endif
+}
+
+// Run the interrupt handler for the DMA transfer in progress.
+static void runInterrupt()
+{
+    irqPending = false;
+    if (!dma.active)
+        return;
+
+    // Errors come from the DMA stream, end of the transfer from the SPI.
+    if (dma.failNext)
+    {
+        dma.failNext = false;
+        DMA1_Stream1_IRQHandler();
+    }
+    else
+    {
+        SPI5_IRQHandler();
+    }
+}
+
+unsigned long millis()
+{
+    return now++;
+}
+
+uint32_t __get_PRIMASK()
+{
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    primask = priMask;
+    if (!primask && irqPending)
+        runInterrupt();
+}
+
+void __disable_irq()
+{
+    primask = 1;
+}
+
+void __enable_irq()
+{
+    __set_PRIMASK(0);
+}
+
+void __WFI()
+{
+    // DMA transfer ends while the CPU sleeps.
+    if (dma.active)
+        irqPending = true;
+    if (!primask && irqPending)
+        runInterrupt();
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if ((GPIOx == &gpioF) && (GPIO_Pin == GPIO_PIN_6))
+        csLow = (PinState == GPIO_PIN_RESET);
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type, uint32_t, uint32_t)
+{
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type)
+{
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *)
+{
+    return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+    if (dma.active && (hdma == hspi.hdmatx))
+        dmaEnd(true);
+}
+
+#if (USE_HAL_SPI_REGISTER_CALLBACKS == 1)
+HAL_StatusTypeDef HAL_SPI_RegisterCallback(SPI_HandleTypeDef *hspi, HAL_SPI_CallbackIDTypeDef CallbackID,
+                                           pSPI_CallbackTypeDef pCallback)
+{
+    if (CallbackID == HAL_SPI_TX_COMPLETE_CB_ID)
+        hspi->TxCpltCallback = pCallback;
+    else if (CallbackID == HAL_SPI_TX_RX_COMPLETE_CB_ID)
+        hspi->TxRxCpltCallback = pCallback;
+    else if (CallbackID == HAL_SPI_ERROR_CB_ID)
+        hspi->ErrorCallback = pCallback;
+    else
+        return HAL_ERROR;
+    return HAL_OK;
+}
+#endif
+
+// Start of the DMA transfer, buffer must be written from the D-Cache before.
+static HAL_StatusTypeDef dmaStart(SPI_HandleTypeDef *_hspi, uint8_t *_tx, uint8_t *_rx, uint16_t _len,
+                                  HAL_SPI_StateTypeDef _state)
+{
+    if ((_hspi != &hspi) || (hspi.State != HAL_SPI_STATE_READY))
+        return HAL_BUSY;
+
+    if ((_tx < cleanedAddress) || ((_tx + _len) > (cleanedAddress + cleanedLen)))
+        notCleaned++;
+    cleanedAddress = NULL;
+    cleanedLen = 0;
+
+    dma.active = true;
+    dma.tx = _tx;
+    dma.rx = _rx;
+    dma.len = _len;
+    hspi.State = _state;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size)
+{
+    return dmaStart(hspi, pData, NULL, Size, HAL_SPI_STATE_BUSY_TX);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData,
+                                              uint16_t Size)
+{
+    return dmaStart(hspi, pTxData, pRxData, Size, HAL_SPI_STATE_BUSY_TX_RX);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi)
+{
+    aborts++;
+    dma.active = false;
+    irqPending = false;
+    hspi->State = HAL_SPI_STATE_READY;
+    return HAL_OK;
+}
+
+void HAL_SPI_IRQHandler(SPI_HandleTypeDef *)
+{
+    if (dma.active)
+        dmaEnd(false);
+}
+
+void stm32CacheClean(const volatile void *_address, uint32_t _len)
+{
+    cleanedAddress = (const uint8_t *)_address;
+    cleanedLen = _len;
+}
+
+void stm32CacheCleanInvalidate(const volatile void *_address, uint32_t _len)
+{
+    stm32CacheClean(_address, _len);
+    invalidates++;
+}
+
+void stm32CacheInvalidate(const volatile void *, uint32_t)
+{
+    invalidates++;
+}
+
+// Fill the buffer with pseudo-random bytes.
+static void randomFill(uint8_t *_buffer, uint32_t _len)
+{
+    for (uint32_t i = 0; i < _len; i++)
+        _buffer[i] = rand() & 0xFF;
+}
+
+// Send the data to the slave in the chunks, same as WiFiClass::dataSend().
+static bool sendData(const uint8_t *_data, uint32_t _len)
+{
+    for (uint32_t _offset = 0; _offset < _len; _offset += INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER)
+    {
+        uint32_t _chunk = _len - _offset;
+        if (_chunk > INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER)
+            _chunk = INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER;
+        if (!stm32SpiDmaQueue(INKPLATE_ESP32_SPI_CMD_MASTER_SEND, 0, 0, (uint8_t *)_data + _offset, _chunk, false))
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    static uint8_t data[SLAVE_BUFFER_SIZE];
+    static uint8_t readBuffer[SLAVE_BUFFER_SIZE];
+
+    srand(1234);
+    hspi.State = HAL_SPI_STATE_READY;
+    TEST_CHECK(stm32SpiDmaInit(&hspi, &gpioF, GPIO_PIN_6));
+
+    // Status and end of transfer packets are short, CPU sends them. Too long packets do not fit into the buffer.
+    uint8_t status[4] = {0};
+    TEST_CHECK(!stm32SpiDmaQueue(INKPLATE_ESP32_SPI_CMD_REQ_SLAVE_INFO, 4, 0, status, sizeof(status), true));
+    TEST_CHECK(!stm32SpiDmaQueue(INKPLATE_ESP32_SPI_CMD_MASTER_SEND_DONE, 0, 0, NULL, 0, false));
+    TEST_CHECK(!stm32SpiDmaQueue(INKPLATE_ESP32_SPI_CMD_MASTER_SEND, 0, 0, data,
+                                 INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER + 2, false));
+    TEST_CHECK(slave.packets == 0);
+
+    // Send more than one chunk. All chunks are queued, then CPU sleeps until they are sent.
+    randomFill(data, 10000);
+    TEST_CHECK(sendData(data, 10000));
+    TEST_CHECK(stm32SpiDmaBusy());
+    TEST_CHECK(stm32SpiDmaWait());
+    TEST_CHECK(!stm32SpiDmaBusy());
+    TEST_CHECK(slave.packets == 3);
+    TEST_CHECK(slave.receivedLen == 10000);
+    TEST_CHECK(memcmp(slave.received, data, 10000) == 0);
+    TEST_CHECK(!csLow);
+    TEST_CHECK(primask == 0);
+
+    // Read the data from the slave. Header is not copied into the buffer.
+    randomFill(slave.toSend, SLAVE_BUFFER_SIZE);
+    memset(readBuffer, 0, sizeof(readBuffer));
+    uint32_t invalidatesBefore = invalidates;
+    TEST_CHECK(stm32SpiDmaQueue(INKPLATE_ESP32_SPI_CMD_MASTER_READ_DATA, 0, 0, readBuffer,
+                                INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER, true));
+    TEST_CHECK(stm32SpiDmaWait());
+    TEST_CHECK(memcmp(readBuffer, slave.toSend, INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER) == 0);
+    TEST_CHECK(readBuffer[INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER] == 0);
+    TEST_CHECK(invalidates > invalidatesBefore);
+
+    // Mixed packets are sent in the same order as they are queued.
+    uint32_t packetsBefore = slave.packets;
+    uint32_t readBefore = slave.sentLen;
+    TEST_CHECK(stm32SpiDmaQueue(INKPLATE_ESP32_SPI_CMD_MASTER_SEND, 0, 0, data, 100, false));
+    TEST_CHECK(stm32SpiDmaQueue(INKPLATE_ESP32_SPI_CMD_MASTER_READ_DATA, 0, 0, readBuffer, 200, true));
+    TEST_CHECK(stm32SpiDmaQueue(INKPLATE_ESP32_SPI_CMD_MASTER_SEND, 0, 0, data + 100, 50, false));
+    TEST_CHECK(stm32SpiDmaWait());
+    TEST_CHECK(slave.packets == packetsBefore + 3);
+    TEST_CHECK(slave.commands[packetsBefore] == INKPLATE_ESP32_SPI_CMD_MASTER_SEND);
+    TEST_CHECK(slave.commands[packetsBefore + 1] == INKPLATE_ESP32_SPI_CMD_MASTER_READ_DATA);
+    TEST_CHECK(slave.commands[packetsBefore + 2] == INKPLATE_ESP32_SPI_CMD_MASTER_SEND);
+    TEST_CHECK(memcmp(readBuffer, slave.toSend + readBefore, 200) == 0);
+    TEST_CHECK(memcmp(slave.received + 10000, data, 150) == 0);
+
+    // Interrupt of the other SPI user (microSD card) is ignored.
+    packetsBefore = slave.packets;
+    SPI5_IRQHandler();
+    DMA1_Stream0_IRQHandler();
+    TEST_CHECK(!stm32SpiDmaBusy());
+    TEST_CHECK(slave.packets == packetsBefore);
+
+    // DMA error drops the queue and it's reported once.
+    dma.failNext = true;
+    TEST_CHECK(sendData(data, 5000));
+    TEST_CHECK(!stm32SpiDmaWait());
+    TEST_CHECK(!stm32SpiDmaBusy());
+    TEST_CHECK(!csLow);
+    TEST_CHECK(stm32SpiDmaWait());
+    TEST_CHECK(sendData(data, 64));
+    TEST_CHECK(stm32SpiDmaWait());
+
+    // Waiting with the interrupts disabled ends with the timeout, but the interrupts stay disabled.
+    uint32_t abortsBefore = aborts;
+    TEST_CHECK(sendData(data, 64));
+    __disable_irq();
+    TEST_CHECK(!stm32SpiDmaWait(5));
+    TEST_CHECK(primask == 1);
+    TEST_CHECK(aborts == abortsBefore + 1);
+    __enable_irq();
+    TEST_CHECK(!stm32SpiDmaBusy());
+    TEST_CHECK(!csLow);
+
+    // Every DMA transfer had a valid header, the chip select and the buffer written from the D-Cache.
+    TEST_CHECK(slave.badPackets == 0);
+    TEST_CHECK(notCleaned == 0);
+
+    TEST_END(TEST_NAME);
+}
@@ -0,0 +1,25 @@
+/**
+ **************************************************
+ *
+ * @file        Arduino.h
+ * @brief       Minimal Arduino header for the host tests. Only what
+ *              the tested STM32 files use is here, time is provided
+ *              by the test itself.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add a header guard.
+#ifndef __INKPLATE_TEST_ARDUINO_H__
+#define __INKPLATE_TEST_ARDUINO_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Time in milliseconds (defined in the test).
+unsigned long millis();
+
+#endif
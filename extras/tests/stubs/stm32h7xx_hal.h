@@ -0,0 +1,162 @@
+/**
+ **************************************************
+ *
+ * @file        stm32h7xx_hal.h
+ * @brief       Minimal STM32H7 HAL for the host tests. Types and
+ *              constants are here, functions are defined in the test
+ *              (it acts as the SPI, DMA and the device on the bus).
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add a header guard.
+#ifndef __INKPLATE_TEST_STM32H7XX_HAL_H__
+#define __INKPLATE_TEST_STM32H7XX_HAL_H__
+
+#include <stdint.h>
+
+// HAL callback registration is off by default (same as in stm32h7xx_hal_conf.h), test can turn it on.
+#ifndef USE_HAL_SPI_REGISTER_CALLBACKS
+#define USE_HAL_SPI_REGISTER_CALLBACKS 0
+#endif
+
+typedef enum
+{
+    HAL_OK = 0x00,
+    HAL_ERROR = 0x01,
+    HAL_BUSY = 0x02,
+    HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+// GPIO.
+typedef struct
+{
+    uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+
+// Interrupts.
+typedef enum
+{
+    DMA1_Stream0_IRQn = 11,
+    DMA1_Stream1_IRQn = 12,
+    SPI5_IRQn = 85
+} IRQn_Type;
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+uint32_t __get_PRIMASK();
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq();
+void __enable_irq();
+void __WFI();
+
+// DMA.
+typedef struct
+{
+    uint32_t Request;
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+    uint32_t FIFOMode;
+} DMA_InitTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    DMA_InitTypeDef Init;
+    void *Parent;
+} DMA_HandleTypeDef;
+
+extern uint32_t DMA1_Stream0_Instance;
+extern uint32_t DMA1_Stream1_Instance;
+#define DMA1_Stream0 ((void *)&DMA1_Stream0_Instance)
+#define DMA1_Stream1 ((void *)&DMA1_Stream1_Instance)
+
+#define DMA_REQUEST_SPI5_RX   85U
+#define DMA_REQUEST_SPI5_TX   86U
+#define DMA_PERIPH_TO_MEMORY  0x00000000U
+#define DMA_MEMORY_TO_PERIPH  0x00000040U
+#define DMA_PINC_DISABLE      0x00000000U
+#define DMA_MINC_ENABLE       0x00000400U
+#define DMA_PDATAALIGN_BYTE   0x00000000U
+#define DMA_MDATAALIGN_BYTE   0x00000000U
+#define DMA_NORMAL            0x00000000U
+#define DMA_PRIORITY_HIGH     0x00020000U
+#define DMA_FIFOMODE_DISABLE  0x00000000U
+
+#define __HAL_RCC_DMA1_CLK_ENABLE()
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__)                                                  \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__);                                                           \
+        (__DMA_HANDLE__).Parent = (__HANDLE__);                                                                        \
+    } while (0)
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+// SPI.
+typedef enum
+{
+    HAL_SPI_STATE_RESET = 0x00,
+    HAL_SPI_STATE_READY = 0x01,
+    HAL_SPI_STATE_BUSY_TX = 0x03,
+    HAL_SPI_STATE_BUSY_TX_RX = 0x05,
+    HAL_SPI_STATE_ABORT = 0x07
+} HAL_SPI_StateTypeDef;
+
+#define HAL_SPI_ERROR_NONE (0x00000000UL)
+#define HAL_SPI_ERROR_DMA  (0x00000010UL)
+
+typedef struct __SPI_HandleTypeDef
+{
+    void *Instance;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+    volatile HAL_SPI_StateTypeDef State;
+    volatile uint32_t ErrorCode;
+#if (USE_HAL_SPI_REGISTER_CALLBACKS == 1)
+    void (*TxCpltCallback)(struct __SPI_HandleTypeDef *hspi);
+    void (*TxRxCpltCallback)(struct __SPI_HandleTypeDef *hspi);
+    void (*ErrorCallback)(struct __SPI_HandleTypeDef *hspi);
+#endif
+} SPI_HandleTypeDef;
+
+#if (USE_HAL_SPI_REGISTER_CALLBACKS == 1)
+typedef enum
+{
+    HAL_SPI_TX_COMPLETE_CB_ID = 0x00UL,
+    HAL_SPI_RX_COMPLETE_CB_ID = 0x01UL,
+    HAL_SPI_TX_RX_COMPLETE_CB_ID = 0x02UL,
+    HAL_SPI_ERROR_CB_ID = 0x06UL
+} HAL_SPI_CallbackIDTypeDef;
+
+typedef void (*pSPI_CallbackTypeDef)(SPI_HandleTypeDef *hspi);
+
+HAL_StatusTypeDef HAL_SPI_RegisterCallback(SPI_HandleTypeDef *hspi, HAL_SPI_CallbackIDTypeDef CallbackID,
+                                           pSPI_CallbackTypeDef pCallback);
+#endif
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData,
+                                              uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+void HAL_SPI_IRQHandler(SPI_HandleTypeDef *hspi);
+
+#endif
@@ -0,0 +1,13 @@
+/**
+ **************************************************
+ *
+ * @file        stm32h7xx_hal_dma.h
+ * @brief       Everything is in the minimal stm32h7xx_hal.h of the
+ *              host tests.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+#include "stm32h7xx_hal.h"
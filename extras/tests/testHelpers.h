@@ -0,0 +1,42 @@
+/**
+ **************************************************
+ *
+ * @file        testHelpers.h
+ * @brief       Minimal check macros for the host tests of the parts of
+ *              the library that do not depend on Arduino or STM32 HAL.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add a header guard.
+#ifndef __INKPLATE_TEST_HELPERS_H__
+#define __INKPLATE_TEST_HELPERS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Number of failed checks (each test file has its own).
+static int _testFailures = 0;
+
+// Check the condition, print the location and the condition if it fails.
+#define TEST_CHECK(_cond)                                                                                              \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(_cond))                                                                                                  \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #_cond);                                           \
+            _testFailures++;                                                                                           \
+        }                                                                                                              \
+    } while (0)
+
+// Print the result and return the exit code from main().
+#define TEST_END(_name)                                                                                                \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        printf("%s: %s\n", _name, _testFailures ? "FAILED" : "OK");                                                    \
+        return _testFailures ? 1 : 0;                                                                                  \
+    } while (0)
+
+#endif
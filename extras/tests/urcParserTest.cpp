@@ -0,0 +1,285 @@
+/**
+ **************************************************
+ *
+ * @file        urcParserTest.cpp
+ * @brief       Fuzz test and benchmark for the streaming parser of the
+ *              ESP32 AT messages. Random streams of text lines and
+ *              frames with binary payload are split into the packets at
+ *              random places, parser must return the same lines, frames
+ *              and payload as generated. Random garbage must not make
+ *              the parser read outside of the data. At the end, parsing
+ *              speed of the large HTTP download is measured.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "system/wifi/esp32SpiAtParser.h"
+#include "testHelpers.h"
+
+// Number of random streams and max. number of items (lines or frames) in each of them.
+#define FUZZ_STREAMS   2000
+#define FUZZ_MAX_ITEMS 12
+
+// Max. payload size of one frame.
+#define FUZZ_MAX_PAYLOAD 600
+
+// Size of the benchmark download and of one SPI packet.
+#define BENCH_SIZE        (4 * 1024 * 1024)
+#define BENCH_PACKET_SIZE 4092
+
+// One line or frame, as generated or as parsed.
+typedef struct
+{
+    uint8_t event;
+    uint8_t type;
+    int16_t linkId;
+    std::string topic;
+    std::string data;
+} Item;
+
+// Text lines that ESP32 can send between the frames.
+static const char *lines[] = {"OK", "SEND OK", "WIFI CONNECTED", "WIFI GOT IP", "busy p...", "0,CLOSED", "+CWJAP:1",
+                              "+HTTPCGETSIZE:123", "+MQTTCONNECTED:0,1,\"broker\",\"1883\",\"\",1"};
+
+static uint32_t randomNumber(uint32_t _max)
+{
+    return (uint32_t)rand() % _max;
+}
+
+static std::string randomPayload()
+{
+    std::string _payload;
+    uint32_t _len = randomNumber(FUZZ_MAX_PAYLOAD);
+
+    // Binary data, sometimes with the bytes that look like a new line or a new frame.
+    for (uint32_t i = 0; i < _len; i++)
+    {
+        switch (randomNumber(8))
+        {
+        case 0:
+            _payload += "\r\n";
+            break;
+        case 1:
+            _payload += "+IPD,";
+            break;
+        default:
+            _payload += (char)randomNumber(256);
+        }
+    }
+    return _payload;
+}
+
+// Generate the random stream and the items the parser must return.
+static std::string generateStream(std::vector<Item> *_items)
+{
+    std::string _stream;
+    uint32_t _numberOfItems = 1 + randomNumber(FUZZ_MAX_ITEMS);
+
+    for (uint32_t n = 0; n < _numberOfItems; n++)
+    {
+        Item _item;
+        _item.event = INKPLATE_ESP32_URC_EVENT_FRAME;
+        _item.linkId = -1;
+        std::string _payload = randomPayload();
+        char _header[128];
+
+        switch (randomNumber(7))
+        {
+        case 0: {
+            // Text line, sometimes with the empty line before it.
+            _item.event = INKPLATE_ESP32_URC_EVENT_LINE;
+            _item.type = INKPLATE_ESP32_URC_TYPE_NONE;
+            _item.data = lines[randomNumber(sizeof(lines) / sizeof(lines[0]))];
+            _stream += (randomNumber(2) ? "\r\n" : "") + _item.data + "\r\n";
+            _items->push_back(_item);
+            continue;
+        }
+        case 1:
+            _item.type = INKPLATE_ESP32_URC_TYPE_IPD;
+            snprintf(_header, sizeof(_header), "+IPD,%u:", (unsigned)_payload.size());
+            break;
+        case 2:
+            _item.type = INKPLATE_ESP32_URC_TYPE_IPD;
+            _item.linkId = randomNumber(5);
+            snprintf(_header, sizeof(_header), "+IPD,%d,%u,\"192.168.1.%u\",%u:", _item.linkId,
+                     (unsigned)_payload.size(), randomNumber(255), randomNumber(65536));
+            break;
+        case 3:
+            _item.type = INKPLATE_ESP32_URC_TYPE_HTTPCGET;
+            snprintf(_header, sizeof(_header), "+HTTPCGET:%u,", (unsigned)_payload.size());
+            break;
+        case 4:
+            _item.type = INKPLATE_ESP32_URC_TYPE_HTTPCLIENT;
+            snprintf(_header, sizeof(_header), "+HTTPCLIENT:%u,", (unsigned)_payload.size());
+            break;
+        case 5:
+            _item.type = INKPLATE_ESP32_URC_TYPE_CIPRECVDATA;
+            snprintf(_header, sizeof(_header), "+CIPRECVDATA:%u,", (unsigned)_payload.size());
+            break;
+        default:
+            // Topic can have commas, but not quotes.
+            _item.type = INKPLATE_ESP32_URC_TYPE_MQTTSUBRECV;
+            _item.linkId = 0;
+            _item.topic = randomNumber(2) ? "inkplate/motion" : "a,b:c";
+            snprintf(_header, sizeof(_header), "+MQTTSUBRECV:0,\"%s\",%u,", _item.topic.c_str(),
+                     (unsigned)_payload.size());
+            break;
+        }
+
+        // Payload is followed by CRLF in most of the frames.
+        _item.data = _payload;
+        _stream += _header + _payload + (randomNumber(3) ? "\r\n" : "");
+        _items->push_back(_item);
+    }
+
+    return _stream;
+}
+
+// Parse the stream split into the random packets and collect the lines and frames.
+static void parseStream(AtUrcParser *_parser, const std::string &_stream, uint32_t _maxPacket,
+                        std::vector<Item> *_items)
+{
+    uint32_t _offset = 0;
+    while (_offset < _stream.size())
+    {
+        uint32_t _packetLen = 1 + randomNumber(_maxPacket);
+        if (_packetLen > (_stream.size() - _offset))
+            _packetLen = _stream.size() - _offset;
+
+        // Copy the packet, so reading outside of it is found by the sanitizer.
+        std::vector<uint8_t> _packet(_stream.begin() + _offset, _stream.begin() + _offset + _packetLen);
+        _offset += _packetLen;
+
+        uint32_t _used = 0;
+        while (_used < _packetLen)
+        {
+            AtUrcEvent _event;
+            uint32_t _n = _parser->parse(_packet.data() + _used, _packetLen - _used, &_event);
+            TEST_CHECK((_n != 0) && (_n <= (_packetLen - _used)));
+            if (_n == 0)
+                return;
+
+            if (_event.event == INKPLATE_ESP32_URC_EVENT_PAYLOAD)
+            {
+                const uint8_t *_start = _packet.data() + _used;
+                TEST_CHECK((_event.data >= _start) && ((_event.data + _event.len) <= (_start + _n)));
+                TEST_CHECK(!_items->empty());
+                if (!_items->empty())
+                    _items->back().data.append((const char *)_event.data, _event.len);
+            }
+            else if (_event.event != INKPLATE_ESP32_URC_EVENT_NONE)
+            {
+                Item _item;
+                _item.event = _event.event;
+                _item.type = _event.type;
+                _item.linkId = _event.linkId;
+                if (_event.topic != NULL)
+                    _item.topic.assign(_event.topic, _event.topicLen);
+                if (_event.event == INKPLATE_ESP32_URC_EVENT_LINE)
+                    _item.data.assign((const char *)_event.data, _event.len);
+                _items->push_back(_item);
+            }
+            _used += _n;
+        }
+    }
+}
+
+static bool sameItems(const std::vector<Item> &_a, const std::vector<Item> &_b)
+{
+    if (_a.size() != _b.size())
+        return false;
+
+    for (size_t i = 0; i < _a.size(); i++)
+    {
+        if ((_a[i].event != _b[i].event) || (_a[i].type != _b[i].type) || (_a[i].linkId != _b[i].linkId) ||
+            (_a[i].topic != _b[i].topic) || (_a[i].data != _b[i].data))
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    srand(42);
+    AtUrcParser _parser;
+
+    // Random streams, each one split in the different ways (from the byte by byte to the whole SPI packets).
+    static const uint32_t _maxPackets[] = {1, 3, 64, 4092};
+    for (uint32_t n = 0; n < FUZZ_STREAMS; n++)
+    {
+        std::vector<Item> _expected;
+        std::string _stream = generateStream(&_expected);
+
+        for (uint32_t p = 0; p < sizeof(_maxPackets) / sizeof(_maxPackets[0]); p++)
+        {
+            std::vector<Item> _parsed;
+            _parser.begin();
+            parseStream(&_parser, _stream, _maxPackets[p], &_parsed);
+            TEST_CHECK(sameItems(_expected, _parsed));
+            TEST_CHECK(!_parser.inFrame());
+        }
+    }
+
+    // Random garbage with a lot of frame prefixes. Parser must only stay inside of the data.
+    for (uint32_t n = 0; n < FUZZ_STREAMS; n++)
+    {
+        std::string _stream;
+        uint32_t _len = randomNumber(2000);
+        static const char *_pieces[] = {"+IPD,", "+HTTPCGET:", "+MQTTSUBRECV:", "\"", ",", ":", "\r\n", "99999999999"};
+        while (_stream.size() < _len)
+        {
+            if (randomNumber(2))
+                _stream += _pieces[randomNumber(sizeof(_pieces) / sizeof(_pieces[0]))];
+            else
+                _stream += (char)randomNumber(256);
+        }
+
+        std::vector<Item> _parsed;
+        _parser.begin();
+        parseStream(&_parser, _stream, 1 + randomNumber(100), &_parsed);
+    }
+
+    // Benchmark: large HTTP download in the SPI packets.
+    std::string _download;
+    uint32_t _frames = 0;
+    while (_download.size() < BENCH_SIZE)
+    {
+        _frames++;
+        std::string _payload(BENCH_PACKET_SIZE - 16, 'x');
+        char _header[32];
+        snprintf(_header, sizeof(_header), "+HTTPCGET:%u,", (unsigned)_payload.size());
+        _download += _header + _payload + "\r\n";
+    }
+
+    _parser.begin();
+    uint64_t _payloadBytes = 0;
+    clock_t _start = clock();
+    for (uint32_t _offset = 0; _offset < _download.size(); _offset += BENCH_PACKET_SIZE)
+    {
+        uint32_t _packetLen = ((_download.size() - _offset) < BENCH_PACKET_SIZE) ? (_download.size() - _offset)
+                                                                                  : BENCH_PACKET_SIZE;
+        const uint8_t *_packet = (const uint8_t *)_download.data() + _offset;
+        uint32_t _used = 0;
+        while (_used < _packetLen)
+        {
+            AtUrcEvent _event;
+            _used += _parser.parse(_packet + _used, _packetLen - _used, &_event);
+            if (_event.event == INKPLATE_ESP32_URC_EVENT_PAYLOAD)
+                _payloadBytes += _event.len;
+        }
+    }
+    double _seconds = (double)(clock() - _start) / CLOCKS_PER_SEC;
+    TEST_CHECK(_payloadBytes == ((uint64_t)_frames * (BENCH_PACKET_SIZE - 16)));
+    printf("urcParserTest: %u bytes parsed in %.3f ms (%.1f MB/s on the host)\n", (unsigned)_download.size(),
+           _seconds * 1000.0, _seconds > 0 ? (_download.size() / _seconds / 1e6) : 0.0);
+
+    TEST_END("urcParserTest");
+}
@@ -0,0 +1,514 @@
+#!/usr/bin/env python3
+"""
+Host side tool for the Inkplate 6 Motion remote display (RemoteDisplay class).
+
+It sends dirty rectangles (1 bit or 4 bit, raw, RLE and/or XOR compressed) over UDP,
+resends fragments requested with NACK and measures the frame latency. It also has a
+local stand-in for the board (same protocol, framebuffer in the memory, simulated
+packet loss), so the sender can be checked without the board.
+
+Usage:
+    remote_display.py send <board ip> [--port 5005] [--bpp 1|4] [--image file ...] [--frames 20]
+    remote_display.py emulate [--port 5005] [--bpp 1|4] [--loss 0.1] [--dump out.pgm]
+    remote_display.py selftest [--bpp 1|4] [--loss 0.2]
+
+Packet header (little endian, 20 bytes):
+    'I', 'R', type, flags, frameId (u16), fragIndex (u16), fragCount (u16),
+    fragSize (u16), payloadLen (u16), reserved (u16), timestamp (u32)
+Types: 1 = DATA, 2 = NACK (payload: missing fragment indexes, u16), 3 = ACK,
+       4 = DISPLAYED (payload: board latency in ms, u32). Replies echo the timestamp.
+Frame (reassembled DATA payloads) is a list of rectangles:
+    x (u16), y (u16), w (u16), h (u16), bpp (u8), encoding (u8), dataLen (u32), data
+x and w must be multiple of 8 (1 bit) or 2 (4 bit). Pixels are packed as in the
+framebuffer: 1 bit - MSB is the left pixel, 1 = black; 4 bit - low nibble is the
+left pixel, 0 = black, 15 = white. Encoding flags: 1 = RLE (PackBits), 2 = XOR
+with the current framebuffer.
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+
+SCREEN_WIDTH = 1024
+SCREEN_HEIGHT = 758
+
+HEADER = struct.Struct("<2sBBHHHHHHI")
+RECT = struct.Struct("<HHHHBBI")
+MAGIC = b"IR"
+
+TYPE_DATA = 1
+TYPE_NACK = 2
+TYPE_ACK = 3
+TYPE_DISPLAYED = 4
+
+FLAG_FULL_UPDATE = 0x01
+ENC_RLE = 0x01
+ENC_XOR = 0x02
+
+FRAG_SIZE = 1400
+MAX_FRAGMENTS = 2048
+NACK_TIMEOUT = 0.04
+NACK_MAX = 128
+COALESCE_TIME = 0.05
+
+
+def now_ms():
+    return int(time.monotonic() * 1000) & 0xFFFFFFFF
+
+
+def row_bytes(bpp):
+    return SCREEN_WIDTH * bpp // 8
+
+
+# ---------------------------------------------------------------- Compression
+
+
+def rle_encode(data):
+    """PackBits: n < 128 - copy n + 1 bytes, n > 128 - repeat next byte 257 - n times."""
+    out = bytearray()
+    i = 0
+    n = len(data)
+    while i < n:
+        run = 1
+        while i + run < n and run < 128 and data[i + run] == data[i]:
+            run += 1
+        if run >= 3:
+            out.append(257 - run)
+            out.append(data[i])
+            i += run
+            continue
+        start = i
+        i += run
+        while i < n and i - start < 128:
+            if i + 2 < n and data[i] == data[i + 1] == data[i + 2]:
+                break
+            i += 1
+        out.append(i - start - 1)
+        out += data[start:i]
+    return bytes(out)
+
+
+def rle_decode(data, size):
+    out = bytearray()
+    i = 0
+    while i < len(data) and len(out) < size:
+        n = data[i]
+        i += 1
+        if n == 128:
+            continue
+        if n > 128:
+            if i >= len(data):
+                raise ValueError("RLE repeat without data")
+            out += bytes([data[i]]) * (257 - n)
+            i += 1
+        else:
+            if i + n + 1 > len(data):
+                raise ValueError("RLE literal out of data")
+            out += data[i:i + n + 1]
+            i += n + 1
+    if len(out) != size:
+        raise ValueError("RLE size mismatch")
+    return bytes(out)
+
+
+# ---------------------------------------------------------------- Framebuffer
+
+
+class Framebuffer:
+    """Framebuffer packed in the same way as on the board."""
+
+    def __init__(self, bpp):
+        self.bpp = bpp
+        self.stride = row_bytes(bpp)
+        # 1 bit: 0 = white, 4 bit: 15 = white.
+        self.data = bytearray((0x00 if bpp == 1 else 0xFF) for _ in range(self.stride * SCREEN_HEIGHT))
+
+    def rect(self, x, y, w, h):
+        b = w * self.bpp // 8
+        o = x * self.bpp // 8
+        return b"".join(bytes(self.data[(y + r) * self.stride + o:(y + r) * self.stride + o + b]) for r in range(h))
+
+    def write(self, x, y, w, h, data, xor=False):
+        b = w * self.bpp // 8
+        o = x * self.bpp // 8
+        for r in range(h):
+            p = (y + r) * self.stride + o
+            src = data[r * b:(r + 1) * b]
+            if xor:
+                self.data[p:p + b] = bytes(a ^ c for a, c in zip(self.data[p:p + b], src))
+            else:
+                self.data[p:p + b] = src
+
+    def save_pgm(self, path):
+        pixels = bytearray()
+        for y in range(SCREEN_HEIGHT):
+            row = self.data[y * self.stride:(y + 1) * self.stride]
+            for v in row:
+                if self.bpp == 1:
+                    pixels += bytes(0 if (v >> (7 - i)) & 1 else 255 for i in range(8))
+                else:
+                    pixels += bytes(((v & 0x0F) * 17, (v >> 4) * 17))
+        with open(path, "wb") as f:
+            f.write(b"P5\n%d %d\n255\n" % (SCREEN_WIDTH, SCREEN_HEIGHT))
+            f.write(pixels)
+
+
+def pack_gray(gray, bpp):
+    """Pack 8 bit grayscale pixels (list of rows) into the framebuffer format."""
+    out = bytearray()
+    for row in gray:
+        if bpp == 1:
+            for x in range(0, SCREEN_WIDTH, 8):
+                b = 0
+                for i in range(8):
+                    if row[x + i] < 128:
+                        b |= 0x80 >> i
+                out.append(b)
+        else:
+            for x in range(0, SCREEN_WIDTH, 2):
+                out.append((row[x] >> 4) | ((row[x + 1] >> 4) << 4))
+    return bytes(out)
+
+
+def load_image(path, bpp):
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("Pillow is needed for the images (pip install pillow)")
+    img = Image.open(path).convert("L").resize((SCREEN_WIDTH, SCREEN_HEIGHT))
+    px = img.load()
+    return pack_gray([[px[x, y] for x in range(SCREEN_WIDTH)] for y in range(SCREEN_HEIGHT)], bpp)
+
+
+def test_pattern(n, bpp):
+    """Frame with the moving box and the counter bar (only small part changes between frames)."""
+    gray = [[255] * SCREEN_WIDTH for _ in range(SCREEN_HEIGHT)]
+    bx = (n * 37) % (SCREEN_WIDTH - 160)
+    by = (n * 23) % (SCREEN_HEIGHT - 120)
+    for y in range(by, by + 120):
+        row = gray[y]
+        for x in range(bx, bx + 160):
+            row[x] = ((x + y) * 4) & 0xFF if bpp == 4 else 0
+    bar = (n * 29) % SCREEN_WIDTH
+    for y in range(SCREEN_HEIGHT - 20, SCREEN_HEIGHT):
+        for x in range(bar):
+            gray[y][x] = 0
+    return pack_gray(gray, bpp)
+
+
+# ---------------------------------------------------------------- Sender
+
+
+def dirty_rects(old, new, bpp, band=16):
+    """Bounding box of the changes in each band of rows, byte aligned and merged with the next band."""
+    stride = row_bytes(bpp)
+    ppb = 8 // bpp
+    rects = []
+    for y0 in range(0, SCREEN_HEIGHT, band):
+        h = min(band, SCREEN_HEIGHT - y0)
+        left, right = stride, -1
+        for y in range(y0, y0 + h):
+            a = old[y * stride:(y + 1) * stride]
+            b = new[y * stride:(y + 1) * stride]
+            if a == b:
+                continue
+            l = next(i for i in range(stride) if a[i] != b[i])
+            r = next(i for i in range(stride - 1, -1, -1) if a[i] != b[i])
+            left, right = min(left, l), max(right, r)
+        if right < 0:
+            continue
+        if rects and rects[-1][1] + rects[-1][3] == y0 and rects[-1][0] == left * ppb and \
+                rects[-1][2] == (right - left + 1) * ppb:
+            rects[-1][3] += h
+        else:
+            rects.append([left * ppb, y0, (right - left + 1) * ppb, h])
+    return rects
+
+
+def encode_frame(old_fb, new, bpp, use_xor=True):
+    """Encode the changed rectangles, each one with the smallest encoding."""
+    out = bytearray()
+    ref = Framebuffer(bpp)
+    ref.data = bytearray(new)
+    for x, y, w, h in dirty_rects(old_fb.data, new, bpp):
+        raw = ref.rect(x, y, w, h)
+        options = [(0, raw), (ENC_RLE, rle_encode(raw))]
+        if use_xor:
+            delta = bytes(a ^ b for a, b in zip(old_fb.rect(x, y, w, h), raw))
+            options.append((ENC_RLE | ENC_XOR, rle_encode(delta)))
+        enc, data = min(options, key=lambda o: len(o[1]))
+        out += RECT.pack(x, y, w, h, bpp, enc, len(data)) + data
+    return bytes(out)
+
+
+class Sender:
+    def __init__(self, host, port, timeout=2.0, retries=5, verbose=True):
+        self.addr = (host, port)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        # Any local port, the board replies to the sender of the last packet.
+        self.sock.bind(("0.0.0.0", 0))
+        self.sock.settimeout(0.05)
+        self.frame_id = random.randint(0, 0xFFFF)
+        self.timeout = timeout
+        self.retries = retries
+        self.verbose = verbose
+        self.latency = []
+        self.displayed = {}
+
+    def packets(self, frame, flags, ts):
+        count = max(1, (len(frame) + FRAG_SIZE - 1) // FRAG_SIZE)
+        if count > MAX_FRAGMENTS:
+            raise ValueError("frame too large")
+        for i in range(count):
+            part = frame[i * FRAG_SIZE:(i + 1) * FRAG_SIZE]
+            yield HEADER.pack(MAGIC, TYPE_DATA, flags, self.frame_id, i, count, FRAG_SIZE, len(part), 0, ts) + part
+
+    def send_frame(self, frame, flags=0):
+        """Send one frame and wait for the ACK (NACKed fragments are sent again). Returns ACK latency in ms."""
+        self.frame_id = (self.frame_id + 1) & 0xFFFF
+        ts = now_ms()
+        pkts = list(self.packets(frame, flags, ts))
+        for p in pkts:
+            self.sock.sendto(p, self.addr)
+        start = time.monotonic()
+        last = start
+        tries = 0
+        while True:
+            reply = self.receive()
+            if reply is not None:
+                rtype, fid, rts, payload = reply
+                if fid == self.frame_id and rtype == TYPE_ACK:
+                    return (time.monotonic() - start) * 1000
+                if fid == self.frame_id and rtype == TYPE_NACK:
+                    for i in struct.unpack("<%dH" % (len(payload) // 2), payload):
+                        if i < len(pkts):
+                            self.sock.sendto(pkts[i], self.addr)
+                    last = time.monotonic()
+                continue
+            if time.monotonic() - last > self.timeout / self.retries:
+                # No reply at all (whole frame or the ACK lost), send everything again.
+                tries += 1
+                if tries > self.retries:
+                    raise TimeoutError("no ACK for frame %d" % self.frame_id)
+                for p in pkts:
+                    self.sock.sendto(p, self.addr)
+                last = time.monotonic()
+
+    def receive(self):
+        try:
+            data, _ = self.sock.recvfrom(2048)
+        except socket.timeout:
+            return None
+        if len(data) < HEADER.size:
+            return None
+        magic, rtype, _, fid, _, _, _, plen, _, rts = HEADER.unpack_from(data)
+        if magic != MAGIC:
+            return None
+        payload = data[HEADER.size:HEADER.size + plen]
+        if rtype == TYPE_DISPLAYED:
+            board = struct.unpack("<I", payload[:4])[0] if len(payload) >= 4 else 0
+            total = (now_ms() - rts) & 0xFFFFFFFF
+            self.latency.append((total, board))
+            self.displayed[fid] = total
+            if self.verbose:
+                print("  frame %5d on the screen: %4d ms end-to-end (board %4d ms)" % (fid, total, board))
+        return rtype, fid, rts, payload
+
+    def drain(self, seconds):
+        end = time.monotonic() + seconds
+        while time.monotonic() < end:
+            self.receive()
+
+
+def run_sender(args, frames):
+    sender = Sender(args.host, args.port)
+    model = Framebuffer(args.bpp)
+    for n, new in enumerate(frames):
+        frame = encode_frame(model, new, args.bpp, not args.no_xor)
+        flags = FLAG_FULL_UPDATE if (n == 0 and args.full_first) else 0
+        ack = sender.send_frame(frame, flags)
+        model.data = bytearray(new)
+        print("frame %5d: %7d bytes, ACK after %6.1f ms" % (sender.frame_id, len(frame), ack))
+        sender.drain(args.interval)
+    sender.drain(2.0)
+    if sender.latency:
+        totals = sorted(t for t, _ in sender.latency)
+        print("end-to-end latency: min %d ms, median %d ms, max %d ms" %
+              (totals[0], totals[len(totals) // 2], totals[-1]))
+    return model
+
+
+# ---------------------------------------------------------------- Stand-in board
+
+
+class Emulator:
+    """Local stand-in for the board: same reassembly, NACK, coalescing and replies as RemoteDisplay."""
+
+    def __init__(self, port, bpp, loss=0.0, dump=None, update_time=0.25, verbose=True):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(("0.0.0.0", port))
+        self.sock.settimeout(0.005)
+        self.fb = Framebuffer(bpp)
+        self.bpp = bpp
+        self.loss = loss
+        self.dump = dump
+        self.update_time = update_time
+        self.verbose = verbose
+        self.remote = None
+        self.frame = None
+        self.applied = None
+        self.update_since = None
+        self.last_apply = 0
+        self.last_nack = 0
+        self.updates = 0
+        self.nacks = 0
+        self.running = True
+
+    def reply(self, rtype, fid, ts, payload=b""):
+        if self.remote is not None and random.random() >= self.loss:
+            self.sock.sendto(HEADER.pack(MAGIC, rtype, 0, fid, 0, 0, 0, len(payload), 0, ts) + payload, self.remote)
+
+    def handle(self, data):
+        if len(data) < HEADER.size:
+            return
+        magic, rtype, flags, fid, idx, count, size, plen, _, ts = HEADER.unpack_from(data)
+        if magic != MAGIC or rtype != TYPE_DATA:
+            return
+        if self.applied is not None and fid == self.applied[0]:
+            self.reply(TYPE_ACK, fid, self.applied[1])
+            return
+        if self.frame is None or self.frame["id"] != fid:
+            if count == 0 or count > MAX_FRAGMENTS or size == 0:
+                self.frame = None
+                return
+            self.frame = {"id": fid, "count": count, "size": size, "flags": flags, "ts": ts, "parts": {},
+                          "start": time.monotonic()}
+        f = self.frame
+        if idx >= f["count"] or idx in f["parts"]:
+            return
+        f["parts"][idx] = data[HEADER.size:HEADER.size + plen]
+        f["last"] = time.monotonic()
+        if len(f["parts"]) == f["count"]:
+            self.apply(b"".join(f["parts"][i] for i in range(f["count"])))
+            self.applied = (fid, f["ts"], f["start"])
+            if self.update_since is None:
+                self.update_since = f["start"]
+            self.last_apply = time.monotonic()
+            self.frame = None
+            self.reply(TYPE_ACK, fid, f["ts"])
+
+    def apply(self, frame):
+        off = 0
+        while len(frame) - off >= RECT.size:
+            x, y, w, h, bpp, enc, dlen = RECT.unpack_from(frame, off)
+            off += RECT.size
+            data = frame[off:off + dlen]
+            off += dlen
+            ppb = 8 // bpp
+            if bpp != self.bpp or x % ppb or w % ppb or x + w > SCREEN_WIDTH or y + h > SCREEN_HEIGHT:
+                print("bad rectangle", x, y, w, h, bpp)
+                continue
+            size = w // ppb * h
+            if enc & ENC_RLE:
+                data = rle_decode(data, size)
+            self.fb.write(x, y, w, h, data, bool(enc & ENC_XOR))
+
+    def poll(self):
+        try:
+            data, addr = self.sock.recvfrom(2048)
+            if random.random() >= self.loss:
+                self.remote = addr
+                self.handle(data)
+        except socket.timeout:
+            pass
+        t = time.monotonic()
+        f = self.frame
+        if f is not None and t - f["last"] >= NACK_TIMEOUT and t - self.last_nack >= NACK_TIMEOUT:
+            missing = [i for i in range(f["count"]) if i not in f["parts"]][:NACK_MAX]
+            self.reply(TYPE_NACK, f["id"], f["ts"], struct.pack("<%dH" % len(missing), *missing))
+            self.last_nack = t
+            self.nacks += 1
+        if self.update_since is not None and self.frame is None and t - self.last_apply >= COALESCE_TIME:
+            # Screen update takes some time on the board.
+            time.sleep(self.update_time)
+            latency = int((time.monotonic() - self.update_since) * 1000)
+            self.update_since = None
+            self.updates += 1
+            if self.dump:
+                self.fb.save_pgm(self.dump)
+            if self.verbose:
+                print("update %d: frame %d, %d ms" % (self.updates, self.applied[0], latency))
+            self.reply(TYPE_DISPLAYED, self.applied[0], self.applied[1], struct.pack("<I", latency))
+
+    def run(self):
+        while self.running:
+            self.poll()
+
+
+def selftest(args):
+    """Emulator and sender on the localhost with the packet loss, framebuffers must be the same at the end."""
+    emu = Emulator(args.port, args.bpp, args.loss, verbose=False, update_time=0.02)
+    thread = threading.Thread(target=emu.run, daemon=True)
+    thread.start()
+    sender = Sender("127.0.0.1", args.port, verbose=False)
+    model = Framebuffer(args.bpp)
+    for n in range(args.frames):
+        new = test_pattern(n, args.bpp)
+        sender.send_frame(encode_frame(model, new, args.bpp), 0)
+        model.data = bytearray(new)
+    sender.drain(1.0)
+    emu.running = False
+    thread.join()
+    ok = emu.fb.data == model.data
+    print("%d frames, %d updates, %d NACKs, loss %.0f %% -> %s" %
+          (args.frames, emu.updates, emu.nacks, args.loss * 100, "OK" if ok else "FRAMEBUFFER MISMATCH"))
+    return 0 if ok else 1
+
+
+def main():
+    p = argparse.ArgumentParser(description="Inkplate 6 Motion remote display sender and stand-in")
+    sub = p.add_subparsers(dest="cmd", required=True)
+
+    s = sub.add_parser("send", help="send frames to the board (or to the emulator)")
+    s.add_argument("host")
+    s.add_argument("--image", nargs="*", help="images to send one after another (default: test pattern)")
+    s.add_argument("--frames", type=int, default=20, help="number of test pattern frames")
+    s.add_argument("--interval", type=float, default=0.0, help="pause between frames in seconds")
+    s.add_argument("--no-xor", action="store_true", help="do not use XOR encoding")
+    s.add_argument("--full-first", action="store_true", help="use full update for the first frame")
+
+    e = sub.add_parser("emulate", help="local stand-in for the board")
+    e.add_argument("--loss", type=float, default=0.0, help="packet loss probability (both ways)")
+    e.add_argument("--dump", help="save framebuffer as PGM after each update")
+
+    t = sub.add_parser("selftest", help="sender against the emulator on the localhost")
+    t.add_argument("--loss", type=float, default=0.2)
+    t.add_argument("--frames", type=int, default=30)
+
+    for sp in (s, e, t):
+        sp.add_argument("--port", type=int, default=5005)
+        sp.add_argument("--bpp", type=int, choices=(1, 4), default=1)
+
+    args = p.parse_args()
+    if args.cmd == "send":
+        if args.image:
+            frames = [load_image(f, args.bpp) for f in args.image]
+        else:
+            frames = [test_pattern(n, args.bpp) for n in range(args.frames)]
+        run_sender(args, frames)
+    elif args.cmd == "emulate":
+        print("Remote display stand-in on UDP port %d (%d bit)" % (args.port, args.bpp))
+        try:
+            Emulator(args.port, args.bpp, args.loss, args.dump).run()
+        except KeyboardInterrupt:
+            pass
+    else:
+        sys.exit(selftest(args))
+
+
+if __name__ == "__main__":
+    main()
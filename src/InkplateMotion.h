@@ -35,6 +35,9 @@
 // Include WiFi Library for the ESP32 (using AT commands over SPI).
 #include "system/wifi/esp32SpiAt.h"
 
+// Include streaming JSON parser (for the WiFi responses).
+#include "system/jsonStreamParser.h"
+
 // Include header file for board select.
 #include "boardSelect.h"
 
@@ -79,10 +79,14 @@ int EPDDriver::initDriver(Inkplate *_inkplatePtr)
     _inkplate = _inkplatePtr;
 
     // Initialize the image processing library.
-    imgProcess.begin(_inkplate, SCREEN_WIDTH);
+    imgProcess.begin(_inkplate, SCREEN_WIDTH, _pendingScreenFB);
 
     // Initialize image decoder library.
-    image.begin(_inkplate, &WiFi, &imgProcess, (uint8_t *)0xD0600000, _downloadFileMemory);
+    image.begin(_inkplate, &WiFi, &imgProcess, (uint8_t *)0xD0600000, _downloadFileMemory, _pendingScreenFB,
+                _imageCacheMemory);
+
+    // Initialize the remote display service.
+    remoteDisplay.begin(_inkplate, _pendingScreenFB, _remoteDisplayMemory);
 
     // Put every peripheral into low power mode.
     peripheralState(INKPLATE_PERIPHERAL_ALL_PERI, false);
@@ -122,6 +126,9 @@ int EPDDriver::initDriver(Inkplate *_inkplatePtr)
     // Init STM32 FMC (Flexible memory controller) for faster pushing data to panel using hardware.
     stm32FmcInit(EPD_FMC_ADDR);
 
+    // Init STM32 DMA2D for fast framebuffer fills and copies.
+    stm32Dma2dInit();
+
     // Turn off EPD PMIC.
     internalIO.digitalWriteIO(TPS_WAKE_PIN, LOW, true);
 
@@ -196,20 +203,15 @@ void EPDDriver::cleanFast(uint8_t *_clearWavefrom, uint8_t _wavefromPhases)
 void EPDDriver::clearDisplay()
 {
     // Framebuffer if filled with different data depending on the cuurrent mode.
+    // Use DMA2D for this (framebuffer is filled as rectangle, one screen row at the time).
     if (getDisplayMode() == INKPLATE_1BW)
     {
-        for (int i = 0; i < (SCREEN_HEIGHT * SCREEN_WIDTH / 8); i++)
-        {
-            _pendingScreenFB[i] = 0;
-        }
+        stm32Dma2dFill(_pendingScreenFB, SCREEN_WIDTH / 8, SCREEN_WIDTH / 8, SCREEN_HEIGHT, 0);
     }
 
     if (getDisplayMode() == INKPLATE_GL16)
     {
-        for (int i = 0; i < (SCREEN_HEIGHT * SCREEN_WIDTH / 2); i++)
-        {
-            _pendingScreenFB[i] = 255;
-        }
+        stm32Dma2dFill(_pendingScreenFB, SCREEN_WIDTH / 2, SCREEN_WIDTH / 2, SCREEN_HEIGHT, 255);
     }
 }
 
@@ -863,7 +865,7 @@ void EPDDriver::differenceMask(uint8_t *_currentScreenFB, uint8_t *_pendingScree
  * @param   const uint8_t *_p
  *          Pointer to the image bitmap data.
  *
- * @note    To-Do: Try to implement STM32 DMA2D for this.
+ * @note    Copy is done by the DMA2D if the bitmap is 32 bit aligned, otherwise CPU is used.
  */
 void EPDDriver::drawBitmapFast(const uint8_t *_p)
 {
@@ -871,21 +873,9 @@ void EPDDriver::drawBitmapFast(const uint8_t *_p)
     // To-Do: Add x, y, w and h.
     // To-Do2: Check for input parameters.
     // To-Do3: Check for screen rotation!
-    // To-Do4: Use HW accelerator for all that if possible?
 
-    // Copy line by line.
-    for (int i = 0; i < SCREEN_HEIGHT * SCREEN_WIDTH / 8; i += sizeof(_oneLine1))
-    {
-        // Copy data into internal buffer.
-        memcpy(_oneLine1, _p + i, sizeof(_oneLine1));
-
-        // Start DMA transfer into pending screen framebuffer.
-        HAL_MDMA_Start_IT(_sdramMdmaHandle, (uint32_t)_oneLine1, (uint32_t)(_pendingScreenFB) + i, sizeof(_oneLine1),
-                          1);
-        while (stm32FmcSdramCompleteFlag() == 0)
-            ;
-        stm32FmcClearSdramCompleteFlag();
-    }
+    // Copy whole bitmap into pending screen framebuffer.
+    stm32Dma2dCopy(_p, SCREEN_WIDTH / 8, _pendingScreenFB, SCREEN_WIDTH / 8, SCREEN_WIDTH / 8, SCREEN_HEIGHT);
 }
 
 /**
@@ -22,6 +22,9 @@
 // Include library for the STM32 FMC
 #include "../../stm32System/stm32FMC.h"
 
+// Include library for the STM32 DMA2D (Chrom-ART) accelerator.
+#include "../../stm32System/stm32DMA2D.h"
+
 // Include library defines
 #include "../../system/defines.h"
 
@@ -40,6 +43,9 @@
 // Include library for image decoding.
 #include "imageDecoder.h"
 
+// Include remote display service (screen driven from the PC over the UDP).
+#include "remoteDisplay.h"
+
 // Include the library for the image processing (image to grayscale conversion, color inversion, dither).
 #include "../../libs/imageProcessing/imageProcessing.h"
 
@@ -187,6 +193,9 @@ class EPDDriver : public Helpers
     // Class for the image processing (grayscale, color invert, dither).
     ImageProcessing imgProcess;
 
+    // Class for the remote display service (dirty rectangles received over the UDP).
+    RemoteDisplay remoteDisplay;
+
     // If needed, DMA buffers used in drivers can be used for something else.
     volatile uint8_t *_dmaBuffer[3];
 
@@ -207,6 +216,12 @@ class EPDDriver : public Helpers
     // Buffer for downloading files from the web. 4MB in size (4194304 bytes).
     volatile uint8_t *_downloadFileMemory = (uint8_t *)0xD0800000;
 
+    // Memory for the rendered image cache. 8MB in size (8388608 bytes).
+    volatile uint8_t *_imageCacheMemory = (uint8_t *)0xD0C00000;
+
+    // Memory for the frame reassembly of the remote display. 2MB in size (2097152 bytes).
+    volatile uint8_t *_remoteDisplayMemory = (uint8_t *)0xD1400000;
+
   private:
     // Sets EPD control GPIO pins to the output or High-Z state.
     void epdGpioState(uint8_t _state);
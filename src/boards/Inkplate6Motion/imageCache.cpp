@@ -0,0 +1,713 @@
+/**
+ **************************************************
+ *
+ * @file        imageCache.cpp
+ * @brief       Source file for the rendered image cache. Stores the
+ *              final 1 bit or 4 bit framebuffer data of the decoded
+ *              image (after grayscale, invert and dither), so the same
+ *              image can be displayed again without decoding. Uses
+ *              spare SDRAM with LRU eviction and optional persistent
+ *              copy on the microSD card.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include library header file.
+#include "imageCache.h"
+
+// Block usage on other boards.
+#ifdef BOARD_INKPLATE6_MOTION
+
+// Main Inkplate Motion file is needed for the rotation, display mode and screen size.
+#include "../../InkplateMotion.h"
+
+/**
+ * @brief Construct a new Image Cache object.
+ *
+ */
+ImageCache::ImageCache()
+{
+    // Mark all entries as empty.
+    memset(_entries, 0, sizeof(_entries));
+    _sdFolder[0] = '\0';
+}
+
+/**
+ * @brief   Initializer for the image cache.
+ *
+ * @param   Inkplate *_inkplatePtr
+ *          Pointer for the main Inkplate object (used for rotation and display mode).
+ * @param   volatile uint8_t *_screenFramebuffer
+ *          Pointer to the main ePaper framebuffer where images are drawn.
+ * @param   volatile uint8_t *_cacheMemory
+ *          SDRAM address for the cached images.
+ * @param   uint32_t _cacheMemorySize
+ *          Size of the cache memory in bytes.
+ */
+void ImageCache::begin(Inkplate *_inkplatePtr, volatile uint8_t *_screenFramebuffer, volatile uint8_t *_cacheMemory,
+                       uint32_t _cacheMemorySize)
+{
+    // Save everything locally.
+    _inkplate = _inkplatePtr;
+    _framebuffer = _screenFramebuffer;
+    _memory = _cacheMemory;
+    _memorySize = _cacheMemorySize;
+
+    // Start with the empty cache.
+    clear();
+}
+
+/**
+ * @brief   Enables or disables the image cache. Cache is disabled by default.
+ *
+ * @param   bool _en
+ *          true - Decoded images are cached and drawn from the cache next time.
+ *          false - Cache is not used (cached images are kept).
+ */
+void ImageCache::enable(bool _en)
+{
+    _enabled = _en && (_memory != NULL);
+}
+
+/**
+ * @brief   Check if the cache is enabled.
+ *
+ * @return  bool
+ *          true - Cache is enabled.
+ *          false - Cache is disabled.
+ */
+bool ImageCache::isEnabled()
+{
+    return _enabled;
+}
+
+/**
+ * @brief   Enables the persistent cache on the microSD card. Every cached image is also written into the
+ *          folder on the microSD card, and images not found in SDRAM are searched there (so they survive reset).
+ *          microSD card must be initialized before this.
+ *
+ * @param   SdFat *_sdFat
+ *          Pointer to the SdFat object.
+ * @param   const char *_folder
+ *          Folder for the cache files. It will be created if it does not exist.
+ * @return  bool
+ *          true - microSD cache is enabled.
+ *          false - Folder can't be created or the path is too long.
+ */
+bool ImageCache::enableSd(SdFat *_sdFat, const char *_folder)
+{
+    // Check the input parameters (filename needs 21 more chars).
+    if ((_sdFat == NULL) || (_folder == NULL) || ((strlen(_folder) + 22) > IMAGE_CACHE_SD_PATH_MAX))
+        return false;
+
+    // Create the folder if needed.
+    if (!_sdFat->exists(_folder) && !_sdFat->mkdir(_folder))
+        return false;
+
+    // Save the settings.
+    _sd = _sdFat;
+    strcpy(_sdFolder, _folder);
+
+    return true;
+}
+
+/**
+ * @brief   Disables the persistent cache on the microSD card (files are kept).
+ *
+ */
+void ImageCache::disableSd()
+{
+    _sd = NULL;
+}
+
+/**
+ * @brief   Removes all images from the SDRAM cache (microSD card files are kept).
+ *
+ */
+void ImageCache::clear()
+{
+    for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++)
+    {
+        _entries[i].valid = false;
+    }
+}
+
+/**
+ * @brief   Draws the cached image into the main ePaper framebuffer.
+ *
+ * @param   uint64_t _key
+ *          Key of the image (source and processing parameters).
+ * @return  bool
+ *          true - Image is found and drawn.
+ *          false - Image is not cached, it must be decoded.
+ */
+bool ImageCache::draw(uint64_t _key)
+{
+    // Not enabled? Nothing to do.
+    if (!_enabled)
+        return false;
+
+    // Try SDRAM first, then microSD card.
+    ImageCacheEntry *_entry = find(_key);
+    if ((_entry == NULL) && loadFromSd(_key))
+        _entry = find(_key);
+
+    // Not found or cached in the different display mode?
+    if ((_entry == NULL) || (_entry->displayMode != _inkplate->getDisplayMode()))
+    {
+        _misses++;
+        return false;
+    }
+
+    // Mark it as recently used and draw it.
+    _entry->lastUse = ++_useCounter;
+    blit(_entry);
+    _hits++;
+
+    return true;
+}
+
+/**
+ * @brief   Stores the image from the main ePaper framebuffer into the cache. Called after the image is decoded.
+ *
+ * @param   uint64_t _key
+ *          Key of the image (source and processing parameters).
+ * @param   int _x
+ *          X position of the image on the screen (with rotation).
+ * @param   int _y
+ *          Y position of the image on the screen (with rotation).
+ * @param   int _w
+ *          Width of the drawn image (with rotation).
+ * @param   int _h
+ *          Height of the drawn image (with rotation).
+ * @return  bool
+ *          true - Image is cached.
+ *          false - Image is not on the screen or it's too large for the cache.
+ */
+bool ImageCache::store(uint64_t _key, int _x, int _y, int _w, int _h)
+{
+    // Not enabled? Nothing to do.
+    if (!_enabled)
+        return false;
+
+    // Get the image position in the framebuffer.
+    ImageCacheEntry _newEntry;
+    memset(&_newEntry, 0, sizeof(_newEntry));
+    if (!physicalRect(_x, _y, _w, _h, &_newEntry.x, &_newEntry.y, &_newEntry.w, &_newEntry.h))
+        return false;
+    _newEntry.displayMode = _inkplate->getDisplayMode();
+
+    // Calculate the size.
+    uint16_t _firstByte, _numBytes;
+    uint8_t _leftMask, _rightMask;
+    byteSpan(&_newEntry, &_firstByte, &_numBytes, &_leftMask, &_rightMask);
+    _newEntry.size = (uint32_t)_numBytes * _newEntry.h;
+
+    // Replace the old one if it's the same image.
+    ImageCacheEntry *_entry = find(_key);
+    if (_entry != NULL)
+        evict(_entry);
+
+    // Find the space for it.
+    _entry = allocate(_newEntry.size);
+    if (_entry == NULL)
+        return false;
+    _newEntry.offset = _entry->offset;
+
+    // Copy the framebuffer data into the cache.
+    uint32_t _stride = (_newEntry.displayMode == INKPLATE_1BW) ? (SCREEN_WIDTH / 8) : (SCREEN_WIDTH / 2);
+    stm32Dma2dCopy(_framebuffer + (_stride * _newEntry.y) + _firstByte, _stride, _memory + _newEntry.offset,
+                   _numBytes, _numBytes, _newEntry.h);
+
+    // Save the entry.
+    _newEntry.key = _key;
+    _newEntry.lastUse = ++_useCounter;
+    _newEntry.valid = true;
+    memcpy(_entry, &_newEntry, sizeof(ImageCacheEntry));
+
+    // Write it on the microSD card as well.
+    saveToSd(_entry);
+
+    return true;
+}
+
+/**
+ * @brief   Get the number of the images drawn from the cache.
+ *
+ * @return  uint32_t
+ *          Number of cache hits.
+ */
+uint32_t ImageCache::getHits()
+{
+    return _hits;
+}
+
+/**
+ * @brief   Get the number of the images that were not found in the cache.
+ *
+ * @return  uint32_t
+ *          Number of cache misses.
+ */
+uint32_t ImageCache::getMisses()
+{
+    return _misses;
+}
+
+/**
+ * @brief   Adds data to the 64 bit FNV-1a hash. Used for making the cache keys.
+ *
+ * @param   uint64_t _hash
+ *          Current hash value (IMAGE_CACHE_HASH_SEED for the new hash).
+ * @param   const void *_data
+ *          Data that needs to be added to the hash.
+ * @param   size_t _n
+ *          Size of the data in bytes.
+ * @return  uint64_t
+ *          New hash value.
+ */
+uint64_t ImageCache::hash(uint64_t _hash, const void *_data, size_t _n)
+{
+    const uint8_t *_bytes = (const uint8_t *)_data;
+    for (size_t i = 0; i < _n; i++)
+    {
+        _hash ^= _bytes[i];
+        _hash *= 0x100000001B3ULL;
+    }
+
+    return _hash;
+}
+
+/**
+ * @brief   Adds data from the SDRAM (image file buffer) to the 64 bit hash. Data is read as 32 bit words (one
+ *          hash step per word), since it's much faster and the image files can be large.
+ *
+ * @param   uint64_t _hash
+ *          Current hash value.
+ * @param   volatile uint8_t *_data
+ *          Data that needs to be added to the hash.
+ * @param   size_t _n
+ *          Size of the data in bytes.
+ * @return  uint64_t
+ *          New hash value.
+ */
+uint64_t ImageCache::hash(uint64_t _hash, volatile uint8_t *_data, size_t _n)
+{
+    // Hash the unaligned start byte-by-byte.
+    while ((_n > 0) && ((uint32_t)_data & 3))
+    {
+        _hash = (_hash ^ *_data++) * 0x100000001B3ULL;
+        _n--;
+    }
+
+    // Then 32 bits at the time.
+    volatile uint32_t *_words = (volatile uint32_t *)_data;
+    for (size_t i = 0; i < (_n / 4); i++)
+    {
+        _hash = (_hash ^ _words[i]) * 0x100000001B3ULL;
+    }
+
+    // And the rest.
+    _data += _n & ~((size_t)3);
+    for (size_t i = 0; i < (_n & 3); i++)
+    {
+        _hash = (_hash ^ _data[i]) * 0x100000001B3ULL;
+    }
+
+    return _hash;
+}
+
+/**
+ * @brief   Converts the rectangle on the screen (with rotation) into the rectangle in the framebuffer and
+ *          clips it to the screen.
+ *
+ * @param   int _x
+ *          X position of the rectangle on the screen.
+ * @param   int _y
+ *          Y position of the rectangle on the screen.
+ * @param   int _w
+ *          Width of the rectangle on the screen.
+ * @param   int _h
+ *          Height of the rectangle on the screen.
+ * @param   uint16_t *_px
+ *          Pointer to the variable for X position in the framebuffer.
+ * @param   uint16_t *_py
+ *          Pointer to the variable for Y position in the framebuffer.
+ * @param   uint16_t *_pw
+ *          Pointer to the variable for width in the framebuffer.
+ * @param   uint16_t *_ph
+ *          Pointer to the variable for height in the framebuffer.
+ * @return  bool
+ *          true - Rectangle is (at least partially) on the screen.
+ *          false - Rectangle is not visible.
+ */
+bool ImageCache::physicalRect(int _x, int _y, int _w, int _h, uint16_t *_px, uint16_t *_py, uint16_t *_pw,
+                              uint16_t *_ph)
+{
+    // Clip it to the screen (with rotation).
+    int _x1 = min(_x + _w, (int)(_inkplate->width()));
+    int _y1 = min(_y + _h, (int)(_inkplate->height()));
+    _x = max(_x, 0);
+    _y = max(_y, 0);
+    if ((_x >= _x1) || (_y >= _y1))
+        return false;
+
+    // Rotate it the same way Inkplate::drawPixel() does.
+    int _rx, _ry, _rw, _rh;
+    switch (_inkplate->getRotation())
+    {
+    case 1:
+        _rx = (int)(SCREEN_WIDTH) - _y1;
+        _ry = _x;
+        _rw = _y1 - _y;
+        _rh = _x1 - _x;
+        break;
+    case 2:
+        _rx = (int)(SCREEN_WIDTH) - _x1;
+        _ry = (int)(SCREEN_HEIGHT) - _y1;
+        _rw = _x1 - _x;
+        _rh = _y1 - _y;
+        break;
+    case 3:
+        _rx = _y;
+        _ry = (int)(SCREEN_HEIGHT) - _x1;
+        _rw = _y1 - _y;
+        _rh = _x1 - _x;
+        break;
+    default:
+        _rx = _x;
+        _ry = _y;
+        _rw = _x1 - _x;
+        _rh = _y1 - _y;
+        break;
+    }
+
+    // Save the result.
+    *_px = _rx;
+    *_py = _ry;
+    *_pw = _rw;
+    *_ph = _rh;
+
+    return true;
+}
+
+/**
+ * @brief   Calculates which framebuffer bytes in each row belong to the image. First and last byte can be
+ *          shared with other pixels, so masks are used for them.
+ *
+ * @param   ImageCacheEntry *_entry
+ *          Cached image.
+ * @param   uint16_t *_firstByte
+ *          Pointer to the variable for the first byte in the framebuffer row.
+ * @param   uint16_t *_numBytes
+ *          Pointer to the variable for the number of bytes in each row.
+ * @param   uint8_t *_leftMask
+ *          Pointer to the variable for the mask of the image pixels in the first byte.
+ * @param   uint8_t *_rightMask
+ *          Pointer to the variable for the mask of the image pixels in the last byte.
+ */
+void ImageCache::byteSpan(ImageCacheEntry *_entry, uint16_t *_firstByte, uint16_t *_numBytes, uint8_t *_leftMask,
+                          uint8_t *_rightMask)
+{
+    uint16_t _lastPixel = _entry->x + _entry->w - 1;
+
+    if (_entry->displayMode == INKPLATE_1BW)
+    {
+        // 8 pixels per byte, first pixel is MSB.
+        *_firstByte = _entry->x / 8;
+        *_numBytes = (_lastPixel / 8) - *_firstByte + 1;
+        *_leftMask = 0xFF >> (_entry->x % 8);
+        *_rightMask = 0xFF << (7 - (_lastPixel % 8));
+    }
+    else
+    {
+        // 2 pixels per byte, first pixel is in the lower nibble.
+        *_firstByte = _entry->x / 2;
+        *_numBytes = (_lastPixel / 2) - *_firstByte + 1;
+        *_leftMask = (_entry->x & 1) ? 0xF0 : 0xFF;
+        *_rightMask = (_lastPixel & 1) ? 0xFF : 0x0F;
+    }
+
+    // Image is only one byte wide? Both masks are used on the same byte.
+    if (*_numBytes == 1)
+    {
+        *_leftMask &= *_rightMask;
+        *_rightMask = *_leftMask;
+    }
+}
+
+/**
+ * @brief   Copies the cached image into the main ePaper framebuffer. Whole bytes are copied with DMA2D,
+ *          bytes shared with other pixels are merged by CPU.
+ *
+ * @param   ImageCacheEntry *_entry
+ *          Cached image.
+ */
+void ImageCache::blit(ImageCacheEntry *_entry)
+{
+    // Get the bytes used by the image.
+    uint16_t _firstByte, _numBytes;
+    uint8_t _leftMask, _rightMask;
+    byteSpan(_entry, &_firstByte, &_numBytes, &_leftMask, &_rightMask);
+
+    // Get the start of the image in the framebuffer and in the cache.
+    uint32_t _stride = (_entry->displayMode == INKPLATE_1BW) ? (SCREEN_WIDTH / 8) : (SCREEN_WIDTH / 2);
+    volatile uint8_t *_dst = _framebuffer + (_stride * _entry->y) + _firstByte;
+    volatile uint8_t *_src = _memory + _entry->offset;
+
+    // Copy all whole bytes at once.
+    uint16_t _startByte = (_leftMask == 0xFF) ? 0 : 1;
+    uint16_t _endByte = ((_rightMask == 0xFF) || (_numBytes == 1)) ? _numBytes : (_numBytes - 1);
+    if (_endByte > _startByte)
+        stm32Dma2dCopy(_src + _startByte, _numBytes, _dst + _startByte, _stride, _endByte - _startByte,
+                       _entry->h);
+
+    // Merge the partial bytes.
+    if ((_leftMask != 0xFF) || (_rightMask != 0xFF))
+    {
+        for (uint16_t _y = 0; _y < _entry->h; _y++)
+        {
+            if (_leftMask != 0xFF)
+                _dst[0] = (_dst[0] & ~_leftMask) | (_src[0] & _leftMask);
+            if ((_rightMask != 0xFF) && (_numBytes > 1))
+                _dst[_numBytes - 1] = (_dst[_numBytes - 1] & ~_rightMask) | (_src[_numBytes - 1] & _rightMask);
+
+            _dst += _stride;
+            _src += _numBytes;
+        }
+    }
+}
+
+/**
+ * @brief   Finds the image in the SDRAM cache.
+ *
+ * @param   uint64_t _key
+ *          Key of the image.
+ * @return  ImageCacheEntry*
+ *          Pointer to the cached image, NULL if not found.
+ */
+ImageCacheEntry *ImageCache::find(uint64_t _key)
+{
+    for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++)
+    {
+        if (_entries[i].valid && (_entries[i].key == _key))
+            return &_entries[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   Finds free entry and free SDRAM space for the new image. Least recently used images are removed
+ *          until there is enough space.
+ *
+ * @param   uint32_t _size
+ *          Size of the image in bytes.
+ * @return  ImageCacheEntry*
+ *          Pointer to the free entry (with offset set), NULL if the image is larger than the cache.
+ */
+ImageCacheEntry *ImageCache::allocate(uint32_t _size)
+{
+    // Too large? Don't even try.
+    if ((_size == 0) || (_size > _memorySize))
+        return NULL;
+
+    while (true)
+    {
+        // Find free entry and the oldest used one.
+        ImageCacheEntry *_free = NULL;
+        ImageCacheEntry *_oldest = NULL;
+        for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++)
+        {
+            if (!_entries[i].valid)
+            {
+                if (_free == NULL)
+                    _free = &_entries[i];
+            }
+            else if ((_oldest == NULL) || (_entries[i].lastUse < _oldest->lastUse))
+            {
+                _oldest = &_entries[i];
+            }
+        }
+
+        // Is there enough space?
+        uint32_t _offset;
+        if ((_free != NULL) && findFreeSpace(_size, &_offset))
+        {
+            _free->offset = _offset;
+            return _free;
+        }
+
+        // No, remove the least recently used image and try again.
+        if (_oldest == NULL)
+            return NULL;
+        evict(_oldest);
+    }
+}
+
+/**
+ * @brief   Finds the first gap between cached images large enough for the new image.
+ *
+ * @param   uint32_t _size
+ *          Size of the image in bytes.
+ * @param   uint32_t *_offset
+ *          Pointer to the variable for the offset of the free space.
+ * @return  bool
+ *          true - Free space is found.
+ *          false - There is no gap large enough.
+ */
+bool ImageCache::findFreeSpace(uint32_t _size, uint32_t *_offset)
+{
+    // Start from the beginning and jump over every image that overlaps with the candidate space.
+    uint32_t _candidate = 0;
+    bool _moved = true;
+    while (_moved)
+    {
+        _moved = false;
+        for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++)
+        {
+            if (_entries[i].valid && (_entries[i].offset < (_candidate + _size)) &&
+                ((_entries[i].offset + _entries[i].size) > _candidate))
+            {
+                // Keep it 32 bit aligned for the DMA2D.
+                _candidate = (_entries[i].offset + _entries[i].size + 3) & ~3UL;
+                _moved = true;
+            }
+        }
+
+        // Out of the memory?
+        if ((_candidate + _size) > _memorySize)
+            return false;
+    }
+
+    *_offset = _candidate;
+    return true;
+}
+
+/**
+ * @brief   Removes the image from the SDRAM cache.
+ *
+ * @param   ImageCacheEntry *_entry
+ *          Cached image.
+ */
+void ImageCache::evict(ImageCacheEntry *_entry)
+{
+    _entry->valid = false;
+}
+
+/**
+ * @brief   Loads the cached image from the microSD card into the SDRAM cache.
+ *
+ * @param   uint64_t _key
+ *          Key of the image.
+ * @return  bool
+ *          true - Image is loaded into the SDRAM cache.
+ *          false - microSD cache is not used, image is not found or the file is not valid.
+ */
+bool ImageCache::loadFromSd(uint64_t _key)
+{
+    // microSD cache is not used.
+    if (_sd == NULL)
+        return false;
+
+    // Try to open the file.
+    char _path[IMAGE_CACHE_SD_PATH_MAX];
+    sdFilename(_key, _path);
+    File _file = _sd->open(_path, O_RDONLY);
+    if (!_file)
+        return false;
+
+    // Read and check the header.
+    ImageCacheSdHeader _header;
+    if ((_file.read(&_header, sizeof(_header)) != sizeof(_header)) || (_header.magic != IMAGE_CACHE_SD_MAGIC) ||
+        (_header.key != _key) || ((_file.fileSize() - sizeof(_header)) != _header.size))
+    {
+        _file.close();
+        return false;
+    }
+
+    // Find the space for it.
+    ImageCacheEntry *_entry = allocate(_header.size);
+    if (_entry == NULL)
+    {
+        _file.close();
+        return false;
+    }
+
+    // Load the data.
+    if (_file.read((uint8_t *)(_memory + _entry->offset), _header.size) != (int)(_header.size))
+    {
+        _file.close();
+        return false;
+    }
+    _file.close();
+
+    // Save the entry.
+    _entry->key = _key;
+    _entry->size = _header.size;
+    _entry->x = _header.x;
+    _entry->y = _header.y;
+    _entry->w = _header.w;
+    _entry->h = _header.h;
+    _entry->displayMode = _header.displayMode;
+    _entry->lastUse = ++_useCounter;
+    _entry->valid = true;
+
+    return true;
+}
+
+/**
+ * @brief   Writes the cached image on the microSD card (if the microSD cache is used).
+ *
+ * @param   ImageCacheEntry *_entry
+ *          Cached image.
+ */
+void ImageCache::saveToSd(ImageCacheEntry *_entry)
+{
+    // microSD cache is not used.
+    if (_sd == NULL)
+        return;
+
+    // Fill the header.
+    ImageCacheSdHeader _header;
+    memset(&_header, 0, sizeof(_header));
+    _header.magic = IMAGE_CACHE_SD_MAGIC;
+    _header.key = _entry->key;
+    _header.x = _entry->x;
+    _header.y = _entry->y;
+    _header.w = _entry->w;
+    _header.h = _entry->h;
+    _header.displayMode = _entry->displayMode;
+    _header.size = _entry->size;
+
+    // Write the file.
+    char _path[IMAGE_CACHE_SD_PATH_MAX];
+    sdFilename(_entry->key, _path);
+    File _file = _sd->open(_path, O_WRONLY | O_CREAT | O_TRUNC);
+    if (!_file)
+        return;
+
+    bool _ok = (_file.write(&_header, sizeof(_header)) == sizeof(_header)) &&
+               (_file.write((uint8_t *)(_memory + _entry->offset), _entry->size) == _entry->size);
+    _file.close();
+
+    // Do not leave broken files.
+    if (!_ok)
+        _sd->remove(_path);
+}
+
+/**
+ * @brief   Makes the path of the cache file on the microSD card.
+ *
+ * @param   uint64_t _key
+ *          Key of the image.
+ * @param   char *_path
+ *          Buffer for the path (at least IMAGE_CACHE_SD_PATH_MAX bytes).
+ */
+void ImageCache::sdFilename(uint64_t _key, char *_path)
+{
+    sprintf(_path, "%s/%08lX%08lX.ipc", _sdFolder, (unsigned long)(_key >> 32), (unsigned long)(_key & 0xFFFFFFFF));
+}
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ **************************************************
+ *
+ * @file        imageCache.h
+ * @brief       Header file for the rendered image cache. Stores the
+ *              final 1 bit or 4 bit framebuffer data of the decoded
+ *              image (after grayscale, invert and dither), so the same
+ *              image can be displayed again without decoding. Uses
+ *              spare SDRAM with LRU eviction and optional persistent
+ *              copy on the microSD card.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add header guard.
+#ifndef __INKPLATE_MOTION_IMAGE_CACHE_H__
+#define __INKPLATE_MOTION_IMAGE_CACHE_H__
+
+// Block usage on other boards.
+#ifdef BOARD_INKPLATE6_MOTION
+
+// Include main Arduino header file.
+#include "Arduino.h"
+
+// Include file for the each board feature selection (for the SdFat).
+#include "features/featureSelect.h"
+
+// Size of the SDRAM memory used for the cache.
+#define IMAGE_CACHE_SDRAM_SIZE (8 * 1024 * 1024) // 8MB by default
+
+// Max. number of the images in the SDRAM cache.
+#define IMAGE_CACHE_MAX_ENTRIES 32
+
+// Max. length of the path to the cache folder on the microSD card.
+#define IMAGE_CACHE_SD_PATH_MAX 48
+
+// Magic number of the cache files on the microSD card ("IPC1").
+#define IMAGE_CACHE_SD_MAGIC 0x31435049UL
+
+// Start value for the cache key hash (64 bit FNV-1a offset basis).
+#define IMAGE_CACHE_HASH_SEED 0xCBF29CE484222325ULL
+
+// Forward declaration of the Inkplate Class.
+class Inkplate;
+
+// One cached image. Position and size are in the framebuffer (physical) coordinates, so rotation does not matter.
+typedef struct
+{
+    uint64_t key;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t lastUse;
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint8_t displayMode;
+    bool valid;
+} ImageCacheEntry;
+
+// Header of the cache file on the microSD card (followed by the framebuffer data).
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint64_t key;
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint8_t displayMode;
+    uint8_t reserved[3];
+    uint32_t size;
+} ImageCacheSdHeader;
+
+// Rendered image cache class.
+class ImageCache
+{
+  public:
+    ImageCache();
+    void begin(Inkplate *_inkplatePtr, volatile uint8_t *_screenFramebuffer, volatile uint8_t *_cacheMemory,
+               uint32_t _cacheMemorySize);
+    void enable(bool _en);
+    bool isEnabled();
+    bool enableSd(SdFat *_sdFat, const char *_folder = "/imgcache");
+    void disableSd();
+    void clear();
+    bool draw(uint64_t _key);
+    bool store(uint64_t _key, int _x, int _y, int _w, int _h);
+    uint32_t getHits();
+    uint32_t getMisses();
+
+    static uint64_t hash(uint64_t _hash, const void *_data, size_t _n);
+    static uint64_t hash(uint64_t _hash, volatile uint8_t *_data, size_t _n);
+
+  private:
+    bool physicalRect(int _x, int _y, int _w, int _h, uint16_t *_px, uint16_t *_py, uint16_t *_pw, uint16_t *_ph);
+    void byteSpan(ImageCacheEntry *_entry, uint16_t *_firstByte, uint16_t *_numBytes, uint8_t *_leftMask,
+                  uint8_t *_rightMask);
+    void blit(ImageCacheEntry *_entry);
+    ImageCacheEntry *find(uint64_t _key);
+    ImageCacheEntry *allocate(uint32_t _size);
+    bool findFreeSpace(uint32_t _size, uint32_t *_offset);
+    void evict(ImageCacheEntry *_entry);
+    bool loadFromSd(uint64_t _key);
+    void saveToSd(ImageCacheEntry *_entry);
+    void sdFilename(uint64_t _key, char *_path);
+
+    // Inkplate base class object pointer - needed for the rotation and display mode.
+    Inkplate *_inkplate = NULL;
+
+    // Main ePaper framebuffer (images are drawn there).
+    volatile uint8_t *_framebuffer = NULL;
+
+    // Memory for the cached images (in SDRAM).
+    volatile uint8_t *_memory = NULL;
+    uint32_t _memorySize = 0;
+
+    // All cached images.
+    ImageCacheEntry _entries[IMAGE_CACHE_MAX_ENTRIES];
+
+    // Counter used for LRU.
+    uint32_t _useCounter = 0;
+
+    // Cache is disabled by default.
+    bool _enabled = false;
+
+    // Persistent cache on the microSD card.
+    SdFat *_sd = NULL;
+    char _sdFolder[IMAGE_CACHE_SD_PATH_MAX];
+
+    // Statistics.
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+};
+
+#endif
+
+#endif
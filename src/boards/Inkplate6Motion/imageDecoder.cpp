@@ -18,12 +18,12 @@
 // Block usage on other boards.
 #ifdef BOARD_INKPLATE6_MOTION
 
+// It needs also main Inkplate Motion file to get the base class (and screen size for the callbacks).
+#include "../../InkplateMotion.h"
+
 // Include code for all image decoder callbacks.
 #include "imageDecoderCallbacks.h"
 
-// It needs also main Inkplate Motion file to get the base class.
-#include "../../InkplateMotion.h"
-
 /**
  * @brief Construct a new Image Decoder::Image Decoder object
  *
@@ -44,10 +44,15 @@ ImageDecoder::ImageDecoder()
  *          SDRAM address for temp. storing decoded image.
  * @param   volatile uint8_t *_downloadFileMemory
  *          The address to where image files from web should be downloaded
+ * @param   volatile uint8_t *_screenFramebuffer
+ *          Pointer to the main ePaper framebuffer (used for writing BMP rows directly into it).
+ * @param   volatile uint8_t *_cacheMemory
+ *          SDRAM address for the decoded image cache (IMAGE_CACHE_SDRAM_SIZE bytes).
  *
  */
 void ImageDecoder::begin(Inkplate *_inkplatePtr, WiFiClass *_wifiPtr, ImageProcessing *_imgProcessPtr,
-                         uint8_t *_tempFbAddress, volatile uint8_t *_downloadFileMemory)
+                         uint8_t *_tempFbAddress, volatile uint8_t *_downloadFileMemory,
+                         volatile uint8_t *_screenFramebuffer, volatile uint8_t *_cacheMemory)
 {
     // Save these addresses locally.
     _framebufferHandler.framebuffer = _tempFbAddress;
@@ -55,10 +60,14 @@ void ImageDecoder::begin(Inkplate *_inkplatePtr, WiFiClass *_wifiPtr, ImageProce
     _inkplate = _inkplatePtr;
     _imgProcess = _imgProcessPtr;
     _imageDownloadMemoryPtr = _downloadFileMemory;
+    _screenFramebufferPtr = _screenFramebuffer;
 
     // Set the framebuffer size.
     _framebufferHandler.fbHeight = SCREEN_HEIGHT;
     _framebufferHandler.fbWidth = SCREEN_WIDTH;
+
+    // Initialize the cache for the decoded images.
+    cache.begin(_inkplatePtr, _screenFramebuffer, _cacheMemory, IMAGE_CACHE_SDRAM_SIZE);
 }
 
 /**
@@ -74,18 +83,22 @@ void ImageDecoder::begin(Inkplate *_inkplatePtr, WiFiClass *_wifiPtr, ImageProce
  * @param   bool _invert
  *          true - colors are inverted.
  * @param   uint8_t _dither
- *          Disable or enable dithering on the image as well as choosing dither kernel.
+ *          Dither mode (see InkplateDitherMode) - 0 disabled, 1 error diffusion with the kernel, or ordered dither.
  * @param   enum InkplateImageDecodeFormat _format
  *          Force specific image format (if automatic detecton of the image format fails).
  * @param   enum InkplateImagePathType _pathType
  *          Force specific path where image is stored (web or microSD).
+ * @param   enum InkplateImageScaleMode _scaleMode
+ *          How the image is scaled to the area from X, Y to the edge of the screen. By default, image is not
+ *          scaled (cropped by the screen).
  * @return  bool
  *          true - Image loaded in the ePaper framebuffer succ.
  *          false - Image load failed. Check ImageDecoder::getError() for the reason.
  */
 bool ImageDecoder::draw(const char *_path, int _x, int _y, bool _invert, uint8_t _dither,
                         const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
-                        enum InkplateImageDecodeFormat _format, enum InkplateImagePathType _pathType)
+                        enum InkplateImageDecodeFormat _format, enum InkplateImagePathType _pathType,
+                        enum InkplateImageScaleMode _scaleMode)
 {
     // Check if the path detection is set to auto (it should be by default).
     if (_pathType == INKPLATE_IMAGE_DECODE_PATH_AUTO)
@@ -123,7 +136,7 @@ bool ImageDecoder::draw(const char *_path, int _x, int _y, bool _invert, uint8_t
 
             // Use proper decoder for the image type.
             bool _retValue = drawFromSd(&_file, _x, _y, _invert, _dither, _ditherKernelParameters,
-                                        _ditherKernelParametersSize, _format);
+                                        _ditherKernelParametersSize, _format, _scaleMode);
 
             // Close the file.
             _file.close();
@@ -142,7 +155,7 @@ bool ImageDecoder::draw(const char *_path, int _x, int _y, bool _invert, uint8_t
     {
         // Call drawFromWeb and return the result of that
         return drawFromWeb(_path, _x, _y, _invert, _dither, _ditherKernelParameters, _ditherKernelParametersSize,
-                           _format);
+                           _format, _scaleMode);
     }
 
     // If you got there, there must be something wrong.
@@ -163,16 +176,22 @@ bool ImageDecoder::draw(const char *_path, int _x, int _y, bool _invert, uint8_t
  * @param   bool _invert
  *          true - colors are inverted.
  * @param   uint8_t _dither
- *          Disable or enable dithering on the image as well as choosing dither kernel.
+ *          Dither mode (see InkplateDitherMode) - 0 disabled, 1 error diffusion with the kernel, or ordered dither.
  * @param   enum InkplateImageDecodeFormat _format
  *          Force specific image format (if automatic detecton of the image format fails).
+ * @param   enum InkplateImageScaleMode _scaleMode
+ *          How the image is scaled to the area from X, Y to the edge of the screen.
+ * @param   uint64_t _sourceKey
+ *          Identifies the image for the decoded image cache (for example hash of the name and version of the
+ *          image). If 0, key is made from the size and the whole content of the image (hashed on every call).
  * @return  bool
  *          true - Image loaded in the ePaper framebuffer succ.
  *          false - Image load failed. Check ImageDecoder::getError() for the reason.
  */
 bool ImageDecoder::drawFromBuffer(void *_buffer, size_t _size, int _x, int _y, bool _invert, uint8_t _dither,
                                   const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
-                                  enum InkplateImageDecodeFormat _format)
+                                  enum InkplateImageDecodeFormat _format, enum InkplateImageScaleMode _scaleMode,
+                                  uint64_t _sourceKey)
 {
     // Watch-out! Some decoders have some issues while reading directly from the SDRAM. I'm not sure why...
     // Clear all errors.
@@ -192,29 +211,60 @@ bool ImageDecoder::drawFromBuffer(void *_buffer, size_t _size, int _x, int _y, b
         return false;
     }
 
+    // Native images are already processed, so they go directly into the framebuffer (no need for the cache).
+    if (_format == INKPLATE_IMAGE_DECODE_FORMAT_NATIVE)
+        return drawNative(NULL, (const uint8_t *)_buffer, _size, _x, _y, _invert);
+
+    // Image from the buffer is identified by the key from the caller or by its size and content (images with the
+    // same size can differ anywhere, so the whole buffer is hashed). If it's already decoded, draw it from the cache.
+    uint64_t _cacheKey = 0;
+    if (cache.isEnabled())
+    {
+        if (_sourceKey == 0)
+            _sourceKey = ImageCache::hash(IMAGE_CACHE_HASH_SEED, (volatile uint8_t *)_buffer, _size);
+        _sourceKey = ImageCache::hash(_sourceKey, &_size, sizeof(_size));
+        _cacheKey = cacheKey(_sourceKey, _x, _y, _invert, _dither, _ditherKernelParameters,
+                             _ditherKernelParametersSize, _scaleMode);
+        if (cache.draw(_cacheKey))
+            return true;
+    }
+
+    // Create session handler. Decoded rows go directly into the image processing.
+    InkplateDecoderSessionHandler _sessionHandler;
+    memset(&_sessionHandler, 0, sizeof(InkplateDecoderSessionHandler));
+    _sessionHandler.fileBuffer = (uint8_t *)_buffer;
+    _sessionHandler.frameBufferHandler = &_framebufferHandler;
+    _sessionHandler.bufferOffset = 0;
+    _sessionHandler.fileBufferSize = _size;
+    rowStreamInit(&_sessionHandler, _imgProcess, (uint8_t *)(_inkplate->_dmaBuffer[2]));
+    rowStreamSetScale(&_sessionHandler, _scaleMode, _inkplate->width() - _x, _inkplate->height() - _y);
+    // Direct write into the screen framebuffer is only possible if the screen is not rotated.
+    rowStreamSetScreen(&_sessionHandler, _inkplate->getRotation() == 0 ? _screenFramebufferPtr : NULL,
+                       _inkplate->getDisplayMode(), _x, _y, _invert, _dither != 0);
+
+    // Start the image processing before decode.
+    if (!beginDecode(_x, _y, _invert, _dither, _ditherKernelParameters, _ditherKernelParametersSize))
+        return false;
+
+    // Decode status.
+    bool _decodeOk = false;
+
     // Set the decoder.
-    // Code is similar as for the microSD card, but uses different callbacks and sessionHandlers.
+    // Code is similar as for the microSD card, but uses different callbacks.
     switch (_format)
     {
     case INKPLATE_IMAGE_DECODE_FORMAT_BMP: {
         // Let's initialize BMP decoder.
         memset(&_bmpDecoder, 0, sizeof(BmpDecode_t));
-        InkplateDecoderSessionHandler _sessionHandler;
         _bmpDecoder.inputFeed = &readBytesFromBufferBmp;
         _bmpDecoder.errorCode = BMP_DECODE_NO_ERROR;
-        _sessionHandler.fileBuffer = (uint8_t *)_buffer;
-        _sessionHandler.frameBufferHandler = &_framebufferHandler;
-        _sessionHandler.bufferOffset = 0;
-        _sessionHandler.fileBufferSize = _size;
         _bmpDecoder.output = &writeBytesToFrameBufferBmp;
+        _bmpDecoder.rowOutput = &writeRowToFrameBufferBmp;
         _bmpDecoder.sessionHandler = &_sessionHandler;
+        _sessionHandler.bmpDecoder = &_bmpDecoder;
 
         // Call function to process BMP decoding.
-        if (!inkplateImageDecodeHelpersBmp(&_bmpDecoder, &_decodeError))
-        {
-            // Something went wrong!
-            return false;
-        }
+        _decodeOk = inkplateImageDecodeHelpersBmp(&_bmpDecoder, &_decodeError);
 
         // Check image size and constrain it.
         _imageW = min((int)(SCREEN_WIDTH), (int)(_bmpDecoder.header.infoHeader.width));
@@ -225,18 +275,9 @@ bool ImageDecoder::drawFromBuffer(void *_buffer, size_t _size, int _x, int _y, b
     case INKPLATE_IMAGE_DECODE_FORMAT_JPG: {
         // Initialize the JPG decoder.
         memset(&_jpgDecoder, 0, sizeof(JDEC));
-        InkplateDecoderSessionHandler _sessionHandler;
-        _sessionHandler.fileBuffer = (uint8_t *)_buffer;
-        _sessionHandler.frameBufferHandler = &_framebufferHandler;
-        _sessionHandler.bufferOffset = 0;
-        _sessionHandler.fileBufferSize = _size;
-
-        if (!inkplateImageDecodeHelpersJpg(&_jpgDecoder, &readBytesFromBufferJpg, &writeBytesToFrameBufferJpg,
-                                           &_decodeError, &_sessionHandler))
-        {
-            // Something went wrong with decoding the image!
-            return false;
-        }
+
+        _decodeOk = inkplateImageDecodeHelpersJpg(&_jpgDecoder, &readBytesFromBufferJpg, &writeBytesToFrameBufferJpg,
+                                                  &_decodeError, &_sessionHandler, true, &selectScaleJpg);
 
         // Check image size and constrain it.
         _imageW = min((int)(SCREEN_WIDTH), (int)(_jpgDecoder.width));
@@ -245,20 +286,10 @@ bool ImageDecoder::drawFromBuffer(void *_buffer, size_t _size, int _x, int _y, b
     }
 
     case INKPLATE_IMAGE_DECODE_FORMAT_PNG: {
-        // Create session handler.
-        InkplateDecoderSessionHandler _sessionHandler;
-        _sessionHandler.fileBuffer = (uint8_t *)_buffer;
-        _sessionHandler.frameBufferHandler = &_framebufferHandler;
-        _sessionHandler.bufferOffset = 0;
-        _sessionHandler.fileBufferSize = _size;
-
         // Decode it chunk-by-chunk.
-        if (!inkplateImageDecodeHelpersPng(_pngDecoder, &readBytesFromBufferPng, &writeBytesToFrameBufferPng, &_imageW,
-                                           &_imageH, &_decodeError, &_sessionHandler))
-        {
-            // Something went wrong with decoding the image
-            return false;
-        }
+        _decodeOk = inkplateImageDecodeHelpersPng(_pngDecoder, &readBytesFromBufferPng, &writeBytesToFrameBufferPng,
+                                                  &_imageW, &_imageH, &_decodeError, &_sessionHandler,
+                                                  &writeRowToFrameBufferPng);
 
         // Check image size and constrain it.
         _imageW = min((int)(SCREEN_WIDTH), (int)(_imageW));
@@ -269,17 +300,13 @@ bool ImageDecoder::drawFromBuffer(void *_buffer, size_t _size, int _x, int _y, b
     default: {
         // Somehow no format specified, return error!
         _decodeError = INKPLATE_IMAGE_DECODE_ERR_UNKNOWN_FORMAT;
-        return false;
+        break;
     }
     }
 
-    // Process the image and draw it in the epaper framebuffer.
-    _imgProcess->processImage((uint8_t *)(_framebufferHandler.framebuffer), _x, _y, _imageW, _imageH, _dither, _invert,
-                              _ditherKernelParameters, _ditherKernelParametersSize,
-                              _inkplate->getDisplayMode() == INKPLATE_1BW ? 1 : 4);
-
-    // Decoded ok? Return true!
-    return true;
+    // Process the rest of the image and end the decode.
+    return endDecode(&_sessionHandler, _decodeOk, _x, _y, _imageW, _imageH, _invert, _dither,
+                     _ditherKernelParameters, _ditherKernelParametersSize, _cacheKey);
 }
 
 /**
@@ -294,16 +321,22 @@ bool ImageDecoder::drawFromBuffer(void *_buffer, size_t _size, int _x, int _y, b
  * @param   bool _invert
  *          true - Colors are inverted.
  * @param   uint8_t _dither
- *          Disable or enable dithering on the image as well as choosing dither kernel.
+ *          Dither mode (see InkplateDitherMode) - 0 disabled, 1 error diffusion with the kernel, or ordered dither.
  * @param   enum InkplateImageDecodeFormat _format
  *          Force specific image format (if automatic detecton of the image format fails).
+ * @param   enum InkplateImageScaleMode _scaleMode
+ *          How the image is scaled to the area from X, Y to the edge of the screen.
+ * @param   uint64_t _sourceKey
+ *          Identifies the file content for the decoded image cache. If 0, it's made from the file location on the
+ *          microSD card, size and modification time.
  * @return  bool
  *          true - Image loaded and decoded succ.
  *          false -  Image load/decode failed. Check ImageDecoder::getError() for reason.
  */
 bool ImageDecoder::drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t _dither,
                               const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
-                              enum InkplateImageDecodeFormat _format)
+                              enum InkplateImageDecodeFormat _format, enum InkplateImageScaleMode _scaleMode,
+                              uint64_t _sourceKey)
 {
     // Reset error variable.
     _decodeError = INKPLATE_IMAGE_DECODE_NO_ERR;
@@ -319,8 +352,46 @@ bool ImageDecoder::drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t
         return false;
     }
 
-    // Get the file size.
-    uint32_t _fileSize = _file->size();
+    // Native images are already processed, so they go directly into the framebuffer (no need for the cache).
+    if (_format == INKPLATE_IMAGE_DECODE_FORMAT_NATIVE)
+        return drawNative(_file, NULL, 0, _x, _y, _invert);
+
+    // File is identified by its location on the microSD card, size and modification time.
+    // If it's already decoded, draw it from the cache.
+    uint64_t _cacheKey = 0;
+    if (cache.isEnabled())
+    {
+        if (_sourceKey == 0)
+        {
+            uint32_t _fileId[3] = {_file->firstSector(), (uint32_t)(_file->fileSize()), 0};
+            uint16_t _fileDate = 0, _fileTime = 0;
+            _file->getModifyDateTime(&_fileDate, &_fileTime);
+            _fileId[2] = ((uint32_t)(_fileDate) << 16) | _fileTime;
+            _sourceKey = ImageCache::hash(IMAGE_CACHE_HASH_SEED, _fileId, sizeof(_fileId));
+        }
+        _cacheKey = cacheKey(_sourceKey, _x, _y, _invert, _dither, _ditherKernelParameters,
+                             _ditherKernelParametersSize, _scaleMode);
+        if (cache.draw(_cacheKey))
+            return true;
+    }
+
+    // Create session handler. Decoded rows go directly into the image processing.
+    InkplateDecoderSessionHandler _sessionHandler;
+    memset(&_sessionHandler, 0, sizeof(InkplateDecoderSessionHandler));
+    _sessionHandler.file = _file;
+    _sessionHandler.frameBufferHandler = &_framebufferHandler;
+    rowStreamInit(&_sessionHandler, _imgProcess, (uint8_t *)(_inkplate->_dmaBuffer[2]));
+    rowStreamSetScale(&_sessionHandler, _scaleMode, _inkplate->width() - _x, _inkplate->height() - _y);
+    // Direct write into the screen framebuffer is only possible if the screen is not rotated.
+    rowStreamSetScreen(&_sessionHandler, _inkplate->getRotation() == 0 ? _screenFramebufferPtr : NULL,
+                       _inkplate->getDisplayMode(), _x, _y, _invert, _dither != 0);
+
+    // Start the image processing before decode.
+    if (!beginDecode(_x, _y, _invert, _dither, _ditherKernelParameters, _ditherKernelParametersSize))
+        return false;
+
+    // Decode status.
+    bool _decodeOk = false;
 
     // Check what decoder needs to be used.
     switch (_format)
@@ -328,17 +399,15 @@ bool ImageDecoder::drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t
     case INKPLATE_IMAGE_DECODE_FORMAT_BMP: {
         // Let's initialize BMP decoder.
         memset(&_bmpDecoder, 0, sizeof(BmpDecode_t));
-        InkplateDecoderSessionHandler _sessionHandler;
         _bmpDecoder.inputFeed = &readBytesFromSdBmp;
         _bmpDecoder.errorCode = BMP_DECODE_NO_ERROR;
-        _sessionHandler.file = _file;
-        _sessionHandler.frameBufferHandler = &_framebufferHandler;
         _bmpDecoder.output = &writeBytesToFrameBufferBmp;
+        _bmpDecoder.rowOutput = &writeRowToFrameBufferBmp;
         _bmpDecoder.sessionHandler = &_sessionHandler;
+        _sessionHandler.bmpDecoder = &_bmpDecoder;
 
         // Call function to process BMP decoding.
-        if (!inkplateImageDecodeHelpersBmp(&_bmpDecoder, &_decodeError))
-            return false;
+        _decodeOk = inkplateImageDecodeHelpersBmp(&_bmpDecoder, &_decodeError);
 
         // Check image size and constrain it.
         _imageW = min((int)(SCREEN_WIDTH), (int)(_bmpDecoder.header.infoHeader.width));
@@ -348,13 +417,9 @@ bool ImageDecoder::drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t
     case INKPLATE_IMAGE_DECODE_FORMAT_JPG: {
         // Initialize the JPG decoder.
         memset(&_jpgDecoder, 0, sizeof(JDEC));
-        InkplateDecoderSessionHandler _sessionHandler;
-        _sessionHandler.file = _file;
-        _sessionHandler.frameBufferHandler = &_framebufferHandler;
 
-        if (!inkplateImageDecodeHelpersJpg(&_jpgDecoder, &readBytesFromSdJpg, &writeBytesToFrameBufferJpg,
-                                           &_decodeError, &_sessionHandler))
-            return false;
+        _decodeOk = inkplateImageDecodeHelpersJpg(&_jpgDecoder, &readBytesFromSdJpg, &writeBytesToFrameBufferJpg,
+                                                  &_decodeError, &_sessionHandler, true, &selectScaleJpg);
 
         // Check image size and constrain it.
         _imageW = min((int)(SCREEN_WIDTH), (int)(_jpgDecoder.width));
@@ -362,15 +427,10 @@ bool ImageDecoder::drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t
         break;
     }
     case INKPLATE_IMAGE_DECODE_FORMAT_PNG: {
-        // Create session handler.
-        InkplateDecoderSessionHandler _sessionHandler;
-        _sessionHandler.file = _file;
-        _sessionHandler.frameBufferHandler = &_framebufferHandler;
-
         // Decode it chunk-by-chunk.
-        if (!inkplateImageDecodeHelpersPng(_pngDecoder, readBytesFromSdPng, writeBytesToFrameBufferPng, &_imageW,
-                                           &_imageH, &_decodeError, &_sessionHandler))
-            return false;
+        _decodeOk = inkplateImageDecodeHelpersPng(_pngDecoder, readBytesFromSdPng, writeBytesToFrameBufferPng,
+                                                  &_imageW, &_imageH, &_decodeError, &_sessionHandler,
+                                                  &writeRowToFrameBufferPng);
 
         // Check image size and constrain it.
         _imageW = min((int)(SCREEN_WIDTH), (int)(_imageW));
@@ -381,23 +441,29 @@ bool ImageDecoder::drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t
     default: {
         // Set error flag.
         _decodeError = INKPLATE_IMAGE_DECODE_ERR_UNKNOWN_FORMAT;
-
-        // Return false for fail.
-        return false;
+        break;
     }
     }
 
-    // Process the image and draw it in the epaper framebuffer.
-    _imgProcess->processImage((uint8_t *)(_framebufferHandler.framebuffer), _x, _y, _imageW, _imageH, _dither, _invert,
-                              _ditherKernelParameters, _ditherKernelParametersSize,
-                              _inkplate->getDisplayMode() == INKPLATE_1BW ? 1 : 4);
-
-    // Everything went ok? Return success!
-    return true;
+    // Process the rest of the image and end the decode.
+    return endDecode(&_sessionHandler, _decodeOk, _x, _y, _imageW, _imageH, _invert, _dither,
+                     _ditherKernelParameters, _ditherKernelParametersSize, _cacheKey);
 }
 
 /**
- * @brief This function draws an image from web, it has format auto-detection. Max image file size is by default 4MB.
+ * @brief This function draws an image from web, it has format auto-detection. JPG and PNG images are decoded while
+ * they are downloaded (see ImageDecoder::setWebStreaming()), so there is no limit for the file size. Other formats
+ * (and all images if the cache is enabled) are downloaded first; max image file size for them is by default 4MB. If
+ * the cache is enabled and the server sends ETag or Last-Modified, decoded image is found in the cache by the URL and
+ * these validators before the download, so a cache hit costs only the HTTP HEAD request. Without the validators the
+ * key is made from the downloaded file, so the image is downloaded every time (only the decode is saved). If the
+ * webCache is enabled, downloaded images are saved on the microSD card and next time they are loaded from there if
+ * the server reports that the image is not modified.
+ *
+ * @note With the cache or the webCache enabled every image costs one extra HTTP HEAD request before the download (the
+ * GET response does not carry the ETag and Last-Modified headers). It's sent even if the image can't be stored later
+ * (server sends no validators, or the image is too large and is streamed), since that is only known after the
+ * request. Disable the caches for images that change on every request.
  *
  * @note Not all image formats and HTTP servers are created equal. There is support for all these image formats, but the
  * software can't handle every possible case. If your image doesn't work, please try exporting it from a different image
@@ -416,6 +482,8 @@ bool ImageDecoder::drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t
  * @param   enum InkplateImageDecodeFormat _format
  *          The format of the image, you can pass AUTO and it will be detected in-function. Check the enum for more
  * details
+ * @param   enum InkplateImageScaleMode _scaleMode
+ *          How the image is scaled to the area from X, Y to the edge of the screen.
  *
  * @return  bool
  *          True if everything was successful, false if something went wront
@@ -423,29 +491,682 @@ bool ImageDecoder::drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t
  */
 bool ImageDecoder::drawFromWeb(const char *_path, int _x, int _y, bool _invert, uint8_t _dither,
                                const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
-                               enum InkplateImageDecodeFormat _format)
+                               enum InkplateImageDecodeFormat _format, enum InkplateImageScaleMode _scaleMode)
 {
-    // Let's download  the file and save it to the image download memory
+    // Clear all errors.
+    _decodeError = INKPLATE_IMAGE_DECODE_NO_ERR;
+
+    // Set the URL.
     WiFiClient client;
-    uint32_t fileSize = client.downloadFile(_path, _imageDownloadMemoryPtr, DOWNLOAD_IMAGE_MAX_SIZE); // 4MB buffer size
+    if (!client.begin(_path))
+    {
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_DOWNLOAD_FAIL;
+        return false;
+    }
 
-    // Didn't download file? There was an error!
-    if (fileSize == 0)
+    // If there is a copy of the image on the microSD card, ask the server if the image is changed (conditional
+    // request with the saved ETag and Last-Modified). If it's not changed, use the copy without downloading it.
+    if (webCache.isEnabled())
+    {
+        WebCacheEntry *_cached = webCache.find(_path);
+        if ((_cached != NULL) && client.notModified(_cached->etag, _cached->lastModified))
+        {
+            File _file;
+            if (webCache.open(_cached, &_file))
+            {
+                // Detect the format from the copy.
+                if (_format == INKPLATE_IMAGE_DECODE_FORMAT_AUTO)
+                {
+                    uint8_t _fileSignature[10] = {0};
+                    _file.read(_fileSignature, 10);
+                    _file.rewind();
+                    _format = inkplateImageDecodeHelpersDetectImageFormat((char *)_path, _fileSignature);
+                }
+
+                // Draw it like any other image from the microSD card. The copy is rewritten in place when the image
+                // changes, so the decoded image cache key is made from the URL and validators instead of the file.
+                uint64_t _sourceKey = webSourceKey(_path, _cached->etag, _cached->lastModified);
+
+                // Nothing will be downloaded, release the HTTP client first.
+                client.end();
+                bool _retValue = drawFromSd(&_file, _x, _y, _invert, _dither, _ditherKernelParameters,
+                                            _ditherKernelParametersSize, _format, _scaleMode, _sourceKey);
+                _file.close();
+                return _retValue;
+            }
+        }
+        else if (_cached == NULL)
+        {
+            // Not cached yet, get the validators for the new copy (conditional request already got them).
+            client.HEAD();
+        }
+    }
+    else if (cache.isEnabled())
+    {
+        // Validators are needed for the decoded image cache key.
+        client.HEAD();
+    }
+
+    // If the server sent the validators, decoded image cache key is made from them (same key as for the copy on the
+    // microSD card), otherwise from the downloaded image. Check the cache before anything is downloaded.
+    uint64_t _sourceKey = webSourceKey(_path, client.getETag(), client.getLastModified());
+    if (cache.isEnabled() && (_sourceKey != 0))
+    {
+        if (cache.draw(cacheKey(_sourceKey, _x, _y, _invert, _dither, _ditherKernelParameters,
+                                _ditherKernelParametersSize, _scaleMode)))
+        {
+            client.end();
+            return true;
+        }
+    }
+
+    // Start the HTTP GET request. First chunk of the file is received here.
+    if (!client.GET())
+    {
+        client.end();
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_DOWNLOAD_FAIL;
         return false;
+    }
 
     // Let's check if format needs to be detected
     if (_format == INKPLATE_IMAGE_DECODE_FORMAT_AUTO)
     {
         // Format needs to be detected
-        // First, copy the first 10 bytes to a buffer which will be used to read the file signature
-        uint8_t fileHeader[10];
-        memcpy(fileHeader, (void *)_imageDownloadMemoryPtr, 10);
+        // First, copy the first 10 bytes of the first chunk to a buffer which will be used to read the file signature
+        uint8_t fileHeader[10] = {0};
+        client.peek((char *)fileHeader, sizeof(fileHeader));
         _format = inkplateImageDecodeHelpersDetectImageFormat((char *)_path, fileHeader);
     }
 
+    // JPG and PNG decoders only read forward, so they can be fed directly from the HTTP stream. BMP rows are stored
+    // bottom-up (decoder needs random access), streamed images are not stored in the decoded image cache and the
+    // copy on the microSD card is written from the downloaded file, so these are downloaded first. Files that do not
+    // fit into the download memory are always streamed.
+    bool _streamable = (_format == INKPLATE_IMAGE_DECODE_FORMAT_JPG) || (_format == INKPLATE_IMAGE_DECODE_FORMAT_PNG);
+    bool _needsFile = cache.isEnabled() || webCache.isEnabled();
+    if (_streamable && ((client.size() > DOWNLOAD_IMAGE_MAX_SIZE) || (_webStreaming && !_needsFile)))
+    {
+        return drawFromStream(&client, _x, _y, _invert, _dither, _ditherKernelParameters,
+                              _ditherKernelParametersSize, _format, _scaleMode);
+    }
+
+    // Let's download the rest of the file and save it to the image download memory
+    uint32_t fileSize = client.readToBuffer(_imageDownloadMemoryPtr, DOWNLOAD_IMAGE_MAX_SIZE); // 4MB buffer size
+
+    // Didn't download file? There was an error!
+    if (fileSize == 0)
+    {
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_DOWNLOAD_FAIL;
+        return false;
+    }
+
+    // Save the copy on the microSD card for the next time (only if the server sent the validators).
+    if (webCache.isEnabled())
+        webCache.store(_path, client.getETag(), client.getLastModified(), _imageDownloadMemoryPtr, fileSize);
+
     // Now, draw the image from the buffer and return the result of that
     return drawFromBuffer((void *)_imageDownloadMemoryPtr, fileSize, _x, _y, _invert, _dither, _ditherKernelParameters,
-                          _ditherKernelParametersSize, _format);
+                          _ditherKernelParametersSize, _format, _scaleMode, _sourceKey);
+}
+
+/**
+ * @brief   Decodes JPG or PNG image directly from the HTTP stream. Decoder reads every chunk as soon as it's received
+ *          from the ESP32, so download and decode overlap and there is no limit for the file size. Image is not
+ *          stored in the cache. This is usually called from ImageDecoder::drawFromWeb().
+ *
+ * @param   WiFiClient *_client
+ *          Pointer to the WiFiClient object. HTTP GET must be already started. Transfer is ended here.
+ * @param   int _x
+ *          X position of the image in the epaper framebuffer.
+ * @param   int _y
+ *          Y position of the image in the epaper framebuffer.
+ * @param   bool _invert
+ *          true - Colors are inverted.
+ * @param   uint8_t _dither
+ *          Dither mode (see InkplateDitherMode) - 0 disabled, 1 error diffusion with the kernel, or ordered dither.
+ * @param   enum InkplateImageDecodeFormat _format
+ *          Image format (only INKPLATE_IMAGE_DECODE_FORMAT_JPG and INKPLATE_IMAGE_DECODE_FORMAT_PNG can be streamed).
+ * @param   enum InkplateImageScaleMode _scaleMode
+ *          How the image is scaled to the area from X, Y to the edge of the screen.
+ * @return  bool
+ *          true - Image loaded and decoded succ.
+ *          false -  Image load/decode failed. Check ImageDecoder::getError() for reason.
+ */
+bool ImageDecoder::drawFromStream(WiFiClient *_client, int _x, int _y, bool _invert, uint8_t _dither,
+                                  const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
+                                  enum InkplateImageDecodeFormat _format, enum InkplateImageScaleMode _scaleMode)
+{
+    // Image width and height parameters (known after image decode).
+    int _imageW = 0;
+    int _imageH = 0;
+
+    // Create session handler. Decoded rows go directly into the image processing.
+    // Buffer offset counts received bytes and buffer size is the file size reported by the server (0 if unknown).
+    InkplateDecoderSessionHandler _sessionHandler;
+    memset(&_sessionHandler, 0, sizeof(InkplateDecoderSessionHandler));
+    _sessionHandler.client = _client;
+    _sessionHandler.frameBufferHandler = &_framebufferHandler;
+    _sessionHandler.bufferOffset = 0;
+    _sessionHandler.fileBufferSize = _client->size();
+    rowStreamInit(&_sessionHandler, _imgProcess, (uint8_t *)(_inkplate->_dmaBuffer[2]));
+    rowStreamSetScale(&_sessionHandler, _scaleMode, _inkplate->width() - _x, _inkplate->height() - _y);
+    // Direct write into the screen framebuffer is only possible if the screen is not rotated.
+    rowStreamSetScreen(&_sessionHandler, _inkplate->getRotation() == 0 ? _screenFramebufferPtr : NULL,
+                       _inkplate->getDisplayMode(), _x, _y, _invert, _dither != 0);
+
+    // Start the image processing before decode.
+    if (!beginDecode(_x, _y, _invert, _dither, _ditherKernelParameters, _ditherKernelParametersSize))
+    {
+        webStreamDrain(&_sessionHandler);
+        _client->end();
+        return false;
+    }
+
+    // Decode status.
+    bool _decodeOk = false;
+
+    // Code is similar as for the microSD card, but uses HTTP stream callbacks.
+    switch (_format)
+    {
+    case INKPLATE_IMAGE_DECODE_FORMAT_JPG: {
+        // Initialize the JPG decoder.
+        memset(&_jpgDecoder, 0, sizeof(JDEC));
+
+        _decodeOk = inkplateImageDecodeHelpersJpg(&_jpgDecoder, &readBytesFromWebJpg, &writeBytesToFrameBufferJpg,
+                                                  &_decodeError, &_sessionHandler, true, &selectScaleJpg);
+
+        // Check image size and constrain it.
+        _imageW = min((int)(SCREEN_WIDTH), (int)(_jpgDecoder.width));
+        _imageH = min((int)(SCREEN_HEIGHT), (int)(_jpgDecoder.height));
+        break;
+    }
+
+    case INKPLATE_IMAGE_DECODE_FORMAT_PNG: {
+        // Decode it chunk-by-chunk, as chunks arrive.
+        _decodeOk = inkplateImageDecodeHelpersPng(_pngDecoder, &readBytesFromWebPng, &writeBytesToFrameBufferPng,
+                                                  &_imageW, &_imageH, &_decodeError, &_sessionHandler,
+                                                  &writeRowToFrameBufferPng);
+
+        // Check image size and constrain it.
+        _imageW = min((int)(SCREEN_WIDTH), (int)(_imageW));
+        _imageH = min((int)(SCREEN_HEIGHT), (int)(_imageH));
+        break;
+    }
+
+    default: {
+        // This format can't be streamed.
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_UNKNOWN_FORMAT;
+        break;
+    }
+    }
+
+    // Skip everything decoder did not read (data after the end of the image or after an error) and end the transfer.
+    webStreamDrain(&_sessionHandler);
+    _client->end();
+
+    // Process the rest of the image and end the decode. Streamed images are not cached.
+    return endDecode(&_sessionHandler, _decodeOk, _x, _y, _imageW, _imageH, _invert, _dither,
+                     _ditherKernelParameters, _ditherKernelParametersSize, 0);
+}
+
+/**
+ * @brief   Loads native Inkplate image (.ipi) from the microSD card or from the buffer. Image data is already
+ *          dithered and packed in the framebuffer format, so if the image matches current display mode, screen is
+ *          not rotated and X position is on the byte boundary, rows are copied directly into the framebuffer by the
+ *          DMA2D (many rows from one multi-sector microSD read at once). Otherwise, every pixel is drawn with
+ *          drawPixel(). Dither and scale are not used for these images.
+ *
+ * @param   File *_file
+ *          Pointer to the opened file on the microSD card. NULL if the image is loaded from the buffer.
+ * @param   const uint8_t *_buffer
+ *          Pointer to the image in the memory. NULL if the image is loaded from the microSD card.
+ * @param   size_t _size
+ *          Size of the image in the buffer in bytes.
+ * @param   int _x
+ *          X position of the image in the epaper framebuffer.
+ * @param   int _y
+ *          Y position of the image in the epaper framebuffer.
+ * @param   bool _invert
+ *          true - Colors are inverted.
+ * @return  bool
+ *          true - Image loaded succ.
+ *          false - Image load failed. Check ImageDecoder::getError() for reason.
+ */
+bool ImageDecoder::drawNative(File *_file, const uint8_t *_buffer, size_t _size, int _x, int _y, bool _invert)
+{
+    // Read position inside the buffer.
+    size_t _offset = 0;
+
+    // Read the header and check it.
+    InkplateNativeImageHeader _header;
+    if (!nativeRead(_file, _buffer, _size, &_offset, &_header, sizeof(_header)) ||
+        !inkplateImageDecodeHelpersNativeHeader(&_header))
+    {
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_NATIVE_FAULT;
+        return false;
+    }
+
+    // Move to the image data.
+    _offset = _header.dataOffset;
+    if ((_file != NULL) && !_file->seekSet(_offset))
+    {
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_NATIVE_FAULT;
+        return false;
+    }
+
+    // Image is completely outside of the screen? Nothing to do.
+    int _screenW = _inkplate->width();
+    int _screenH = _inkplate->height();
+    if ((_x >= _screenW) || (_y >= _screenH) || ((_x + _header.width) <= 0) || ((_y + _header.height) <= 0))
+        return true;
+
+    // Get the visible part of the image (rows below the screen are not even read).
+    int _rows = min((int)(_header.height), _screenH - _y);
+    uint16_t _startPixel = (_x < 0) ? -_x : 0;
+    uint16_t _endPixel = min((int)(_header.width), _screenW - _x);
+
+    // Check if the rows can be copied directly into the framebuffer.
+    uint8_t _displayMode = _inkplate->getDisplayMode();
+    uint8_t _pixelsPerByte = 8 / _header.bpp;
+    bool _direct = (_inkplate->getRotation() == 0) && (_x >= 0) && (_y >= 0) && ((_x % _pixelsPerByte) == 0) &&
+                   (((_header.bpp == 1) && (_displayMode == INKPLATE_1BW)) ||
+                    ((_header.bpp == 4) && (_displayMode != INKPLATE_1BW)));
+    uint32_t _fbStride = (_displayMode == INKPLATE_1BW) ? (SCREEN_WIDTH / 8) : (SCREEN_WIDTH / 2);
+    uint16_t _directBytes = _direct ? (_endPixel / _pixelsPerByte) : 0;
+    volatile uint8_t *_fbPtr = _screenFramebufferPtr + (_fbStride * _y) + (_x / _pixelsPerByte);
+
+    // Uncompressed image from the memory does not even need a copy.
+    if (_direct && (_buffer != NULL) && !_invert && !(_header.flags & INKPLATE_NATIVE_IMAGE_FLAG_RLE))
+    {
+        // Check if the whole image is there.
+        if ((_offset + ((size_t)(_header.stride) * _rows)) > _size)
+        {
+            _decodeError = INKPLATE_IMAGE_DECODE_ERR_NATIVE_FAULT;
+            return false;
+        }
+
+        // Copy all rows at once.
+        stm32Dma2dCopy(_buffer + _offset, _header.stride, _fbPtr, _fbStride, _directBytes, _rows);
+
+        // Draw the pixels that are not filling the whole byte at the right edge.
+        if ((_directBytes * _pixelsPerByte) < _endPixel)
+        {
+            for (int i = 0; i < _rows; i++)
+            {
+                nativeDrawPixels(_buffer + _offset + ((size_t)(_header.stride) * i), _header.bpp, _x, _y + i,
+                                 _directBytes * _pixelsPerByte, _endPixel);
+            }
+        }
+
+        return true;
+    }
+
+    // Allocate the buffer for as many rows as possible (and one for the compressed row, if needed).
+    decodeArenaReset();
+    int _chunkRows = max(1, min(_rows, (int)(NATIVE_IMAGE_CHUNK_SIZE / _header.stride)));
+    uint8_t *_chunk = (uint8_t *)decodeArenaMalloc((size_t)(_chunkRows) * _header.stride);
+    size_t _packedSize = _header.stride + (_header.stride / 128) + 1;
+    uint8_t *_packed = NULL;
+    if (_header.flags & INKPLATE_NATIVE_IMAGE_FLAG_RLE)
+        _packed = (uint8_t *)decodeArenaMalloc(_packedSize);
+    if ((_chunk == NULL) || ((_header.flags & INKPLATE_NATIVE_IMAGE_FLAG_RLE) && (_packed == NULL)))
+    {
+        decodeArenaFree(_packed);
+        decodeArenaFree(_chunk);
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_NO_MEMORY;
+        return false;
+    }
+
+    // Load it chunk by chunk.
+    bool _ok = true;
+    int _row = 0;
+    while (_ok && (_row < _rows))
+    {
+        int _n = min(_chunkRows, _rows - _row);
+
+        if (!(_header.flags & INKPLATE_NATIVE_IMAGE_FLAG_RLE))
+        {
+            // Read all rows at once.
+            _ok = nativeRead(_file, _buffer, _size, &_offset, _chunk, (size_t)(_n) * _header.stride);
+        }
+        else
+        {
+            // Each row starts with its compressed size.
+            for (int i = 0; _ok && (i < _n); i++)
+            {
+                uint16_t _packedRowSize = 0;
+                _ok = nativeRead(_file, _buffer, _size, &_offset, &_packedRowSize, sizeof(_packedRowSize)) &&
+                      (_packedRowSize <= _packedSize) &&
+                      nativeRead(_file, _buffer, _size, &_offset, _packed, _packedRowSize) &&
+                      (inkplateImageDecodeHelpersNativeUnpackRow(_packed, _packedRowSize,
+                                                                 _chunk + ((size_t)(_header.stride) * i),
+                                                                 _header.stride) == _packedRowSize);
+            }
+        }
+
+        if (!_ok)
+            break;
+
+        // Invert the colors. XOR with all ones turns every sample v into (max - v) for every bit depth, so black and
+        // white are swapped in all formats (1 bit: 1 is black, 2 and 4 bit: 0 is black and max is white).
+        if (_invert)
+        {
+            for (size_t i = 0; i < ((size_t)(_n) * _header.stride); i++)
+            {
+                _chunk[i] ^= 0xFF;
+            }
+        }
+
+        // Copy the whole bytes into the framebuffer. Chunk is written by the CPU (cached), stm32Dma2dCopy() cleans
+        // the source range from the D-Cache before the DMA2D reads it.
+        if (_direct)
+            stm32Dma2dCopy(_chunk, _header.stride, _fbPtr + (_fbStride * _row), _fbStride, _directBytes, _n);
+
+        // Draw everything that could not be copied.
+        if ((_directBytes * _pixelsPerByte) < _endPixel)
+        {
+            for (int i = 0; i < _n; i++)
+            {
+                nativeDrawPixels(_chunk + ((size_t)(_header.stride) * i), _header.bpp, _x, _y + _row + i,
+                                 _direct ? (_directBytes * _pixelsPerByte) : _startPixel, _endPixel);
+            }
+        }
+
+        _row += _n;
+    }
+
+    // Release the buffers. Arena reset does not release the ones that did not fit into the arena (heap fallback).
+    decodeArenaFree(_packed);
+    decodeArenaFree(_chunk);
+
+    // Check if the image is broken (file too short or bad compressed data).
+    if (!_ok)
+    {
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_NATIVE_FAULT;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief   Reads the bytes of the native image from the microSD card or from the buffer.
+ *
+ * @param   File *_file
+ *          Pointer to the opened file on the microSD card. If NULL, buffer is used.
+ * @param   const uint8_t *_buffer
+ *          Pointer to the image in the memory.
+ * @param   size_t _size
+ *          Size of the image in the buffer in bytes.
+ * @param   size_t *_offset
+ *          Current read position inside the buffer (updated after the read).
+ * @param   void *_dst
+ *          Where to store read bytes.
+ * @param   size_t _n
+ *          Number of bytes to read.
+ * @return  bool
+ *          true - All bytes were read.
+ *          false - End of the file / buffer.
+ */
+bool ImageDecoder::nativeRead(File *_file, const uint8_t *_buffer, size_t _size, size_t *_offset, void *_dst,
+                              size_t _n)
+{
+    // Read from the microSD card. Large reads are done sector by sector directly into the destination buffer.
+    if (_file != NULL)
+        return (_file->read(_dst, _n) == (int)(_n));
+
+    // Otherwise use the buffer.
+    if ((_buffer == NULL) || ((*_offset + _n) > _size))
+        return false;
+
+    memcpy(_dst, _buffer + *_offset, _n);
+    (*_offset) += _n;
+
+    return true;
+}
+
+/**
+ * @brief   Draws pixels of one native image row by using drawPixel() (rotated screen, different bit depth
+ *          than display mode or pixels that are not on the byte boundary).
+ *
+ * @param   const uint8_t *_row
+ *          Pointer to the native image row.
+ * @param   uint8_t _bpp
+ *          Bits per pixel of the native image (1, 2 or 4).
+ * @param   int _x
+ *          X position of the image on the screen.
+ * @param   int _y
+ *          Y position of this row on the screen.
+ * @param   uint16_t _start
+ *          First pixel in the row that will be drawn.
+ * @param   uint16_t _end
+ *          Pixel after the last drawn pixel.
+ */
+void ImageDecoder::nativeDrawPixels(const uint8_t *_row, uint8_t _bpp, int _x, int _y, uint16_t _start,
+                                    uint16_t _end)
+{
+    bool _bwMode = (_inkplate->getDisplayMode() == INKPLATE_1BW);
+
+    for (uint16_t i = _start; i < _end; i++)
+    {
+        // Get the pixel as 4 bit gray level (0 = black, 15 = white).
+        uint8_t _level;
+        if (_bpp == 1)
+        {
+            _level = (_row[i >> 3] & (0x80 >> (i & 7))) ? 0 : 15;
+        }
+        else if (_bpp == 2)
+        {
+            _level = ((_row[i >> 2] >> ((i & 3) * 2)) & 0x03) * 5;
+        }
+        else
+        {
+            _level = (_row[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+        }
+
+        // In 1 bit mode, 1 is black.
+        _inkplate->drawPixel(_x + i, _y, _bwMode ? (_level < 8) : _level);
+    }
+}
+
+/**
+ * @brief   Starts the image processing row stream before the decode. Decoded rows are processed
+ *          (inverted, dithered and written into the epaper framebuffer) while the image is decoded.
+ *
+ * @param   int _x
+ *          X position of the image in the epaper framebuffer.
+ * @param   int _y
+ *          Y position of the image in the epaper framebuffer.
+ * @param   bool _invert
+ *          true - Colors are inverted.
+ * @param   uint8_t _dither
+ *          Disable or enable dithering on the image.
+ * @param   const KernelElement *_ditherKernelParameters
+ *          Pointer to the dither kernel parameters.
+ * @param   size_t _ditherKernelParametersSize
+ *          Dither kernels size.
+ * @return  bool
+ *          true - Image processing is ready.
+ *          false - Image processing failed to start (no memory).
+ */
+bool ImageDecoder::beginDecode(int _x, int _y, bool _invert, uint8_t _dither,
+                               const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize)
+{
+    // Release all working memory from the previous decode.
+    decodeArenaReset();
+
+    if (!_imgProcess->beginRowStream(_x, _y, _dither, _invert, _ditherKernelParameters, _ditherKernelParametersSize,
+                                     _inkplate->getDisplayMode() == INKPLATE_1BW ? 1 : 4))
+    {
+        // Free anything that has been allocated.
+        _imgProcess->endRowStream();
+
+        // Set the error flag.
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_NO_MEMORY;
+        return false;
+    }
+
+    // Everything is ready.
+    return true;
+}
+
+/**
+ * @brief   Ends the decode. Processes the last rows left in the decoder session band buffer and
+ *          ends the row stream. If the image could not be streamed (interlaced PNG), it's processed
+ *          from the temp. framebuffer.
+ *
+ * @param   void *_sessionHandlerPtr
+ *          Pointer to the InkplateDecoderSessionHandler used for decode.
+ * @param   bool _decodeOk
+ *          Decode status returned by the decoder.
+ * @param   int _x
+ *          X position of the image in the epaper framebuffer.
+ * @param   int _y
+ *          Y position of the image in the epaper framebuffer.
+ * @param   int _imageW
+ *          Width of the decoded image (constrained to the screen).
+ * @param   int _imageH
+ *          Height of the decoded image (constrained to the screen).
+ * @param   bool _invert
+ *          true - Colors are inverted.
+ * @param   uint8_t _dither
+ *          Disable or enable dithering on the image.
+ * @param   const KernelElement *_ditherKernelParameters
+ *          Pointer to the dither kernel parameters.
+ * @param   size_t _ditherKernelParametersSize
+ *          Dither kernels size.
+ * @param   uint64_t _cacheKey
+ *          Key for storing the decoded image into the cache (0 if cache is not used).
+ * @return  bool
+ *          Decode status (_decodeOk).
+ */
+bool ImageDecoder::endDecode(void *_sessionHandlerPtr, bool _decodeOk, int _x, int _y, int _imageW, int _imageH,
+                             bool _invert, uint8_t _dither, const KernelElement *_ditherKernelParameters,
+                             size_t _ditherKernelParametersSize, uint64_t _cacheKey)
+{
+    // Get the session handler.
+    InkplateDecoderSessionHandler *_sessionHandler = (InkplateDecoderSessionHandler *)_sessionHandlerPtr;
+
+    // Process the last band (if decoding failed, show what has been decoded so far).
+    rowStreamFlush(_sessionHandler);
+
+    // End the row stream (and the scaling).
+    rowStreamEnd(_sessionHandler);
+    _imgProcess->endRowStream();
+
+    // Memory for the scaling could not be allocated? Return error.
+    if (_sessionHandler->streamError)
+    {
+        _decodeError = INKPLATE_IMAGE_DECODE_ERR_NO_MEMORY;
+        return false;
+    }
+
+    // Image was not streamed? Process it from the temp. framebuffer.
+    if (_decodeOk && _sessionHandler->fullFrame)
+    {
+        _imgProcess->processImage((uint8_t *)(_framebufferHandler.framebuffer), _x, _y, _imageW, _imageH, _dither,
+                                  _invert, _ditherKernelParameters, _ditherKernelParametersSize,
+                                  _inkplate->getDisplayMode() == INKPLATE_1BW ? 1 : 4);
+    }
+
+    // Save the decoded image into the cache. Size on the screen is known only if the image was streamed.
+    if (_decodeOk && (_cacheKey != 0))
+    {
+        int _drawnW = _sessionHandler->sourceSet ? _sessionHandler->outW : _imageW;
+        int _drawnH = _sessionHandler->sourceSet ? _sessionHandler->outH : _imageH;
+        cache.store(_cacheKey, _x, _y, _drawnW, _drawnH);
+    }
+
+    // Return the decode status.
+    return _decodeOk;
+}
+
+/**
+ * @brief   Makes the key for the image cache. Same image drawn with different parameters (position, dither,
+ *          invert, scale, display mode, rotation or serpentine dither) is cached separately.
+ *
+ * @param   uint64_t _sourceKey
+ *          Hash of the image source (file or buffer content).
+ * @param   int _x
+ *          X position of the image in the epaper framebuffer.
+ * @param   int _y
+ *          Y position of the image in the epaper framebuffer.
+ * @param   bool _invert
+ *          true - Colors are inverted.
+ * @param   uint8_t _dither
+ *          Disable or enable dithering on the image.
+ * @param   const KernelElement *_ditherKernelParameters
+ *          Pointer to the dither kernel parameters.
+ * @param   size_t _ditherKernelParametersSize
+ *          Dither kernels size.
+ * @param   enum InkplateImageScaleMode _scaleMode
+ *          How the image is scaled.
+ * @return  uint64_t
+ *          Cache key (never 0).
+ */
+uint64_t ImageDecoder::cacheKey(uint64_t _sourceKey, int _x, int _y, bool _invert, uint8_t _dither,
+                                const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
+                                enum InkplateImageScaleMode _scaleMode)
+{
+    // All parameters that change the output (including the image processing settings, like the scan order of the
+    // error diffusion).
+    int32_t _params[9] = {_x,
+                          _y,
+                          _invert,
+                          _dither,
+                          _scaleMode,
+                          _inkplate->getDisplayMode(),
+                          _inkplate->getRotation(),
+                          (int32_t)(_ditherKernelParametersSize),
+                          _imgProcess->getSerpentineDither()};
+    uint64_t _key = ImageCache::hash(_sourceKey, _params, sizeof(_params));
+
+    // Kernel is used only if dithering is enabled.
+    if (_dither && (_ditherKernelParameters != NULL))
+        _key = ImageCache::hash(_key, _ditherKernelParameters, sizeof(KernelElement) * _ditherKernelParametersSize);
+
+    // 0 means "not cached".
+    return (_key != 0) ? _key : 1;
+}
+
+/**
+ * @brief   Makes the image source key for the decoded image cache from the URL and the HTTP validators (ETag and
+ *          Last-Modified), so the image from the web can be found in the cache before it's downloaded.
+ *
+ * @param   const char *_url
+ *          URL of the image.
+ * @param   const char *_etag
+ *          ETag sent by the server (empty string if unknown).
+ * @param   const char *_lastModified
+ *          Last-Modified sent by the server (empty string if unknown).
+ * @return  uint64_t
+ *          Image source key, 0 if the server did not send any validator (image must be identified by the content).
+ */
+uint64_t ImageDecoder::webSourceKey(const char *_url, const char *_etag, const char *_lastModified)
+{
+    // Without validators the same URL can give a different image.
+    if ((_etag[0] == '\0') && (_lastModified[0] == '\0'))
+        return 0;
+
+    uint64_t _key = ImageCache::hash(IMAGE_CACHE_HASH_SEED, _url, strlen(_url));
+    _key = ImageCache::hash(_key, _etag, strlen(_etag));
+    return ImageCache::hash(_key, _lastModified, strlen(_lastModified));
+}
+
+/**
+ * @brief   Enables or disables decoding JPG and PNG images from the web while they are downloaded. If disabled,
+ *          image is downloaded into the SDRAM first (up to DOWNLOAD_IMAGE_MAX_SIZE) and then decoded. Images larger
+ *          than DOWNLOAD_IMAGE_MAX_SIZE are always streamed.
+ *
+ * @param   bool _en
+ *          true - Stream decode is enabled (default).
+ *          false - Stream decode is disabled.
+ * @note    If the cache or the webCache is enabled, images are always downloaded first, since both store the
+ *          image from the downloaded file.
+ */
+void ImageDecoder::setWebStreaming(bool _en)
+{
+    _webStreaming = _en;
 }
 
 /**
@@ -463,4 +1184,27 @@ enum InkplateImageDecodeErrors ImageDecoder::getError()
     return _decodeError;
 }
 
+/**
+ * @brief   Returns the max. amount of the decode arena memory used by the decoders and image processing
+ *          since startup. Used for tuning the DECODE_ARENA_SIZE (see system/decodeArena.h).
+ *
+ * @return  size_t
+ *          High-water mark of the decode arena in bytes.
+ */
+size_t ImageDecoder::getMemoryHighWaterMark()
+{
+    return decodeArenaHighWaterMark();
+}
+
+/**
+ * @brief   Returns how many times the decode arena was too small and heap was used instead.
+ *
+ * @return  uint32_t
+ *          Number of the heap allocations since startup (should be zero).
+ */
+uint32_t ImageDecoder::getMemoryHeapFallbacks()
+{
+    return decodeArenaHeapFallbacks();
+}
+
 #endif
\ No newline at end of file
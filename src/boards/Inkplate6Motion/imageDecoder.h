@@ -28,12 +28,22 @@
 // Include Image Processing library as well.
 #include "../../libs/imageProcessing/imageProcessing.h"
 
+// Include cache for the decoded images.
+#include "imageCache.h"
+
+// Include cache for the downloaded images.
+#include "webCache.h"
+
 // Define the maximum downloadable file size for images (for drawImageFromWeb and draw functions)
 #define DOWNLOAD_IMAGE_MAX_SIZE 4 * 1024 * 1024 // 4MB by default
 
-// Forward declaration of the Inkplate Class and WiFiClass.
+// Size of the buffer used for loading native (.ipi) images - that many bytes are read from the microSD at once.
+#define NATIVE_IMAGE_CHUNK_SIZE (32 * 1024ULL)
+
+// Forward declaration of the Inkplate Class, WiFiClass and WiFiClient.
 class Inkplate;
 class WiFiClass;
+class WiFiClient;
 
 // Image decode framebuffer typedef.
 typedef struct
@@ -49,26 +59,67 @@ class ImageDecoder
   public:
     ImageDecoder();
     void begin(Inkplate *_inkplatePtr, WiFiClass *_wifiPtr, ImageProcessing *_imgProcessPtr, uint8_t *_tempFbAddress,
-               volatile uint8_t *_downloadFileMemory);
+               volatile uint8_t *_downloadFileMemory, volatile uint8_t *_screenFramebuffer,
+               volatile uint8_t *_cacheMemory);
     bool draw(const char *_path, int _x, int _y, bool _invert, uint8_t _dither,
               const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
               enum InkplateImageDecodeFormat _format = INKPLATE_IMAGE_DECODE_FORMAT_AUTO,
-              enum InkplateImagePathType _pathType = INKPLATE_IMAGE_DECODE_PATH_AUTO);
+              enum InkplateImagePathType _pathType = INKPLATE_IMAGE_DECODE_PATH_AUTO,
+              enum InkplateImageScaleMode _scaleMode = INKPLATE_IMAGE_SCALE_NONE);
     bool drawFromBuffer(void *_buffer, size_t _size, int _x, int _y, bool _invert, uint8_t _dither,
                         const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
-                        enum InkplateImageDecodeFormat _format);
+                        enum InkplateImageDecodeFormat _format,
+                        enum InkplateImageScaleMode _scaleMode = INKPLATE_IMAGE_SCALE_NONE, uint64_t _sourceKey = 0);
     bool drawFromSd(File *_file, int _x, int _y, bool _invert, uint8_t _dither,
                     const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
-                    enum InkplateImageDecodeFormat _format);
+                    enum InkplateImageDecodeFormat _format,
+                    enum InkplateImageScaleMode _scaleMode = INKPLATE_IMAGE_SCALE_NONE, uint64_t _sourceKey = 0);
     bool drawFromWeb(const char *_path, int _x, int _y, bool _invert, uint8_t _dither,
                      const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
-                     enum InkplateImageDecodeFormat _format);
+                     enum InkplateImageDecodeFormat _format,
+                     enum InkplateImageScaleMode _scaleMode = INKPLATE_IMAGE_SCALE_NONE);
+
+    // Enable or disable decoding images from the web while they are downloaded (enabled by default).
+    void setWebStreaming(bool _en);
 
     // Get what kind of error ImageDecode class got.
     // Note that there is seperate method for the each image decoder errors.
     enum InkplateImageDecodeErrors getError();
 
+    // Get the decode working memory usage (max. bytes used and number of allocations that did not fit).
+    size_t getMemoryHighWaterMark();
+    uint32_t getMemoryHeapFallbacks();
+
+    // Cache for the decoded images (disabled by default, use cache.enable(true)).
+    ImageCache cache;
+
+    // Copies of the downloaded images on the microSD card (disabled by default, use webCache.enable(&sdFat)).
+    WebCache webCache;
+
   private:
+    // Start and end of the image processing for the each decode.
+    bool beginDecode(int _x, int _y, bool _invert, uint8_t _dither, const KernelElement *_ditherKernelParameters,
+                     size_t _ditherKernelParametersSize);
+    bool endDecode(void *_sessionHandlerPtr, bool _decodeOk, int _x, int _y, int _imageW, int _imageH, bool _invert,
+                   uint8_t _dither, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
+                   uint64_t _cacheKey);
+
+    // Decodes image directly from the HTTP stream (without downloading the whole file first).
+    bool drawFromStream(WiFiClient *_client, int _x, int _y, bool _invert, uint8_t _dither,
+                        const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
+                        enum InkplateImageDecodeFormat _format, enum InkplateImageScaleMode _scaleMode);
+
+    // Loader for the native (pre-dithered and already packed) Inkplate images.
+    bool drawNative(File *_file, const uint8_t *_buffer, size_t _size, int _x, int _y, bool _invert);
+    bool nativeRead(File *_file, const uint8_t *_buffer, size_t _size, size_t *_offset, void *_dst, size_t _n);
+    void nativeDrawPixels(const uint8_t *_row, uint8_t _bpp, int _x, int _y, uint16_t _start, uint16_t _end);
+
+    // Makes the image cache key from the image source and all processing parameters.
+    uint64_t cacheKey(uint64_t _sourceKey, int _x, int _y, bool _invert, uint8_t _dither,
+                      const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize,
+                      enum InkplateImageScaleMode _scaleMode);
+    static uint64_t webSourceKey(const char *_url, const char *_etag, const char *_lastModified);
+
     // Inkplate base class object pointer - needed for Inkplate::drawPixel();
     Inkplate *_inkplate;
 
@@ -78,7 +129,7 @@ class ImageDecoder
     // Class for the image processing and displying content on the screen after decode.
     ImageProcessing *_imgProcess;
 
-    // Framebuffer handler.
+    // Framebuffer handler (only used for images that can't be decoded row-by-row, like interlaced PNG).
     InkplateImageDecodeFBHandler _framebufferHandler;
 
     // Handle for each of the decoders.
@@ -89,6 +140,12 @@ class ImageDecoder
     // Pointer to memory where images are downloaded via Wifi
     volatile uint8_t *_imageDownloadMemoryPtr;
 
+    // Pointer to the main ePaper framebuffer.
+    volatile uint8_t *_screenFramebufferPtr;
+
+    // Decode JPG and PNG images from the web while they are downloaded.
+    bool _webStreaming = true;
+
     // Decoded image error log.
     enum InkplateImageDecodeErrors _decodeError = INKPLATE_IMAGE_DECODE_NO_ERR;
 };
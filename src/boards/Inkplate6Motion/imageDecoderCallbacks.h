@@ -25,6 +25,18 @@
 #include "../../libs/bmpDecode/bmpDecode.h"
 #include "../../libs/pngle/pngle.h"
 
+// Include image processing for the decoded rows.
+#include "../../libs/imageProcessing/imageProcessing.h"
+
+// Max. number of rows decoded at once (max. JPG MCU height). Band buffer must be at least
+// INKPLATE_DECODER_BAND_MAX_ROWS * SCREEN_WIDTH bytes in size.
+#define INKPLATE_DECODER_BAND_MAX_ROWS 16
+
+// Byte order of the TJpgDec RGB888 output (JD_FORMAT 0). mcu_output() in tjpgd.c writes R, G and then B.
+#define INKPLATE_DECODER_JPG_RED   0
+#define INKPLATE_DECODER_JPG_GREEN 1
+#define INKPLATE_DECODER_JPG_BLUE  2
+
 /**
  * @brief   Session handler. Used by image decoder to be able to pass buffers, file,
  *          framebuffer etc into the decoder callbacks.
@@ -36,9 +48,310 @@ typedef struct
     size_t fileBufferSize;
     size_t bufferOffset;
     File *file;
+    WiFiClient *client;
     InkplateImageDecodeFBHandler *frameBufferHandler;
+    ImageProcessing *imageProcessing;
+    BmpDecode_t *bmpDecoder;
+    uint8_t *bandBuffer;
+    uint16_t bandStride;
+    uint8_t bandMaxRows;
+    bool bandAllocated;
+    int16_t bandTop;
+    uint8_t bandRows;
+    uint16_t bandWidth;
+    bool fullFrame;
+    enum InkplateImageScaleMode scaleMode;
+    int areaW;
+    int areaH;
+    bool sourceSet;
+    int outW;
+    int outH;
+    bool resample;
+    bool streamError;
+    volatile uint8_t *screenFramebuffer;
+    uint8_t displayMode;
+    int16_t imageX;
+    int16_t imageY;
+    bool invert;
+    bool dither;
+    bool direct;
+    uint8_t rowLut[256];
 } InkplateDecoderSessionHandler;
 
+/**
+ * @brief   Initializes the row stream part of the session handler. Decoded pixels are converted into
+ *          grayscale and stored in the band buffer (one or more image rows). When decoder moves to the
+ *          next row/band, finished rows are sent into the image processing (invert, dither, framebuffer
+ *          write), so there is no need for the temp. RGB888 framebuffer in the SDRAM.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ * @param   ImageProcessing *_imageProcessing
+ *          Pointer to the image processing object. Row stream must be started before decode.
+ * @param   uint8_t *_bandBuffer
+ *          Buffer for the decoded rows. Must be at least INKPLATE_DECODER_BAND_MAX_ROWS * SCREEN_WIDTH bytes.
+ */
+void static rowStreamInit(InkplateDecoderSessionHandler *_session, ImageProcessing *_imageProcessing,
+                          uint8_t *_bandBuffer)
+{
+    _session->imageProcessing = _imageProcessing;
+    _session->bandBuffer = _bandBuffer;
+    _session->bandStride = SCREEN_WIDTH;
+    _session->bandMaxRows = INKPLATE_DECODER_BAND_MAX_ROWS;
+    _session->bandAllocated = false;
+    _session->bandTop = 0;
+    _session->bandRows = 0;
+    _session->bandWidth = 0;
+    _session->fullFrame = false;
+    _session->scaleMode = INKPLATE_IMAGE_SCALE_NONE;
+    _session->areaW = SCREEN_WIDTH;
+    _session->areaH = SCREEN_HEIGHT;
+    _session->sourceSet = false;
+    _session->resample = false;
+    _session->streamError = false;
+    _session->screenFramebuffer = NULL;
+    _session->direct = false;
+}
+
+/**
+ * @brief   Sets the screen framebuffer parameters. Used by the decoders that can write rows directly into the
+ *          screen framebuffer (without the image processing) if the image already matches the display mode.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ * @param   volatile uint8_t *_framebuffer
+ *          Pointer to the screen framebuffer. NULL disables direct write (for example, if the screen is rotated).
+ * @param   uint8_t _displayMode
+ *          Current display mode (INKPLATE_1BW or INKPLATE_GL16).
+ * @param   int _x
+ *          X position of the image on the screen.
+ * @param   int _y
+ *          Y position of the image on the screen.
+ * @param   bool _invert
+ *          true - Colors are inverted.
+ * @param   bool _dither
+ *          true - Image is dithered.
+ */
+void static rowStreamSetScreen(InkplateDecoderSessionHandler *_session, volatile uint8_t *_framebuffer,
+                               uint8_t _displayMode, int _x, int _y, bool _invert, bool _dither)
+{
+    _session->screenFramebuffer = _framebuffer;
+    _session->displayMode = _displayMode;
+    _session->imageX = _x;
+    _session->imageY = _y;
+    _session->invert = _invert;
+    _session->dither = _dither;
+}
+
+/**
+ * @brief   Sets how the image is scaled. Must be called before decode.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ * @param   enum InkplateImageScaleMode _mode
+ *          Scale mode (none, fit, fill or stretch).
+ * @param   int _areaW
+ *          Width of the area where the image is drawn.
+ * @param   int _areaH
+ *          Height of the area where the image is drawn.
+ */
+void static rowStreamSetScale(InkplateDecoderSessionHandler *_session, enum InkplateImageScaleMode _mode, int _areaW,
+                              int _areaH)
+{
+    _session->scaleMode = _mode;
+    _session->areaW = _areaW;
+    _session->areaH = _areaH;
+}
+
+/**
+ * @brief   Sets the size of the decoded image (known only after the decoder parsed the header). If the image
+ *          needs to be scaled, band buffer large enough for the source rows is allocated and resampler
+ *          in the image processing is started.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ * @param   int _srcW
+ *          Width of the decoded image (after the decoder scaling, if used).
+ * @param   int _srcH
+ *          Height of the decoded image (after the decoder scaling, if used).
+ * @param   uint8_t _maxRows
+ *          Max. number of rows decoder outputs at once (MCU height for JPG, 1 for others).
+ * @return  bool
+ *          true - Row stream is ready.
+ *          false - Memory allocation failed.
+ */
+bool static rowStreamSetSource(InkplateDecoderSessionHandler *_session, int _srcW, int _srcH, uint8_t _maxRows)
+{
+    // Set it only once.
+    if (_session->sourceSet)
+        return !_session->streamError;
+    _session->sourceSet = true;
+
+    // Size of the image on the screen (changed below if the image is scaled).
+    _session->outW = _srcW;
+    _session->outH = _srcH;
+
+    // No scaling? Nothing to do.
+    if (_session->scaleMode == INKPLATE_IMAGE_SCALE_NONE)
+        return true;
+
+    // Get the size of the scaled image.
+    int _dstW, _dstH;
+    inkplateImageDecodeHelpersScaledSize(_session->scaleMode, _srcW, _srcH, _session->areaW, _session->areaH, &_dstW,
+                                         &_dstH);
+
+    // Same size? No need for the resampler.
+    if ((_dstW == _srcW) && (_dstH == _srcH))
+        return true;
+
+    // Visible part of the scaled image. Image that fills the area is cropped at the center.
+    int _outW = min(_dstW, _session->areaW);
+    int _outH = min(_dstH, _session->areaH);
+    int _cropX = (_dstW - _outW) / 2;
+    int _cropY = (_dstH - _outH) / 2;
+
+    // Source rows can be wider than the screen, so the band buffer must be allocated.
+    _maxRows = min((int)(_maxRows), INKPLATE_DECODER_BAND_MAX_ROWS);
+    _session->bandBuffer = (uint8_t *)decodeArenaMalloc((size_t)_srcW * _maxRows);
+    if ((_session->bandBuffer == NULL) || (_srcW > 0xFFFF) || (_srcH > 0xFFFF) || (_dstW > 0xFFFF) ||
+        (_dstH > 0xFFFF) ||
+        !_session->imageProcessing->beginResample(_srcW, _srcH, _dstW, _dstH, _cropX, _cropY, _outW, _outH))
+    {
+        // Release the memory and mark the error. Decoder callbacks will stop the decode.
+        if (_session->bandBuffer != NULL)
+            decodeArenaFree(_session->bandBuffer);
+        _session->bandBuffer = NULL;
+        _session->streamError = true;
+        return false;
+    }
+
+    // Use the new band buffer.
+    _session->bandAllocated = true;
+    _session->bandStride = _srcW;
+    _session->bandMaxRows = _maxRows;
+    _session->outW = _outW;
+    _session->outH = _outH;
+    _session->resample = true;
+
+    return true;
+}
+
+/**
+ * @brief   Sends all rows from the band buffer into the image processing.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ */
+void static rowStreamFlush(InkplateDecoderSessionHandler *_session)
+{
+    // Process row-by-row, but only rows that are on the screen.
+    for (int _row = 0; _row < _session->bandRows; _row++)
+    {
+        if (_session->resample)
+        {
+            // Image is scaled, resampler needs every row (it will output rows in the screen size).
+            _session->imageProcessing->resampleRow(_session->bandBuffer + (_row * _session->bandStride));
+        }
+        else if ((_session->bandTop + _row) < SCREEN_HEIGHT)
+        {
+            _session->imageProcessing->processRow(_session->bandBuffer + (_row * _session->bandStride),
+                                                  _session->bandWidth, _session->bandTop + _row);
+        }
+    }
+
+    // Band is empty now.
+    _session->bandRows = 0;
+    _session->bandWidth = 0;
+}
+
+/**
+ * @brief   Gets the band buffer for the selected rows. If the decoder moved to the new band, old one is
+ *          processed first.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ * @param   int16_t _top
+ *          First row of the band (Y position inside the image).
+ * @param   uint8_t _rows
+ *          Number of rows in the band.
+ * @return  uint8_t*
+ *          Pointer to the band buffer (first pixel of the _top row) or NULL if the band is outside the image.
+ */
+static uint8_t *rowStreamSelectBand(InkplateDecoderSessionHandler *_session, int16_t _top, uint8_t _rows)
+{
+    // Still in the same band? Just return the buffer.
+    if ((_session->bandRows != 0) && (_session->bandTop == _top))
+        return _session->bandBuffer;
+
+    // New band, process the old one.
+    rowStreamFlush(_session);
+
+    // Check for bounds!
+    if ((_top < 0) || (_session->bandBuffer == NULL))
+        return NULL;
+
+    // Set new band. Fill it with white so missing pixels won't show up as black.
+    _session->bandTop = _top;
+    _session->bandRows = min((int)(_rows), (int)(_session->bandMaxRows));
+    memset(_session->bandBuffer, 0xFF, _session->bandRows * _session->bandStride);
+
+    // Return the buffer.
+    return _session->bandBuffer;
+}
+
+/**
+ * @brief   Ends the row stream. Releases the memory allocated for the scaling.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ */
+void static rowStreamEnd(InkplateDecoderSessionHandler *_session)
+{
+    // Stop the resampler.
+    if (_session->resample)
+        _session->imageProcessing->endResample();
+    _session->resample = false;
+
+    // Free the band buffer if it's allocated.
+    if (_session->bandAllocated)
+        decodeArenaFree(_session->bandBuffer);
+    _session->bandAllocated = false;
+    _session->bandBuffer = NULL;
+}
+
+/**
+ * @brief   Function handles writing one pixel into the row stream.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ * @param   int16_t _x
+ *          X position of the current pixel.
+ * @param   int16_t _y
+ *          Y position of the current pixel.
+ * @param   uint32_t _color
+ *          Pixel color (must be RGB888).
+ *
+ * @note    Pixels must come row-by-row, from top to bottom.
+ */
+void static drawIntoRowStream(InkplateDecoderSessionHandler *_session, int16_t _x, int16_t _y, uint32_t _color)
+{
+    // Check for bounds!
+    if ((_x >= _session->bandStride) || (_x < 0) || (_y < 0))
+        return;
+
+    // Get the buffer for this row.
+    uint8_t *_band = rowStreamSelectBand(_session, _y, 1);
+    if (_band == NULL)
+        return;
+
+    // Convert it to the grayscale and save it.
+    _band[_x] = ImageProcessing::toGrayscale(_color >> 16, (_color >> 8) & 0xFF, _color & 0xFF);
+
+    // Update the row width.
+    if (_x >= _session->bandWidth)
+        _session->bandWidth = _x + 1;
+}
+
 /**
  * @brief   Function handles writing pixels into the temp. framebuffer fro decoded image.
  *
@@ -128,8 +441,200 @@ void static writeBytesToFrameBufferBmp(void *_sessionHandlerPtr, int16_t _x, int
     // Decode _sessionHandler buffer into DecoderSessionHandler.
     InkplateDecoderSessionHandler *_sessionHandler = (InkplateDecoderSessionHandler *)_sessionHandlerPtr;
 
-    // Draw pixel into the frame buffer.
-    drawIntoFramebuffer(_sessionHandler->frameBufferHandler, _x, _y, _color);
+    // Image size is known at the first pixel (header is already parsed).
+    if (!_sessionHandler->sourceSet && (_sessionHandler->bmpDecoder != NULL))
+    {
+        rowStreamSetSource(_sessionHandler, _sessionHandler->bmpDecoder->header.infoHeader.width,
+                           _sessionHandler->bmpDecoder->header.infoHeader.height, 1);
+    }
+
+    // Send pixel into the row stream.
+    drawIntoRowStream(_sessionHandler, _x, _y, _color);
+}
+
+/**
+ * @brief   Prepares the BMP row output. Calculates grayscale value of each palette color and checks if
+ *          the image can be copied directly into the screen framebuffer (1 bit BMP in 1 bit mode or 4 bit BMP
+ *          in 4 bit mode, aligned to the framebuffer bytes).
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ * @param   BmpDecode_t *_bmpDecodeHandler
+ *          BMP Decoder specific handler. Header must be already parsed.
+ */
+void static prepareRowOutputBmp(InkplateDecoderSessionHandler *_session, BmpDecode_t *_bmpDecodeHandler)
+{
+    BmpInfo *_info = &_bmpDecodeHandler->header.infoHeader;
+
+    // Grayscale value of each color from the palette.
+    uint8_t _grayPalette[256];
+    if (_bmpDecodeHandler->header.customPalette)
+    {
+        for (int i = 0; i < (1 << _info->bitCount); i++)
+        {
+            BmpColorTable *_color = &_bmpDecodeHandler->header.colorTable[i];
+            _grayPalette[i] = ImageProcessing::toGrayscale(_color->red, _color->green, _color->blue);
+        }
+    }
+
+    // Check if the image can be written directly into the screen framebuffer.
+    _session->direct = false;
+    bool _canCopy = (_session->screenFramebuffer != NULL) && !_session->resample && (_session->imageX >= 0) &&
+                    (_session->imageY >= 0) && ((_session->imageX + _info->width) <= SCREEN_WIDTH);
+
+    if (_canCopy && (_info->bitCount == 1) && (_session->displayMode == INKPLATE_1BW) &&
+        ((_session->imageX % 8) == 0) && ((_info->width % 8) == 0))
+    {
+        // In 1 bit mode, bit set means black pixel. Check what each BMP bit value should be.
+        uint8_t _mask0 = (_grayPalette[0] < 128) ? 0xFF : 0x00;
+        uint8_t _mask1 = (_grayPalette[1] < 128) ? 0xFF : 0x00;
+        if (_session->invert)
+        {
+            _mask0 = ~_mask0;
+            _mask1 = ~_mask1;
+        }
+
+        // Make a LUT for the whole byte (8 pixels).
+        for (int i = 0; i < 256; i++)
+        {
+            _session->rowLut[i] = (i & _mask1) | (~i & _mask0);
+        }
+
+        _session->direct = true;
+    }
+    else if (_canCopy && !_session->dither && (_info->bitCount == 4) && (_session->displayMode == INKPLATE_GL16) &&
+             ((_session->imageX % 2) == 0) && ((_info->width % 2) == 0))
+    {
+        // 4 bit value of each palette color.
+        uint8_t _palette4Bit[16];
+        for (int i = 0; i < 16; i++)
+        {
+            _palette4Bit[i] = _session->invert ? (15 - (_grayPalette[i] >> 4)) : (_grayPalette[i] >> 4);
+        }
+
+        // Make a LUT for the whole byte (2 pixels). BMP has the first pixel in the upper nibble,
+        // framebuffer has it in the lower nibble.
+        for (int i = 0; i < 256; i++)
+        {
+            _session->rowLut[i] = _palette4Bit[i >> 4] | (_palette4Bit[i & 0x0F] << 4);
+        }
+
+        _session->direct = true;
+    }
+    else if (_bmpDecodeHandler->header.customPalette)
+    {
+        // Image processing is needed, LUT is just grayscale palette.
+        memcpy(_session->rowLut, _grayPalette, 1 << _info->bitCount);
+    }
+}
+
+/**
+ * @brief   Callback for the BMP decoder to write the whole decoded row. Row is copied directly into the screen
+ *          framebuffer (if the image matches the display mode) or it's converted into the grayscale and sent
+ *          into the row stream.
+ *
+ * @param   BmpDecode_t *_bmpDecodeHandler
+ *          BMP Decoder specific handler. Must not be null!
+ * @param   int16_t _y
+ *          Y position of the row inside the image.
+ * @param   uint8_t *_rowData
+ *          Raw BMP row data.
+ */
+void static writeRowToFrameBufferBmp(BmpDecode_t *_bmpDecodeHandler, int16_t _y, uint8_t *_rowData)
+{
+    // Get the session typedef from the bmpDecoder handler.
+    InkplateDecoderSessionHandler *_session = (InkplateDecoderSessionHandler *)_bmpDecodeHandler->sessionHandler;
+    BmpInfo *_info = &_bmpDecodeHandler->header.infoHeader;
+
+    // First row? Set everything up (header is already parsed).
+    if (!_session->sourceSet)
+    {
+        rowStreamSetSource(_session, _info->width, _info->height, 1);
+        prepareRowOutputBmp(_session, _bmpDecodeHandler);
+    }
+
+    // Scaling setup failed? Skip it.
+    if (_session->streamError)
+        return;
+
+    // Copy directly into the screen framebuffer?
+    if (_session->direct)
+    {
+        // Check for bounds!
+        int _fbY = _y + _session->imageY;
+        if ((_fbY < 0) || (_fbY >= SCREEN_HEIGHT))
+            return;
+
+        // 8 pixels per byte in 1 bit mode, 2 pixels per byte in 4 bit mode.
+        uint8_t _pixelsPerByte = (_session->displayMode == INKPLATE_1BW) ? 8 : 2;
+        uint32_t _fbRowBytes = SCREEN_WIDTH / _pixelsPerByte;
+        uint16_t _rowBytes = _info->width / _pixelsPerByte;
+
+        // Convert the row in the internal RAM first, framebuffer in the SDRAM is written at once.
+        for (int _x = 0; _x < _rowBytes; _x++)
+        {
+            _session->bandBuffer[_x] = _session->rowLut[_rowData[_x]];
+        }
+        memcpy((uint8_t *)_session->screenFramebuffer + (_fbRowBytes * _fbY) + (_session->imageX / _pixelsPerByte),
+               _session->bandBuffer, _rowBytes);
+        return;
+    }
+
+    // Get the band for this row.
+    uint8_t *_band = rowStreamSelectBand(_session, _y, 1);
+    if (_band == NULL)
+        return;
+
+    // Clip the row to the band.
+    int _w = min((int)(_info->width), (int)(_session->bandStride));
+
+    // Convert the row into the grayscale.
+    switch (_info->bitCount)
+    {
+    case 1:
+        for (int _x = 0; _x < _w; _x++)
+        {
+            _band[_x] = _session->rowLut[(_rowData[_x >> 3] >> (7 - (_x & 7))) & 1];
+        }
+        break;
+
+    case 4:
+        for (int _x = 0; _x < _w; _x++)
+        {
+            _band[_x] = _session->rowLut[(_rowData[_x >> 1] >> ((_x & 1) ? 0 : 4)) & 0x0F];
+        }
+        break;
+
+    case 8:
+        for (int _x = 0; _x < _w; _x++)
+        {
+            _band[_x] = _session->rowLut[_rowData[_x]];
+        }
+        break;
+
+    case 16:
+        for (int _x = 0; _x < _w; _x++)
+        {
+            // Extract the individual color components from 565RGB and upscale them into 8 bit.
+            uint16_t _rawPixelData = (_rowData[(_x * 2) + 1] << 8) | _rowData[_x * 2];
+            uint8_t _r = (_rawPixelData >> 11) & 0b00011111;
+            uint8_t _g = (_rawPixelData >> 5) & 0b00111111;
+            uint8_t _b = _rawPixelData & 0b00011111;
+            _band[_x] = ImageProcessing::toGrayscale((_r << 3) | (_r >> 2), (_g << 2) | (_g >> 4), (_b << 3) | (_b >> 2));
+        }
+        break;
+
+    case 24:
+        for (int _x = 0; _x < _w; _x++)
+        {
+            // BMP stores colors as BGR.
+            _band[_x] = ImageProcessing::toGrayscale(_rowData[(_x * 3) + 2], _rowData[(_x * 3) + 1], _rowData[_x * 3]);
+        }
+        break;
+    }
+
+    // Update the row width.
+    _session->bandWidth = _w;
 }
 
 /**
@@ -197,30 +702,89 @@ int static writeBytesToFrameBufferJpg(JDEC *_jd, void *_bitmap, JRECT *_rect)
     // Use 8 bits for the bitmap and framebuffer representation.
     uint8_t *_decodedData = (uint8_t *)(_bitmap);
 
-    // Write the pixels into the framebuffer!
-    // DMA2D could be used here?
-    for (int _y = 0; _y < _h; _y++)
-    {
-        // Calculate source starting points for the current row.
-        int srcIndex = (_w * _y);
+    // Scaling setup failed? Stop the decoder.
+    if (_sessionHandle->streamError)
+        return 0;
 
-        for (int _x = 0; _x < _w; _x++)
+    // Get the band buffer for this MCU row (all MCUs in the same row share the band).
+    uint8_t *_band = rowStreamSelectBand(_sessionHandle, _y0, _h);
+    if (_band == NULL)
+        return 1;
+
+    // Clip the MCU to the band width (screen width if the image is not scaled) and the band height.
+    int _visibleW = min(_w, (int)(_sessionHandle->bandStride) - _x0);
+    int _visibleH = min(_h, (int)(_sessionHandle->bandRows));
+
+    // MCU is completely outside of the screen? Skip it.
+    if (_visibleW <= 0)
+        return 1;
+
+    // Luma-only output? Decoder already gives 8 bit grayscale, just copy it into the band.
+    if (_jd->grayscale)
+    {
+        for (int _y = 0; _y < _visibleH; _y++)
         {
-            // Get the RGB values.
-            uint8_t r = _decodedData[((srcIndex + _x) * 3) + 2];
-            uint8_t g = _decodedData[((srcIndex + _x) * 3) + 1];
-            uint8_t b = _decodedData[((srcIndex + _x) * 3)];
-
-            // Write the pixel into temp. framebuffer for decoded images.
-            drawIntoFramebuffer(_sessionHandle->frameBufferHandler, _x + _x0, _y + _y0,
-                                ((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b));
+            memcpy(_band + (_y * _sessionHandle->bandStride) + _x0, _decodedData + (_w * _y), _visibleW);
+        }
+    }
+    else
+    {
+        // Convert the pixels into grayscale and store them in the band.
+        for (int _y = 0; _y < _visibleH; _y++)
+        {
+            // Calculate source and destination starting points for the current row.
+            uint8_t *_src = _decodedData + (_w * _y * 3);
+            uint8_t *_dst = _band + (_y * _sessionHandle->bandStride) + _x0;
+
+            for (int _x = 0; _x < _visibleW; _x++)
+            {
+                _dst[_x] = ImageProcessing::toGrayscale(_src[INKPLATE_DECODER_JPG_RED],
+                                                        _src[INKPLATE_DECODER_JPG_GREEN],
+                                                        _src[INKPLATE_DECODER_JPG_BLUE]);
+                _src += 3;
+            }
         }
     }
 
+    // Update the band width.
+    if ((_x0 + _visibleW) > _sessionHandle->bandWidth)
+        _sessionHandle->bandWidth = _x0 + _visibleW;
+
     // Return 1 for success.
     return 1;
 }
 
+/**
+ * @brief   Callback for the JPG decoder to select the output scale. Called after the JPG header is parsed.
+ *          Uses the largest decoder scale (1/2, 1/4 or 1/8) that still keeps the image larger than the
+ *          scaled image; the rest is done by the resampler.
+ *
+ * @param   JDEC *_jd
+ *          JPG Decoder specific handler. Must not be null!
+ * @return  uint8_t
+ *          TJpgDec scale (0 - 1/1, 1 - 1/2, 2 - 1/4, 3 - 1/8).
+ */
+uint8_t static selectScaleJpg(JDEC *_jd)
+{
+    // Session identifier (5th argument of jd_prepare function).
+    InkplateDecoderSessionHandler *_sessionHandle = (InkplateDecoderSessionHandler *)_jd->device;
+
+    // Decoder scale is only used if the image is scaled.
+    uint8_t _scale = 0;
+    if (_sessionHandle->scaleMode != INKPLATE_IMAGE_SCALE_NONE)
+    {
+        int _dstW, _dstH;
+        inkplateImageDecodeHelpersScaledSize(_sessionHandle->scaleMode, _jd->width, _jd->height,
+                                             _sessionHandle->areaW, _sessionHandle->areaH, &_dstW, &_dstH);
+        _scale = inkplateImageDecodeHelpersJpgScale(_jd->width, _jd->height, _dstW, _dstH);
+    }
+
+    // Set the size of the decoded image. One MCU row is max. 16 rows.
+    rowStreamSetSource(_sessionHandle, _jd->width >> _scale, _jd->height >> _scale, (_jd->msy * 8) >> _scale);
+
+    return _scale;
+}
+
 /**
  * @brief   Callback for the PNG decoder for feeding data into the decoder.
  *
@@ -299,9 +863,67 @@ void static writeBytesToFrameBufferPng(pngle_t *_pngle, uint32_t _x, uint32_t _y
     // Get the session handler.
     InkplateDecoderSessionHandler *_sessionHandle = (InkplateDecoderSessionHandler *)pngle_get_user_data(_pngle);
 
-    // Write the pixel into temp. framebuffer for decoded images.
-    drawIntoFramebuffer(_sessionHandle->frameBufferHandler, _x, _y,
-                        ((uint32_t)(_r) << 16) | ((uint32_t)(_g) << 8) | (uint32_t)(_b));
+    // Interlaced PNG does not come row-by-row, so it can't be streamed. Use temp. framebuffer for it.
+    if (pngle_get_ihdr(_pngle)->interlace)
+    {
+        // Mark that this image needs to be processed from the temp. framebuffer.
+        _sessionHandle->fullFrame = true;
+
+        // Write the pixel into temp. framebuffer for decoded images.
+        drawIntoFramebuffer(_sessionHandle->frameBufferHandler, _x, _y,
+                            ((uint32_t)(_r) << 16) | ((uint32_t)(_g) << 8) | (uint32_t)(_b));
+        return;
+    }
+
+    // Image size is known at the first pixel (header is already parsed).
+    if (!_sessionHandle->sourceSet)
+    {
+        rowStreamSetSource(_sessionHandle, pngle_get_width(_pngle), pngle_get_height(_pngle), 1);
+    }
+
+    // Send pixel into the row stream.
+    drawIntoRowStream(_sessionHandle, _x, _y, ((uint32_t)(_r) << 16) | ((uint32_t)(_g) << 8) | (uint32_t)(_b));
+}
+
+/**
+ * @brief   Callback for the PNG decoder to write the whole decoded row (only for non-interlaced images).
+ *          Decoder already converted it into 8 bit grayscale, so it's just copied into the row stream.
+ *
+ * @param   pngle_t *_pngle
+ *          PNG Decoder specific handler. Must not be null!
+ * @param   uint32_t _y
+ *          Y position of the row inside the image.
+ * @param   uint32_t _w
+ *          Width of the row in pixels.
+ * @param   const uint8_t *_rowData
+ *          Decoded row in 8 bit grayscale.
+ */
+void static writeRowToFrameBufferPng(pngle_t *_pngle, uint32_t _y, uint32_t _w, const uint8_t *_rowData)
+{
+    // Get the session handler.
+    InkplateDecoderSessionHandler *_sessionHandle = (InkplateDecoderSessionHandler *)pngle_get_user_data(_pngle);
+
+    // Image size is known at the first row (header is already parsed).
+    if (!_sessionHandle->sourceSet)
+    {
+        rowStreamSetSource(_sessionHandle, pngle_get_width(_pngle), pngle_get_height(_pngle), 1);
+    }
+
+    // Scaling setup failed? Skip it.
+    if (_sessionHandle->streamError)
+        return;
+
+    // Get the band for this row.
+    uint8_t *_band = rowStreamSelectBand(_sessionHandle, _y, 1);
+    if (_band == NULL)
+        return;
+
+    // Clip the row to the band and copy it.
+    int _visibleW = min((int)(_w), (int)(_sessionHandle->bandStride));
+    memcpy(_band, _rowData, _visibleW);
+
+    // Update the row width.
+    _sessionHandle->bandWidth = _visibleW;
 }
 
 /**
@@ -434,12 +1056,9 @@ bool static readBytesFromBufferPng(pngle_t *_pngle)
                            ? 8128
                            : _sessionHandle->fileBufferSize - _sessionHandle->bufferOffset;
 
-            // Copying to a local buffer fixes issues with PNG's from web
-            uint8_t _internalBuffer[8128];
-            memcpy(_internalBuffer, (uint8_t *)(_sessionHandle->fileBuffer + _sessionHandle->bufferOffset), _len);
-
-            // Feed the decoder!
-            int _fed = pngle_feed(_pngle, _internalBuffer, _len);
+            // Feed the decoder directly from the buffer, decoder does not modify the input data.
+            int _fed =
+                pngle_feed(_pngle, (const uint8_t *)(_sessionHandle->fileBuffer + _sessionHandle->bufferOffset), _len);
 
             // Advance the index.
             _sessionHandle->bufferOffset += _len;
@@ -456,6 +1075,114 @@ bool static readBytesFromBufferPng(pngle_t *_pngle)
     // If you got there, PNG is loaded successfully, return true for success.
     return true;
 }
+
+/**
+ * @brief   Returns how many bytes can be read from the HTTP stream right now. If the file size is known,
+ *          it stops at the end of the file without waiting for the timeout of the WiFiClient::available().
+ *          bufferOffset holds the number of bytes already read and fileBufferSize the file size (0 if unknown).
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ * @return  int
+ *          Number of bytes available for read, 0 if the end of the stream is reached.
+ */
+int static webStreamAvailable(InkplateDecoderSessionHandler *_session)
+{
+    // Whole file already received? Do not wait for more data.
+    if ((_session->fileBufferSize != 0) && (_session->bufferOffset >= _session->fileBufferSize))
+        return 0;
+
+    // Otherwise, wait for the next chunk (or timeout).
+    return _session->client->available();
+}
+
+/**
+ * @brief   Skips all data left in the HTTP stream (for example, data after the end of the image or after
+ *          the decode error), so the modem is ready for the next command.
+ *
+ * @param   InkplateDecoderSessionHandler *_session
+ *          Pointer to the session handler.
+ */
+void static webStreamDrain(InkplateDecoderSessionHandler *_session)
+{
+    int _len;
+    while ((_len = webStreamAvailable(_session)) > 0)
+    {
+        _session->bufferOffset += _session->client->read(NULL, _len);
+    }
+}
+
+/**
+ * @brief   Function reads bytes directly from the HTTP stream and feeds into the JPG decoder.
+ *
+ * @param   JDEC *_jpgDecoder
+ *          JPG Decoder specific handler. Must not be null!
+ * @param   uint8_t *_buffer
+ *          Buffer where to store bytes read from the stream. If null, bytes are skipped (decoder only
+ *          skips forward, so there is no need for the seek).
+ * @param   size_t _n
+ *          Number of bytes to read or skip.
+ * @return  size_t
+ *          Number of bytes succesfully read or skipped. Less than _n only at the end of the stream.
+ */
+size_t static readBytesFromWebJpg(JDEC *_jpgDecoder, uint8_t *_buffer, size_t _n)
+{
+    // Get the session handler.
+    InkplateDecoderSessionHandler *_sessionHandle = (InkplateDecoderSessionHandler *)_jpgDecoder->device;
+
+    // Return value.
+    size_t _retValue = 0;
+
+    // Request can be larger than one received chunk, so read chunk by chunk.
+    while ((_retValue < _n) && (webStreamAvailable(_sessionHandle) > 0))
+    {
+        uint16_t _len = _sessionHandle->client->read(_buffer != NULL ? (char *)(_buffer + _retValue) : NULL,
+                                                     (uint16_t)(min(_n - _retValue, (size_t)0xFFFF)));
+
+        // Advance the offset.
+        _retValue += _len;
+        _sessionHandle->bufferOffset += _len;
+    }
+
+    // Return the result.
+    return _retValue;
+}
+
+/**
+ * @brief   Function reads bytes directly from the HTTP stream and feeds into the PNG decoder. Every chunk is
+ *          decoded as soon as it arrives.
+ *
+ * @param   pngle_t *_pngle
+ *          PNG Decoder specific handler. Must not be null!
+ * @return  bool
+ *          true - Image loaded into decoder succesfully.
+ *          false - Image load failed.
+ */
+bool static readBytesFromWebPng(pngle_t *_pngle)
+{
+    // Get the session handler.
+    InkplateDecoderSessionHandler *_sessionHandle = (InkplateDecoderSessionHandler *)pngle_get_user_data(_pngle);
+
+    // 2k buffer for the image chunk load.
+    uint8_t _buff[2048];
+
+    // Feed the decoder until there is no more data in the stream.
+    int _toread;
+    while ((_toread = webStreamAvailable(_sessionHandle)) > 0)
+    {
+        int _len = _sessionHandle->client->read((char *)_buff, min(2048, _toread));
+        _sessionHandle->bufferOffset += _len;
+
+        if (pngle_feed(_pngle, _buff, _len) < 0)
+        {
+            // Ooops, this is not good, go back return false for fail.
+            return false;
+        }
+    }
+
+    // If you got there, PNG is loaded successfully, return true for success.
+    return true;
+}
 #endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,603 @@
+/**
+ **************************************************
+ *
+ * @file        remoteDisplay.cpp
+ * @brief       Source file for the remote display service. PC or
+ *              server sends dirty rectangles (1 bit or 4 bit, raw,
+ *              RLE and/or XOR compressed) over UDP, they are
+ *              reassembled, written into the framebuffer and the
+ *              screen is updated with the partial update (many
+ *              frames can be merged into one update). Lost fragments
+ *              are requested again with NACK. Host side sender is in
+ *              extras/tools/remoteDisplay.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include library header file.
+#include "remoteDisplay.h"
+
+// Block usage on other boards.
+#ifdef BOARD_INKPLATE6_MOTION
+
+// It needs also main Inkplate Motion file to get the base class (screen update and screen size).
+#include "../../InkplateMotion.h"
+
+// Read little endian values from the packet.
+static inline uint16_t remoteDisplayGet16(const uint8_t *_p)
+{
+    return (uint16_t)(_p[0] | (_p[1] << 8));
+}
+
+static inline uint32_t remoteDisplayGet32(const uint8_t *_p)
+{
+    return (uint32_t)_p[0] | ((uint32_t)_p[1] << 8) | ((uint32_t)_p[2] << 16) | ((uint32_t)_p[3] << 24);
+}
+
+/**
+ * @brief Construct a new Remote Display object.
+ *
+ */
+RemoteDisplay::RemoteDisplay()
+{
+    memset(_received, 0, sizeof(_received));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+/**
+ * @brief   Initializer for the remote display (called by the driver, not by the user).
+ *
+ * @param   Inkplate *_inkplatePtr
+ *          Pointer for the main Inkplate object (used for the screen update).
+ * @param   volatile uint8_t *_screenFramebuffer
+ *          Pointer to the framebuffer where rectangles are written.
+ * @param   volatile uint8_t *_frameMemory
+ *          SDRAM memory for the frame reassembly (REMOTE_DISPLAY_MAX_FRAME_SIZE bytes).
+ */
+void RemoteDisplay::begin(Inkplate *_inkplatePtr, volatile uint8_t *_screenFramebuffer,
+                          volatile uint8_t *_frameMemory)
+{
+    _inkplate = _inkplatePtr;
+    _framebuffer = _screenFramebuffer;
+    this->_frameMemory = _frameMemory;
+}
+
+/**
+ * @brief   Start the remote display service. WiFi must be connected before this. UDP mode 2 is used, so the
+ *          replies (ACK, NACK) are sent to the sender of the last received packet.
+ *
+ * @param   uint16_t _localPort
+ *          Local UDP port for the frames.
+ * @param   const char *_senderHost
+ *          IP address of the sender (only the first remote, any sender can be used later).
+ * @return  bool
+ *          true - Service is started.
+ *          false - UDP socket can't be opened.
+ */
+bool RemoteDisplay::start(uint16_t _localPort, const char *_senderHost)
+{
+    // Stop it first if it's already running.
+    if (_started)
+        stop();
+
+    // Open the UDP "connection" for any remote.
+    if (!_udp.begin(_localPort) || !_udp.setHost(_senderHost, _localPort) || !_udp.beginPacket())
+        return false;
+
+    // Start with the new frame.
+    _inFrame = false;
+    _applied = false;
+    _ackPending = false;
+    _updatePending = false;
+    _fullUpdate = false;
+    _started = true;
+
+    return true;
+}
+
+/**
+ * @brief   Stop the remote display service (close the UDP socket). Screen update that waits for more frames is
+ *          done before that.
+ *
+ */
+void RemoteDisplay::stop()
+{
+    if (!_started)
+        return;
+
+    if (_updatePending)
+        screenUpdate();
+
+    _udp.end();
+    _inFrame = false;
+    _started = false;
+}
+
+/**
+ * @brief   Handles the remote display - receives the packets, applies complete frames, sends ACK and NACK and
+ *          updates the screen. It must be called as often as possible (from the loop()).
+ *
+ * @return  bool
+ *          true - Screen is updated with this call.
+ *          false - No screen update.
+ */
+bool RemoteDisplay::loop()
+{
+    if (!_started)
+        return false;
+
+    // Get all received packets. Nothing can be sent until everything is read, since sending uses the same buffer.
+    uint16_t _len = 0;
+    uint8_t _packets = 0;
+    while ((_packets < REMOTE_DISPLAY_MAX_LOOP_PACKETS) && ((_len = _udp.readPacket(_packet, sizeof(_packet))) != 0))
+    {
+        handlePacket(_len);
+        _packets++;
+    }
+    bool _canSend = (_len == 0);
+
+    unsigned long _now = millis();
+
+    // Acknowledge the last applied frame.
+    if (_canSend && _ackPending)
+    {
+        sendReply(REMOTE_DISPLAY_TYPE_ACK, _appliedId, _appliedTimestamp, NULL, 0);
+        _ackPending = false;
+    }
+
+    // Check the frame that is not complete.
+    if (_inFrame)
+    {
+        if ((unsigned long)(_now - _frameStart) > REMOTE_DISPLAY_FRAME_TIMEOUT)
+        {
+            // Sender is gone, drop the frame.
+            _inFrame = false;
+            _stats.droppedFrames++;
+        }
+        else if (_canSend && ((unsigned long)(_now - _lastFragment) >= REMOTE_DISPLAY_NACK_TIMEOUT) &&
+                 ((unsigned long)(_now - _lastNack) >= REMOTE_DISPLAY_NACK_TIMEOUT))
+        {
+            // No new fragments for some time, request the missing ones.
+            sendNack();
+            _lastNack = _now;
+        }
+    }
+
+    // Update the screen if no new frames are received for some time (or if the update waits for too long). Sender is
+    // informed when it's done, so wait until all packets are read.
+    if (_canSend && _updatePending && ((!_inFrame && ((unsigned long)(_now - _lastApply) >= _coalesceTime)) ||
+                           ((unsigned long)(_now - _updateSince) >= _maxUpdateDelay)))
+    {
+        screenUpdate();
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief   Sets how long to wait for more frames before the screen update. Every frame received in this time is
+ *          shown with the same update.
+ *
+ * @param   uint16_t _coalesceTime
+ *          Time without new frames before the update in milliseconds (0 = update after each frame).
+ * @param   uint16_t _maxUpdateDelay
+ *          Max. time from the first frame to the update in milliseconds (if frames are received all the time).
+ */
+void RemoteDisplay::setCoalesceTime(uint16_t _coalesceTime, uint16_t _maxUpdateDelay)
+{
+    this->_coalesceTime = _coalesceTime;
+    this->_maxUpdateDelay = _maxUpdateDelay;
+}
+
+/**
+ * @brief   Keep the EPD power supply on after the screen update (faster updates, but higher current).
+ *
+ * @param   bool _leaveOn
+ *          true - Keep EPD PMIC on (default).
+ *          false - Turn off EPD PMIC after each update.
+ */
+void RemoteDisplay::keepPowerOn(bool _leaveOn)
+{
+    this->_leaveOn = _leaveOn;
+}
+
+/**
+ * @brief   Get the statistics of the remote display (latency is measured from the first fragment of the oldest
+ *          frame to the end of the screen update).
+ *
+ * @return  RemoteDisplayStats *
+ *          Pointer to the statistics.
+ */
+RemoteDisplayStats *RemoteDisplay::stats()
+{
+    return &_stats;
+}
+
+/**
+ * @brief   Reset the statistics.
+ *
+ */
+void RemoteDisplay::resetStats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+/**
+ * @brief   Handle one received packet - store the fragment of the frame and apply the frame if it's complete.
+ *
+ * @param   uint16_t _len
+ *          Length of the packet in the packet buffer.
+ */
+void RemoteDisplay::handlePacket(uint16_t _len)
+{
+    // Check the header.
+    if ((_len < REMOTE_DISPLAY_HEADER_SIZE) || (_packet[0] != 'I') || (_packet[1] != 'R') ||
+        (_packet[2] != REMOTE_DISPLAY_TYPE_DATA))
+    {
+        _stats.badPackets++;
+        return;
+    }
+
+    RemoteDisplayHeader _header;
+    _header.type = _packet[2];
+    _header.flags = _packet[3];
+    _header.frameId = remoteDisplayGet16(_packet + 4);
+    _header.fragIndex = remoteDisplayGet16(_packet + 6);
+    _header.fragCount = remoteDisplayGet16(_packet + 8);
+    _header.fragSize = remoteDisplayGet16(_packet + 10);
+    _header.payloadLen = remoteDisplayGet16(_packet + 12);
+    _header.timestamp = remoteDisplayGet32(_packet + 16);
+
+    // Frame is already applied? ACK was lost, send it again.
+    if (_applied && (_header.frameId == _appliedId))
+    {
+        _stats.duplicates++;
+        _ackPending = true;
+        return;
+    }
+
+    // Fragment of the new frame? Drop the old one if it's not complete (sender moved on).
+    if (!_inFrame || (_header.frameId != _frameId))
+    {
+        if (_inFrame)
+            _stats.droppedFrames++;
+
+        if (!newFrame(&_header))
+        {
+            _inFrame = false;
+            _stats.badPackets++;
+            return;
+        }
+    }
+
+    // Check the fragment. All fragments except the last one must have the same size.
+    bool _isLast = (_header.fragIndex == (_fragCount - 1));
+    if ((_header.fragCount != _fragCount) || (_header.fragSize != _fragSize) || (_header.fragIndex >= _fragCount) ||
+        (_header.payloadLen > (_len - REMOTE_DISPLAY_HEADER_SIZE)) ||
+        (_isLast ? (_header.payloadLen > _fragSize) : (_header.payloadLen != _fragSize)))
+    {
+        _stats.badPackets++;
+        return;
+    }
+
+    // Already received?
+    if (_received[_header.fragIndex >> 3] & (1 << (_header.fragIndex & 7)))
+    {
+        _stats.duplicates++;
+        return;
+    }
+
+    // Store the fragment at its place in the frame.
+    memcpy((uint8_t *)_frameMemory + ((uint32_t)_header.fragIndex * _fragSize), _packet + REMOTE_DISPLAY_HEADER_SIZE,
+           _header.payloadLen);
+    _received[_header.fragIndex >> 3] |= (1 << (_header.fragIndex & 7));
+    _fragReceived++;
+    _stats.fragments++;
+    _lastFragment = millis();
+
+    // Last fragment also gives the size of the frame.
+    if (_isLast)
+        _frameLen = ((uint32_t)_header.fragIndex * _fragSize) + _header.payloadLen;
+
+    // Complete frame? Apply it and acknowledge it.
+    if (_fragReceived == _fragCount)
+    {
+        _inFrame = false;
+
+        if (!applyFrame())
+            _stats.badPackets++;
+
+        _applied = true;
+        _appliedId = _frameId;
+        _appliedTimestamp = _frameTimestamp;
+        _ackPending = true;
+    }
+}
+
+/**
+ * @brief   Start the reassembly of the new frame.
+ *
+ * @param   RemoteDisplayHeader *_header
+ *          Header of the first received fragment of the frame.
+ * @return  bool
+ *          true - New frame is started.
+ *          false - Frame info is not valid (too many fragments or frame too large).
+ */
+bool RemoteDisplay::newFrame(RemoteDisplayHeader *_header)
+{
+    // Check the frame size.
+    if ((_header->fragCount == 0) || (_header->fragCount > REMOTE_DISPLAY_MAX_FRAGMENTS) ||
+        (_header->fragSize == 0) || (_header->fragSize > (REMOTE_DISPLAY_PACKET_SIZE - REMOTE_DISPLAY_HEADER_SIZE)) ||
+        (((uint32_t)_header->fragCount * _header->fragSize) > REMOTE_DISPLAY_MAX_FRAME_SIZE))
+        return false;
+
+    // Reset the state of the reassembly.
+    memset(_received, 0, (_header->fragCount + 7) / 8);
+    _inFrame = true;
+    _frameId = _header->frameId;
+    _frameFlags = _header->flags;
+    _fragCount = _header->fragCount;
+    _fragSize = _header->fragSize;
+    _fragReceived = 0;
+    _frameLen = 0;
+    _frameTimestamp = _header->timestamp;
+    _frameStart = millis();
+    _lastNack = 0;
+
+    return true;
+}
+
+/**
+ * @brief   Write all rectangles of the complete frame into the framebuffer and schedule the screen update.
+ *
+ * @return  bool
+ *          true - All rectangles are written.
+ *          false - Frame or some of the rectangles are not valid (valid ones are written).
+ */
+bool RemoteDisplay::applyFrame()
+{
+    const uint8_t *_frame = (const uint8_t *)_frameMemory;
+    uint32_t _offset = 0;
+    bool _ok = true;
+
+    // Frame is just a list of the rectangles (header + data). Empty frame only requests the screen update.
+    while ((_frameLen - _offset) >= REMOTE_DISPLAY_RECT_HEADER_SIZE)
+    {
+        const uint8_t *_rect = _frame + _offset;
+        uint32_t _dataLen = remoteDisplayGet32(_rect + 10);
+        _offset += REMOTE_DISPLAY_RECT_HEADER_SIZE;
+
+        if (_dataLen > (_frameLen - _offset))
+            return false;
+
+        if (!applyRect(_rect, _frame + _offset, _dataLen))
+            _ok = false;
+
+        _offset += _dataLen;
+    }
+
+    // Schedule the screen update. Latency is measured from the first frame of the update.
+    if (!_updatePending)
+    {
+        _updatePending = true;
+        _updateSince = _frameStart;
+    }
+    if (_frameFlags & REMOTE_DISPLAY_FLAG_FULL_UPDATE)
+        _fullUpdate = true;
+    _lastApply = millis();
+
+    _stats.frames++;
+    _stats.lastFrameId = _frameId;
+
+    return _ok && (_offset == _frameLen);
+}
+
+/**
+ * @brief   Write one rectangle into the framebuffer. Rectangle must be byte aligned in the framebuffer (X and width
+ *          are multiple of 8 in 1 bit mode or multiple of 2 in 4 bit mode) and it must use the current display mode.
+ *          Pixels are packed in the same way as in the framebuffer, row by row.
+ *
+ * @param   const uint8_t *_rect
+ *          Rectangle header (x, y, w, h, bits per pixel, encoding, data length).
+ * @param   const uint8_t *_data
+ *          Data of the rectangle (raw or RLE compressed, XOR means data is XORed with the framebuffer).
+ * @param   uint32_t _dataLen
+ *          Length of the data in bytes.
+ * @return  bool
+ *          true - Rectangle is written.
+ *          false - Rectangle is not valid.
+ */
+bool RemoteDisplay::applyRect(const uint8_t *_rect, const uint8_t *_data, uint32_t _dataLen)
+{
+    uint16_t _x = remoteDisplayGet16(_rect);
+    uint16_t _y = remoteDisplayGet16(_rect + 2);
+    uint16_t _w = remoteDisplayGet16(_rect + 4);
+    uint16_t _h = remoteDisplayGet16(_rect + 6);
+    uint8_t _bpp = _rect[8];
+    uint8_t _encoding = _rect[9];
+
+    // Check the mode and the alignment.
+    uint8_t _pixelsPerByte;
+    if ((_bpp == 1) && (_inkplate->getDisplayMode() == INKPLATE_1BW))
+    {
+        _pixelsPerByte = 8;
+    }
+    else if ((_bpp == 4) && (_inkplate->getDisplayMode() == INKPLATE_GL16))
+    {
+        _pixelsPerByte = 2;
+    }
+    else
+    {
+        return false;
+    }
+
+    if ((_w == 0) || (_h == 0) || ((_x % _pixelsPerByte) != 0) || ((_w % _pixelsPerByte) != 0) ||
+        (((uint32_t)_x + _w) > SCREEN_WIDTH) || (((uint32_t)_y + _h) > SCREEN_HEIGHT) ||
+        (_encoding & ~(REMOTE_DISPLAY_ENC_RLE | REMOTE_DISPLAY_ENC_XOR)))
+        return false;
+
+    uint32_t _stride = SCREEN_WIDTH / _pixelsPerByte;
+    uint32_t _rowBytes = _w / _pixelsPerByte;
+    uint32_t _size = _rowBytes * _h;
+    volatile uint8_t *_dst = _framebuffer + ((uint32_t)_y * _stride) + (_x / _pixelsPerByte);
+
+    // Raw data is copied directly into the framebuffer.
+    if (_encoding == 0)
+    {
+        if (_dataLen != _size)
+            return false;
+
+        stm32Dma2dCopy(_data, _rowBytes, _dst, _stride, _rowBytes, _h);
+        return true;
+    }
+
+    // Otherwise, write byte by byte (RLE is PackBits: n < 128 - copy n + 1 bytes, n > 128 - repeat next byte 257 - n
+    // times, 128 - no operation).
+    bool _xor = (_encoding & REMOTE_DISPLAY_ENC_XOR);
+    bool _rle = (_encoding & REMOTE_DISPLAY_ENC_RLE);
+    volatile uint8_t *_row = _dst;
+    uint32_t _col = 0;
+    uint32_t _written = 0;
+    uint32_t _in = 0;
+
+    if (!_rle && (_dataLen != _size))
+        return false;
+
+    while ((_in < _dataLen) && (_written < _size))
+    {
+        uint32_t _count = 1;
+        bool _repeat = false;
+
+        if (_rle)
+        {
+            uint8_t _n = _data[_in++];
+            if (_n == 128)
+                continue;
+
+            _repeat = (_n > 128);
+            _count = _repeat ? (257 - _n) : (_n + 1);
+
+            // Check if there is enough input data and if the output fits into the rectangle.
+            if (((_repeat ? 1 : _count) > (_dataLen - _in)) || (_count > (_size - _written)))
+                return false;
+        }
+
+        for (uint32_t i = 0; i < _count; i++)
+        {
+            uint8_t _b = _repeat ? _data[_in] : _data[_in + i];
+            _row[_col] = _xor ? (_row[_col] ^ _b) : _b;
+
+            // Go to the next row of the rectangle.
+            if (++_col == _rowBytes)
+            {
+                _col = 0;
+                _row += _stride;
+            }
+        }
+
+        _in += _repeat ? 1 : _count;
+        _written += _count;
+    }
+
+    return (_written == _size);
+}
+
+/**
+ * @brief   Send the reply packet (ACK, NACK, DISPLAYED) to the sender.
+ *
+ * @param   uint8_t _type
+ *          Packet type (REMOTE_DISPLAY_TYPE_xxx).
+ * @param   uint16_t _frameId
+ *          ID of the frame.
+ * @param   uint32_t _timestamp
+ *          Timestamp of the frame from the sender (sent back, so sender can measure the latency).
+ * @param   const uint8_t *_payload
+ *          Payload of the reply (can be NULL).
+ * @param   uint16_t _len
+ *          Length of the payload in bytes.
+ */
+void RemoteDisplay::sendReply(uint8_t _type, uint16_t _frameId, uint32_t _timestamp, const uint8_t *_payload,
+                              uint16_t _len)
+{
+    uint8_t _reply[REMOTE_DISPLAY_HEADER_SIZE + (REMOTE_DISPLAY_NACK_MAX * 2)];
+
+    if (_len > (sizeof(_reply) - REMOTE_DISPLAY_HEADER_SIZE))
+        _len = sizeof(_reply) - REMOTE_DISPLAY_HEADER_SIZE;
+
+    memset(_reply, 0, REMOTE_DISPLAY_HEADER_SIZE);
+    _reply[0] = 'I';
+    _reply[1] = 'R';
+    _reply[2] = _type;
+    _reply[4] = _frameId & 0xFF;
+    _reply[5] = _frameId >> 8;
+    _reply[12] = _len & 0xFF;
+    _reply[13] = _len >> 8;
+    _reply[16] = _timestamp & 0xFF;
+    _reply[17] = (_timestamp >> 8) & 0xFF;
+    _reply[18] = (_timestamp >> 16) & 0xFF;
+    _reply[19] = _timestamp >> 24;
+
+    if ((_payload != NULL) && (_len != 0))
+        memcpy(_reply + REMOTE_DISPLAY_HEADER_SIZE, _payload, _len);
+
+    _udp.send(_reply, REMOTE_DISPLAY_HEADER_SIZE + _len);
+}
+
+/**
+ * @brief   Request missing fragments of the current frame (NACK payload is a list of the fragment indexes).
+ *
+ */
+void RemoteDisplay::sendNack()
+{
+    uint8_t _list[REMOTE_DISPLAY_NACK_MAX * 2];
+    uint16_t _n = 0;
+
+    for (uint16_t i = 0; (i < _fragCount) && (_n < REMOTE_DISPLAY_NACK_MAX); i++)
+    {
+        if (!(_received[i >> 3] & (1 << (i & 7))))
+        {
+            _list[_n * 2] = i & 0xFF;
+            _list[(_n * 2) + 1] = i >> 8;
+            _n++;
+        }
+    }
+
+    sendReply(REMOTE_DISPLAY_TYPE_NACK, _frameId, _frameTimestamp, _list, _n * 2);
+    _stats.nacks++;
+}
+
+/**
+ * @brief   Update the screen with all applied frames and tell the sender which frame is now shown on the screen
+ *          (DISPLAYED packet has the board latency in milliseconds as the payload).
+ *
+ */
+void RemoteDisplay::screenUpdate()
+{
+    if (_fullUpdate)
+    {
+        _inkplate->display(_leaveOn);
+    }
+    else
+    {
+        _inkplate->partialUpdate(_leaveOn);
+    }
+
+    _updatePending = false;
+    _fullUpdate = false;
+
+    // Latency from the first fragment of the oldest frame to the end of the update.
+    uint32_t _latency = millis() - _updateSince;
+    _stats.lastLatency = _latency;
+    if (_latency > _stats.maxLatency)
+        _stats.maxLatency = _latency;
+    _stats.updates++;
+
+    uint8_t _payload[4] = {(uint8_t)(_latency & 0xFF), (uint8_t)((_latency >> 8) & 0xFF),
+                           (uint8_t)((_latency >> 16) & 0xFF), (uint8_t)(_latency >> 24)};
+    sendReply(REMOTE_DISPLAY_TYPE_DISPLAYED, _appliedId, _appliedTimestamp, _payload, sizeof(_payload));
+}
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ **************************************************
+ *
+ * @file        remoteDisplay.h
+ * @brief       Header file for the remote display service. PC or
+ *              server sends dirty rectangles (1 bit or 4 bit, raw,
+ *              RLE and/or XOR compressed) over UDP, they are
+ *              reassembled, written into the framebuffer and the
+ *              screen is updated with the partial update (many
+ *              frames can be merged into one update). Lost fragments
+ *              are requested again with NACK. Host side sender is in
+ *              extras/tools/remoteDisplay.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add header guard.
+#ifndef __INKPLATE_MOTION_REMOTE_DISPLAY_H__
+#define __INKPLATE_MOTION_REMOTE_DISPLAY_H__
+
+// Block usage on other boards.
+#ifdef BOARD_INKPLATE6_MOTION
+
+// Include main Arduino header file.
+#include "Arduino.h"
+
+// Include WiFi library for the UDP.
+#include "../../system/wifi/esp32SpiAt.h"
+
+// Default UDP port of the remote display.
+#define REMOTE_DISPLAY_DEFAULT_PORT 5005
+
+// Max. size of the one UDP packet (fits into the Ethernet MTU).
+#define REMOTE_DISPLAY_PACKET_SIZE 1472
+
+// Size of the packet header and of the rectangle header inside the frame.
+#define REMOTE_DISPLAY_HEADER_SIZE 20
+#define REMOTE_DISPLAY_RECT_HEADER_SIZE 14
+
+// Max. size of the one frame (all rectangles) and max. number of the fragments in one frame.
+#define REMOTE_DISPLAY_MAX_FRAME_SIZE (2 * 1024 * 1024ULL)
+#define REMOTE_DISPLAY_MAX_FRAGMENTS 2048
+
+// Packet types.
+#define REMOTE_DISPLAY_TYPE_DATA      1
+#define REMOTE_DISPLAY_TYPE_NACK      2
+#define REMOTE_DISPLAY_TYPE_ACK       3
+#define REMOTE_DISPLAY_TYPE_DISPLAYED 4
+
+// Frame flags - use full update instead of the partial update.
+#define REMOTE_DISPLAY_FLAG_FULL_UPDATE 0x01
+
+// Rectangle encoding flags (can be combined). Without them data is raw.
+#define REMOTE_DISPLAY_ENC_RLE 0x01
+#define REMOTE_DISPLAY_ENC_XOR 0x02
+
+// If there is no new fragment for that long (in milliseconds), missing fragments are requested with NACK.
+#define REMOTE_DISPLAY_NACK_TIMEOUT 40ULL
+
+// Max. number of the missing fragments in one NACK packet.
+#define REMOTE_DISPLAY_NACK_MAX 128
+
+// Incomplete frame is dropped after this time (in milliseconds).
+#define REMOTE_DISPLAY_FRAME_TIMEOUT 3000ULL
+
+// Default time (in milliseconds) to wait for more frames before the screen update and max. delay of the update.
+#define REMOTE_DISPLAY_COALESCE_TIME 50ULL
+#define REMOTE_DISPLAY_MAX_UPDATE_DELAY 1000ULL
+
+// Max. number of the packets handled with one loop() call.
+#define REMOTE_DISPLAY_MAX_LOOP_PACKETS 64
+
+// Forward declaration of the Inkplate Class.
+class Inkplate;
+
+// Header of every UDP packet (little endian).
+typedef struct __attribute__((packed))
+{
+    uint8_t magic[2];
+    uint8_t type;
+    uint8_t flags;
+    uint16_t frameId;
+    uint16_t fragIndex;
+    uint16_t fragCount;
+    uint16_t fragSize;
+    uint16_t payloadLen;
+    uint16_t reserved;
+    uint32_t timestamp;
+} RemoteDisplayHeader;
+
+// Statistics of the remote display.
+typedef struct
+{
+    uint32_t frames;
+    uint32_t fragments;
+    uint32_t duplicates;
+    uint32_t nacks;
+    uint32_t droppedFrames;
+    uint32_t badPackets;
+    uint32_t updates;
+    uint32_t lastLatency;
+    uint32_t maxLatency;
+    uint16_t lastFrameId;
+} RemoteDisplayStats;
+
+// Remote display service - screen is driven from the PC over the UDP.
+class RemoteDisplay
+{
+  public:
+    RemoteDisplay();
+    void begin(Inkplate *_inkplatePtr, volatile uint8_t *_screenFramebuffer, volatile uint8_t *_frameMemory);
+    bool start(uint16_t _localPort = REMOTE_DISPLAY_DEFAULT_PORT, const char *_senderHost = "0.0.0.0");
+    void stop();
+    bool loop();
+    void setCoalesceTime(uint16_t _coalesceTime, uint16_t _maxUpdateDelay = REMOTE_DISPLAY_MAX_UPDATE_DELAY);
+    void keepPowerOn(bool _leaveOn);
+    RemoteDisplayStats *stats();
+    void resetStats();
+
+  private:
+    void handlePacket(uint16_t _len);
+    bool newFrame(RemoteDisplayHeader *_header);
+    bool applyFrame();
+    bool applyRect(const uint8_t *_rect, const uint8_t *_data, uint32_t _dataLen);
+    void sendReply(uint8_t _type, uint16_t _frameId, uint32_t _timestamp, const uint8_t *_payload, uint16_t _len);
+    void sendNack();
+    void screenUpdate();
+
+    // Pointer to the Inkplate object, framebuffer and SDRAM memory for the frame reassembly.
+    Inkplate *_inkplate = NULL;
+    volatile uint8_t *_framebuffer = NULL;
+    volatile uint8_t *_frameMemory = NULL;
+
+    // UDP socket and the buffer for one packet.
+    WiFiUDP _udp;
+    uint8_t _packet[REMOTE_DISPLAY_PACKET_SIZE];
+    bool _started = false;
+
+    // Frame that is reassembled now.
+    bool _inFrame = false;
+    uint16_t _frameId = 0;
+    uint8_t _frameFlags = 0;
+    uint16_t _fragCount = 0;
+    uint16_t _fragSize = 0;
+    uint16_t _fragReceived = 0;
+    uint32_t _frameLen = 0;
+    uint32_t _frameTimestamp = 0;
+    unsigned long _frameStart = 0;
+    unsigned long _lastFragment = 0;
+    unsigned long _lastNack = 0;
+    uint8_t _received[REMOTE_DISPLAY_MAX_FRAGMENTS / 8];
+
+    // Last applied frame (duplicates are only acknowledged again).
+    bool _applied = false;
+    uint16_t _appliedId = 0;
+    uint32_t _appliedTimestamp = 0;
+    bool _ackPending = false;
+
+    // Screen update that waits for more frames.
+    bool _updatePending = false;
+    bool _fullUpdate = false;
+    unsigned long _updateSince = 0;
+    unsigned long _lastApply = 0;
+    uint16_t _coalesceTime = REMOTE_DISPLAY_COALESCE_TIME;
+    uint16_t _maxUpdateDelay = REMOTE_DISPLAY_MAX_UPDATE_DELAY;
+    bool _leaveOn = true;
+
+    // Statistics.
+    RemoteDisplayStats _stats;
+};
+
+#endif
+
+#endif
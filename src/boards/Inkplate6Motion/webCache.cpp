@@ -0,0 +1,383 @@
+/**
+ **************************************************
+ *
+ * @file        webCache.cpp
+ * @brief       Source file for the cache of the downloaded files on
+ *              the microSD card. Keeps a copy of every downloaded
+ *              image and its HTTP validators (ETag, Last-Modified)
+ *              in a small index file, so unchanged images can be
+ *              loaded from the microSD card instead of downloading
+ *              them again.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include library header file.
+#include "webCache.h"
+
+// Block usage on other boards.
+#ifdef BOARD_INKPLATE6_MOTION
+
+// Image cache is needed for the hash function.
+#include "imageCache.h"
+
+/**
+ * @brief Construct a new Web Cache object.
+ *
+ */
+WebCache::WebCache()
+{
+    // Mark all entries as empty.
+    memset(_entries, 0, sizeof(_entries));
+    _folder[0] = '\0';
+}
+
+/**
+ * @brief   Enables the cache of the downloaded files on the microSD card. Index of the cached files is loaded
+ *          from the folder (if it exists). microSD card must be initialized before this.
+ *
+ * @param   SdFat *_sdFat
+ *          Pointer to the SdFat object.
+ * @param   const char *_folder
+ *          Folder for the cache files. It will be created if it does not exist.
+ * @return  bool
+ *          true - Cache is enabled.
+ *          false - Folder can't be created or the path is too long.
+ */
+bool WebCache::enable(SdFat *_sdFat, const char *_folder)
+{
+    // Check the input parameters (filename needs 21 more chars).
+    if ((_sdFat == NULL) || (_folder == NULL) || ((strlen(_folder) + 22) > WEB_CACHE_SD_PATH_MAX))
+        return false;
+
+    // Create the folder if needed.
+    if (!_sdFat->exists(_folder) && !_sdFat->mkdir(_folder))
+        return false;
+
+    // Save the settings.
+    _sd = _sdFat;
+    strcpy(this->_folder, _folder);
+
+    // Load the index. If there is no index (or it's broken), start with the empty cache.
+    if (!loadIndex())
+    {
+        memset(_entries, 0, sizeof(_entries));
+        _useCounter = 0;
+    }
+
+    return true;
+}
+
+/**
+ * @brief   Disables the cache (files on the microSD card are kept).
+ *
+ */
+void WebCache::disable()
+{
+    _sd = NULL;
+}
+
+/**
+ * @brief   Check if the cache is enabled.
+ *
+ * @return  bool
+ *          true - Cache is enabled.
+ *          false - Cache is disabled.
+ */
+bool WebCache::isEnabled()
+{
+    return (_sd != NULL);
+}
+
+/**
+ * @brief   Removes all files from the cache (also from the microSD card).
+ *
+ */
+void WebCache::clear()
+{
+    // Not enabled? Nothing to do.
+    if (_sd == NULL)
+        return;
+
+    // Remove all cached files.
+    char _path[WEB_CACHE_SD_PATH_MAX];
+    for (int i = 0; i < WEB_CACHE_MAX_ENTRIES; i++)
+    {
+        if (_entries[i].valid)
+        {
+            filename(_entries[i].urlHash, _path);
+            _sd->remove(_path);
+        }
+    }
+
+    // Save the empty index.
+    memset(_entries, 0, sizeof(_entries));
+    _useCounter = 0;
+    saveIndex();
+}
+
+/**
+ * @brief   Find the cached copy of the file.
+ *
+ * @param   const char *_url
+ *          URL of the file.
+ * @return  WebCacheEntry*
+ *          Pointer to the cache entry (with the validators for the conditional request), NULL if not cached.
+ */
+WebCacheEntry *WebCache::find(const char *_url)
+{
+    // Not enabled? Nothing to find.
+    if ((_sd == NULL) || (_url == NULL))
+        return NULL;
+
+    uint64_t _hash = urlHash(_url);
+    for (int i = 0; i < WEB_CACHE_MAX_ENTRIES; i++)
+    {
+        if (_entries[i].valid && (_entries[i].urlHash == _hash))
+        {
+            // Mark it as recently used.
+            _entries[i].lastUse = ++_useCounter;
+            return &_entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   Opens the cached copy of the file on the microSD card.
+ *
+ * @param   WebCacheEntry *_entry
+ *          Pointer to the cache entry (from WebCache::find()).
+ * @param   File *_file
+ *          Pointer to the file object. File is opened for reading if this method returns true.
+ * @return  bool
+ *          true - File is opened.
+ *          false - File is missing or it's broken.
+ */
+bool WebCache::open(WebCacheEntry *_entry, File *_file)
+{
+    // Check the input parameters.
+    if ((_sd == NULL) || (_entry == NULL) || (_file == NULL))
+        return false;
+
+    // Try to open the file.
+    char _path[WEB_CACHE_SD_PATH_MAX];
+    filename(_entry->urlHash, _path);
+    *_file = _sd->open(_path, O_RDONLY);
+    if (!(*_file))
+        return false;
+
+    // Check the file size.
+    if (_file->fileSize() != _entry->size)
+    {
+        _file->close();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief   Stores the downloaded file and its validators into the cache. If the cache is full, the least
+ *          recently used file is removed. Files without validators are not stored (they can't be checked).
+ *
+ * @param   const char *_url
+ *          URL of the file.
+ * @param   const char *_etag
+ *          ETag of the file (can be empty string).
+ * @param   const char *_lastModified
+ *          Last-Modified of the file (can be empty string).
+ * @param   volatile uint8_t *_data
+ *          Pointer to the downloaded file.
+ * @param   uint32_t _size
+ *          Size of the downloaded file in bytes.
+ * @return  bool
+ *          true - File is stored.
+ *          false - File is not stored (no validators or microSD card write failed).
+ */
+bool WebCache::store(const char *_url, const char *_etag, const char *_lastModified, volatile uint8_t *_data,
+                     uint32_t _size)
+{
+    // Not enabled? Nothing to do.
+    if ((_sd == NULL) || (_url == NULL) || (_data == NULL) || (_size == 0))
+        return false;
+
+    // Without validators there is no way to check if the file is changed.
+    if (((_etag == NULL) || (_etag[0] == '\0')) && ((_lastModified == NULL) || (_lastModified[0] == '\0')))
+        return false;
+
+    // Get the entry for this URL (existing one, empty one or the least recently used one).
+    uint64_t _hash = urlHash(_url);
+    WebCacheEntry *_entry = allocate(_hash);
+
+    // Write the file.
+    char _path[WEB_CACHE_SD_PATH_MAX];
+    filename(_hash, _path);
+    File _file = _sd->open(_path, O_WRONLY | O_CREAT | O_TRUNC);
+    bool _ok = _file && (_file.write((uint8_t *)_data, _size) == _size);
+    if (_file)
+        _file.close();
+
+    // Do not leave broken files.
+    if (!_ok)
+    {
+        _sd->remove(_path);
+        saveIndex();
+        return false;
+    }
+
+    // Save the entry.
+    _entry->urlHash = _hash;
+    _entry->size = _size;
+    _entry->lastUse = ++_useCounter;
+    strncpy(_entry->etag, _etag != NULL ? _etag : "", sizeof(_entry->etag) - 1);
+    strncpy(_entry->lastModified, _lastModified != NULL ? _lastModified : "", sizeof(_entry->lastModified) - 1);
+    _entry->valid = 1;
+
+    // Update the index on the microSD card.
+    return saveIndex();
+}
+
+/**
+ * @brief   Loads the index from the microSD card.
+ *
+ * @return  bool
+ *          true - Index loaded.
+ *          false - Index does not exist or it's not valid.
+ */
+bool WebCache::loadIndex()
+{
+    // Try to open the file.
+    char _path[WEB_CACHE_SD_PATH_MAX];
+    sprintf(_path, "%s/%s", _folder, WEB_CACHE_INDEX_NAME);
+    File _file = _sd->open(_path, O_RDONLY);
+    if (!_file)
+        return false;
+
+    // Read and check the header, then read all entries.
+    WebCacheIndexHeader _header;
+    bool _ok = (_file.read(&_header, sizeof(_header)) == sizeof(_header)) &&
+               (_header.magic == WEB_CACHE_INDEX_MAGIC) && (_header.numberOfEntries == WEB_CACHE_MAX_ENTRIES) &&
+               (_header.entrySize == sizeof(WebCacheEntry)) &&
+               (_file.read(_entries, sizeof(_entries)) == sizeof(_entries));
+    _file.close();
+
+    // Restore the LRU counter.
+    if (_ok)
+        _useCounter = _header.useCounter;
+
+    return _ok;
+}
+
+/**
+ * @brief   Writes the index on the microSD card.
+ *
+ * @return  bool
+ *          true - Index saved.
+ *          false - microSD card write failed.
+ */
+bool WebCache::saveIndex()
+{
+    // Fill the header.
+    WebCacheIndexHeader _header;
+    memset(&_header, 0, sizeof(_header));
+    _header.magic = WEB_CACHE_INDEX_MAGIC;
+    _header.numberOfEntries = WEB_CACHE_MAX_ENTRIES;
+    _header.entrySize = sizeof(WebCacheEntry);
+    _header.useCounter = _useCounter;
+
+    // Write the file.
+    char _path[WEB_CACHE_SD_PATH_MAX];
+    sprintf(_path, "%s/%s", _folder, WEB_CACHE_INDEX_NAME);
+    File _file = _sd->open(_path, O_WRONLY | O_CREAT | O_TRUNC);
+    if (!_file)
+        return false;
+
+    bool _ok = (_file.write(&_header, sizeof(_header)) == sizeof(_header)) &&
+               (_file.write(_entries, sizeof(_entries)) == sizeof(_entries));
+    _file.close();
+
+    // Broken index is removed, so it's not loaded next time.
+    if (!_ok)
+        _sd->remove(_path);
+
+    return _ok;
+}
+
+/**
+ * @brief   Finds the entry for the new file. Uses the entry with the same URL, empty entry or removes the least
+ *          recently used file. Returned entry is marked as not valid until the file is written.
+ *
+ * @param   uint64_t _urlHash
+ *          Hash of the URL.
+ * @return  WebCacheEntry*
+ *          Pointer to the entry (never NULL).
+ */
+WebCacheEntry *WebCache::allocate(uint64_t _urlHash)
+{
+    WebCacheEntry *_entry = NULL;
+
+    // Same URL or empty entry?
+    for (int i = 0; (i < WEB_CACHE_MAX_ENTRIES) && (_entry == NULL); i++)
+    {
+        if (_entries[i].valid && (_entries[i].urlHash == _urlHash))
+            _entry = &_entries[i];
+    }
+    for (int i = 0; (i < WEB_CACHE_MAX_ENTRIES) && (_entry == NULL); i++)
+    {
+        if (!_entries[i].valid)
+            _entry = &_entries[i];
+    }
+
+    // Cache is full, remove the least recently used file.
+    if (_entry == NULL)
+    {
+        _entry = &_entries[0];
+        for (int i = 1; i < WEB_CACHE_MAX_ENTRIES; i++)
+        {
+            if (_entries[i].lastUse < _entry->lastUse)
+                _entry = &_entries[i];
+        }
+
+        char _path[WEB_CACHE_SD_PATH_MAX];
+        filename(_entry->urlHash, _path);
+        _sd->remove(_path);
+    }
+
+    // Clear it.
+    memset(_entry, 0, sizeof(WebCacheEntry));
+
+    return _entry;
+}
+
+/**
+ * @brief   Makes the path of the cached file on the microSD card.
+ *
+ * @param   uint64_t _urlHash
+ *          Hash of the URL.
+ * @param   char *_path
+ *          Buffer for the path (at least WEB_CACHE_SD_PATH_MAX bytes).
+ */
+void WebCache::filename(uint64_t _urlHash, char *_path)
+{
+    sprintf(_path, "%s/%08lX%08lX.bin", _folder, (unsigned long)(_urlHash >> 32),
+            (unsigned long)(_urlHash & 0xFFFFFFFF));
+}
+
+/**
+ * @brief   Calculates the hash of the URL (used as the file name and for the search).
+ *
+ * @param   const char *_url
+ *          URL of the file.
+ * @return  uint64_t
+ *          64 bit FNV-1a hash of the URL.
+ */
+uint64_t WebCache::urlHash(const char *_url)
+{
+    return ImageCache::hash(IMAGE_CACHE_HASH_SEED, _url, strlen(_url));
+}
+
+#endif
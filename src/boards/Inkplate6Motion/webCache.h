@@ -0,0 +1,99 @@
+/**
+ **************************************************
+ *
+ * @file        webCache.h
+ * @brief       Header file for the cache of the downloaded files on
+ *              the microSD card. Keeps a copy of every downloaded
+ *              image and its HTTP validators (ETag, Last-Modified)
+ *              in a small index file, so unchanged images can be
+ *              loaded from the microSD card instead of downloading
+ *              them again.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add header guard.
+#ifndef __INKPLATE_MOTION_WEB_CACHE_H__
+#define __INKPLATE_MOTION_WEB_CACHE_H__
+
+// Block usage on other boards.
+#ifdef BOARD_INKPLATE6_MOTION
+
+// Include main Arduino header file.
+#include "Arduino.h"
+
+// Include file for the each board feature selection (for the SdFat).
+#include "features/featureSelect.h"
+
+// Include HTTP client for the validator size.
+#include "../../system/wifi/esp32SpiAt.h"
+
+// Max. number of the files in the cache.
+#define WEB_CACHE_MAX_ENTRIES 32
+
+// Max. length of the path to the cache folder on the microSD card.
+#define WEB_CACHE_SD_PATH_MAX 48
+
+// Magic number of the index file ("IWC1").
+#define WEB_CACHE_INDEX_MAGIC 0x31435749UL
+
+// Name of the index file inside the cache folder.
+#define WEB_CACHE_INDEX_NAME "index.bin"
+
+// One cached file.
+typedef struct __attribute__((packed))
+{
+    uint64_t urlHash;
+    uint32_t size;
+    uint32_t lastUse;
+    uint8_t valid;
+    char etag[INKPLATE_ESP32_HTTP_VALIDATOR_SIZE];
+    char lastModified[INKPLATE_ESP32_HTTP_VALIDATOR_SIZE];
+} WebCacheEntry;
+
+// Header of the index file on the microSD card (followed by all entries).
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint16_t numberOfEntries;
+    uint16_t entrySize;
+    uint32_t useCounter;
+} WebCacheIndexHeader;
+
+// Cache of the downloaded files on the microSD card.
+class WebCache
+{
+  public:
+    WebCache();
+    bool enable(SdFat *_sdFat, const char *_folder = "/webcache");
+    void disable();
+    bool isEnabled();
+    void clear();
+    WebCacheEntry *find(const char *_url);
+    bool open(WebCacheEntry *_entry, File *_file);
+    bool store(const char *_url, const char *_etag, const char *_lastModified, volatile uint8_t *_data,
+               uint32_t _size);
+
+  private:
+    bool loadIndex();
+    bool saveIndex();
+    WebCacheEntry *allocate(uint64_t _urlHash);
+    void filename(uint64_t _urlHash, char *_path);
+    uint64_t urlHash(const char *_url);
+
+    // SdFat object pointer (NULL if the cache is disabled).
+    SdFat *_sd = NULL;
+    char _folder[WEB_CACHE_SD_PATH_MAX];
+
+    // All cached files (copy of the index file).
+    WebCacheEntry _entries[WEB_CACHE_MAX_ENTRIES];
+
+    // Counter used for LRU.
+    uint32_t _useCounter = 0;
+};
+
+#endif
+
+#endif
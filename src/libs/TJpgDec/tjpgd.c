@@ -26,6 +26,9 @@
 
 #include "tjpgd.h"
 
+/* Added by Soldered Electronics - grayscale (Y only) output can be selected at run time with jd->grayscale */
+#define JD_GRAYOUT(jd)	(JD_FORMAT == 2 || (jd)->grayscale)
+
 
 #if JD_FASTDECODE == 2
 #define HUFF_BIT	10	/* Bit length to apply fast huffman decode */
@@ -758,7 +761,7 @@ static JRESULT mcu_load (
 				}
 			} while (++z < 64);		/* Next AC element */
 
-			if (JD_FORMAT != 2 || !cmp) {	/* C components may not be processed if in grayscale output */
+			if (!JD_GRAYOUT(jd) || !cmp) {	/* C components may not be processed if in grayscale output */
 				if (z == 1 || (JD_USE_SCALE && jd->scale == 3)) {	/* If no AC element or scale ratio is 1/8, IDCT can be ommited and the block is filled with DC value */
 					d = (jd_yuv_t)((*tmp / 256) + 128);
 					if (JD_FASTDECODE >= 1) {
@@ -815,7 +818,7 @@ static JRESULT mcu_output (
 	if (!JD_USE_SCALE || jd->scale != 3) {	/* Not for 1/8 scaling */
 		pix = (uint8_t*)jd->workbuf;
 
-		if (JD_FORMAT != 2) {	/* RGB output (build an RGB MCU from Y/C component) */
+		if (!JD_GRAYOUT(jd)) {	/* RGB output (build an RGB MCU from Y/C component) */
 			for (iy = 0; iy < my; iy++) {
 				pc = py = jd->mcubuf;
 				if (my == 16) {		/* Double block height? */
@@ -863,16 +866,16 @@ static JRESULT mcu_output (
 			/* Get averaged RGB value of each square correcponds to a pixel */
 			s = jd->scale * 2;	/* Number of shifts for averaging */
 			w = 1 << jd->scale;	/* Width of square */
-			a = (mx - w) * (JD_FORMAT != 2 ? 3 : 1);	/* Bytes to skip for next line in the square */
+			a = (mx - w) * (!JD_GRAYOUT(jd) ? 3 : 1);	/* Bytes to skip for next line in the square */
 			op = (uint8_t*)jd->workbuf;
 			for (iy = 0; iy < my; iy += w) {
 				for (ix = 0; ix < mx; ix += w) {
-					pix = (uint8_t*)jd->workbuf + (iy * mx + ix) * (JD_FORMAT != 2 ? 3 : 1);
+					pix = (uint8_t*)jd->workbuf + (iy * mx + ix) * (!JD_GRAYOUT(jd) ? 3 : 1);
 					r = g = b = 0;
 					for (y = 0; y < w; y++) {	/* Accumulate RGB value in the square */
 						for (x = 0; x < w; x++) {
 							r += *pix++;	/* Accumulate R or Y (monochrome output) */
-							if (JD_FORMAT != 2) {	/* RGB output? */
+							if (!JD_GRAYOUT(jd)) {	/* RGB output? */
 								g += *pix++;	/* Accumulate G */
 								b += *pix++;	/* Accumulate B */
 							}
@@ -880,7 +883,7 @@ static JRESULT mcu_output (
 						pix += a;
 					}							/* Put the averaged pixel value */
 					*op++ = (uint8_t)(r >> s);	/* Put R or Y (monochrome output) */
-					if (JD_FORMAT != 2) {	/* RGB output? */
+					if (!JD_GRAYOUT(jd)) {	/* RGB output? */
 						*op++ = (uint8_t)(g >> s);	/* Put G */
 						*op++ = (uint8_t)(b >> s);	/* Put B */
 					}
@@ -901,7 +904,7 @@ static JRESULT mcu_output (
 			for (ix = 0; ix < mx; ix += 8) {
 				yy = *py;	/* Get Y component */
 				py += 64;
-				if (JD_FORMAT != 2) {
+				if (!JD_GRAYOUT(jd)) {
 					*pix++ = /*R*/ BYTECLIP(yy + ((int)(1.402 * CVACC) * cr / CVACC));
 					*pix++ = /*G*/ BYTECLIP(yy - ((int)(0.344 * CVACC) * cb + (int)(0.714 * CVACC) * cr) / CVACC);
 					*pix++ = /*B*/ BYTECLIP(yy + ((int)(1.772 * CVACC) * cb / CVACC));
@@ -922,17 +925,17 @@ static JRESULT mcu_output (
 		for (y = 0; y < ry; y++) {
 			for (x = 0; x < rx; x++) {	/* Copy effective pixels */
 				*d++ = *s++;
-				if (JD_FORMAT != 2) {
+				if (!JD_GRAYOUT(jd)) {
 					*d++ = *s++;
 					*d++ = *s++;
 				}
 			}
-			s += (mx - rx) * (JD_FORMAT != 2 ? 3 : 1);	/* Skip truncated pixels */
+			s += (mx - rx) * (!JD_GRAYOUT(jd) ? 3 : 1);	/* Skip truncated pixels */
 		}
 	}
 
 	/* Convert RGB888 to RGB565 if needed */
-	if (JD_FORMAT == 1) {
+	if (JD_FORMAT == 1 && !jd->grayscale) {
 		uint8_t *s = (uint8_t*)jd->workbuf;
 		uint16_t w, *d = (uint16_t*)s;
 		unsigned int n = rx * ry;
@@ -129,8 +129,8 @@ bool bmpDecodeProcessBmp(BmpDecode_t *_bmpDecodeHandle)
     // Check if custom color palette is used.
     if (_bmpDecodeHandle->header.customPalette)
     {
-        // Fill row by row but note that bitmap is upside down.
-        for (int _y = _bmpDecodeHandle->header.infoHeader.height; _y >= 0; _y--)
+        // Fill row by row but note that bitmap is upside down. Rows are sent from top to bottom.
+        for (int _y = _bmpDecodeHandle->header.infoHeader.height - 1; _y >= 0; _y--)
         {
             // Fill one line of the BMP file into the framebuffer.
             // Do not forget to skip header and palette data.
@@ -145,6 +145,13 @@ bool bmpDecodeProcessBmp(BmpDecode_t *_bmpDecodeHandle)
             // Flipped y axis (BMP thing).
             uint32_t _yFlipped = _bmpDecodeHandle->header.infoHeader.height - _y - 1;
 
+            // Row output is used? Send the whole raw row at once and skip pixel-by-pixel output.
+            if (_bmpDecodeHandle->rowOutput != NULL)
+            {
+                _bmpDecodeHandle->rowOutput(_bmpDecodeHandle, _yFlipped, _oneLineBuffer);
+                continue;
+            }
+
             // Storing in the temp framebuffer must be in RGB888, so conversion must be done accordingly.
             switch (_bmpDecodeHandle->header.infoHeader.bitCount)
             {
@@ -180,7 +187,7 @@ bool bmpDecodeProcessBmp(BmpDecode_t *_bmpDecodeHandle)
                         uint8_t _px = _oneLineBuffer[_completeBytes];
 
                         // Write those 8 pixels.
-                        for (int i = 7; i >= (7 - _rem); i--)
+                        for (int i = 7; i > (7 - _rem); i--)
                         {
                             // Convert byte into color.
                             uint8_t _index = 7 - i;
@@ -229,7 +236,7 @@ bool bmpDecodeProcessBmp(BmpDecode_t *_bmpDecodeHandle)
                         uint8_t _b = _bmpDecodeHandle->header.colorTable[_px].blue;
 
                         // Draw the image using converter RGB values.
-                        _bmpDecodeHandle->output(_bmpDecodeHandle->sessionHandler, (_completeBytes * 2) + 1, _yFlipped, (_r << 16) | (_g << 8) | _b);
+                        _bmpDecodeHandle->output(_bmpDecodeHandle->sessionHandler, (_completeBytes * 2), _yFlipped, (_r << 16) | (_g << 8) | _b);
                     }
                 }
                 break;
@@ -251,8 +258,8 @@ bool bmpDecodeProcessBmp(BmpDecode_t *_bmpDecodeHandle)
     }
     else
     {
-        // Fill row by row but note that bitmap is upside down.
-        for (uint32_t _y = 0; _y < (_bmpDecodeHandle->header.infoHeader.height); _y++)
+        // Fill row by row but note that bitmap is upside down. Rows are sent from top to bottom.
+        for (int _y = _bmpDecodeHandle->header.infoHeader.height - 1; _y >= 0; _y--)
         {
             // Fill one line of the BMP file into the framebuffer.
             // Do not forget to skip header and palette data.
@@ -267,6 +274,13 @@ bool bmpDecodeProcessBmp(BmpDecode_t *_bmpDecodeHandle)
             // Flipped y axis (BMP thing).
             uint32_t _yFlipped = _bmpDecodeHandle->header.infoHeader.height - _y - 1;
 
+            // Row output is used? Send the whole raw row at once and skip pixel-by-pixel output.
+            if (_bmpDecodeHandle->rowOutput != NULL)
+            {
+                _bmpDecodeHandle->rowOutput(_bmpDecodeHandle, _yFlipped, _oneLineBuffer);
+                continue;
+            }
+
             // Storing in the temp framebuffer must be in RGB888, so conversion must be done accordingly.
             switch (_bmpDecodeHandle->header.infoHeader.bitCount)
             {
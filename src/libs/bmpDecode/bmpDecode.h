@@ -79,6 +79,8 @@ struct BmpDecodeHandle
     enum BmpErrors errorCode;
     size_t (*inputFeed)(BmpDecode_t *_bmpDecodeHandler, void *_buffer, uint64_t _n);
     void (*output)(void *_sessionHandler, int16_t _x, int16_t _y, uint32_t _color);
+    // Optional row output. If set, it's used instead of output() - whole row is sent as raw BMP data (no color conversion).
+    void (*rowOutput)(BmpDecode_t *_bmpDecodeHandler, int16_t _y, uint8_t *_rowData);
     void *sessionHandler;
     BmpHeader header;
 };
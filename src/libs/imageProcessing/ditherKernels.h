@@ -2,6 +2,16 @@
 #ifndef __DITHER_KERNELS_H__
 #define __DITHER_KERNELS_H__
 
+// Dither modes (_dither parameter of the image functions).
+enum InkplateDitherMode
+{
+    INKPLATE_DITHER_NONE = 0,       // No dithering.
+    INKPLATE_DITHER_KERNEL = 1,     // Error diffusion with the provided kernel (FS_KERNEL, STUCKI_KERNEL etc).
+    INKPLATE_DITHER_BAYER_4X4 = 2,  // Ordered dither, 4x4 Bayer matrix (kernel is not used).
+    INKPLATE_DITHER_BAYER_8X8 = 3,  // Ordered dither, 8x8 Bayer matrix (kernel is not used).
+    INKPLATE_DITHER_BLUE_NOISE = 4, // Ordered dither, 64x64 blue noise tile (kernel is not used).
+};
+
 // Dithering Kernel
 typedef struct {
     int8_t x_offset;  // X offset from the current pixel
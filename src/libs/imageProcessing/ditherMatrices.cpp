@@ -0,0 +1,282 @@
+// Include header file.
+#include "ditherMatrices.h"
+
+// Thresholds are calculated from the rank of each matrix element as ((2 * rank + 1) * 255) / (2 * N), N is number of
+// elements, so they are evenly spread over the whole 8 bit range.
+
+const uint8_t ditherBayer4x4[DITHER_BAYER_4X4_SIZE * DITHER_BAYER_4X4_SIZE] = {
+      7, 135,  39, 167,
+    199,  71, 231, 103,
+     55, 183,  23, 151,
+    247, 119, 215,  87
+};
+
+const uint8_t ditherBayer8x8[DITHER_BAYER_8X8_SIZE * DITHER_BAYER_8X8_SIZE] = {
+      1, 129,  33, 161,   9, 137,  41, 169,
+    193,  65, 225,  97, 201,  73, 233, 105,
+     49, 177,  17, 145,  57, 185,  25, 153,
+    241, 113, 209,  81, 249, 121, 217,  89,
+     13, 141,  45, 173,   5, 133,  37, 165,
+    205,  77, 237, 109, 197,  69, 229, 101,
+     61, 189,  29, 157,  53, 181,  21, 149,
+    253, 125, 221,  93, 245, 117, 213,  85
+};
+
+const uint8_t ditherBlueNoise64x64[DITHER_BLUE_NOISE_SIZE * DITHER_BLUE_NOISE_SIZE] = {
+    223, 144, 181,  13, 225, 110,  34, 184, 157, 238, 206, 138,  40, 126, 197, 244,
+     93, 215, 114,  65,   9, 208, 224,  15, 136, 232, 202,  44, 161, 251,   3, 150,
+    208,  77,  34, 147, 223, 199,  88, 141, 110, 218,  57, 121, 233,  43, 218, 159,
+     22, 190, 105, 138,  63,  98, 226, 118, 242,  71, 113,  11, 184,  74, 125,  96,
+     21, 238,  56,  88, 151,  68, 214,  16, 127,  58,  29, 168, 224,  66, 165,  21,
+    131,  31, 168, 252, 152,  90, 120, 164,  61,  84, 151, 104,  69, 199,  84,  50,
+    236, 119, 195,  53,  98, 160,  30, 254, 170,  77, 240,  17, 165,  72,   2, 108,
+    242,  55, 221,   5, 248, 171,  24, 153,  49, 136, 197, 154, 104, 245,  49, 160,
+     76, 192, 116, 170, 251,  46, 142,  78, 228, 108, 186,  86,   9, 149, 100, 210,
+     61, 227,  80,  23, 199,  44,  73, 245, 189,  30, 239,   9, 140, 226, 116, 177,
+     96,  22, 171, 243,   5, 126, 210,  60,   7, 129, 186, 101, 144, 200, 127, 178,
+     77, 142, 168, 122,  36, 207,  79, 191, 219,  28,  84, 211,  23, 133, 176, 208,
+     42, 134,  29, 207,   3, 106, 182, 205, 164,  43, 251, 120, 202, 237,  41, 180,
+    116, 148, 185, 107, 234, 129, 178,   2, 102, 130, 212, 175,  56,  23, 157,  35,
+    223, 140,  67, 109, 217,  76, 185, 104, 154, 204,  49,  30, 228,  58, 237,  40,
+    203,  16,  89, 192,  66, 112, 143,  13, 102, 177, 253,  41,  69, 225,   2, 109,
+    154, 220,  99,  69, 138, 231,  31,  95,  11,  71, 141,  23,  57, 134,  78,   3,
+    243,  49,  12, 140,  60,  29, 218, 146, 203,  48,  74, 117, 195, 101, 247,  64,
+    202,  10, 190, 151,  26, 169,  43, 228,  22, 245,  80, 174, 119,  91,  23, 147,
+    102, 253,  47, 218, 155, 241,  53, 233, 126,  57, 161,  98, 187, 149,  85, 249,
+    172,  10, 240, 186, 160,  57, 125, 246, 151, 198, 221, 169, 102, 191, 219, 163,
+     92, 198, 224,  96, 192, 161, 110,  20,  90, 254, 157,  14, 217,  81, 180, 136,
+    120,  87, 234,  51,  90, 248, 141,  68, 123,  96, 146, 217,   8, 193, 163, 223,
+     61, 175, 133,  23,  98,   0, 167,  85, 202,  20, 139, 230, 117,  32, 197,  61,
+     92, 123,  45,  85,  21, 220,  81, 178,  36, 114,  88,  45, 241,  17, 112,  34,
+    132,  66, 170,  39, 249,  81, 228,  65, 169,  31, 224, 133,  42, 154,   1,  47,
+    212,  29, 163, 132, 200, 117,   1, 216, 165, 192,  36,  63, 136, 246,  77, 124,
+      5, 109, 230,  76, 180, 212, 119,  35, 225, 174,  79,   7,  54, 218, 130,  18,
+    204, 180, 143, 209, 111, 193,   7, 137,  64, 232,   0, 185, 153,  63, 143, 249,
+    210,  16, 114, 147,   4, 127,  41, 200, 117, 186,  99,  68, 242, 111, 232, 188,
+     99, 253,  74,  14, 225,  39, 179,  83,  51,  15, 238, 180, 106,  45,  27, 184,
+    214, 154,  34, 198, 140,  49, 250, 147,  62, 109, 196, 247, 155, 178, 103, 236,
+     75,  32, 254,  62, 167,  40, 240,  99, 206, 163, 130,  74, 211,  96, 176,  50,
+     86, 184, 238,  75, 214, 179, 152, 240,  12, 141,  51, 205, 172,  28,  75, 141,
+     58, 175, 112, 187,  62, 101, 144, 235, 113, 209, 127,  86, 227, 152, 204,  99,
+     51,  86, 242,  64, 113,  25,  93, 188,   9, 136,  34,  96,  65,  25, 144,  47,
+    165, 115,   1,  94, 227, 122, 152, 184,  51,  26, 254, 110,  31, 235,   6, 201,
+    126,  24, 159,  47, 104,  28,  58,  97,  78, 216, 161,   6,  89, 197, 122, 222,
+     24, 149,  42, 214, 157, 246,  27, 198,  66, 155,  32, 170,   2,  59, 133, 249,
+    171, 127,  18, 168, 224, 157, 207,  73, 168, 237, 213, 126, 187, 242,  84, 216,
+    136, 231, 190, 156,  21,  56,  79,  13, 218,  89, 147, 195,  55, 132, 164,  73,
+    231,  97, 223, 132, 195, 246, 118, 194, 232,  27, 121, 249, 140,  41, 166,   8,
+    202, 242,  84, 123,   9,  75, 129, 171,  12,  97, 252,  72, 217, 190,  81,  12,
+     38, 216, 189,  89,   6,  55, 127, 232,  21,  87,  48, 158,   4, 113, 196,  16,
+    101,  35,  71, 219, 138, 201, 249, 107, 128, 173,  65,  11, 177, 220, 112,  28,
+    151,  58, 177,  16,  70, 155,   8, 134,  43, 173,  73, 105, 217,  62, 235, 108,
+     72, 134,  30, 232, 175, 209,  93,  47, 232, 188, 141, 115,  43, 159, 121, 227,
+    150,  73, 109, 143, 246, 176, 106,  43, 146, 114, 203,  74, 228,  41, 171,  63,
+    247, 178, 128,  48, 103, 169,  33, 154, 232,  39, 206, 243, 100,  79,  42, 251,
+    197, 118,  38, 204,  92, 219, 184,  82, 149, 211,  53, 185,  14, 153,  86, 178,
+     46, 193, 156,  98,  58,  36, 145, 218, 120,  57,  21, 204,  93, 240,  27,  98,
+    199,  49, 235,  31,  68, 203,  26, 219, 184, 243,  17, 179, 139,  93, 221, 152,
+      6,  85, 205,  12, 233,  87,  64, 188,   4,  77, 117, 140,  19, 157, 188, 135,
+      3,  87, 244, 161, 128,  52,  25, 253, 110,   3, 241, 136,  97, 206,  27, 248,
+    118, 224,   5, 186, 116, 251, 182,   2, 160,  85, 243, 152,   8, 181,  54, 166,
+    131,   3, 162, 193, 132,  94, 154,  81,  61, 130,  99,  59, 253,  26, 118,  51,
+    138, 237, 159, 115, 184,  19, 209, 141, 100, 219, 162,  52, 201, 229,  64,  98,
+    172, 217,  66,  11, 228, 101, 170,  63, 202,  88, 162,  32, 231,  50, 131, 161,
+     19,  92,  69, 207, 139,  20,  79, 107, 202,  38, 178,  70, 122, 222,  76, 206,
+    252,  86, 115,  58, 216,  15, 251, 196,   0, 172,  39, 157, 207,  79, 189, 213,
+    108,  59,  30,  72, 145, 246, 120,  49, 240,  23, 182,  93,  34, 114,  17, 239,
+     48, 123, 148, 189,  41, 140, 235, 120,  36, 187, 124,  70, 175, 112, 198,  64,
+    217, 146, 244,  36,  86, 167, 235,  59, 224, 134,  95, 208,  34, 144, 106,  17,
+     40, 181, 223,  27, 174, 123,  49, 108, 143, 237, 199, 115,   8, 131, 164,  20,
+    227, 171, 196, 222,  94,  36, 174,  82, 194, 124,  69, 252, 215, 131, 183, 153,
+    200,  80,  27, 109, 208,  77,  19, 214, 150,  55, 237,  16, 209,  84,   1, 179,
+    103,  51, 173, 122, 221,  49, 193, 124,  28, 171,  15, 234,  59, 186, 243, 155,
+    124,  67, 142, 101, 238,  74, 166, 223,  88,  26,  70, 222,  48, 239,  67,  92,
+    141,  44, 125,   0, 164,  60, 226,   9, 156,  43, 143,   0, 166,  77,  37,  92,
+      8, 231, 166, 250,  56, 179, 160,  96,  10, 221, 105, 166, 143, 252,  39, 232,
+    136,  26, 196,  15, 156,  98,   6, 146,  68, 253, 102, 156, 129,   0,  90,  51,
+    194, 232,  11, 189,  39, 146,  12, 186,  44, 129, 183, 102, 146, 178,  33, 193,
+     13,  83, 238, 107, 204, 137, 115, 213, 101, 237, 201, 107,  55, 192, 246, 142,
+    211,  45, 130,  94,   0, 121, 244,  67, 199, 132,  78,  29,  52, 119, 158,  68,
+    206,  85, 239, 108,  66, 247, 213, 165,  85, 188,  48, 200,  79, 226, 172, 212,
+     29,  95, 163,  80, 203, 116, 245,  65, 207, 160, 249,  24,  86, 216, 110, 248,
+    152, 214, 174,  68,  33, 254,  18,  71, 178,  25,  82, 229, 148,  20, 101,  60,
+    117, 182,  71, 195, 150, 211,  27, 111,  42, 174, 245, 188, 219,  89, 186,  11,
+    123, 164,  56, 141, 183,  30, 112,  42, 229, 121,  10, 220, 113,  25, 135,  70,
+    118, 242, 131,  55, 220,  89,  32, 135,  98,   7, 119,  59, 166,   2, 129,  62,
+    100,  52,  23, 145, 186,  84, 153, 196,  52, 135, 170,  40, 122, 206, 233, 173,
+     30, 224,  15, 238,  39,  83, 187, 143, 234,  88,   5,  63, 137,  21, 241, 100,
+    227,  36, 217,   9, 206,  75, 137, 197,  21, 145, 180,  67, 153,  43, 234, 159,
+      8, 205,  34, 181,   2, 157, 231, 176, 214,  79, 225, 186, 234,  46, 209, 176,
+    230, 200, 123, 241, 104,  46, 232, 120,  91, 247,   9, 215,  72, 161,   6,  78,
+    145,  91, 159, 109, 133, 228,  53, 165,  19, 127, 155, 202, 111, 172,  45, 146,
+    192,  77, 115, 157,  93, 241, 178,  60, 104, 239,  37,  96, 246, 199,  88, 187,
+    106,  65, 146, 254, 108,  61, 124,  15,  51, 153,  33, 132, 103, 147,  79,  18,
+     37, 159,  90,  14, 215, 169,   3, 208,  35, 147, 111, 183,  97,  50, 130, 190,
+    254,  48, 208,  61, 175,   6, 102, 221,  70, 209, 100,  32, 232,  79, 206,  63,
+     14, 175, 253,  22, 130,  47,   2, 219,  78, 202, 128, 166,   5, 121,  55,  18,
+    224, 168,  90,  46, 199, 173,  80, 195, 247, 114, 203,  69,  14, 253, 192, 112,
+    244,  72, 185,  55, 129,  78, 139,  65, 187, 220,  56, 242,  25, 201, 228, 104,
+     17, 125, 187,  28, 247,  80, 194, 120,  43, 176, 254,  56, 161,   2, 121, 245,
+    134,  98,  55, 194, 225, 166, 114, 147, 173,  13,  51, 215,  76, 177, 144, 249,
+    126,  26, 214, 137,  19, 237,  34, 142,  99,  18, 169, 216,  91, 160,  58, 132,
+    213,  25, 148, 229, 199,  34, 250, 159, 104,  12,  83, 163, 118, 144,  69,  40,
+    165, 215,  72, 106, 156, 136,  22, 239, 144,   8,  82, 190, 139, 226,  92, 167,
+     39, 221, 149,  28,  70,  87, 237,  39,  94, 248, 151, 105, 229,  22, 203,  80,
+     44, 183,  74, 229, 119,  96, 163, 219,  70, 189,  57, 140,  40, 225,   4, 173,
+     46, 123,  95,   6, 111, 176,  89,  19, 236, 177, 135,  38, 224,   4, 176, 243,
+     86, 145,   7, 234,  46, 216,  62, 163,  95, 216, 124,  27, 108,  44, 184,  17,
+     82, 200, 109, 180, 125, 210,  15, 192, 123,  68, 183,  32, 137,  62, 109, 156,
+    210, 103, 149,  11,  62, 206,  49,   3, 122, 239,  29, 231, 126, 185, 103,  82,
+    236, 188, 160, 245,  57, 135, 221,  48, 125,  63, 214, 186,  59,  92, 207, 113,
+     22, 225, 119, 181,  87, 190, 113,  38, 201,  65, 156, 242, 199,  71, 215, 146,
+    236,  61,   9, 233,  37, 158,  59, 139, 227,  18, 207,  86, 245, 190,  35, 236,
+      7,  57, 244, 192, 159, 131, 249, 182, 151,  87, 164, 108,  72,  21, 209, 155,
+     13,  68,  38, 206,  81,  24, 193, 151, 205,  94,  26, 107, 251, 160, 131,  47,
+    196,  58, 168,  35, 131,  10, 249, 174,  16, 234,  47,  98,   9, 161, 126,  31,
+    112, 170, 141,  90, 197, 105, 251,  81, 165,  45, 116, 169,   2, 121, 164,  89,
+    138, 172, 115,  41,  91,  26,  74, 106,  37, 210,  10, 201, 147, 244,  59, 118,
+    143, 216, 112, 173, 146, 238,  70, 108,   2, 167, 230, 147,  11,  74,  30, 234,
+    149, 103,  75, 239, 199,  66, 149, 102, 130,  84, 181, 143, 221,  52, 245,  84,
+    205,  43, 246,  71, 148,   3, 176,  27, 103, 219, 145,  67, 215,  52, 231,  68,
+    212,  27,  78, 207, 234, 166, 198, 226, 138,  64, 252,  48,  90, 172,  35, 196,
+     77, 253,  26,  91,   7, 121, 182,  37, 249,  80,  53, 127, 197, 217, 169,  83,
+    189,   0, 215, 141,  20,  91, 227,  45, 195, 224,  19, 115,  73, 187, 104,   1,
+    178, 129,  18, 211,  50, 226, 128, 191,  56, 241,  16, 196,  96, 147,  14, 187,
+    127, 254, 180, 142,  18, 120,  54,   7,  85, 174, 121, 190,  14, 128, 223,  99,
+    181,  49, 130, 188, 229,  53, 217, 159, 136, 212, 181,  33,  91,  51, 113,  17,
+    242, 126,  46, 164, 113, 211, 170,   3,  72, 159,  40, 252, 167,  23, 212, 150,
+     56, 224,  95, 121, 167,  76,  36, 210, 152,  83, 129,  40, 250, 176, 115,  39,
+     95,  54,   0, 105,  63, 220, 152, 186, 235,  21, 157, 103, 233,  71, 152,   3,
+    116, 161, 212,  65, 153, 103,  18,  92,  61,  13, 110, 241, 156, 231, 183, 144,
+     65, 175,  97, 253,  31,  56, 125, 243, 111, 138, 199,  92, 123,  46, 133, 240,
+     75, 191, 154,  29, 196, 236,  92, 116,   7, 171, 188, 111,  73,  25, 223, 199,
+    166, 226, 154, 239, 191,  94,  29, 127, 100, 212,  60,  33, 208, 175,  54, 237,
+     34,  88,  10, 245,  33, 204, 175, 240, 125, 169, 195,  67,   4, 126,  36,  94,
+    218,  27, 207,  72, 191, 156,  82, 179,  31, 218,  62,  13, 235, 203,  87,  32,
+    113,  11, 253,  65, 107,  13, 145, 247,  68, 216,  21, 230, 163, 138,  56,  83,
+    133,  30, 115,  80,  38, 167, 247,  71,  43, 139, 240,  83, 113,  22, 134, 201,
+    228, 189, 145,  80, 115, 140,  69,  42, 223,  29,  98, 145, 211,  78, 194, 246,
+     50, 119, 151,   7, 134, 236,  16, 201,  55, 103, 169, 143, 182,  65, 158, 227,
+    175, 139,  45, 162, 219, 179,  56, 189,  37, 136,  89,  45, 205, 101, 243,   6,
+    212,  66, 176, 205, 136,   9, 210, 148, 192,   4, 167, 199, 146, 249,  75, 102,
+     19, 121,  56, 171, 233,  12, 187,  89, 150, 205,  50, 253,  22, 163, 105,  11,
+    160, 188,  86, 229, 107,  41,  97, 141, 248,   5, 229,  84,  29, 117,   5, 197,
+     97,  71, 208, 127,  82,  32, 121, 225, 158, 105, 241, 155,  64,  19, 179, 148,
+     92, 247,  16,  50, 228, 119,  54, 106, 229,  78, 123,  50,  16, 183,  44, 169,
+     66, 251, 197,  38,  97, 213, 122, 247,   1,  76, 137, 117, 179,  55, 215, 128,
+     69, 238,  24,  57, 203, 166, 221,  65, 161, 116, 190,  46, 210, 250, 134,  55,
+     22, 244, 181,   2, 239, 151,  95,  19,  75, 202,   4, 125, 190, 226, 112,  44,
+    193, 125, 158, 102, 180,  73, 161,  22, 173,  35, 245, 104, 215,  89, 224, 137,
+    158,  92,  14, 223, 156,  53,  29, 166, 107, 189, 235,  33,  93, 230, 141,  41,
+    202, 102, 138, 180, 120,  77,  20, 193,  33,  75, 133, 156,  99,  73, 173, 222,
+    150, 119,  38, 103,  63, 194, 213, 169, 251,  54, 176,  84,  38, 139,  72, 167,
+     25, 218,  62, 236,  29, 198, 253,  94, 211, 137, 182,  64, 160, 125,   0, 205,
+     33, 184, 139, 111,  79, 184, 134,  65, 216,  23, 156,  69, 197,   5,  81, 248,
+     14, 162,  45, 215,   0, 250, 130, 101, 237, 203,  23, 241,  15, 192,  37, 108,
+     77, 205, 163, 225, 135,  48,   9, 129,  35, 143, 111, 236, 198,   9, 242, 208,
+     83, 110,  11, 135,  87, 144,   3, 124,  49,  83,   9, 201,  32, 231,  56, 110,
+     74, 215,  47, 235,   6, 208, 241,  93, 177,  56, 126, 222, 168, 114, 153, 181,
+    120,  72, 234,  90, 154,  40, 184, 149,  50, 165, 111,  62, 215, 121, 162,  10,
+    230,  53,  17,  88, 182, 245, 113,  85, 187, 229,  23,  69, 162,  95, 119,  54,
+    146, 250, 164, 212,  41, 224,  63, 188, 239, 148, 220, 119,  78, 144, 173, 242,
+     20, 122, 168,  67, 148, 118,  20,  42, 145, 250,  13, 101,  44, 233,  62,  33,
+    222, 198,  25, 175, 109,  62, 220,  82,   7, 211,  90, 181, 138,  49, 244,  94,
+    180, 126, 197, 147,  26,  77, 162, 221,  57,  97, 210, 150,  47, 220, 180,  15,
+    191,  34,  73, 187, 118, 173, 100, 155,  23, 108,  38, 165, 251,  16,  89, 195,
+    157,  95, 248,  32, 193,  84, 162, 231, 110, 193,  80, 210, 142,  17, 195, 107,
+     87, 143,  53, 129, 240, 202,  25, 124, 234, 140,  36, 230,   0,  84, 196, 145,
+     40, 254,  66, 105, 233,  43, 201,  16, 133, 167,   0, 127, 254,  29, 136,  88,
+    229, 125, 101,   7,  55, 246,  17, 209,  72, 227, 194,  57, 100, 206,  42, 135,
+    219,   4, 182, 108, 227,  50, 204,  66,   3, 133,  34, 180,  66, 246, 128, 172,
+      3, 251, 190,  79,  10, 161,  93, 174,  55, 195,  73, 118, 158, 217,  62,  18,
+    114, 165,   3, 209, 171, 119, 149,  71, 237,  39, 200,  81, 106, 168,  66, 200,
+     45, 170, 237, 204, 157,  85, 132,  44, 172,  88, 134,   4, 181, 122, 238,  62,
+    192,  81,  56, 142,  12, 131, 178,  99, 220, 167, 241, 112, 157,  93,  47, 214,
+     70, 163,  22, 104, 223, 137,  38, 252, 106,  13, 168, 247,  26, 102, 176, 238,
+     80, 219, 138,  90,  59,  21, 250,  96, 179, 117, 227,  59, 189,  10, 218, 109,
+    145,  23,  61, 137,  33, 226, 191, 114, 240,  28, 159, 235,  70, 153,  24, 111,
+     37, 243, 164, 202,  90, 254,  28, 155,  39,  83,  57,   9, 204,  23, 225, 140,
+     35, 119, 209, 153,  51, 198,  74, 188, 152, 219,  94,  48, 206, 149,  38, 129,
+    201,  52,  30, 191, 226, 139, 185,  10,  52, 158,  24, 141, 239, 156,  36, 246,
+     75, 208,  95, 185, 110,  71,   1, 149,  59, 216, 106,  47, 209,  85, 226, 174,
+    147, 117,  21, 218,  42, 118,  76, 231, 207, 125, 188, 230, 133,  80, 179, 104,
+    193, 236,  90,  30, 244, 113,   2, 128,  33,  64, 137, 182, 124,  69, 228,  11,
+    103, 153, 247, 112,  39,  82, 210, 111, 220,  78, 184,  99,  45,  86, 124, 178,
+     13, 161, 243,  17, 214, 163, 252,  91, 197,  19, 128, 186,  34, 135,  13,  97,
+    222,  74, 133,  61, 158, 197, 143,  19, 102, 150,  27,  97, 166,  60, 247,  11,
+     76,  54, 144, 183,  68, 167, 227,  89, 240, 200,  22, 226,   5,  87, 191, 164,
+     64, 183,  15, 131, 176,  63, 156,  30, 134, 248,   5, 213, 131, 195,  63, 213,
+    100, 122,  41,  81, 127,  54,  35, 139, 175,  75, 243,  94, 165, 253, 199,  50,
+    180,   1, 189, 234, 103,   7, 243,  53, 177,  69, 250,  48, 198,  33, 123, 151,
+    171, 213,   5, 125, 206,  22, 149,  55, 169, 105,  78, 162, 114, 252, 135,  44,
+    232,  79, 208,  95, 240,   4, 229,  92, 193,  58, 116, 167,  29, 230,   7, 150,
+     53, 225, 182, 154, 230, 177, 207, 111,  10, 212, 152,  58,   5, 109,  67, 157,
+    107, 249,  87,  32, 170,  72, 186, 131, 221,   1, 206, 111, 144, 220,  96, 232,
+     44, 108, 254,  83,  46, 104, 212, 135,   9, 185, 233,  35, 209,  57,  25, 205,
+    116, 143,  32,  57, 150, 200, 121, 171,  41, 148,  86, 238,  70, 159, 113, 252,
+     30, 196,  68,   5,  99,  24,  70, 235,  49, 118,  30, 194, 219, 129, 233,  28,
+    139,  51, 151, 203, 127, 225,  37,  86, 114, 155,  80, 174,  13,  74,  24, 200,
+    136,  18, 188, 159, 235, 176,  78,  38, 250, 124,  52, 142,  99, 154, 178,  94,
+      0, 243, 171, 220, 103,  46,  76,  18, 233, 211,  15, 197,  44,  96, 186,  75,
+    133,  93, 145, 243, 120, 194, 134,  92, 166, 226, 140,  79, 170,  43,  90, 191,
+     77, 210, 115,  15,  57,  99, 163, 200,  28, 233,  41, 130, 242, 186, 159,  51,
+     87, 224,  66,  34, 130,  12, 222, 157,  96,  69, 217,  18, 195,  73, 234, 130,
+     60, 192,  85,  12, 135, 185, 254, 139,  64, 106, 173, 122, 142, 226,  21, 210,
+    172,  15, 205,  57,  39, 163, 250,  17, 200,  66,  99, 248,  20, 144, 214,  10,
+    173,  33, 231, 175, 242, 147,  11, 252,  63, 189,  96, 214,  59, 104, 124, 246,
+    180, 116, 148,  98, 203,  58, 114, 192,  25, 182, 160, 112, 247,  40,  16, 216,
+    151,  35, 120, 164, 227,  28,  94, 204, 160,  36,  75, 249,   1, 165,  60, 120,
+     45, 232, 107, 180, 222,  85,  60, 152,  37, 177,   5, 122, 184,  64, 110, 244,
+    100, 154,  65,  89,  40, 207,  73, 120, 138, 168,   8, 150,  31, 225,   2,  76,
+     31, 210,  14, 248, 181,  88, 237,  44, 138, 240,   4,  86, 172, 126,  98, 185,
+     77, 250, 205,  68,  43, 117, 174,   8, 124, 222, 191,  52,  87, 216, 103, 245,
+    151,  80, 132,  25, 149,   1, 212, 103, 129, 241, 207,  54, 228, 155, 200,  49,
+    225,   7, 123, 193, 140, 108, 178,  24, 223,  50, 109, 194,  71, 166, 201, 140,
+    172,  61, 161,  46, 135,   0, 150, 208,  76, 122,  49, 212,  61, 228, 162,  48,
+    112,  14, 143, 102, 239, 213,  59,  85, 244,  25, 148, 117, 200, 135,  29, 188,
+      6, 199,  61, 248,  95, 123, 174, 230,  52,  82, 144, 105,  35,  84,  21, 136,
+     71, 179, 246,  28, 214,   2, 233,  91, 201,  78, 234, 125, 251,  90,  47, 220,
+     97, 236,  82, 118, 229,  71, 171,  20, 100, 223, 149, 189,  30, 141,   5, 196,
+    221, 169,  55, 181,   4, 132, 157, 189,  47, 101, 182,  11, 241,  43,  74, 170,
+     96, 224,  38, 158, 205,  68,  33, 191,  10, 164,  24, 194, 171, 251, 116, 168,
+    204,  97,  50, 160,  82,  60, 134,  42, 154,  26, 173,  42,  11, 155, 116,  24,
+    128,   6, 185, 215,  26, 194, 110, 253,  60, 177,  12,  93, 118, 241,  67,  94,
+    131,  31, 230,  90, 197,  76,  31, 228, 138, 213,  60,  83, 173, 153, 213, 126,
+     24, 142, 114, 181,  15, 233, 139,  88, 118, 214, 237,  72, 132,   1, 217,  42,
+     19, 231, 142, 115, 225, 170, 248, 192, 105, 220, 141,  98, 208, 183,  67, 239,
+    198, 145,  40,  99, 154,  51, 131, 203,  37, 136, 245, 204,  78, 155, 214,  22,
+    244,  76, 120, 160,  21, 246, 116,  93,  12, 162, 112, 230,  22, 105,  58, 251,
+    194,  70, 238,  84,  53, 105, 168, 253,  63, 142,  95,  44, 211,  61,  91, 148,
+    195,  76,   8, 187,  32, 100,  14, 122,  67,   4, 245,  59, 130, 229,  34, 170,
+     87,  58, 245, 175,  77, 236,   8,  86, 165, 109,  23,  53, 170,  39, 113, 178,
+    146, 191,  40, 209, 140,  52, 177, 204,  67, 252,  31, 192, 128, 221,   4,  91,
+     44, 168,  10, 203, 151, 219,  18,  45, 195,  15, 183, 115, 153, 179, 241, 127,
+    165, 106, 251,  63, 208, 153,  52, 217, 167, 185,  88, 195,  23,  81, 148, 110,
+     17, 213, 117,  12, 206, 106, 147, 218,  64, 231, 184, 126, 235,   8, 198,  53,
+    102,   1, 236,  66, 105, 221, 152,  41, 129, 185, 146,  50,  75, 144, 183, 119,
+    154, 227, 109, 132,  37, 185, 123,  82, 160, 223,  36, 244,  12, 104,  31,  53,
+    218,  28, 137, 171,  89, 128, 238,  81,  28, 133,  45, 151, 114, 211,  52, 252,
+    187, 158,  73, 137,  32, 169,  46, 189,  16,  91, 152,  70, 216,  89, 134, 254,
+     73, 172, 114, 163,  13,  87,  24, 238,  82,   1,  91, 237, 207,  37, 244,  64,
+    211,  27,  60, 249,  95,  69, 238, 207, 106,  60, 130, 167,  74, 193, 231,  83,
+    124, 191,  46, 222,  17,  39, 190, 159, 107, 203, 222,  13, 242, 174,   2, 133,
+     93,  43, 228, 182, 250,  70, 122, 240, 135,  42, 198,  28, 107,  48, 158, 209,
+     27, 227,  47, 198, 250, 132, 194, 110, 167, 222, 116, 162,  14, 101, 165,  20,
+    138,  88, 170, 193,   1, 158,  30, 137,   8, 234,  88, 203,  41, 133, 151,   4,
+     95, 236,  73, 113, 150, 233,  69,   8, 254,  61,  92, 162,  71, 101, 196,  65,
+    217,  24, 125,  52,  97, 213,   1, 101, 174, 222, 117, 247, 168, 191,  14, 119,
+     85, 148, 127,  75,  35, 175,  60, 215,  48,  27, 190,  54, 129, 199,  81, 223,
+    108, 204,  36, 142, 230, 102, 176,  50, 190, 155,  25, 117, 252,  59, 215, 182,
+     54, 158,  10, 177, 212,  97, 142, 119, 177,  35, 126, 230,  48, 142,  31, 236,
+    156, 107, 201, 162,  20, 150, 196,  79,  26,  64, 146,   6,  58, 139, 239,  41,
+    177, 202,   8, 218, 155, 100,   6, 149,  79, 134, 247,  71, 226, 150,  46, 177,
+      6, 243,  72, 115,  54, 217,  77, 250, 109,  67, 218, 183,  14,  81, 110,  31,
+    210, 132, 249,  83,  54,  20, 198,  47, 221, 148, 194,  20, 172, 213, 117, 179,
+     76,   6, 242,  82, 231,  58, 128, 248, 158, 209,  94, 228,  80, 211, 100,  67,
+    229, 107,  55,  91, 185, 240, 121, 232, 202,  98, 174,   7, 111,  26, 252,  62,
+    124, 153, 183,  16, 202, 128,  20, 147, 205,  37, 132,  93, 162, 140, 239, 169,
+     67, 106,  38, 201, 128, 164, 244,  81, 100,   0,  74, 105, 248,  84,  12,  54,
+    145, 190,  42, 137, 179, 104,  37, 183,  51, 112,  19, 179, 123,  32, 184, 130,
+     19, 164, 248, 131,  18,  68,  45, 181,  17,  39, 152, 204,  85, 183, 135,  91,
+    211,  40,  83, 235, 161,  42, 187,  87,   3, 172, 235,  53, 222,  36, 196,   7
+};
@@ -0,0 +1,22 @@
+// Header guard.
+#ifndef __DITHER_MATRICES_H__
+#define __DITHER_MATRICES_H__
+
+// Include Arduino Header file.
+#include <Arduino.h>
+
+// Threshold matrices for the ordered dithering. Every value is the threshold for one pixel (8 bit grayscale);
+// pixel brighter than the threshold is white (1 bit mode). Matrices are tiled over the screen.
+// Size of the each matrix (width = height, must be multiple of 4).
+#define DITHER_BAYER_4X4_SIZE 4
+#define DITHER_BAYER_8X8_SIZE 8
+#define DITHER_BLUE_NOISE_SIZE 64
+
+// Classic Bayer matrices.
+extern const uint8_t ditherBayer4x4[DITHER_BAYER_4X4_SIZE * DITHER_BAYER_4X4_SIZE];
+extern const uint8_t ditherBayer8x8[DITHER_BAYER_8X8_SIZE * DITHER_BAYER_8X8_SIZE];
+
+// Blue noise tile (made with void-and-cluster method) - no visible pattern, but still stable between frames.
+extern const uint8_t ditherBlueNoise64x64[DITHER_BLUE_NOISE_SIZE * DITHER_BLUE_NOISE_SIZE];
+
+#endif
@@ -4,6 +4,233 @@
 // Include Inkplate Motion Library.
 #include "InkplateMotion.h"
 
+// Working memory is taken from the image decode arena.
+#include "../../system/decodeArena.h"
+
+/**
+ * @brief   Ordered dither of one pixel. Output is the same as from the error diffusion dither: 1 bit - 0xF0 for the
+ *          black pixel, 0 for the white pixel; 4 bit - gray level in the upper nibble.
+ *
+ * @param   uint8_t _pixel
+ *          8 bit grayscale pixel.
+ * @param   uint8_t _threshold
+ *          Threshold from the matrix (0 - 254).
+ * @param   uint8_t _bitDepth
+ *          Output bit depth - 4 for 4 bit mode, 1 for 1 bit mode.
+ * @return  uint8_t
+ *          Dithered pixel.
+ */
+static inline uint8_t orderedDitherPixel(uint8_t _pixel, uint8_t _threshold, uint8_t _bitDepth)
+{
+    if (_bitDepth == 1)
+    {
+        // Black if pixel is not above the threshold (sign of the difference is used as mask).
+        return (uint8_t)(((int32_t)(_pixel) - _threshold - 1) >> 31) & 0xF0;
+    }
+
+    // Level = (pixel * 15 + 254 - threshold) / 255, division by 255 is done as (v + 1 + (v >> 8)) >> 8.
+    uint32_t _v = (_pixel * 15UL) + 254 - _threshold;
+    return ((_v + 1 + (_v >> 8)) >> 8) << 4;
+}
+
+/**
+ * @brief   Ordered dither of four pixels at once into 1 bit. Pixels are processed as two 16 bit lanes inside the 32 bit
+ *          word (bytes 0 and 2, then bytes 1 and 3), so there are no branches and no per-pixel loads.
+ *
+ * @param   uint32_t _pixels
+ *          Four 8 bit grayscale pixels.
+ * @param   uint32_t _thresholds
+ *          Four thresholds from the matrix.
+ * @return  uint32_t
+ *          Four dithered pixels (see orderedDitherPixel()).
+ */
+static inline uint32_t orderedDither1Bit4Px(uint32_t _pixels, uint32_t _thresholds)
+{
+    // 256 + threshold - pixel, bit 8 of each lane is set if the pixel is black.
+    uint32_t _even = ((_thresholds & 0x00FF00FF) | 0x01000100) - (_pixels & 0x00FF00FF);
+    uint32_t _odd = (((_thresholds >> 8) & 0x00FF00FF) | 0x01000100) - ((_pixels >> 8) & 0x00FF00FF);
+
+    // Convert the bit into 0xF0 in the right byte.
+    return (((_even >> 8) & 0x00010001) * 0xF0) | ((((_odd >> 8) & 0x00010001) * 0xF0) << 8);
+}
+
+/**
+ * @brief   Ordered dither of four pixels at once into 4 bit. Same as orderedDither1Bit4Px(), two 16 bit lanes are used.
+ *
+ * @param   uint32_t _pixels
+ *          Four 8 bit grayscale pixels.
+ * @param   uint32_t _thresholds
+ *          Four thresholds from the matrix.
+ * @return  uint32_t
+ *          Four dithered pixels (see orderedDitherPixel()).
+ */
+static inline uint32_t orderedDither4Bit4Px(uint32_t _pixels, uint32_t _thresholds)
+{
+    // Pixel * 15 + 254 - threshold, max. 4079 so it fits into the lane.
+    uint32_t _even = ((_pixels & 0x00FF00FF) * 15) + (0x00FE00FE - (_thresholds & 0x00FF00FF));
+    uint32_t _odd = (((_pixels >> 8) & 0x00FF00FF) * 15) + (0x00FE00FE - ((_thresholds >> 8) & 0x00FF00FF));
+
+    // Divide each lane by 255.
+    _even = ((_even + 0x00010001 + ((_even >> 8) & 0x00FF00FF)) >> 8) & 0x000F000F;
+    _odd = ((_odd + 0x00010001 + ((_odd >> 8) & 0x00FF00FF)) >> 8) & 0x000F000F;
+
+    // Move the levels into the upper nibble of the right byte.
+    return (_even << 4) | (_odd << 12);
+}
+
+/**
+ * @brief   Error diffusion of one row with the kernel known at compile time. All weights are template parameters,
+ *          so the kernel loop is unrolled, zero weights are removed by the compiler and there are no branches for the
+ *          target row or the bit depth. Kernel can spread the error up to two pixels left/right and two rows down:
+ *          _R1, _R2 - current row (x + 1, x + 2); _N_2 ... _N2 - next row (x - 2 ... x + 2); _A_2 ... _A2 - row after.
+ *          Output is the same as from the generic ImageProcessing::ditherImageRow().
+ *
+ * @param   uint8_t *_row
+ *          Pointer to the row (8 bit grayscale). Dithered pixels are written back into it.
+ * @param   uint16_t _width
+ *          Width of the row in pixels.
+ * @param   int16_t *_current
+ *          Error buffer of the current row.
+ * @param   int16_t *_next
+ *          Error buffer of the next row.
+ * @param   int16_t *_afterNext
+ *          Error buffer of the row after the next one.
+ *
+ * @note    _Dir is 1 for left to right and -1 for right to left scan (kernel is mirrored).
+ *          Error buffers must have two pixels of padding on both sides, so edges don't need to be checked
+ *          (error that goes into the padding is never used).
+ */
+template <int _R1, int _R2, int _N_2, int _N_1, int _N0, int _N1, int _N2, int _A_2, int _A_1, int _A0, int _A1, int _A2, uint8_t _BitDepth, int _Dir>
+static void ditherRowKernel(uint8_t *_row, uint16_t _width, int16_t *_current, int16_t *_next, int16_t *_afterNext)
+{
+    // Skip the left padding.
+    _current += 2;
+    _next += 2;
+    _afterNext += 2;
+
+    int _x = (_Dir > 0) ? 0 : (_width - 1);
+    for (uint16_t _n = 0; _n < _width; _n++, _x += _Dir)
+    {
+        // Adjust pixel value with propagated error and clamp it.
+        int16_t _oldPixel = _row[_x] + _current[_x];
+        _oldPixel = (_oldPixel < 0) ? 0 : (_oldPixel > 255) ? 255 : _oldPixel;
+
+        // Quantize it and calculate the error.
+        int16_t _quantError;
+        if (_BitDepth == 1)
+        {
+            // 1-bit output: 0xF0 is black.
+            _row[_x] = (_oldPixel >= 128) ? 0x00 : 0xF0;
+            _quantError = (_oldPixel >= 128) ? (_oldPixel - 255) : _oldPixel;
+        }
+        else
+        {
+            // 4-bit output: quantize to 0-15.
+            uint8_t _newPixel = (_oldPixel * 15 + 127) >> 8;
+            _row[_x] = _newPixel << 4;
+            _quantError = _oldPixel - (_newPixel << 4);
+        }
+
+        // Propagate the error.
+        if (_R1) _current[_x + _Dir] += (_quantError * _R1) >> 4;
+        if (_R2) _current[_x + 2 * _Dir] += (_quantError * _R2) >> 4;
+        if (_N_2) _next[_x - 2 * _Dir] += (_quantError * _N_2) >> 4;
+        if (_N_1) _next[_x - _Dir] += (_quantError * _N_1) >> 4;
+        if (_N0) _next[_x] += (_quantError * _N0) >> 4;
+        if (_N1) _next[_x + _Dir] += (_quantError * _N1) >> 4;
+        if (_N2) _next[_x + 2 * _Dir] += (_quantError * _N2) >> 4;
+        if (_A_2) _afterNext[_x - 2 * _Dir] += (_quantError * _A_2) >> 4;
+        if (_A_1) _afterNext[_x - _Dir] += (_quantError * _A_1) >> 4;
+        if (_A0) _afterNext[_x] += (_quantError * _A0) >> 4;
+        if (_A1) _afterNext[_x + _Dir] += (_quantError * _A1) >> 4;
+        if (_A2) _afterNext[_x + 2 * _Dir] += (_quantError * _A2) >> 4;
+    }
+}
+
+/**
+ * @brief   Gets both scan directions of the specialized error diffusion for the selected bit depth.
+ *
+ * @param   uint8_t _bitDepth
+ *          Output bit depth - 4 for 4 bit mode, 1 for 1 bit mode.
+ * @param   DitherRowFunction *_forward
+ *          Left to right function is stored here.
+ * @param   DitherRowFunction *_reverse
+ *          Right to left function is stored here.
+ */
+template <int _R1, int _R2, int _N_2, int _N_1, int _N0, int _N1, int _N2, int _A_2, int _A_1, int _A0, int _A1, int _A2>
+static void ditherRowSelect(uint8_t _bitDepth, DitherRowFunction *_forward, DitherRowFunction *_reverse)
+{
+    if (_bitDepth == 1)
+    {
+        *_forward = &ditherRowKernel<_R1, _R2, _N_2, _N_1, _N0, _N1, _N2, _A_2, _A_1, _A0, _A1, _A2, 1, 1>;
+        *_reverse = &ditherRowKernel<_R1, _R2, _N_2, _N_1, _N0, _N1, _N2, _A_2, _A_1, _A0, _A1, _A2, 1, -1>;
+    }
+    else
+    {
+        *_forward = &ditherRowKernel<_R1, _R2, _N_2, _N_1, _N0, _N1, _N2, _A_2, _A_1, _A0, _A1, _A2, 4, 1>;
+        *_reverse = &ditherRowKernel<_R1, _R2, _N_2, _N_1, _N0, _N1, _N2, _A_2, _A_1, _A0, _A1, _A2, 4, -1>;
+    }
+}
+
+/**
+ * @brief   Checks if the kernel is the same as one of the built-in kernels. Kernels are compared by content, since
+ *          each file has its own copy of the built-in kernel arrays.
+ *
+ * @param   const KernelElement *_kernel
+ *          Kernel provided by the user.
+ * @param   size_t _kernelSize
+ *          Number of elements in the provided kernel.
+ * @param   const KernelElement *_builtIn
+ *          Built-in kernel.
+ * @param   size_t _builtInSize
+ *          Number of elements in the built-in kernel.
+ * @return  bool
+ *          true - Kernels are the same.
+ */
+static bool ditherKernelEquals(const KernelElement *_kernel, size_t _kernelSize, const KernelElement *_builtIn, size_t _builtInSize)
+{
+    return (_kernelSize == _builtInSize) && (memcmp(_kernel, _builtIn, _builtInSize * sizeof(KernelElement)) == 0);
+}
+
+/**
+ * @brief   Finds the specialized error diffusion for the kernel.
+ *
+ * @param   const KernelElement *_kernel
+ *          Pointer to the dither kernel parameters.
+ * @param   size_t _kernelSize
+ *          Number of elements in the kernel.
+ * @param   uint8_t _bitDepth
+ *          Output bit depth - 4 for 4 bit mode, 1 for 1 bit mode.
+ * @param   DitherRowFunction *_forward
+ *          Left to right function is stored here (NULL if the kernel is not one of the built-in kernels).
+ * @param   DitherRowFunction *_reverse
+ *          Right to left function is stored here (NULL if the kernel is not one of the built-in kernels).
+ */
+static void ditherRowFind(const KernelElement *_kernel, size_t _kernelSize, uint8_t _bitDepth, DitherRowFunction *_forward, DitherRowFunction *_reverse)
+{
+    *_forward = NULL;
+    *_reverse = NULL;
+
+    // Only 1 bit and 4 bit are supported.
+    if ((_bitDepth != 1) && (_bitDepth != 4)) return;
+
+    // Weights are: current row (x + 1, x + 2), next row (x - 2 ... x + 2), row after (x - 2 ... x + 2).
+    if (ditherKernelEquals(_kernel, _kernelSize, FS_KERNEL, FS_KERNEL_SIZE))
+        ditherRowSelect<7, 0, 0, 3, 5, 1, 0, 0, 0, 0, 0, 0>(_bitDepth, _forward, _reverse);
+    else if (ditherKernelEquals(_kernel, _kernelSize, JJN_KERNEL, JJN_KERNEL_SIZE))
+        ditherRowSelect<7, 5, 3, 5, 7, 5, 3, 1, 3, 5, 3, 1>(_bitDepth, _forward, _reverse);
+    else if (ditherKernelEquals(_kernel, _kernelSize, STUCKI_KERNEL, STUCKI_KERNEL_SIZE))
+        ditherRowSelect<8, 4, 2, 4, 8, 4, 2, 1, 2, 4, 2, 1>(_bitDepth, _forward, _reverse);
+    else if (ditherKernelEquals(_kernel, _kernelSize, SIERRA_KERNEL, SIERRA_KERNEL_SIZE))
+        ditherRowSelect<5, 3, 2, 4, 5, 4, 2, 0, 2, 3, 2, 0>(_bitDepth, _forward, _reverse);
+    else if (ditherKernelEquals(_kernel, _kernelSize, SIERRA_LITE_KERNEL, SIERRA_LITE_KERNEL_SIZE))
+        ditherRowSelect<2, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0>(_bitDepth, _forward, _reverse);
+    else if (ditherKernelEquals(_kernel, _kernelSize, ATKINSON_KERNEL, ATKINSON_KERNEL_SIZE))
+        ditherRowSelect<1, 1, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0>(_bitDepth, _forward, _reverse);
+    else if (ditherKernelEquals(_kernel, _kernelSize, BURKES_KERNEL, BURKES_KERNEL_SIZE))
+        ditherRowSelect<8, 4, 2, 4, 8, 4, 2, 0, 0, 0, 0, 0>(_bitDepth, _forward, _reverse);
+}
+
 /**
  * @brief Construct a new Image Processing object
  * 
@@ -30,11 +257,14 @@ ImageProcessing::~ImageProcessing()
  *          Inkplate object - used for drawPixel and DMA buffers.
  * @param   uint16_t _displayWidth
  *          Real screen width in pixels (without rotation). 
+ * @param   volatile uint8_t *_framebuffer
+ *          Main epaper framebuffer. Processed rows are packed into 1 bit or 4 bit and written directly into it.
+ *          If NULL, every pixel is written with drawPixel().
  * @return  bool
  *          true - Initialization successful.
  *          false - Initialization failed. Check memory or input parameters.
  */
-bool ImageProcessing::begin(Inkplate *_inkplate, uint16_t _displayWidth)
+bool ImageProcessing::begin(Inkplate *_inkplate, uint16_t _displayWidth, volatile uint8_t *_framebuffer)
 {
     // Check for the Inkplate object pointer.
     if (_inkplate == NULL) return false;
@@ -42,8 +272,9 @@ bool ImageProcessing::begin(Inkplate *_inkplate, uint16_t _displayWidth)
     // Copy object address locally.
     _inkplatePtr = _inkplate;
 
-    // Copy screen width locally.
+    // Copy screen width and framebuffer address locally.
     _displayW = _displayWidth;
+    this->_framebuffer = _framebuffer;
 
     // Calculate the size of the error buffers.
     _errorBufferSize = (_displayW + 10) * sizeof(uint16_t);
@@ -53,8 +284,11 @@ bool ImageProcessing::begin(Inkplate *_inkplate, uint16_t _displayWidth)
     _nextErrorBuffer = (int16_t*)malloc(_errorBufferSize);
     _afterNextErrorBuffer = (int16_t*)malloc(_errorBufferSize);
 
+    // Packed row is at most half of the screen width (4 bit mode), plus one partial byte.
+    _packedRow = (uint8_t*)malloc((_displayW / 2) + 2);
+
     // Check for allocation.
-    if ((_errorBuffer == NULL) || (_nextErrorBuffer == NULL) || (_afterNextErrorBuffer == NULL))
+    if ((_errorBuffer == NULL) || (_nextErrorBuffer == NULL) || (_afterNextErrorBuffer == NULL) || (_packedRow == NULL))
     {
         // Dang! Allocation has failed, abort everything!
         freeResources();
@@ -80,8 +314,9 @@ bool ImageProcessing::begin(Inkplate *_inkplate, uint16_t _displayWidth)
  *          Width of the image stored in the framebuffer (in pixels).
  * @param   uint16_t _height
  *          Height of the image stored in the framebuffer (in pixels).
- * @param   bool _ditheringEnabled
- *          Switch for disable/enable image dithering.
+ * @param   uint8_t _ditherMode
+ *          Dither mode (see InkplateDitherMode). 0 - disabled, 1 - error diffusion with the kernel,
+ *          other values are ordered dither.
  * @param   bool _colorInversion
  *          Switch for the disable/enable pixel color inversion.
  * @param   const KernelElement *_ditherKernelParameters
@@ -96,7 +331,7 @@ bool ImageProcessing::begin(Inkplate *_inkplate, uint16_t _displayWidth)
  * @note    Processing is done row-by-row due SDRAM buffering.
  *          
  */
-void ImageProcessing::processImage(uint8_t *_imageBuffer, int16_t _x0, int16_t _y0, uint16_t _width, uint16_t _height, bool _ditheringEnabled, bool _colorInversion, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth)
+void ImageProcessing::processImage(uint8_t *_imageBuffer, int16_t _x0, int16_t _y0, uint16_t _width, uint16_t _height, uint8_t _ditherMode, bool _colorInversion, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth)
 {
     // Check for the input parameters.
     if ((_imageBuffer == NULL) || (_width == 0) || (_height == 0)) return;
@@ -105,26 +340,16 @@ void ImageProcessing::processImage(uint8_t *_imageBuffer, int16_t _x0, int16_t _
     if (_width > _displayW) _width = _displayW;
 
     // Prepare buffers for image processing.
-    this->prepare(_imageBuffer, _width, _ditheringEnabled, _colorInversion, _ditherKernelParameters, _ditherKernelParametersSize);
+    if (!this->beginRowStream(_x0, _y0, _ditherMode, _colorInversion, _ditherKernelParameters, _ditherKernelParametersSize, _bitDepth)) return;
+
+    // Use the first DMA buffer as row buffer.
+    uint8_t *_rowBuffer = (uint8_t*)(_inkplatePtr->_dmaBuffer[0]);
 
     // Process line-by-line since it's buffered and accessing SDRAM byte-by-byte is slow.
     for (int _y = 0; _y < _height; _y++)
     {
-        // Do the dither if needed.
-        if ((_ditheringEnabled) && (_ditherKernelParameters) && (_ditherKernelParametersSize > 0))
-        {
-           // Update the buffers. Since there is a support for Stucki Dither that uses 3 rows, all of them needs to be updated.
-           this->ditherImageRow((uint8_t*)(_inkplatePtr->_dmaBuffer[0]), (uint8_t*)(_inkplatePtr->_dmaBuffer[1]), (uint8_t*)(_inkplatePtr->_dmaBuffer[2]), _y, _width, _ditherKernelParameters, _ditherKernelParametersSize, _bitDepth);
-        }
-
-        // Push the pixels to the epaper main framebuffer.
-        this->writePixels(_x0, _y + _y0, (uint8_t*)(_inkplatePtr->_dmaBuffer[0]), _width);
-
-        // Update the buffers!
-        this->moveBuffers(((uint8_t**)&(_inkplatePtr->_dmaBuffer[0])), ((uint8_t**)&(_inkplatePtr->_dmaBuffer[1])), ((uint8_t**)&(_inkplatePtr->_dmaBuffer[2])));
-
-        // Copy new data with DMA!
-        HAL_MDMA_Start_IT(stm32FmcGetSdramMdmaInstance(), (uint32_t)_imageBuffer + ((1024 * (_y + 3)) * 3), (uint32_t)_inkplatePtr->_dmaBuffer[2], MULTIPLE_OF_4(_width * 3), 1);
+        // Copy new data with DMA! Framebuffer is as wide as the screen.
+        HAL_MDMA_Start_IT(stm32FmcGetSdramMdmaInstance(), (uint32_t)_imageBuffer + ((_displayW * _y) * 3), (uint32_t)_rowBuffer, MULTIPLE_OF_4(_width * 3), 1);
         while (stm32FmcSdramCompleteFlag() == 0)
             ;
         stm32FmcClearSdramCompleteFlag();
@@ -135,14 +360,340 @@ void ImageProcessing::processImage(uint8_t *_imageBuffer, int16_t _x0, int16_t _
         // G = 0.7152 => 0.7152 * 256 = 183.0912 = 183
         // B = 0.0722 => 0.0722 * 256 = 18.4832 = 19
         // Tune if needed.
-        this->toGrayscaleRow((uint8_t*)(_inkplatePtr->_dmaBuffer[2]), _width);
+        this->toGrayscaleRow(_rowBuffer, _width);
+
+        // Invert, dither and write the row into the epaper framebuffer.
+        this->processRow(_rowBuffer, _width, _y);
+    }
+
+    // Free allocated memory for dither weight factors.
+    this->endRowStream();
+}
+
+/**
+ * @brief   Starts the row stream. After this, decoder can push the decoded image row-by-row with processRow().
+ *          This way there is no need for the temp. RGB888 framebuffer in the SDRAM.
+ *
+ * @param   int16_t _x0
+ *          X position where to draw image on the screen.
+ * @param   int16_t _y0
+ *          Y position where to draw image on the screen.
+ * @param   uint8_t _ditherMode
+ *          Dither mode (see InkplateDitherMode). 0 - disabled, 1 - error diffusion with the kernel,
+ *          other values are ordered dither.
+ * @param   bool _colorInversion
+ *          Switch for the disable/enable pixel color inversion.
+ * @param   const KernelElement *_ditherKernelParameters
+ *          Pointer to the dither kernel parameters. Only used for the error diffusion.
+ *          Provided Kernels can be used or custom ones.
+ * @param   size_t _ditherKernelParametersSize
+ *          Dither kernels size in bytes.
+ * @param   uint8_t _bitDepth
+ *          Output bit depth - 4 for 4 bit mode, 1 for 1 bit mode.
+ *          Other modes are not supported.
+ * @return  bool
+ *          true - Stream started, rows can be processed.
+ *          false - Stream start failed (library is not initialized or memory allocation failed).
+ *
+ * @note    Every stream must be ended with endRowStream().
+ */
+bool ImageProcessing::beginRowStream(int16_t _x0, int16_t _y0, uint8_t _ditherMode, bool _colorInversion, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth)
+{
+    // Check if the library is initialized at all.
+    if ((_inkplatePtr == NULL) || (_errorBuffer == NULL)) return false;
+
+    // Select the threshold matrix for the ordered dither.
+    switch (_ditherMode)
+    {
+        case INKPLATE_DITHER_BAYER_4X4:
+            _streamMatrix = ditherBayer4x4;
+            _streamMatrixSize = DITHER_BAYER_4X4_SIZE;
+            break;
+        case INKPLATE_DITHER_BAYER_8X8:
+            _streamMatrix = ditherBayer8x8;
+            _streamMatrixSize = DITHER_BAYER_8X8_SIZE;
+            break;
+        case INKPLATE_DITHER_BLUE_NOISE:
+            _streamMatrix = ditherBlueNoise64x64;
+            _streamMatrixSize = DITHER_BLUE_NOISE_SIZE;
+            break;
+        default:
+            _streamMatrix = NULL;
+            _streamMatrixSize = 0;
+            break;
+    }
+
+    // Error diffusion is only used if kernel is provided.
+    bool _ditheringEnabled = (_ditherMode != INKPLATE_DITHER_NONE) && (_streamMatrix == NULL) && (_ditherKernelParameters != NULL) && (_ditherKernelParametersSize > 0);
+
+    // Save the stream parameters locally.
+    _streamX0 = _x0;
+    _streamY0 = _y0;
+    _streamDither = _ditheringEnabled;
+    _streamInvert = _colorInversion;
+    _streamKernel = _ditherKernelParameters;
+    _streamKernelSize = _ditherKernelParametersSize;
+    _streamBitDepth = _bitDepth;
+
+    // Prepare buffers for image processing.
+    this->prepare(_ditheringEnabled, _ditherKernelParameters, _ditherKernelParametersSize);
 
+    // Use the specialized error diffusion for the built-in kernels.
+    _ditherRowForward = NULL;
+    _ditherRowReverse = NULL;
+    if (_ditheringEnabled) ditherRowFind(_ditherKernelParameters, _ditherKernelParametersSize, _bitDepth, &_ditherRowForward, &_ditherRowReverse);
+
+    // Check if the weights are allocated.
+    return (!_ditheringEnabled || (_ditherWeightFactors != NULL));
+}
+
+/**
+ * @brief   Process one 8 bit grayscale row of the image - invert it, dither it and write it into the
+ *          epaper framebuffer.
+ *
+ * @param   uint8_t *_grayRow
+ *          Pointer to the row (8 bit grayscale, one byte per pixel). Data in the buffer will be modified!
+ * @param   uint16_t _width
+ *          Width of the row in pixels.
+ * @param   int16_t _y
+ *          Y position of the row inside the image.
+ *
+ * @note    Rows must be provided in order (from top to bottom) due dithering error propagation.
+ */
+void ImageProcessing::processRow(uint8_t *_grayRow, uint16_t _width, int16_t _y)
+{
+    // Check for the input parameters.
+    if ((_grayRow == NULL) || (_width == 0)) return;
+
+    // Constrain width of the image to the width of the screen.
+    if (_width > _displayW) _width = _displayW;
+
+    if (_streamMatrix != NULL)
+    {
+        // Ordered dither (inversion is done in the same pass).
+        this->orderedDitherRow(_grayRow, _width, _streamX0, _y + _streamY0);
+    }
+    else
+    {
         // Do the inversion if needed.
-        if (_colorInversion) this->invertColorsRow((uint8_t*)(_inkplatePtr->_dmaBuffer[2]), _width);
+        if (_streamInvert) this->invertColorsRow(_grayRow, _width);
+
+        // Do the dither if needed.
+        if (_streamDither) this->ditherImageRow(_grayRow, _width, _streamKernel, _streamKernelSize, _streamBitDepth);
     }
 
+    // Push the pixels to the epaper main framebuffer.
+    this->writePixels(_streamX0, _y + _streamY0, _grayRow, _width);
+}
+
+/**
+ * @brief   Ends the row stream and releases memory used for the dithering.
+ *
+ */
+void ImageProcessing::endRowStream()
+{
     // Free allocated memory for dither weight factors.
-    if (_ditheringEnabled) free(_ditherWeightFactors);
+    if (_ditherWeightFactors) decodeArenaFree(_ditherWeightFactors);
+    _ditherWeightFactors = NULL;
+    _streamDither = false;
+    _streamMatrix = NULL;
+}
+
+/**
+ * @brief   Starts the resampler. Rows of the source image pushed with resampleRow() are scaled with the area
+ *          averaging (every output pixel is the average of all source pixels it covers) and sent into the
+ *          processRow(). Only fixed point math is used. Works for both downscale and upscale.
+ *
+ * @param   uint16_t _srcW
+ *          Width of the source image (in pixels).
+ * @param   uint16_t _srcH
+ *          Height of the source image (in pixels).
+ * @param   uint16_t _dstW
+ *          Width of the scaled image (in pixels).
+ * @param   uint16_t _dstH
+ *          Height of the scaled image (in pixels).
+ * @param   uint16_t _cropX
+ *          Number of the pixels of the scaled image skipped on the left side.
+ * @param   uint16_t _cropY
+ *          Number of the rows of the scaled image skipped on the top.
+ * @param   uint16_t _outW
+ *          Width of the output (visible part of the scaled image).
+ * @param   uint16_t _outH
+ *          Height of the output (visible part of the scaled image).
+ * @return  bool
+ *          true - Resampler is ready.
+ *          false - Memory allocation failed or parameters are out of range.
+ *
+ * @note    Row stream must be started before this with beginRowStream(). Resampler must be ended with endResample().
+ */
+bool ImageProcessing::beginResample(uint16_t _srcW, uint16_t _srcH, uint16_t _dstW, uint16_t _dstH, uint16_t _cropX, uint16_t _cropY, uint16_t _outW, uint16_t _outH)
+{
+    // Release old buffers (if there are any).
+    this->endResample();
+
+    // Check for the input parameters.
+    if ((_srcW == 0) || (_srcH == 0) || (_outW == 0) || (_outH == 0)) return false;
+    if (((uint32_t)(_cropX) + _outW > _dstW) || ((uint32_t)(_cropY) + _outH > _dstH)) return false;
+
+    // Positions are calculated in units of 1 / (src * dst) pixel, check that they fit in 32 bits.
+    if ((((uint64_t)(_srcW) * _dstW) > 0xFFFFFFFFULL) || (((uint64_t)(_srcH) * _dstH) > 0xFFFFFFFFULL)) return false;
+
+    // Allocate accumulator for the output row and buffer for the horizontally scaled and the output row.
+    _resampleAcc = (uint32_t*)decodeArenaMalloc(_outW * sizeof(uint32_t));
+    _resampleRow = (uint8_t*)decodeArenaMalloc(_outW * 2);
+    if ((_resampleAcc == NULL) || (_resampleRow == NULL))
+    {
+        this->endResample();
+        return false;
+    }
+    memset(_resampleAcc, 0, _outW * sizeof(uint32_t));
+
+    // Save the parameters.
+    _resampleSrcW = _srcW;
+    _resampleSrcH = _srcH;
+    _resampleDstW = _dstW;
+    _resampleDstH = _dstH;
+    _resampleCropX = _cropX;
+    _resampleCropY = _cropY;
+    _resampleOutW = _outW;
+    _resampleOutH = _outH;
+    _resampleSrcY = 0;
+    _resampleDstY = 0;
+    _resampleDstYEnd = _srcH;
+
+    // Output pixel is sum of the weights divided by the source size. Precalculate the reciprocals (0.32 fixed point) to avoid division.
+    _resampleRecipH = (0xFFFFFFFFULL / _srcW) + 1;
+    _resampleRecipV = (0xFFFFFFFFULL / _srcH) + 1;
+
+    return true;
+}
+
+/**
+ * @brief   Push one row of the source image into the resampler. When the output row is complete, it's
+ *          processed with processRow().
+ *
+ * @param   uint8_t *_grayRow
+ *          Pointer to the source row (8 bit grayscale, must be source width long).
+ *
+ * @note    Rows must be provided in order (from top to bottom). Rows after the source height are ignored.
+ */
+void ImageProcessing::resampleRow(uint8_t *_grayRow)
+{
+    // Check if the resampler is started at all.
+    if ((_resampleAcc == NULL) || (_grayRow == NULL) || (_resampleSrcY >= _resampleSrcH)) return;
+
+    // Source row covers [srcY * dstH, (srcY + 1) * dstH), output row covers [dstY * srcH, (dstY + 1) * srcH).
+    uint32_t _pos = (uint32_t)(_resampleSrcY) * _resampleDstH;
+    uint32_t _srcEnd = _pos + _resampleDstH;
+    _resampleSrcY++;
+
+    // Horizontal scaled row is calculated only if the row is needed.
+    uint8_t *_hRow = NULL;
+
+    while ((_pos < _srcEnd) && (_resampleDstY < _resampleDstH))
+    {
+        // How much of this source row goes into the current output row?
+        uint32_t _segEnd = (_resampleDstYEnd < _srcEnd) ? _resampleDstYEnd : _srcEnd;
+        uint32_t _weight = _segEnd - _pos;
+        _pos = _segEnd;
+
+        // Skip the rows that are cropped.
+        if ((_resampleDstY >= _resampleCropY) && (_resampleDstY < (_resampleCropY + _resampleOutH)))
+        {
+            // Scale the row horizontally (only once per source row).
+            if (_hRow == NULL)
+            {
+                _hRow = _resampleRow;
+
+                if (_resampleSrcW == _resampleDstW)
+                {
+                    // Same width, just copy visible pixels.
+                    memcpy(_hRow, _grayRow + _resampleCropX, _resampleOutW);
+                }
+                else
+                {
+                    // Source pixel covers [x * dstW, (x + 1) * dstW), output pixel covers [i * srcW, (i + 1) * srcW).
+                    uint32_t _hPos = (uint32_t)(_resampleCropX) * _resampleSrcW;
+                    uint16_t _x = _hPos / _resampleDstW;
+                    uint32_t _xEnd = (uint32_t)(_x + 1) * _resampleDstW;
+
+                    for (int _i = 0; _i < _resampleOutW; _i++)
+                    {
+                        uint32_t _end = _hPos + _resampleSrcW;
+                        uint32_t _sum = 0;
+
+                        // Sum all source pixels (or part of them) covered by this output pixel.
+                        while (_hPos < _end)
+                        {
+                            uint32_t _hSegEnd = (_xEnd < _end) ? _xEnd : _end;
+                            _sum += _grayRow[_x] * (_hSegEnd - _hPos);
+                            _hPos = _hSegEnd;
+                            if (_hPos == _xEnd)
+                            {
+                                _x++;
+                                _xEnd += _resampleDstW;
+                            }
+                        }
+
+                        // Divide by the source width (with rounding).
+                        _hRow[_i] = ((uint64_t)(_sum + (_resampleSrcW >> 1)) * _resampleRecipH) >> 32;
+                    }
+                }
+            }
+
+            // Accumulate the weighted row.
+            for (int _i = 0; _i < _resampleOutW; _i++)
+            {
+                _resampleAcc[_i] += _hRow[_i] * _weight;
+            }
+        }
+
+        // Output row complete? Send it into the processing.
+        if (_pos == _resampleDstYEnd)
+        {
+            this->resampleOutputRow();
+            _resampleDstY++;
+            _resampleDstYEnd += _resampleSrcH;
+        }
+    }
+}
+
+/**
+ * @brief   Ends the resampler and releases the memory.
+ *
+ */
+void ImageProcessing::endResample()
+{
+    if (_resampleAcc) decodeArenaFree(_resampleAcc);
+    if (_resampleRow) decodeArenaFree(_resampleRow);
+    _resampleAcc = NULL;
+    _resampleRow = NULL;
+}
+
+/**
+ * @brief   Converts accumulated output row into the 8 bit grayscale and sends it into the processRow().
+ *          Accumulator is cleared after that.
+ *
+ */
+void ImageProcessing::resampleOutputRow()
+{
+    // Skip the rows that are cropped.
+    if ((_resampleDstY < _resampleCropY) || (_resampleDstY >= (_resampleCropY + _resampleOutH))) return;
+
+    // Use second half of the buffer for the output row.
+    uint8_t *_outRow = _resampleRow + _resampleOutW;
+
+    // Divide by the source height (with rounding).
+    for (int _i = 0; _i < _resampleOutW; _i++)
+    {
+        _outRow[_i] = ((uint64_t)(_resampleAcc[_i] + (_resampleSrcH >> 1)) * _resampleRecipV) >> 32;
+    }
+
+    // Clear the accumulator for the next row.
+    memset(_resampleAcc, 0, _resampleOutW * sizeof(uint32_t));
+
+    // Invert, dither and write the row into the epaper framebuffer.
+    this->processRow(_outRow, _resampleOutW, _resampleDstY - _resampleCropY);
 }
 
 /**
@@ -203,16 +754,11 @@ void ImageProcessing::invertColorsRow(uint8_t *_imageBuffer, uint16_t _imageWidt
 }
 
 /**
- * @brief   Method dithers one row of the provided 
- *          
+ * @brief   Method dithers one row of the provided image. Error is propagated through the error buffers,
+ *          so only the current row is needed.
+ *
  * @param   uint8_t *_currentRow
  *          Pointer to the address of the buffer for the current processed row.
- * @param   uint8_t *_nextRow
- *          Pointer to the address of the buffer for the next processed row.
- * @param   uint8_t *_rowAfterNext
- *          Pointer to the address of the buffer for the after next processed row.
- * @param   int16_t _y0
- *          Y position where the image should be drawn on screen.
  * @param   uint16_t _width
  *          Width of the image provided in the buffers (in pixels).
  * @param   const KernelElement *_ditherKernelParameters
@@ -224,8 +770,20 @@ void ImageProcessing::invertColorsRow(uint8_t *_imageBuffer, uint16_t _imageWidt
  *          Output bit depth - 4 for 4 bit mode, 1 for 1 bit mode.
  *          Other modes are not supported.
  */
-void ImageProcessing::ditherImageRow(uint8_t *_currentRow, uint8_t *_nextRow, uint8_t *_rowAfterNext, int16_t _y0, uint16_t _width, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth)
+void ImageProcessing::ditherImageRow(uint8_t *_currentRow, uint16_t _width, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth)
 {
+    // Built-in kernel? Use the specialized one.
+    if (_ditherRowForward != NULL)
+    {
+        // Serpentine scan - every other row goes from right to left.
+        bool _reverse = _serpentine && (_ditherRowCount & 1);
+        (_reverse ? _ditherRowReverse : _ditherRowForward)(_currentRow, _width, _errorBuffer, _nextErrorBuffer, _afterNextErrorBuffer);
+        _ditherRowCount++;
+
+        this->swapErrorBuffers();
+        return;
+    }
+
     // Precompute constants based on bit depth.
     int16_t _quantErrorFactor = (_bitDepth == 1) ? 255 : 255 >> 4; // Divide by 16
 
@@ -277,11 +835,11 @@ void ImageProcessing::ditherImageRow(uint8_t *_currentRow, uint8_t *_nextRow, ui
                 {
                     _targetBuffer = _errorBuffer; // Same row
                 }
-                else if (_newY == 1 && _nextRow)
+                else if (_newY == 1)
                 {
                     _targetBuffer = _nextErrorBuffer; // Next row
                 }
-                else if (_newY == 2 && _rowAfterNext)
+                else if (_newY == 2)
                 {
                     _targetBuffer = _afterNextErrorBuffer; // After-next row
                 }
@@ -295,6 +853,16 @@ void ImageProcessing::ditherImageRow(uint8_t *_currentRow, uint8_t *_nextRow, ui
         }
     }
 
+    // Swap error buffers for the next iteration.
+    this->swapErrorBuffers();
+}
+
+/**
+ * @brief   Moves error buffers by one row after the row is dithered and clears the ones that are not used yet.
+ *
+ */
+void ImageProcessing::swapErrorBuffers()
+{
     // Swap error buffers for the next iteration.
     int16_t *_temp = _errorBuffer;
     _errorBuffer = _nextErrorBuffer;
@@ -307,7 +875,96 @@ void ImageProcessing::ditherImageRow(uint8_t *_currentRow, uint8_t *_nextRow, ui
 }
 
 /**
- * @brief   Method writes the pixels into the epaper/Inkplate main framebuffer.
+ * @brief   Enables or disables serpentine scan for the built-in error diffusion kernels. With serpentine scan,
+ *          every other row is dithered from right to left with mirrored kernel, which removes "worm" artifacts.
+ *          Custom kernels are always dithered from left to right.
+ *
+ * @param   bool _enable
+ *          true - Serpentine scan is used (default).
+ *          false - Every row is dithered from left to right.
+ */
+void ImageProcessing::setSerpentineDither(bool _enable)
+{
+    _serpentine = _enable;
+}
+
+/**
+ * @brief   Check if the serpentine scan is used for the built-in error diffusion kernels.
+ *
+ * @return  bool
+ *          true - Serpentine scan is used.
+ *          false - Every row is dithered from left to right.
+ */
+bool ImageProcessing::getSerpentineDither()
+{
+    return _serpentine;
+}
+
+/**
+ * @brief   Method dithers one row with the threshold matrix (ordered dither). Each pixel is compared only to its own
+ *          threshold, so there is no error propagation - it's much faster than error diffusion and the pattern
+ *          does not change between frames (matrix is anchored to the screen). Colors are inverted here as well.
+ *
+ * @param   uint8_t *_row
+ *          Pointer to the row (8 bit grayscale). Dithered pixels are written back into it.
+ * @param   uint16_t _width
+ *          Width of the row in pixels.
+ * @param   int16_t _x0
+ *          X position of the first pixel on the screen.
+ * @param   int16_t _y
+ *          Y position of the row on the screen.
+ */
+void ImageProcessing::orderedDitherRow(uint8_t *_row, uint16_t _width, int16_t _x0, int16_t _y)
+{
+    // Matrix size is power of two, so modulo is just a mask.
+    uint8_t _mask = _streamMatrixSize - 1;
+    const uint8_t *_matrixRow = _streamMatrix + ((_y & _mask) * _streamMatrixSize);
+    uint8_t _invert = _streamInvert ? 0xFF : 0x00;
+    uint32_t _invert4Px = _streamInvert ? 0xFFFFFFFF : 0x00000000;
+    uint16_t _x = 0;
+
+    // Pixels one by one until the matrix column is multiple of 4 (four thresholds can be read at once after that).
+    while ((_x < _width) && ((_x0 + _x) & 3))
+    {
+        _row[_x] = orderedDitherPixel(_row[_x] ^ _invert, _matrixRow[(_x0 + _x) & _mask], _streamBitDepth);
+        _x++;
+    }
+
+    // Four pixels at once.
+    uint32_t _pixels;
+    uint32_t _thresholds;
+    if (_streamBitDepth == 1)
+    {
+        for (; (_x + 4) <= _width; _x += 4)
+        {
+            memcpy(&_pixels, _row + _x, 4);
+            memcpy(&_thresholds, _matrixRow + ((_x0 + _x) & _mask), 4);
+            _pixels = orderedDither1Bit4Px(_pixels ^ _invert4Px, _thresholds);
+            memcpy(_row + _x, &_pixels, 4);
+        }
+    }
+    else
+    {
+        for (; (_x + 4) <= _width; _x += 4)
+        {
+            memcpy(&_pixels, _row + _x, 4);
+            memcpy(&_thresholds, _matrixRow + ((_x0 + _x) & _mask), 4);
+            _pixels = orderedDither4Bit4Px(_pixels ^ _invert4Px, _thresholds);
+            memcpy(_row + _x, &_pixels, 4);
+        }
+    }
+
+    // Rest of the pixels.
+    for (; _x < _width; _x++)
+    {
+        _row[_x] = orderedDitherPixel(_row[_x] ^ _invert, _matrixRow[(_x0 + _x) & _mask], _streamBitDepth);
+    }
+}
+
+/**
+ * @brief   Method writes the pixels into the epaper/Inkplate main framebuffer. Row is clipped to the screen once and
+ *          then packed into 1 bit or 4 bit and written as a whole (screen not rotated or rotated by 180 degrees),
+ *          or written as one framebuffer column (screen rotated by 90 or 270 degrees).
  * 
  * @param   int16_t _x0
  *          X coridinate where to start writing the image.
@@ -320,31 +977,157 @@ void ImageProcessing::ditherImageRow(uint8_t *_currentRow, uint8_t *_nextRow, ui
  */
 void ImageProcessing::writePixels(int16_t _x0, int16_t _y0, uint8_t *_imageBuffer, uint16_t _imageWidth)
 {
-    for (int _xPixel = 0; _xPixel < _imageWidth; _xPixel++)
+    // Framebuffer is not known? Use drawPixel().
+    if ((_framebuffer == NULL) || (_packedRow == NULL))
+    {
+        for (int _xPixel = 0; _xPixel < _imageWidth; _xPixel++)
+        {
+            _inkplatePtr->drawPixel(_x0 + _xPixel, _y0, _imageBuffer[_xPixel] >> 4);
+        }
+        return;
+    }
+
+    // Clip the row to the screen (in rotated coordinates).
+    int _start = (_x0 < 0) ? -_x0 : 0;
+    int _end = min((int)(_imageWidth), _inkplatePtr->width() - _x0);
+    if ((_y0 < 0) || (_y0 >= _inkplatePtr->height()) || (_start >= _end)) return;
+
+    // First visible pixel and number of visible pixels.
+    const uint8_t *_src = _imageBuffer + _start;
+    int16_t _x = _x0 + _start;
+    uint16_t _n = _end - _start;
+    bool _bwMode = (_inkplatePtr->getDisplayMode() == INKPLATE_1BW);
+
+    // Map the row into the framebuffer (same as in Inkplate::drawPixel()).
+    switch (_inkplatePtr->getRotation())
     {
-        _inkplatePtr->drawPixel(_x0 + _xPixel, _y0, _imageBuffer[_xPixel] >> 4);
+        case 0:
+            this->writePackedRow(_x, _y0, _src, _n, 1, _bwMode);
+            break;
+        case 1:
+            this->writeTransposedColumn((int)(SCREEN_WIDTH) - 1 - _y0, _x, _src, _n, 1, _bwMode);
+            break;
+        case 2:
+            // Last pixel of the row is the first one in the framebuffer.
+            this->writePackedRow((int)(SCREEN_WIDTH) - _x - _n, (int)(SCREEN_HEIGHT) - 1 - _y0, _src + _n - 1, _n, -1, _bwMode);
+            break;
+        case 3:
+            this->writeTransposedColumn(_y0, (int)(SCREEN_HEIGHT) - 1 - _x, _src, _n, -1, _bwMode);
+            break;
     }
 }
 
 /**
- * @brief   Moves the buffers around. Moves them forward and loops back around.
- *          It goes [1][2][3] -> [2][3][1].
- * 
- * @param   uint8_t **_currentRow
- *          Pointer to the first buffer.
- * @param   uint8_t **_nextRow
- *          Pointer to the second buffer.
- * @param   uint8_t **_rowAfterNext
- *          Pointer to the three buffer.
- *          
+ * @brief   Packs the pixels into one framebuffer row (1 bit or 4 bit) and writes them into the framebuffer. Whole
+ *          bytes are copied at once, partial first and last bytes are merged with the pixels already there.
+ *
+ * @param   int16_t _px
+ *          X position of the first pixel in the framebuffer (must be on the screen).
+ * @param   int16_t _py
+ *          Y position of the row in the framebuffer (must be on the screen).
+ * @param   const uint8_t *_src
+ *          Pointer to the pixel that goes to the _px (processed pixel, value in the upper nibble).
+ * @param   uint16_t _n
+ *          Number of pixels (must fit on the screen).
+ * @param   int8_t _step
+ *          1 - next pixel in the framebuffer is the next pixel in the source, -1 - it's the previous one.
+ * @param   bool _bwMode
+ *          true - 1 bit framebuffer, false - 4 bit framebuffer.
  */
-void ImageProcessing::moveBuffers(uint8_t **_currentRow, uint8_t **_nextRow, uint8_t **_rowAfterNext)
+void ImageProcessing::writePackedRow(int16_t _px, int16_t _py, const uint8_t *_src, uint16_t _n, int8_t _step, bool _bwMode)
 {
-    // Move the buffers([1][2][3] -> [2][3][1]).
-    uint8_t *_temp = *_currentRow;
-    *_currentRow = *_nextRow;
-    *_nextRow = *_rowAfterNext;
-    *_rowAfterNext = _temp;
+    // Framebuffer row and range of the bytes used.
+    uint8_t _shift = _bwMode ? 3 : 1;
+    int _last = _px + _n - 1;
+    volatile uint8_t *_fbRow = _framebuffer + ((uint32_t)(_py) * (_displayW >> _shift));
+    uint16_t _firstByte = _px >> _shift;
+    uint16_t _numBytes = (_last >> _shift) - _firstByte + 1;
+    uint8_t _firstMask;
+    uint8_t _lastMask;
+
+    // Pack the pixels (buffer starts with the byte of the first pixel).
+    memset(_packedRow, 0, _numBytes);
+    if (_bwMode)
+    {
+        // MSB is the first pixel, 1 is black.
+        uint16_t _bit = _px & 7;
+        for (uint16_t i = 0; i < _n; i++, _bit++, _src += _step)
+        {
+            _packedRow[_bit >> 3] |= ((*_src >> 4) & 1) << (7 - (_bit & 7));
+        }
+        _firstMask = 0xFF >> (_px & 7);
+        _lastMask = 0xFF << (7 - (_last & 7));
+    }
+    else
+    {
+        // Lower nibble is the first pixel.
+        uint16_t _nibble = _px & 1;
+        for (uint16_t i = 0; i < _n; i++, _nibble++, _src += _step)
+        {
+            _packedRow[_nibble >> 1] |= (*_src >> 4) << ((_nibble & 1) << 2);
+        }
+        _firstMask = (_px & 1) ? 0xF0 : 0xFF;
+        _lastMask = (_last & 1) ? 0xFF : 0x0F;
+    }
+
+    // Only one byte? Both masks are used on it.
+    if (_numBytes == 1)
+    {
+        _firstMask &= _lastMask;
+        _fbRow[_firstByte] = (_fbRow[_firstByte] & ~_firstMask) | (_packedRow[0] & _firstMask);
+        return;
+    }
+
+    // Merge the partial bytes at the edges and copy all whole bytes at once.
+    _fbRow[_firstByte] = (_fbRow[_firstByte] & ~_firstMask) | (_packedRow[0] & _firstMask);
+    _fbRow[_firstByte + _numBytes - 1] = (_fbRow[_firstByte + _numBytes - 1] & ~_lastMask) | (_packedRow[_numBytes - 1] & _lastMask);
+    if (_numBytes > 2) memcpy((uint8_t *)(_fbRow + _firstByte + 1), _packedRow + 1, _numBytes - 2);
+}
+
+/**
+ * @brief   Writes the pixels into one framebuffer column (used when the screen is rotated by 90 or 270 degrees, so
+ *          one image row is one framebuffer column). Byte and bit position are the same for every pixel, so only
+ *          the row address is moved.
+ *
+ * @param   int16_t _px
+ *          X position of the column in the framebuffer (must be on the screen).
+ * @param   int16_t _py
+ *          Y position of the first pixel in the framebuffer (must be on the screen).
+ * @param   const uint8_t *_src
+ *          Pointer to the first pixel (processed pixel, value in the upper nibble).
+ * @param   uint16_t _n
+ *          Number of pixels (must fit on the screen).
+ * @param   int8_t _step
+ *          1 - next pixel goes one framebuffer row down, -1 - it goes one row up.
+ * @param   bool _bwMode
+ *          true - 1 bit framebuffer, false - 4 bit framebuffer.
+ */
+void ImageProcessing::writeTransposedColumn(int16_t _px, int16_t _py, const uint8_t *_src, uint16_t _n, int8_t _step, bool _bwMode)
+{
+    // Framebuffer stride (negative if the column goes up).
+    int32_t _stride = (int32_t)(_displayW >> (_bwMode ? 3 : 1)) * _step;
+    volatile uint8_t *_fb = _framebuffer + ((uint32_t)(_py) * (_displayW >> (_bwMode ? 3 : 1))) + (_px >> (_bwMode ? 3 : 1));
+
+    if (_bwMode)
+    {
+        // Bit of this column inside the byte.
+        uint8_t _shift = 7 - (_px & 7);
+        uint8_t _mask = ~(1 << _shift);
+        for (uint16_t i = 0; i < _n; i++, _fb += _stride)
+        {
+            *_fb = (*_fb & _mask) | (((_src[i] >> 4) & 1) << _shift);
+        }
+    }
+    else
+    {
+        // Nibble of this column inside the byte.
+        uint8_t _shift = (_px & 1) << 2;
+        uint8_t _mask = ~(0x0F << _shift);
+        for (uint16_t i = 0; i < _n; i++, _fb += _stride)
+        {
+            *_fb = (*_fb & _mask) | ((_src[i] >> 4) << _shift);
+        }
+    }
 }
 
 /**
@@ -357,61 +1140,46 @@ void ImageProcessing::freeResources()
     if (_nextErrorBuffer) free(_nextErrorBuffer);
     if (_errorBuffer) free(_errorBuffer);
     if (_afterNextErrorBuffer) free(_afterNextErrorBuffer);
+    if (_packedRow) free(_packedRow);
 
     // Free precalculated Weight factors.
-    if (_ditherWeightFactors) free(_ditherWeightFactors);
+    if (_ditherWeightFactors) decodeArenaFree(_ditherWeightFactors);
+
+    // Free resampler buffers.
+    this->endResample();
 
     // Set every pointer to NULL.    
     _errorBuffer = NULL;
     _nextErrorBuffer = NULL;
     _afterNextErrorBuffer = NULL;
     _ditherWeightFactors = NULL;
+    _packedRow = NULL;
 }
 
 /**
  * @brief   Method is used to prepare the buffers for the image processing.
- *          It preloads, decodes first three rows, precalculates the dither parameters and clears the buffers.
+ *          It precalculates the dither parameters and clears the buffers.
  * 
- * @param   uint8_t *_imageFramebuffer
- *          Pointer to the framebuffer needs to be processed.
- * @param   uint16_t _w
- *          Size of the image in the buffer that needs to be processes (in pixels).
  * @param   bool _ditheringEnabled
  *          Switch for disable/enable image dithering.
- * @param   bool _colorInversion
- *          Switch for the disable/enable pixel color inversion.
  * @param   const KernelElement *_ditherKernelParameters
  *          Pointer to the dither kernel parameters. NULL if dithering is not used.
  *          Provided Kernels can be used or custom ones.
  * @param   size_t_ditherKernelParametersSize
  *          Dither kernels size in bytes.
  */
-void ImageProcessing::prepare(uint8_t *_imageFramebuffer, uint16_t _w,  bool _ditheringEnabled, bool _colorInversion,  const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize)
+void ImageProcessing::prepare(bool _ditheringEnabled, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize)
 {
     // Initialize dither buffers.
+    _ditherRowCount = 0;
     memset(_errorBuffer, 0, _errorBufferSize);
     memset(_nextErrorBuffer, 0, _errorBufferSize);
     memset(_afterNextErrorBuffer, 0, _errorBufferSize);
 
-    // Feed the data!
-    // Copy one line into SRAM since it's faster to process image from SRAM than from SDRAM.
-    for (int i = 0; i < 3; i++)
-    {
-        // Use DMA and DMA buffers to copy pixels from SDRAM into SRAM.
-        HAL_MDMA_Start_IT(stm32FmcGetSdramMdmaInstance(), (uint32_t)_imageFramebuffer + ((1024 * (i + 3)) * 3), (uint32_t)_inkplatePtr->_dmaBuffer[i], MULTIPLE_OF_4(_w * 3), 1);
-        while (stm32FmcSdramCompleteFlag() == 0)
-            ;
-        stm32FmcClearSdramCompleteFlag();
-
-        // Pre-process these three rows.
-        this->toGrayscaleRow((uint8_t*)(_inkplatePtr->_dmaBuffer[i]), _w, 54, 183, 19);
-        if (_colorInversion) this->invertColorsRow((uint8_t*)(_inkplatePtr->_dmaBuffer[i]), _w);
-    }
-
     // Precompute weight factors for the dithering kernel.
     if ((_ditheringEnabled) && (_ditherKernelParameters) && (_ditherKernelParametersSize > 0))
     {
-        _ditherWeightFactors = (int16_t*)malloc(sizeof(int16_t) * _ditherKernelParametersSize);
+        _ditherWeightFactors = (int16_t*)decodeArenaMalloc(sizeof(int16_t) * _ditherKernelParametersSize);
         if (_ditherWeightFactors == NULL) return;
         for (size_t i = 0; i < _ditherKernelParametersSize; i++)
         {
@@ -7,9 +7,15 @@
 // Include dither kernel typedef and preddefined kernels.
 #include "ditherKernels.h"
 
+// Include threshold matrices for the ordered dither.
+#include "ditherMatrices.h"
+
 // Inkplate class forward declaration.
 class Inkplate;
 
+// Specialized (unrolled) error diffusion for one of the built-in kernels. Parameters are row, width and three error buffers.
+typedef void (*DitherRowFunction)(uint8_t *, uint16_t, int16_t *, int16_t *, int16_t *);
+
 // Class for Inkplate image processing - it adjusts image to the screen (24RGB to 8bit RGB Grayscale, dithering, inversion etc).
 class ImageProcessing
 {
@@ -20,25 +26,64 @@ class ImageProcessing
         ~ImageProcessing();
 
         // Initialization of the library. Returns fail is memory allocation failed or ambiguous input parameters.
-        bool begin(Inkplate *_inkplate, uint16_t _displayWidth);
+        // If the framebuffer address is provided, rows are packed and written directly into it (otherwise drawPixel() is used).
+        bool begin(Inkplate *_inkplate, uint16_t _displayWidth, volatile uint8_t *_framebuffer = NULL);
+
+        // Main function that does the whole image processing from RGB888 framebuffer - it does this row-by-row due SDRAM and buffering.
+        void processImage(uint8_t *_imageBuffer, int16_t _x0, int16_t _y0, uint16_t _width, uint16_t _height, uint8_t _ditherMode, bool _colorInversion, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth);
+
+        // Row streaming - decoder pushes 8 bit grayscale rows (top to bottom) directly into the processing, no temp. framebuffer is needed.
+        bool beginRowStream(int16_t _x0, int16_t _y0, uint8_t _ditherMode, bool _colorInversion, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth);
+        void processRow(uint8_t *_grayRow, uint16_t _width, int16_t _y);
+        void endRowStream();
+
+        // Serpentine scan for the built-in error diffusion kernels (every other row is dithered from right to left). Enabled by default.
+        void setSerpentineDither(bool _enable);
+        bool getSerpentineDither();
+
+        // Resampler - scales rows of the row stream (fixed point area averaging) before they are processed. Source rows are pushed with resampleRow() instead of processRow().
+        bool beginResample(uint16_t _srcW, uint16_t _srcH, uint16_t _dstW, uint16_t _dstH, uint16_t _cropX, uint16_t _cropY, uint16_t _outW, uint16_t _outH);
+        void resampleRow(uint8_t *_grayRow);
+        void endResample();
 
-        // Main function that does the whole image processing - it does this row-by-row due SDRAM and buffering. It pre-buffers three rows in advance.
-        void processImage(uint8_t *_imageBuffer, int16_t _x0, int16_t _y0, uint16_t _width, uint16_t _height, bool _ditheringEnabled, bool _colorInversion, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth);
+        /**
+         * @brief   Convert one RGB888 pixel into 8 bit grayscale. Uses BT.709 standard (see toGrayscaleRow()).
+         *
+         * @param   uint8_t _r
+         *          Red color component.
+         * @param   uint8_t _g
+         *          Green color component.
+         * @param   uint8_t _b
+         *          Blue color component.
+         * @return  uint8_t
+         *          8 bit grayscale value.
+         */
+        static inline uint8_t toGrayscale(uint8_t _r, uint8_t _g, uint8_t _b)
+        {
+            return ((54UL * _r) + (183UL * _g) + (19UL * _b)) >> 8;
+        }
 
     private:
         void toGrayscaleRow(uint8_t *_imageBuffer, uint16_t _imageWidth, uint8_t _redParameter = 54, uint8_t _greenParameter = 183, uint8_t _blueParameter = 19);
         void invertColorsRow(uint8_t *_imageBuffer, uint16_t _imageWidth);
-        void ditherImageRow(uint8_t *_currentRow, uint8_t *_nextRow, uint8_t *_rowAfterNext, int16_t _y0, uint16_t _width, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth);
+        void ditherImageRow(uint8_t *_currentRow, uint16_t _width, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize, uint8_t _bitDepth);
+        void swapErrorBuffers();
+        void orderedDitherRow(uint8_t *_row, uint16_t _width, int16_t _x0, int16_t _y);
         void writePixels(int16_t _x0, int16_t _y0, uint8_t *_imageBuffer, uint16_t _imageWidth);
+        void writePackedRow(int16_t _px, int16_t _py, const uint8_t *_src, uint16_t _n, int8_t _step, bool _bwMode);
+        void writeTransposedColumn(int16_t _px, int16_t _py, const uint8_t *_src, uint16_t _n, int8_t _step, bool _bwMode);
         void freeResources();
-        void moveBuffers(uint8_t **_currentRow, uint8_t **_nextRow, uint8_t **_rowAfterNext);
-        void prepare(uint8_t *_imageFramebuffer, uint16_t _width,  bool _ditheringEnabled, bool _colorInversion,  const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize);
+        void prepare(bool _ditheringEnabled, const KernelElement *_ditherKernelParameters, size_t _ditherKernelParametersSize);
 
         // Internal pointer of the inkplate library object.
         Inkplate *_inkplatePtr = NULL;
         // Real width of the screen (must exclude rotation).
         uint16_t _displayW = 0;
 
+        // Main epaper framebuffer (NULL if not used) and buffer for one packed row.
+        volatile uint8_t *_framebuffer = NULL;
+        uint8_t *_packedRow = NULL;
+
         // Error buffers related.
         int _errorBufferSize = 0;
         int16_t *_errorBuffer = NULL;
@@ -47,6 +92,43 @@ class ImageProcessing
 
         // Buffer for precalculate d weight factors.
         int16_t *_ditherWeightFactors = NULL;
+
+        // Parameters of the current row stream (set in beginRowStream()).
+        int16_t _streamX0 = 0;
+        int16_t _streamY0 = 0;
+        bool _streamDither = false;
+        bool _streamInvert = false;
+        const KernelElement *_streamKernel = NULL;
+        size_t _streamKernelSize = 0;
+        uint8_t _streamBitDepth = 1;
+
+        // Specialized error diffusion for the built-in kernels (NULL for custom kernels, generic code is used).
+        DitherRowFunction _ditherRowForward = NULL;
+        DitherRowFunction _ditherRowReverse = NULL;
+        bool _serpentine = true;
+        uint16_t _ditherRowCount = 0;
+
+        // Threshold matrix for the ordered dither (NULL if ordered dither is not used).
+        const uint8_t *_streamMatrix = NULL;
+        uint8_t _streamMatrixSize = 0;
+
+        // Resampler related (set in beginResample()).
+        void resampleOutputRow();
+        uint32_t *_resampleAcc = NULL;
+        uint8_t *_resampleRow = NULL;
+        uint16_t _resampleSrcW = 0;
+        uint16_t _resampleSrcH = 0;
+        uint16_t _resampleDstW = 0;
+        uint16_t _resampleDstH = 0;
+        uint16_t _resampleCropX = 0;
+        uint16_t _resampleCropY = 0;
+        uint16_t _resampleOutW = 0;
+        uint16_t _resampleOutH = 0;
+        uint16_t _resampleSrcY = 0;
+        uint16_t _resampleDstY = 0;
+        uint32_t _resampleDstYEnd = 0;
+        uint64_t _resampleRecipH = 0;
+        uint64_t _resampleRecipV = 0;
 };
 
 #endif
\ No newline at end of file
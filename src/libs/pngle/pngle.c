@@ -31,6 +31,9 @@
 #include "miniz.h"
 #include "pngle.h"
 
+// Added by Soldered Electronics.
+#include "../../system/decodeArena.h"
+
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
@@ -42,7 +45,9 @@
 #endif
 
 #define PNGLE_ERROR(s) (pngle->error = (s), pngle->state = PNGLE_STATE_ERROR, -1)
-#define PNGLE_CALLOC(a, b, name) (debug_printf("[pngle] Allocating %lu bytes for %s\n", (size_t)(a) * (size_t)(b), (name)), calloc((size_t)(a), (size_t)(b)))
+// Added by Soldered Electronics - memory is allocated from the Inkplate decode arena (see decodeArena.h)
+#define PNGLE_CALLOC(a, b, name) (debug_printf("[pngle] Allocating %lu bytes for %s\n", (size_t)(a) * (size_t)(b), (name)), decodeArenaCalloc((size_t)(a), (size_t)(b)))
+#define PNGLE_FREE(p) decodeArenaFree(p)
 
 #define PNGLE_UNUSED(x) (void)(x)
 
@@ -113,6 +118,14 @@ struct _pngle_t {
 	// Added by Soldered Electronics - session handle (used for framebuffer).
 	void *sessionHandler;
 
+	// Added by Soldered Electronics - scanline output. Callback and format are kept like draw_callback, the output
+	// row and the tables are freed by pngle_reset() and made again for every image.
+	pngle_scanline_callback_t scanline_callback;
+	pngle_scanline_format_t scanline_format;
+	uint8_t *scanline_out; // NULL indicates scanline output is not used (yet)
+	uint8_t level_lut[256]; // sample value (or high byte for depth 16) -> 8 bit level, gamma included
+	uint8_t palette_lut[256 * 3]; // palette index -> gray or RGB888 in the output format
+
 	// misc
 	const char *error;
 	void *user_data;
@@ -162,14 +175,16 @@ void pngle_reset(pngle_t *pngle)
 	pngle->state = PNGLE_STATE_INITIAL;
 	pngle->error = "No error";
 
-	if (pngle->scanline_ringbuf) free(pngle->scanline_ringbuf);
-	if (pngle->palette) free(pngle->palette);
-	if (pngle->trans_palette) free(pngle->trans_palette);
+	if (pngle->scanline_ringbuf) PNGLE_FREE(pngle->scanline_ringbuf);
+	if (pngle->palette) PNGLE_FREE(pngle->palette);
+	if (pngle->trans_palette) PNGLE_FREE(pngle->trans_palette);
+	if (pngle->scanline_out) PNGLE_FREE(pngle->scanline_out);
 #ifndef PNGLE_NO_GAMMA_CORRECTION
-	if (pngle->gamma_table) free(pngle->gamma_table);
+	if (pngle->gamma_table) PNGLE_FREE(pngle->gamma_table);
 #endif
 
 	pngle->scanline_ringbuf = NULL;
+	pngle->scanline_out = NULL;
 	pngle->palette = NULL;
 	pngle->trans_palette = NULL;
 #ifndef PNGLE_NO_GAMMA_CORRECTION
@@ -204,7 +219,7 @@ void pngle_destroy(pngle_t *pngle)
 {
 	if (pngle) {
 		pngle_reset(pngle);
-		free(pngle);
+		PNGLE_FREE(pngle);
 	}
 }
 
@@ -357,6 +372,151 @@ static int pngle_draw_pixels(pngle_t *pngle, size_t scanline_ringbuf_xidx)
 	return 0;
 }
 
+// Added by Soldered Electronics - same BT.709 weights as the Inkplate image processing
+static inline uint8_t scanline_gray(uint8_t r, uint8_t g, uint8_t b)
+{
+	return ((54UL * r) + (183UL * g) + (19UL * b)) >> 8;
+}
+
+// Added by Soldered Electronics - allocates the output row and precomputes depth, gamma and palette tables,
+// so the per-pixel path has no divisions. Called on the first IDAT data (PLTE and gAMA are known by then).
+static int setup_scanline(pngle_t *pngle)
+{
+	uint8_t out_channels = (pngle->scanline_format == PNGLE_SCANLINE_RGB888) ? 3 : 1;
+	uint8_t pixel_depth = (pngle->hdr.color_type & 1) ? 8 : pngle->hdr.depth;
+
+	if ((pngle->scanline_out = PNGLE_CALLOC(pngle->hdr.width, out_channels, "scanline out")) == NULL) return PNGLE_ERROR("Insufficient memory");
+
+	// depth scaling: 1, 2 and 4 bit samples are scaled up, only the high byte of 16 bit samples is used
+	if (pixel_depth < 8) {
+		uint16_t maxval = (1UL << pixel_depth) - 1;
+		for (int i = 0; i <= maxval; i++) {
+			pngle->level_lut[i] = (i * 255 + maxval / 2) / maxval;
+		}
+	} else {
+		for (int i = 0; i < 256; i++) {
+			pngle->level_lut[i] = i;
+		}
+	}
+
+#ifndef PNGLE_NO_GAMMA_CORRECTION
+	if (pngle->gamma_table) {
+		uint16_t maxval = (1UL << pixel_depth) - 1;
+		for (int i = 0; i <= MIN(maxval, 255); i++) {
+			pngle->level_lut[i] = pngle->gamma_table[pixel_depth == 16 ? i * 257 : i];
+		}
+	}
+#endif
+
+	// palette: colors are converted once, indices out of range are rejected in pngle_store_pixels()
+	if (pngle->hdr.color_type == 3) {
+		memset(pngle->palette_lut, 0, sizeof(pngle->palette_lut));
+		for (size_t i = 0; i < pngle->n_palettes; i++) {
+			uint8_t r = pngle->level_lut[pngle->palette[i * 3 + 0]];
+			uint8_t g = pngle->level_lut[pngle->palette[i * 3 + 1]];
+			uint8_t b = pngle->level_lut[pngle->palette[i * 3 + 2]];
+
+			if (out_channels == 3) {
+				pngle->palette_lut[i * 3 + 0] = r;
+				pngle->palette_lut[i * 3 + 1] = g;
+				pngle->palette_lut[i * 3 + 2] = b;
+			} else {
+				pngle->palette_lut[i] = scanline_gray(r, g, b);
+			}
+		}
+	}
+
+	return 0;
+}
+
+// Added by Soldered Electronics - scanline version of pngle_draw_pixels(); stores pixels into the output row
+// and emits the row when it's complete (non-interlaced images only)
+static int pngle_store_pixels(pngle_t *pngle, size_t scanline_ringbuf_xidx)
+{
+	const uint8_t *rb = pngle->scanline_ringbuf;
+	size_t rb_size = pngle->scanline_ringbuf_size;
+	uint8_t depth = pngle->hdr.depth;
+	uint8_t color_type = pngle->hdr.color_type;
+	int rgb = (pngle->scanline_format == PNGLE_SCANLINE_RGB888);
+	uint32_t x = pngle->drawing_x;
+	uint8_t *out = pngle->scanline_out + x * (rgb ? 3 : 1);
+
+	if (depth < 8) {
+		// one byte holds 8 / depth samples (gray levels or palette indices)
+		uint8_t byte = rb[scanline_ringbuf_xidx];
+		uint8_t mask = (1UL << depth) - 1;
+		const uint8_t *lut = (color_type == 3) ? pngle->palette_lut : pngle->level_lut;
+
+		for (int shift = 8 - depth; shift >= 0 && x < pngle->hdr.width; shift -= depth, x++) {
+			uint8_t s = (byte >> shift) & mask;
+
+			if (color_type == 3 && s >= pngle->n_palettes) return PNGLE_ERROR("Color index is out of range");
+
+			if (!rgb) {
+				*out++ = lut[s];
+			} else if (color_type == 3) {
+				*out++ = lut[s * 3 + 0];
+				*out++ = lut[s * 3 + 1];
+				*out++ = lut[s * 3 + 2];
+			} else {
+				*out++ = lut[s];
+				*out++ = lut[s];
+				*out++ = lut[s];
+			}
+		}
+	} else {
+		// one pixel; only the high byte of 16 bit samples is needed
+		uint8_t v[4];
+		size_t step = depth / 8;
+
+		for (uint_fast8_t c = 0; c < pngle->channels; c++) {
+			v[c] = rb[scanline_ringbuf_xidx];
+			scanline_ringbuf_xidx = (scanline_ringbuf_xidx + step) % rb_size;
+		}
+
+		if (color_type == 3) {
+			if (v[0] >= pngle->n_palettes) return PNGLE_ERROR("Color index is out of range");
+
+			if (rgb) {
+				memcpy(out, pngle->palette_lut + v[0] * 3, 3);
+			} else {
+				*out = pngle->palette_lut[v[0]];
+			}
+		} else if (color_type & 2) {
+			uint8_t r = pngle->level_lut[v[0]];
+			uint8_t g = pngle->level_lut[v[1]];
+			uint8_t b = pngle->level_lut[v[2]];
+
+			if (rgb) {
+				out[0] = r;
+				out[1] = g;
+				out[2] = b;
+			} else {
+				*out = scanline_gray(r, g, b);
+			}
+		} else {
+			uint8_t g = pngle->level_lut[v[0]];
+
+			if (rgb) {
+				out[0] = out[1] = out[2] = g;
+			} else {
+				*out = g;
+			}
+		}
+
+		x++;
+	}
+
+	pngle->drawing_x = x;
+
+	// row is complete, send it
+	if (x >= pngle->hdr.width) {
+		pngle->scanline_callback(pngle, pngle->drawing_y, pngle->hdr.width, pngle->scanline_out);
+	}
+
+	return 0;
+}
+
 static inline int paeth(int a, int b, int c)
 {
 	int p = a + b - c;
@@ -379,7 +539,7 @@ static int set_interlace_pass(pngle_t *pngle, uint_fast8_t pass)
 
 	pngle->scanline_ringbuf_size = scanline_stride + bytes_per_pixel * 2; // 2 rooms for c/x and a
 
-	if (pngle->scanline_ringbuf) free(pngle->scanline_ringbuf);
+	if (pngle->scanline_ringbuf) PNGLE_FREE(pngle->scanline_ringbuf);
 	if ((pngle->scanline_ringbuf = PNGLE_CALLOC(pngle->scanline_ringbuf_size, 1, "scanline ringbuf")) == NULL) return PNGLE_ERROR("Insufficient memory");
 
 	pngle->drawing_x = interlace_off_x[pngle->interlace_pass];
@@ -395,7 +555,7 @@ static int set_interlace_pass(pngle_t *pngle, uint_fast8_t pass)
 static int setup_gamma_table(pngle_t *pngle, uint32_t png_gamma)
 {
 #ifndef PNGLE_NO_GAMMA_CORRECTION
-	if (pngle->gamma_table) free(pngle->gamma_table);
+	if (pngle->gamma_table) PNGLE_FREE(pngle->gamma_table);
 
 	if (pngle->display_gamma <= 0) return 0; // disable gamma correction
 	if (png_gamma == 0) return 0;
@@ -424,6 +584,11 @@ static int pngle_on_data(pngle_t *pngle, const uint8_t *p, int len)
 
 	uint_fast8_t bytes_per_pixel = (pngle->channels * pngle->hdr.depth + 7) / 8; // 1 if depth <= 8
 
+	// Added by Soldered Electronics - use scanline output if it's requested and the image is not interlaced
+	if (pngle->scanline_callback && !pngle->hdr.interlace && !pngle->scanline_out) {
+		if (setup_scanline(pngle) < 0) return -1;
+	}
+
 	while (p < ep) {
 		if (pngle->drawing_x >= pngle->hdr.width) {
 			// New row
@@ -484,7 +649,11 @@ static int pngle_on_data(pngle_t *pngle, const uint8_t *p, int len)
 		if (--pngle->scanline_remain_bytes_to_render == 0) {
 			size_t xidx = (pngle->scanline_ringbuf_cidx + pngle->scanline_ringbuf_size - bytes_per_pixel) % pngle->scanline_ringbuf_size;
 
-			if (pngle_draw_pixels(pngle, xidx) < 0) return -1;
+			if (pngle->scanline_out) {
+				if (pngle_store_pixels(pngle, xidx) < 0) return -1;
+			} else {
+				if (pngle_draw_pixels(pngle, xidx) < 0) return -1;
+			}
 
 			pngle->scanline_remain_bytes_to_render = -1; // reset
 		}
@@ -866,6 +1035,14 @@ void pngle_set_done_callback(pngle_t *pngle, pngle_done_callback_t callback)
 	pngle->done_callback = callback;
 }
 
+// Added by Soldered Electronics.
+void pngle_set_scanline_callback(pngle_t *pngle, pngle_scanline_callback_t callback, pngle_scanline_format_t format)
+{
+	if (!pngle) return ;
+	pngle->scanline_callback = callback;
+	pngle->scanline_format = format;
+}
+
 void pngle_set_user_data(pngle_t *pngle, void *user_data)
 {
 	if (!pngle) return ;
@@ -39,6 +39,13 @@ typedef void (*pngle_init_callback_t)(pngle_t *pngle, uint32_t w, uint32_t h);
 typedef void (*pngle_draw_callback_t)(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4]);
 typedef void (*pngle_done_callback_t)(pngle_t *pngle);
 
+// Added by Soldered Electronics - scanline output (whole row at once, alpha is ignored).
+typedef enum {
+	PNGLE_SCANLINE_GRAY8  = 0, // 1 byte per pixel, BT.709 luma for the color images
+	PNGLE_SCANLINE_RGB888 = 1, // 3 bytes per pixel, R, G, B
+} pngle_scanline_format_t;
+typedef void (*pngle_scanline_callback_t)(pngle_t *pngle, uint32_t y, uint32_t w, const uint8_t *data);
+
 // ----------------
 // Basic interfaces
 // ----------------
@@ -54,6 +61,8 @@ uint32_t pngle_get_height(pngle_t *pngle);
 void pngle_set_init_callback(pngle_t *png, pngle_init_callback_t callback);
 void pngle_set_draw_callback(pngle_t *png, pngle_draw_callback_t callback);
 void pngle_set_done_callback(pngle_t *png, pngle_done_callback_t callback);
+// Added by Soldered Electronics - used instead of draw callback for non-interlaced images (interlaced ones still use draw callback)
+void pngle_set_scanline_callback(pngle_t *png, pngle_scanline_callback_t callback, pngle_scanline_format_t format);
 
 void pngle_set_display_gamma(pngle_t *pngle, double display_gamma); // enables gamma correction by specifying display gamma, typically 2.2. No effect when gAMA chunk is missing
 
@@ -0,0 +1,106 @@
+/**
+ **************************************************
+ *
+ * @file        stm32Cache.cpp
+ * @brief       Main source file for the STM32H7 D-Cache maintenance
+ *              used around the DMA transfers (DMA2D, SPI DMA).
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include header file of this .cpp file
+#include "stm32Cache.h"
+
+/**
+ * @brief   Get the cache line aligned memory area that covers the whole buffer. Returns false if the memory is not
+ *          cached at all, so nothing needs to be done.
+ *
+ * @param   const volatile void *_address
+ *          Start address of the buffer.
+ * @param   uint32_t _len
+ *          Length of the buffer in bytes.
+ * @param   uint32_t **_alignedAddress
+ *          Pointer to the variable for the start address of the first cache line.
+ * @param   int32_t *_alignedLen
+ *          Pointer to the variable for the length of all cache lines in bytes.
+ * @return  bool
+ *          true - Cache maintenance is needed.
+ *          false - Memory is not cached (FMC SDRAM is device memory in the default memory map, D-Cache is
+ *          disabled or buffer is empty).
+ */
+static bool stm32CacheArea(const volatile void *_address, uint32_t _len, uint32_t **_alignedAddress,
+                           int32_t *_alignedLen)
+{
+    uint32_t _start = (uint32_t)_address;
+
+    if ((_len == 0) || ((SCB->CCR & SCB_CCR_DC_Msk) == 0))
+        return false;
+
+    // FMC SDRAM (0xC0000000 - 0xDFFFFFFF).
+    if ((_start >= 0xC0000000) && (_start <= 0xDFFFFFFF))
+        return false;
+
+    // Round the start down and the end up to the cache line.
+    uint32_t _alignedStart = _start & ~(STM32_CACHE_LINE_SIZE - 1);
+    uint32_t _end = (_start + _len + STM32_CACHE_LINE_SIZE - 1) & ~(STM32_CACHE_LINE_SIZE - 1);
+
+    *_alignedAddress = (uint32_t *)_alignedStart;
+    *_alignedLen = (int32_t)(_end - _alignedStart);
+
+    return true;
+}
+
+/**
+ * @brief   Write the cached data of the buffer into the memory (before the DMA reads from it).
+ *
+ * @param   const volatile void *_address
+ *          Start address of the buffer.
+ * @param   uint32_t _len
+ *          Length of the buffer in bytes.
+ */
+void stm32CacheClean(const volatile void *_address, uint32_t _len)
+{
+    uint32_t *_alignedAddress;
+    int32_t _alignedLen;
+    if (stm32CacheArea(_address, _len, &_alignedAddress, &_alignedLen))
+        SCB_CleanDCache_by_Addr(_alignedAddress, _alignedLen);
+}
+
+/**
+ * @brief   Write the cached data of the buffer into the memory and drop the cache lines (before the DMA writes
+ *          into it). Dirty lines can't be evicted over the DMA data later on.
+ *
+ * @param   const volatile void *_address
+ *          Start address of the buffer.
+ * @param   uint32_t _len
+ *          Length of the buffer in bytes.
+ */
+void stm32CacheCleanInvalidate(const volatile void *_address, uint32_t _len)
+{
+    uint32_t *_alignedAddress;
+    int32_t _alignedLen;
+    if (stm32CacheArea(_address, _len, &_alignedAddress, &_alignedLen))
+        SCB_CleanInvalidateDCache_by_Addr(_alignedAddress, _alignedLen);
+}
+
+/**
+ * @brief   Drop the cache lines of the buffer (after the DMA wrote into it), so the CPU reads the new data.
+ *
+ * @param   const volatile void *_address
+ *          Start address of the buffer.
+ * @param   uint32_t _len
+ *          Length of the buffer in bytes.
+ *
+ * @note    Cache lines are dropped as a whole. Buffer must be cleaned with stm32CacheCleanInvalidate() before the
+ *          DMA and CPU must not write to the rest of the first and last cache line while the DMA is running,
+ *          otherwise that data is lost.
+ */
+void stm32CacheInvalidate(const volatile void *_address, uint32_t _len)
+{
+    uint32_t *_alignedAddress;
+    int32_t _alignedLen;
+    if (stm32CacheArea(_address, _len, &_alignedAddress, &_alignedLen))
+        SCB_InvalidateDCache_by_Addr(_alignedAddress, _alignedLen);
+}
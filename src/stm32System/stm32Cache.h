@@ -0,0 +1,33 @@
+/**
+ **************************************************
+ *
+ * @file        stm32Cache.h
+ * @brief       Header file for the STM32H7 D-Cache maintenance used
+ *              around the DMA transfers (DMA2D, SPI DMA). DMA does not
+ *              see the CPU cache, so data must be written to the memory
+ *              before the DMA reads it and old cache lines must be dropped
+ *              after the DMA writes into the memory.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add a header guard to the library.
+#ifndef __STM32CACHE_H__
+#define __STM32CACHE_H__
+
+// Include main header file for the Arduino.
+#include "Arduino.h"
+
+// Include STM32 HAL (for the CMSIS cache functions).
+#include "stm32h7xx_hal.h"
+
+// Size of one D-Cache line in bytes.
+#define STM32_CACHE_LINE_SIZE 32
+
+void stm32CacheClean(const volatile void *_address, uint32_t _len);
+void stm32CacheCleanInvalidate(const volatile void *_address, uint32_t _len);
+void stm32CacheInvalidate(const volatile void *_address, uint32_t _len);
+
+#endif
@@ -0,0 +1,339 @@
+/**
+ **************************************************
+ *
+ * @file        stm32DMA2D.cpp
+ * @brief       Main source file for the STM32 DMA2D (Chrom-ART) accelerator.
+ *              Used for fast rectangle fill, rectangle copy and mask blend
+ *              on the 8 bit per pixel buffers (framebuffers, image
+ *              composition, sprite layers).
+ *              If the transfer can't be done by the DMA2D (unaligned buffers,
+ *              buffers in DTCM etc), software blit functions are used instead.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include header file of this .cpp file
+#include "stm32DMA2D.h"
+
+// Handle for the DMA2D peripheral.
+DMA2D_HandleTypeDef _hdma2d;
+
+// Flag for DMA2D init. status.
+static uint8_t _stm32Dma2dInitialized = 0;
+
+/**
+ * @brief   Check if the memory address can be accessed by the DMA2D. DMA2D is AXI bus master, so
+ *          it can't reach ITCM and DTCM RAM (only CPU and MDMA can do that).
+ *
+ * @param   uint32_t _address
+ *          Memory address that needs to be checked.
+ * @return  bool
+ *          true - DMA2D can access this memory.
+ *          false - DMA2D can't access this memory, use CPU.
+ */
+static bool stm32Dma2dAddressValid(uint32_t _address)
+{
+    // ITCM RAM (64kB at 0x00000000).
+    if (_address < 0x00010000)
+        return false;
+
+    // DTCM RAM (128kB at 0x20000000).
+    if ((_address >= 0x20000000) && (_address < 0x20020000))
+        return false;
+
+    // Everything else is fine (AXI SRAM, SRAM1-4, flash and SDRAM).
+    return true;
+}
+
+/**
+ * @brief   Check if the rectangle can be transferred by using 32 bit words. Since DMA2D does not
+ *          have 8 bit output color format, four 8 bit pixels are packed into one ARGB8888 "pixel",
+ *          which means that start address, width and stride must be multiple of 4.
+ *
+ * @param   uint32_t _address
+ *          Start address of the rectangle.
+ * @param   uint32_t _stride
+ *          Width of the whole buffer in bytes.
+ * @param   uint16_t _w
+ *          Width of the rectangle in pixels (bytes).
+ * @return  bool
+ *          true - Rectangle can be transferred by the DMA2D.
+ *          false - Rectangle must be transferred by the CPU.
+ */
+static bool stm32Dma2dRectValid(uint32_t _address, uint32_t _stride, uint16_t _w)
+{
+    // Check the alignment of the everything.
+    if ((_address & 3) || (_stride & 3) || (_w & 3))
+        return false;
+
+    // Check for the DMA2D register limits (line width and line offset).
+    if (((_w / 4) > STM32_DMA2D_MAX_LINE_PIXELS) || (((_stride - _w) / 4) > STM32_DMA2D_MAX_LINE_PIXELS))
+        return false;
+
+    // Check if the DMA2D can reach this memory at all.
+    return stm32Dma2dAddressValid(_address);
+}
+
+/**
+ * @brief   Check if all mask values in one row are the same (fully opaque or fully transparent row).
+ *
+ * @param   const uint8_t *_mask
+ *          Pointer to the first mask value of the row.
+ * @param   uint16_t _w
+ *          Width of the row in pixels.
+ * @return  int
+ *          255 - Fully opaque row, 0 - fully transparent row, -1 - row needs to be blended.
+ */
+static int stm32Dma2dMaskRow(const uint8_t *_mask, uint16_t _w)
+{
+    // Only fully opaque and fully transparent rows can skip the blending.
+    uint8_t _first = _mask[0];
+    if ((_first != 0) && (_first != 255))
+        return -1;
+
+    for (uint16_t i = 1; i < _w; i++)
+    {
+        if (_mask[i] != _first)
+            return -1;
+    }
+
+    return _first;
+}
+
+/**
+ * @brief   Initializaton of the STM32 DMA2D peripheral. Only enables the clock; transfer mode, color
+ *          modes and offsets are set before each transfer.
+ *
+ */
+void stm32Dma2dInit()
+{
+    // Do not init. it twice.
+    if (_stm32Dma2dInitialized)
+        return;
+
+    // Enable the clock for the DMA2D.
+    __HAL_RCC_DMA2D_CLK_ENABLE();
+
+    // Set the instance.
+    _hdma2d.Instance = DMA2D;
+
+    // Set the flag.
+    _stm32Dma2dInitialized = 1;
+
+    INKPLATE_DEBUG_MGS("STM32 DMA2D Init done");
+}
+
+/**
+ * @brief   Returns the address of the DMA2D instance.
+ *
+ * @return  DMA2D_HandleTypeDef*
+ *          Pointer to the STM32 DMA2D Instance.
+ */
+DMA2D_HandleTypeDef *stm32Dma2dGetInstance()
+{
+    return &_hdma2d;
+}
+
+/**
+ * @brief   Fill the rectangle inside 8 bit per pixel buffer with a single value.
+ *
+ * @param   volatile uint8_t *_dst
+ *          Pointer to the first (top left) pixel of the rectangle.
+ * @param   uint32_t _dstStride
+ *          Width of the whole destination buffer in bytes.
+ * @param   uint16_t _w
+ *          Width of the rectangle in pixels.
+ * @param   uint16_t _h
+ *          Height of the rectangle in pixels.
+ * @param   uint8_t _value
+ *          Value written into every pixel.
+ *
+ * @note    DMA2D is used if the rectangle is 32 bit aligned, otherwise CPU is used. Result is the same.
+ */
+void stm32Dma2dFill(volatile uint8_t *_dst, uint32_t _dstStride, uint16_t _w, uint16_t _h, uint8_t _value)
+{
+    // Nothing to do? Return!
+    if ((_w == 0) || (_h == 0))
+        return;
+
+#ifdef STM32_DMA2D_ENABLED
+    if (_stm32Dma2dInitialized && stm32Dma2dRectValid((uint32_t)_dst, _dstStride, _w))
+    {
+        // Register to memory mode. Output color is ARGB8888, so one DMA2D pixel is four framebuffer pixels.
+        _hdma2d.Init.Mode = DMA2D_R2M;
+        _hdma2d.Init.ColorMode = DMA2D_OUTPUT_ARGB8888;
+        _hdma2d.Init.OutputOffset = (_dstStride - _w) / 4;
+        _hdma2d.Init.AlphaInverted = DMA2D_REGULAR_ALPHA;
+        _hdma2d.Init.RedBlueSwap = DMA2D_RB_REGULAR;
+        _hdma2d.Init.BytesSwap = DMA2D_BYTES_REGULAR;
+        _hdma2d.Init.LineOffsetMode = DMA2D_LOM_PIXELS;
+
+        // Repeat the value in all four bytes.
+        uint32_t _color = _value * 0x01010101UL;
+
+        // Destination must not have dirty cache lines that could be written over the DMA2D data.
+        uint32_t _dstLen = (_dstStride * (_h - 1)) + _w;
+        stm32CacheCleanInvalidate(_dst, _dstLen);
+
+        // Start the transfer and wait for it. CPU must read the new data from the memory, not from the cache.
+        if ((HAL_DMA2D_Init(&_hdma2d) == HAL_OK) &&
+            (HAL_DMA2D_Start(&_hdma2d, _color, (uint32_t)_dst, _w / 4, _h) == HAL_OK) &&
+            (HAL_DMA2D_PollForTransfer(&_hdma2d, STM32_DMA2D_TIMEOUT_MS) == HAL_OK))
+        {
+            stm32CacheInvalidate(_dst, _dstLen);
+            return;
+        }
+
+        INKPLATE_DEBUG_MGS("DMA2D fill failed, using CPU");
+    }
+#endif
+
+    // Use software fallback.
+    blitFill8bpp((uint8_t *)_dst, _dstStride, _w, _h, _value);
+}
+
+/**
+ * @brief   Copy rectangle from one 8 bit per pixel buffer into another one.
+ *
+ * @param   const volatile uint8_t *_src
+ *          Pointer to the first (top left) pixel of the source rectangle.
+ * @param   uint32_t _srcStride
+ *          Width of the whole source buffer in bytes.
+ * @param   volatile uint8_t *_dst
+ *          Pointer to the first (top left) pixel of the destination rectangle.
+ * @param   uint32_t _dstStride
+ *          Width of the whole destination buffer in bytes.
+ * @param   uint16_t _w
+ *          Width of the rectangle in pixels.
+ * @param   uint16_t _h
+ *          Height of the rectangle in pixels.
+ *
+ * @note    DMA2D is used if both rectangles are 32 bit aligned, otherwise CPU is used. Result is the same.
+ *          Source and destination must not overlap.
+ */
+void stm32Dma2dCopy(const volatile uint8_t *_src, uint32_t _srcStride, volatile uint8_t *_dst, uint32_t _dstStride,
+                    uint16_t _w, uint16_t _h)
+{
+    // Nothing to do? Return!
+    if ((_w == 0) || (_h == 0))
+        return;
+
+#ifdef STM32_DMA2D_ENABLED
+    if (_stm32Dma2dInitialized && stm32Dma2dRectValid((uint32_t)_src, _srcStride, _w) &&
+        stm32Dma2dRectValid((uint32_t)_dst, _dstStride, _w))
+    {
+        // Memory to memory mode, no pixel format conversion. Four pixels are moved as one ARGB8888 pixel.
+        _hdma2d.Init.Mode = DMA2D_M2M;
+        _hdma2d.Init.ColorMode = DMA2D_OUTPUT_ARGB8888;
+        _hdma2d.Init.OutputOffset = (_dstStride - _w) / 4;
+        _hdma2d.Init.AlphaInverted = DMA2D_REGULAR_ALPHA;
+        _hdma2d.Init.RedBlueSwap = DMA2D_RB_REGULAR;
+        _hdma2d.Init.BytesSwap = DMA2D_BYTES_REGULAR;
+        _hdma2d.Init.LineOffsetMode = DMA2D_LOM_PIXELS;
+
+        // Foreground layer is the source.
+        _hdma2d.LayerCfg[DMA2D_FOREGROUND_LAYER].InputOffset = (_srcStride - _w) / 4;
+        _hdma2d.LayerCfg[DMA2D_FOREGROUND_LAYER].InputColorMode = DMA2D_INPUT_ARGB8888;
+        _hdma2d.LayerCfg[DMA2D_FOREGROUND_LAYER].AlphaMode = DMA2D_NO_MODIF_ALPHA;
+        _hdma2d.LayerCfg[DMA2D_FOREGROUND_LAYER].InputAlpha = 0xFF;
+        _hdma2d.LayerCfg[DMA2D_FOREGROUND_LAYER].AlphaInverted = DMA2D_REGULAR_ALPHA;
+        _hdma2d.LayerCfg[DMA2D_FOREGROUND_LAYER].RedBlueSwap = DMA2D_RB_REGULAR;
+        _hdma2d.LayerCfg[DMA2D_FOREGROUND_LAYER].ChromaSubSampling = DMA2D_NO_CSS;
+
+        // Source data written by the CPU must be in the memory, destination must not have dirty cache lines that
+        // could be written over the DMA2D data.
+        uint32_t _dstLen = (_dstStride * (_h - 1)) + _w;
+        stm32CacheClean(_src, (_srcStride * (_h - 1)) + _w);
+        stm32CacheCleanInvalidate(_dst, _dstLen);
+
+        // Start the transfer and wait for it. CPU must read the new data from the memory, not from the cache.
+        if ((HAL_DMA2D_Init(&_hdma2d) == HAL_OK) &&
+            (HAL_DMA2D_ConfigLayer(&_hdma2d, DMA2D_FOREGROUND_LAYER) == HAL_OK) &&
+            (HAL_DMA2D_Start(&_hdma2d, (uint32_t)_src, (uint32_t)_dst, _w / 4, _h) == HAL_OK) &&
+            (HAL_DMA2D_PollForTransfer(&_hdma2d, STM32_DMA2D_TIMEOUT_MS) == HAL_OK))
+        {
+            stm32CacheInvalidate(_dst, _dstLen);
+            return;
+        }
+
+        INKPLATE_DEBUG_MGS("DMA2D copy failed, using CPU");
+    }
+#endif
+
+    // Use software fallback.
+    blitCopy8bpp((const uint8_t *)_src, _srcStride, (uint8_t *)_dst, _dstStride, _w, _h);
+}
+
+/**
+ * @brief   Blend the 8 bit per pixel source over the destination using the 8 bit per pixel mask.
+ *          See blitBlendPixel() for the exact formula.
+ *
+ * @param   const volatile uint8_t *_src
+ *          Pointer to the first (top left) pixel of the source (foreground) rectangle.
+ * @param   uint32_t _srcStride
+ *          Width of the whole source buffer in bytes.
+ * @param   const volatile uint8_t *_mask
+ *          Pointer to the first (top left) pixel of the mask rectangle.
+ * @param   uint32_t _maskStride
+ *          Width of the whole mask buffer in bytes.
+ * @param   volatile uint8_t *_dst
+ *          Pointer to the first (top left) pixel of the destination (background) rectangle.
+ * @param   uint32_t _dstStride
+ *          Width of the whole destination buffer in bytes.
+ * @param   uint16_t _w
+ *          Width of the rectangle in pixels.
+ * @param   uint16_t _h
+ *          Height of the rectangle in pixels.
+ *
+ * @note    DMA2D blender only outputs 16, 24 or 32 bit colors with one alpha per output pixel, so it can't
+ *          blend 8 bit pixels with per-pixel mask. Consecutive fully opaque rows are copied by the DMA2D (see
+ *          stm32Dma2dCopy()), fully transparent rows are skipped and all other rows are blended by the CPU.
+ *          Result is the same as with blitBlend8bpp().
+ */
+void stm32Dma2dBlend(const volatile uint8_t *_src, uint32_t _srcStride, const volatile uint8_t *_mask,
+                     uint32_t _maskStride, volatile uint8_t *_dst, uint32_t _dstStride, uint16_t _w, uint16_t _h)
+{
+    // Nothing to do? Return!
+    if ((_w == 0) || (_h == 0))
+        return;
+
+#ifdef STM32_DMA2D_ENABLED
+    if (_stm32Dma2dInitialized)
+    {
+        uint16_t _y = 0;
+        while (_y < _h)
+        {
+            // Find the band of the rows with the same kind of the mask.
+            int _type = stm32Dma2dMaskRow((const uint8_t *)_mask + (_maskStride * _y), _w);
+            uint16_t _n = 1;
+            while (((_y + _n) < _h) && (_type != -1) &&
+                   (stm32Dma2dMaskRow((const uint8_t *)_mask + (_maskStride * (_y + _n)), _w) == _type))
+                _n++;
+
+            if (_type == 255)
+            {
+                // Fully opaque rows, it's just a copy.
+                stm32Dma2dCopy(_src + (_srcStride * _y), _srcStride, _dst + (_dstStride * _y), _dstStride, _w, _n);
+            }
+            else if (_type == -1)
+            {
+                // Mixed row, blend it by using the CPU.
+                blitBlend8bpp((const uint8_t *)_src + (_srcStride * _y), _srcStride,
+                              (const uint8_t *)_mask + (_maskStride * _y), _maskStride,
+                              (uint8_t *)_dst + (_dstStride * _y), _dstStride, _w, 1);
+            }
+
+            // Fully transparent rows are left as they are.
+            _y += _n;
+        }
+
+        return;
+    }
+#endif
+
+    // Use software fallback.
+    blitBlend8bpp((const uint8_t *)_src, _srcStride, (const uint8_t *)_mask, _maskStride, (uint8_t *)_dst, _dstStride,
+                  _w, _h);
+}
@@ -0,0 +1,53 @@
+/**
+ **************************************************
+ *
+ * @file        stm32DMA2D.h
+ * @brief       Header file for the STM32 DMA2D (Chrom-ART) accelerator.
+ *              Used for fast rectangle fill and rectangle copy on the
+ *              8 bit per pixel buffers (framebuffers, image composition).
+ *              If the transfer can't be done by the DMA2D (unaligned buffers,
+ *              buffers in DTCM etc), software blit functions are used instead.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add a header guard to the library.
+#ifndef __STM32DMA2D_H__
+#define __STM32DMA2D_H__
+
+// Include main header file for the Arduino.
+#include "Arduino.h"
+
+// Include STM32 DMA2D HAL functions.
+#include "stm32h7xx_hal.h"
+#include "stm32h7xx_hal_dma2d.h"
+
+// Needed for Debug messages
+#include "../system/defines.h"
+
+// D-Cache maintenance for the buffers used by the DMA2D.
+#include "stm32Cache.h"
+
+// Software implementation of the same functions (used as fallback).
+#include "../system/blitHelpers.h"
+
+// Comment out to disable usage of the DMA2D; everything will be done by the CPU.
+#define STM32_DMA2D_ENABLED
+
+// Timeout for one DMA2D transfer in milliseconds.
+#define STM32_DMA2D_TIMEOUT_MS 100ULL
+
+// Max number of pixels per line DMA2D can handle (14 bit register).
+#define STM32_DMA2D_MAX_LINE_PIXELS 16383ULL
+
+void stm32Dma2dInit();
+DMA2D_HandleTypeDef *stm32Dma2dGetInstance();
+void stm32Dma2dFill(volatile uint8_t *_dst, uint32_t _dstStride, uint16_t _w, uint16_t _h, uint8_t _value);
+void stm32Dma2dCopy(const volatile uint8_t *_src, uint32_t _srcStride, volatile uint8_t *_dst, uint32_t _dstStride,
+                    uint16_t _w, uint16_t _h);
+void stm32Dma2dBlend(const volatile uint8_t *_src, uint32_t _srcStride, const volatile uint8_t *_mask,
+                     uint32_t _maskStride, volatile uint8_t *_dst, uint32_t _dstStride, uint16_t _w, uint16_t _h);
+
+#endif
@@ -0,0 +1,480 @@
+/**
+ **************************************************
+ *
+ * @file        stm32SpiDma.cpp
+ * @brief       Main source file for the DMA transport on the STM32 SPI
+ *              used by the ESP32 AT link. Packets (3 byte command
+ *              header + data) are put into the queue and sent one
+ *              after another from the interrupts, so large packets
+ *              move at full SPI clock while the CPU sleeps or does
+ *              other work. Each packet is copied into one DMA buffer,
+ *              so header and data go out in a single DMA transfer.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include header file of this .cpp file
+#include "stm32SpiDma.h"
+
+// DMA handles for the SPI RX and TX.
+static DMA_HandleTypeDef _hdmaSpiRx;
+static DMA_HandleTypeDef _hdmaSpiTx;
+
+// SPI handle used by the ESP32 (it's owned by the Arduino SPI library).
+static SPI_HandleTypeDef *_spiDmaHandle = NULL;
+
+// Chip select pin of the ESP32.
+static GPIO_TypeDef *_spiDmaCsPort = NULL;
+static uint16_t _spiDmaCsPin = 0;
+
+// Packet queue. Packets are added at the head and sent from the tail.
+static Stm32SpiDmaPacket _spiDmaQueue[STM32_SPI_DMA_QUEUE_SIZE];
+static volatile uint8_t _spiDmaQueueHead = 0;
+static volatile uint8_t _spiDmaQueueTail = 0;
+
+// Flag for the transfer in progress (set until the queue is empty).
+static volatile bool _spiDmaBusy = false;
+
+// Flag for the DMA transfer of the current packet (set from the start of the transfer until it's done).
+static volatile bool _spiDmaActive = false;
+
+// Flag for the SPI or DMA error (cleared on next stm32SpiDmaWait()).
+static volatile bool _spiDmaError = false;
+
+// Flag for DMA init. status.
+static uint8_t _stm32SpiDmaInitialized = 0;
+
+// Current packet (header + data) for the DMA. Packet data can be anywhere (also in DTCM that DMA can't reach), so it
+// is copied here. Aligned to the cache line, so cache maintenance does not touch anything else.
+__attribute__((section(".dma_buffer"), aligned(STM32_CACHE_LINE_SIZE))) static uint8_t
+    _spiDmaBuffer[STM32_SPI_DMA_BUFFER_SIZE];
+
+/**
+ * @brief   Drop all packets from the queue and release the chip select. Must be called with the interrupts
+ *          disabled or from the interrupt.
+ *
+ * @param   bool _error
+ *          true - Queue is dropped because of the error.
+ *          false - Queue is dropped on purpose.
+ */
+static void stm32SpiDmaDropQueue(bool _error)
+{
+    HAL_GPIO_WritePin(_spiDmaCsPort, _spiDmaCsPin, GPIO_PIN_SET);
+    _spiDmaQueueTail = _spiDmaQueueHead;
+    _spiDmaActive = false;
+    _spiDmaBusy = false;
+    if (_error)
+        _spiDmaError = true;
+}
+
+/**
+ * @brief   Starts the DMA transfer of the next packet from the queue (header and data in one transfer). If the queue
+ *          is empty, clears the busy flag. Nothing is sent by the CPU here, so it's short enough for the interrupt.
+ *          Must be called with the interrupts disabled or from the interrupt.
+ *
+ */
+static void stm32SpiDmaStartNext()
+{
+    // Queue is empty?
+    if (_spiDmaQueueTail == _spiDmaQueueHead)
+    {
+        _spiDmaBusy = false;
+        return;
+    }
+
+    Stm32SpiDmaPacket *_packet = &_spiDmaQueue[_spiDmaQueueTail];
+    uint16_t _transferLen = STM32_SPI_DMA_HEADER_SIZE + _packet->len;
+
+    // Copy the packet into the DMA buffer and write it from the D-Cache into the memory.
+    memcpy(_spiDmaBuffer, _packet->header, STM32_SPI_DMA_HEADER_SIZE);
+    memcpy(_spiDmaBuffer + STM32_SPI_DMA_HEADER_SIZE, _packet->data, _packet->len);
+    stm32CacheClean(_spiDmaBuffer, _transferLen);
+
+    // Select the ESP32 and start the DMA.
+    HAL_GPIO_WritePin(_spiDmaCsPort, _spiDmaCsPin, GPIO_PIN_RESET);
+    _spiDmaActive = true;
+
+    HAL_StatusTypeDef _status;
+    if (_packet->receive)
+        _status = HAL_SPI_TransmitReceive_DMA(_spiDmaHandle, _spiDmaBuffer, _spiDmaBuffer, _transferLen);
+    else
+        _status = HAL_SPI_Transmit_DMA(_spiDmaHandle, _spiDmaBuffer, _transferLen);
+
+    if (_status != HAL_OK)
+        stm32SpiDmaDropQueue(true);
+}
+
+/**
+ * @brief   Called from the interrupt when the DMA transfer of the current packet is done.
+ *
+ * @param   bool _error
+ *          true - Transfer failed, rest of the queue is dropped.
+ *          false - Transfer is done.
+ */
+static void stm32SpiDmaPacketDone(bool _error)
+{
+    // Not our transfer? SPI is shared with the microSD card.
+    if (!_spiDmaActive)
+        return;
+
+    if (_error)
+    {
+        stm32SpiDmaDropQueue(true);
+        return;
+    }
+
+    // Release the ESP32.
+    HAL_GPIO_WritePin(_spiDmaCsPort, _spiDmaCsPin, GPIO_PIN_SET);
+    _spiDmaActive = false;
+
+    // Copy the received data (without the header) to the packet. Drop the old cache lines first, DMA wrote the data
+    // directly into the memory.
+    Stm32SpiDmaPacket *_packet = &_spiDmaQueue[_spiDmaQueueTail];
+    if (_packet->receive)
+    {
+        stm32CacheInvalidate(_spiDmaBuffer, STM32_SPI_DMA_HEADER_SIZE + _packet->len);
+        memcpy(_packet->data, _spiDmaBuffer + STM32_SPI_DMA_HEADER_SIZE, _packet->len);
+    }
+
+    // Remove the packet from the queue and start the next one.
+    _spiDmaQueueTail = (_spiDmaQueueTail + 1) % STM32_SPI_DMA_QUEUE_SIZE;
+    stm32SpiDmaStartNext();
+}
+
+#if (USE_HAL_SPI_REGISTER_CALLBACKS == 1)
+/**
+ * @brief   Callback for the end of the DMA transfer, registered only for the ESP32 SPI handle (called by the HAL from
+ *          the interrupt).
+ *
+ * @param   SPI_HandleTypeDef *hspi
+ *          Pointer to the SPI handle that finished the transfer.
+ */
+static void stm32SpiDmaCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    // Callback is registered only for the ESP32 SPI handle.
+    (void)hspi;
+
+    stm32SpiDmaPacketDone(false);
+}
+
+/**
+ * @brief   Callback for the SPI or DMA error, registered only for the ESP32 SPI handle (called by the HAL from the
+ *          interrupt).
+ *
+ * @param   SPI_HandleTypeDef *hspi
+ *          Pointer to the SPI handle with the error.
+ */
+static void stm32SpiDmaErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    // Callback is registered only for the ESP32 SPI handle.
+    (void)hspi;
+
+    stm32SpiDmaPacketDone(true);
+}
+#else
+/**
+ * @brief   Checks if the DMA transfer of the current packet is finished. Without the registered callbacks, the only
+ *          other way is to override global HAL SPI callbacks (that would also take them from every other SPI), so
+ *          the SPI handle state is checked after the HAL interrupt handlers. HAL sets the state back to ready at the
+ *          end of the transfer, both on success and on error.
+ *
+ */
+static void stm32SpiDmaCheckDone()
+{
+    if (_spiDmaActive && (_spiDmaHandle->State == HAL_SPI_STATE_READY))
+        stm32SpiDmaPacketDone(_spiDmaHandle->ErrorCode != HAL_SPI_ERROR_NONE);
+}
+#endif
+
+/**
+ * @brief   Initializaton of the DMA for the ESP32 SPI. SPI itself must be already initialized (by the Arduino SPI
+ *          library), this only links the DMA streams to it and enables the interrupts.
+ *
+ * @param   SPI_HandleTypeDef *_spi
+ *          Pointer to the HAL SPI handle of the ESP32 SPI.
+ * @param   GPIO_TypeDef *_csPort
+ *          GPIO port of the ESP32 chip select pin.
+ * @param   uint16_t _csPin
+ *          GPIO pin of the ESP32 chip select pin (GPIO_PIN_x).
+ * @return  bool
+ *          true - DMA is initialized.
+ *          false - DMA init. failed, CPU must be used.
+ */
+bool stm32SpiDmaInit(SPI_HandleTypeDef *_spi, GPIO_TypeDef *_csPort, uint16_t _csPin)
+{
+    // Do not init. it twice.
+    if (_stm32SpiDmaInitialized)
+        return true;
+
+    // Check the parameters and the DMA buffer (linker script must put .dma_buffer into the memory DMA1 can reach).
+    if ((_spi == NULL) || (_csPort == NULL) || !stm32SpiDmaAddressValid(_spiDmaBuffer))
+        return false;
+
+    // Save the SPI and chip select.
+    _spiDmaHandle = _spi;
+    _spiDmaCsPort = _csPort;
+    _spiDmaCsPin = _csPin;
+
+    // Enable the clock for the DMA1.
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    // Configure the RX stream.
+    _hdmaSpiRx.Instance = STM32_SPI_DMA_RX_STREAM;
+    _hdmaSpiRx.Init.Request = STM32_SPI_DMA_RX_REQUEST;
+    _hdmaSpiRx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    _hdmaSpiRx.Init.PeriphInc = DMA_PINC_DISABLE;
+    _hdmaSpiRx.Init.MemInc = DMA_MINC_ENABLE;
+    _hdmaSpiRx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    _hdmaSpiRx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    _hdmaSpiRx.Init.Mode = DMA_NORMAL;
+    _hdmaSpiRx.Init.Priority = DMA_PRIORITY_HIGH;
+    _hdmaSpiRx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&_hdmaSpiRx) != HAL_OK)
+    {
+        INKPLATE_DEBUG_MGS("STM32 SPI DMA RX Init failed");
+        return false;
+    }
+
+    // Configure the TX stream.
+    _hdmaSpiTx.Instance = STM32_SPI_DMA_TX_STREAM;
+    _hdmaSpiTx.Init.Request = STM32_SPI_DMA_TX_REQUEST;
+    _hdmaSpiTx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    _hdmaSpiTx.Init.PeriphInc = DMA_PINC_DISABLE;
+    _hdmaSpiTx.Init.MemInc = DMA_MINC_ENABLE;
+    _hdmaSpiTx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    _hdmaSpiTx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    _hdmaSpiTx.Init.Mode = DMA_NORMAL;
+    _hdmaSpiTx.Init.Priority = DMA_PRIORITY_HIGH;
+    _hdmaSpiTx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&_hdmaSpiTx) != HAL_OK)
+    {
+        INKPLATE_DEBUG_MGS("STM32 SPI DMA TX Init failed");
+        return false;
+    }
+
+    // Link both streams to the SPI.
+    __HAL_LINKDMA(_spiDmaHandle, hdmarx, _hdmaSpiRx);
+    __HAL_LINKDMA(_spiDmaHandle, hdmatx, _hdmaSpiTx);
+
+#if (USE_HAL_SPI_REGISTER_CALLBACKS == 1)
+    // Callbacks only for this SPI handle.
+    if ((HAL_SPI_RegisterCallback(_spiDmaHandle, HAL_SPI_TX_COMPLETE_CB_ID, stm32SpiDmaCpltCallback) != HAL_OK) ||
+        (HAL_SPI_RegisterCallback(_spiDmaHandle, HAL_SPI_TX_RX_COMPLETE_CB_ID, stm32SpiDmaCpltCallback) != HAL_OK) ||
+        (HAL_SPI_RegisterCallback(_spiDmaHandle, HAL_SPI_ERROR_CB_ID, stm32SpiDmaErrorCallback) != HAL_OK))
+    {
+        INKPLATE_DEBUG_MGS("STM32 SPI DMA callbacks failed");
+        return false;
+    }
+#endif
+
+    // Enable the interrupts. SPI interrupt is also needed, since the end of the transfer is signaled by the SPI.
+    HAL_NVIC_SetPriority(STM32_SPI_DMA_RX_IRQ, STM32_SPI_DMA_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(STM32_SPI_DMA_RX_IRQ);
+    HAL_NVIC_SetPriority(STM32_SPI_DMA_TX_IRQ, STM32_SPI_DMA_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(STM32_SPI_DMA_TX_IRQ);
+    HAL_NVIC_SetPriority(STM32_SPI_DMA_SPI_IRQ, STM32_SPI_DMA_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(STM32_SPI_DMA_SPI_IRQ);
+
+    // Set the flag.
+    _stm32SpiDmaInitialized = 1;
+
+    INKPLATE_DEBUG_MGS("STM32 SPI DMA Init done");
+
+    return true;
+}
+
+/**
+ * @brief   Check if the memory address can be accessed by the DMA1. DMA1 is in the D2 domain, so it can't reach
+ *          ITCM and DTCM RAM (only CPU and MDMA can do that).
+ *
+ * @param   const void *_address
+ *          Memory address that needs to be checked.
+ * @return  bool
+ *          true - DMA can access this memory.
+ *          false - DMA can't access this memory, use CPU.
+ */
+bool stm32SpiDmaAddressValid(const void *_address)
+{
+    uint32_t _addr = (uint32_t)(uintptr_t)_address;
+
+    // ITCM RAM (64kB at 0x00000000).
+    if (_addr < 0x00010000)
+        return false;
+
+    // DTCM RAM (128kB at 0x20000000).
+    if ((_addr >= 0x20000000) && (_addr < 0x20020000))
+        return false;
+
+    // Everything else is fine (AXI SRAM, SRAM1-4 and SDRAM).
+    return true;
+}
+
+/**
+ * @brief   Puts the packet into the queue. If nothing is sent at the moment, transfer starts immediately. If the
+ *          queue is full, it waits for a free place. Data buffer must not be changed until the packet is sent (check
+ *          with stm32SpiDmaBusy() or stm32SpiDmaWait()), it's copied into the DMA buffer only when the packet is next.
+ *
+ * @param   uint8_t _cmd
+ *          Command byte of the packet header.
+ * @param   uint8_t _addr
+ *          Address byte of the packet header.
+ * @param   uint8_t _dummy
+ *          Dummy byte of the packet header.
+ * @param   uint8_t *_data
+ *          Pointer to the packet data (can be NULL if _len is 0).
+ * @param   uint16_t _len
+ *          Length of the packet data in bytes.
+ * @param   bool _receive
+ *          true - Received data is stored into the same buffer (full duplex).
+ *          false - Data is only sent.
+ * @return  bool
+ *          true - Packet is in the queue.
+ *          false - DMA is not used (disabled, not initialized, data is shorter than STM32_SPI_DMA_MIN_LEN or does not
+ *          fit into the DMA buffer), CPU must be used after the queue is sent.
+ */
+bool stm32SpiDmaQueue(uint8_t _cmd, uint8_t _addr, uint8_t _dummy, uint8_t *_data, uint16_t _len, bool _receive)
+{
+#ifdef STM32_SPI_DMA_ENABLED
+    // Check if the DMA can be used at all. Short packets are sent faster by the CPU.
+    if (!_stm32SpiDmaInitialized || (_data == NULL) || (_len < STM32_SPI_DMA_MIN_LEN) ||
+        ((STM32_SPI_DMA_HEADER_SIZE + _len) > STM32_SPI_DMA_BUFFER_SIZE))
+        return false;
+
+    // Wait for the free place in the queue.
+    unsigned long _timer = millis();
+    while (((_spiDmaQueueHead + 1) % STM32_SPI_DMA_QUEUE_SIZE) == _spiDmaQueueTail)
+    {
+        if ((unsigned long)(millis() - _timer) > STM32_SPI_DMA_TIMEOUT_MS)
+        {
+            stm32SpiDmaWait(0);
+            return false;
+        }
+    }
+
+    // Queue is also used from the interrupt.
+    uint32_t _primask = __get_PRIMASK();
+    __disable_irq();
+
+    // Fill the packet.
+    Stm32SpiDmaPacket *_packet = &_spiDmaQueue[_spiDmaQueueHead];
+    _packet->header[0] = _cmd;
+    _packet->header[1] = _addr;
+    _packet->header[2] = _dummy;
+    _packet->data = _data;
+    _packet->len = _len;
+    _packet->receive = _receive;
+    _spiDmaQueueHead = (_spiDmaQueueHead + 1) % STM32_SPI_DMA_QUEUE_SIZE;
+
+    // Start the transfer if the queue was idle.
+    if (!_spiDmaBusy)
+    {
+        _spiDmaBusy = true;
+        stm32SpiDmaStartNext();
+    }
+
+    __set_PRIMASK(_primask);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief   Check if there are packets in the queue that are not sent yet.
+ *
+ * @return  bool
+ *          true - Transfer is in progress.
+ *          false - Queue is empty.
+ */
+bool stm32SpiDmaBusy()
+{
+    return _spiDmaBusy;
+}
+
+/**
+ * @brief   Waits until all packets from the queue are sent. CPU sleeps between interrupts. If the timeout occurs,
+ *          transfer is aborted and the rest of the queue is dropped. Must not be called with the interrupts disabled
+ *          (state of the interrupts is restored, but the DMA interrupts can't run, so it ends with the timeout).
+ *
+ * @param   uint32_t _timeoutMs
+ *          Timeout in milliseconds.
+ * @return  bool
+ *          true - All packets are sent.
+ *          false - Timeout or SPI/DMA error, some packets are not sent.
+ */
+bool stm32SpiDmaWait(uint32_t _timeoutMs)
+{
+    unsigned long _timer = millis();
+
+    while (_spiDmaBusy)
+    {
+        // Timeout? Abort everything.
+        if ((unsigned long)(millis() - _timer) >= _timeoutMs)
+        {
+            uint32_t _primask = __get_PRIMASK();
+            __disable_irq();
+            if (_spiDmaBusy)
+            {
+                HAL_SPI_Abort(_spiDmaHandle);
+                stm32SpiDmaDropQueue(true);
+            }
+            __set_PRIMASK(_primask);
+            break;
+        }
+
+        // Sleep until the next interrupt. Interrupts are disabled while checking the flag, so the
+        // interrupt can't come between the check and WFI (pending interrupt still wakes up the CPU).
+        uint32_t _primask = __get_PRIMASK();
+        __disable_irq();
+        if (_spiDmaBusy)
+            __WFI();
+        __set_PRIMASK(_primask);
+    }
+
+    // Return and clear the error flag.
+    bool _ok = !_spiDmaError;
+    _spiDmaError = false;
+    return _ok;
+}
+
+/**
+ * @brief   Interrupt handler for the SPI RX DMA stream.
+ *
+ */
+extern "C" void DMA1_Stream0_IRQHandler()
+{
+    HAL_DMA_IRQHandler(&_hdmaSpiRx);
+#if (USE_HAL_SPI_REGISTER_CALLBACKS != 1)
+    stm32SpiDmaCheckDone();
+#endif
+}
+
+/**
+ * @brief   Interrupt handler for the SPI TX DMA stream.
+ *
+ */
+extern "C" void DMA1_Stream1_IRQHandler()
+{
+    HAL_DMA_IRQHandler(&_hdmaSpiTx);
+#if (USE_HAL_SPI_REGISTER_CALLBACKS != 1)
+    stm32SpiDmaCheckDone();
+#endif
+}
+
+/**
+ * @brief   Interrupt handler for the ESP32 SPI (end of the transfer and errors).
+ *
+ */
+extern "C" void SPI5_IRQHandler()
+{
+    if (_spiDmaHandle == NULL)
+        return;
+
+    HAL_SPI_IRQHandler(_spiDmaHandle);
+#if (USE_HAL_SPI_REGISTER_CALLBACKS != 1)
+    stm32SpiDmaCheckDone();
+#endif
+}
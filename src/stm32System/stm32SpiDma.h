@@ -0,0 +1,82 @@
+/**
+ **************************************************
+ *
+ * @file        stm32SpiDma.h
+ * @brief       Header file for the DMA transport on the STM32 SPI
+ *              used by the ESP32 AT link. Packets (3 byte command
+ *              header + data) are put into the queue and sent one
+ *              after another from the interrupts, so large packets
+ *              move at full SPI clock while the CPU sleeps or does
+ *              other work. Each packet is copied into one DMA buffer,
+ *              so header and data go out in a single DMA transfer.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add a header guard to the library.
+#ifndef __STM32SPIDMA_H__
+#define __STM32SPIDMA_H__
+
+// Include main header file for the Arduino.
+#include "Arduino.h"
+
+// Include STM32 SPI and DMA HAL functions.
+#include "stm32h7xx_hal.h"
+#include "stm32h7xx_hal_dma.h"
+#include "stm32h7xx_hal_spi.h"
+
+// Include D-Cache maintenance for the DMA buffer.
+#include "stm32Cache.h"
+
+// Needed for Debug messages
+#include "../system/defines.h"
+
+// Comment out to disable usage of the DMA; everything will be sent by the CPU.
+#define STM32_SPI_DMA_ENABLED
+
+// DMA streams, requests and interrupts for the ESP32 SPI (SPI5).
+#define STM32_SPI_DMA_RX_STREAM     DMA1_Stream0
+#define STM32_SPI_DMA_TX_STREAM     DMA1_Stream1
+#define STM32_SPI_DMA_RX_IRQ        DMA1_Stream0_IRQn
+#define STM32_SPI_DMA_TX_IRQ        DMA1_Stream1_IRQn
+#define STM32_SPI_DMA_RX_REQUEST    DMA_REQUEST_SPI5_RX
+#define STM32_SPI_DMA_TX_REQUEST    DMA_REQUEST_SPI5_TX
+#define STM32_SPI_DMA_SPI_IRQ       SPI5_IRQn
+#define STM32_SPI_DMA_IRQ_PRIORITY  5
+
+// Max. number of the packets in the queue.
+#define STM32_SPI_DMA_QUEUE_SIZE 8
+
+// Size of the packet header (command, address, dummy).
+#define STM32_SPI_DMA_HEADER_SIZE 3
+
+// Data shorter than this is sent by the CPU (DMA setup takes longer than the transfer itself).
+#define STM32_SPI_DMA_MIN_LEN 32
+
+// Size of the DMA buffer (packet header + max. 4092 bytes of the ESP32 data, multiple of the cache line).
+#define STM32_SPI_DMA_BUFFER_SIZE 4096
+
+// Timeout for the whole queue and for the packet header in milliseconds.
+#define STM32_SPI_DMA_TIMEOUT_MS 100ULL
+
+// One packet in the queue.
+typedef struct
+{
+    uint8_t header[STM32_SPI_DMA_HEADER_SIZE];
+    uint8_t *data;
+    uint16_t len;
+    bool receive;
+} Stm32SpiDmaPacket;
+
+bool stm32SpiDmaInit(SPI_HandleTypeDef *_spi, GPIO_TypeDef *_csPort, uint16_t _csPin);
+bool stm32SpiDmaAddressValid(const void *_address);
+bool stm32SpiDmaQueue(uint8_t _cmd, uint8_t _addr, uint8_t _dummy, uint8_t *_data, uint16_t _len, bool _receive);
+bool stm32SpiDmaBusy();
+bool stm32SpiDmaWait(uint32_t _timeoutMs = STM32_SPI_DMA_TIMEOUT_MS);
+extern "C" void DMA1_Stream0_IRQHandler();
+extern "C" void DMA1_Stream1_IRQHandler();
+extern "C" void SPI5_IRQHandler();
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ **************************************************
+ *
+ * @file        blitHelpers.cpp
+ * @brief       Source file for the software (CPU) blit functions
+ *              for 8 bit per pixel buffers.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include the header file.
+#include "blitHelpers.h"
+
+/**
+ * @brief   Fill the rectangle inside 8 bit per pixel buffer with a single value.
+ *
+ * @param   uint8_t *_dst
+ *          Pointer to the first (top left) pixel of the rectangle.
+ * @param   uint32_t _dstStride
+ *          Width of the whole destination buffer in bytes.
+ * @param   uint16_t _w
+ *          Width of the rectangle in pixels.
+ * @param   uint16_t _h
+ *          Height of the rectangle in pixels.
+ * @param   uint8_t _value
+ *          Value written into every pixel.
+ */
+void blitFill8bpp(uint8_t *_dst, uint32_t _dstStride, uint16_t _w, uint16_t _h, uint8_t _value)
+{
+    // Go row by row.
+    for (uint16_t _y = 0; _y < _h; _y++)
+    {
+        memset(_dst, _value, _w);
+        _dst += _dstStride;
+    }
+}
+
+/**
+ * @brief   Copy rectangle from one 8 bit per pixel buffer into another one.
+ *
+ * @param   const uint8_t *_src
+ *          Pointer to the first (top left) pixel of the source rectangle.
+ * @param   uint32_t _srcStride
+ *          Width of the whole source buffer in bytes.
+ * @param   uint8_t *_dst
+ *          Pointer to the first (top left) pixel of the destination rectangle.
+ * @param   uint32_t _dstStride
+ *          Width of the whole destination buffer in bytes.
+ * @param   uint16_t _w
+ *          Width of the rectangle in pixels.
+ * @param   uint16_t _h
+ *          Height of the rectangle in pixels.
+ *
+ * @note    Source and destination rectangles must not overlap.
+ */
+void blitCopy8bpp(const uint8_t *_src, uint32_t _srcStride, uint8_t *_dst, uint32_t _dstStride, uint16_t _w,
+                  uint16_t _h)
+{
+    // Copy row by row.
+    for (uint16_t _y = 0; _y < _h; _y++)
+    {
+        memcpy(_dst, _src, _w);
+        _src += _srcStride;
+        _dst += _dstStride;
+    }
+}
+
+/**
+ * @brief   Blend the 8 bit per pixel source over the destination using 8 bit per pixel mask.
+ *          See blitBlendPixel() for the exact formula.
+ *
+ * @param   const uint8_t *_src
+ *          Pointer to the first (top left) pixel of the source (foreground) rectangle.
+ * @param   uint32_t _srcStride
+ *          Width of the whole source buffer in bytes.
+ * @param   const uint8_t *_mask
+ *          Pointer to the first (top left) pixel of the mask rectangle.
+ * @param   uint32_t _maskStride
+ *          Width of the whole mask buffer in bytes.
+ * @param   uint8_t *_dst
+ *          Pointer to the first (top left) pixel of the destination (background) rectangle.
+ *          Result is stored here.
+ * @param   uint32_t _dstStride
+ *          Width of the whole destination buffer in bytes.
+ * @param   uint16_t _w
+ *          Width of the rectangle in pixels.
+ * @param   uint16_t _h
+ *          Height of the rectangle in pixels.
+ */
+void blitBlend8bpp(const uint8_t *_src, uint32_t _srcStride, const uint8_t *_mask, uint32_t _maskStride,
+                   uint8_t *_dst, uint32_t _dstStride, uint16_t _w, uint16_t _h)
+{
+    for (uint16_t _y = 0; _y < _h; _y++)
+    {
+        for (uint16_t _x = 0; _x < _w; _x++)
+        {
+            // Skip math for fully transparent and fully opaque pixels (most common case for sprites).
+            uint8_t _m = _mask[_x];
+            if (_m == 255)
+            {
+                _dst[_x] = _src[_x];
+            }
+            else if (_m != 0)
+            {
+                _dst[_x] = blitBlendPixel(_src[_x], _dst[_x], _m);
+            }
+        }
+
+        // Move to the next row.
+        _src += _srcStride;
+        _mask += _maskStride;
+        _dst += _dstStride;
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ **************************************************
+ *
+ * @file        blitHelpers.h
+ * @brief       Header file for the software (CPU) blit functions
+ *              for 8 bit per pixel buffers. These are used as a
+ *              fallback for the STM32 DMA2D accelerator and produce
+ *              the exact same output as the hardware path. They do not
+ *              depend on the STM32 HAL, so they can be built on any host.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add a header guard.
+#ifndef __INKPLATE_BLIT_HELPERS_H__
+#define __INKPLATE_BLIT_HELPERS_H__
+
+// Include only standard C headers, no Arduino or STM32 HAL here.
+#include <stdint.h>
+#include <string.h>
+
+// Fill the rectangle inside 8 bit per pixel buffer with a single value.
+void blitFill8bpp(uint8_t *_dst, uint32_t _dstStride, uint16_t _w, uint16_t _h, uint8_t _value);
+
+// Copy rectangle from one 8 bit per pixel buffer into another one (both can have different stride).
+void blitCopy8bpp(const uint8_t *_src, uint32_t _srcStride, uint8_t *_dst, uint32_t _dstStride, uint16_t _w,
+                  uint16_t _h);
+
+// Blend the 8 bit per pixel source over the destination using the 8 bit per pixel mask.
+void blitBlend8bpp(const uint8_t *_src, uint32_t _srcStride, const uint8_t *_mask, uint32_t _maskStride,
+                   uint8_t *_dst, uint32_t _dstStride, uint16_t _w, uint16_t _h);
+
+/**
+ * @brief   Blend one pixel. Result is round((src * mask + dst * (255 - mask)) / 255), calculated
+ *          without division. Mask value of 255 means source only, 0 means destination only.
+ *
+ * @param   uint8_t _src
+ *          Source (foreground) pixel value.
+ * @param   uint8_t _dst
+ *          Destination (background) pixel value.
+ * @param   uint8_t _mask
+ *          Mask (alpha) value for the current pixel.
+ * @return  uint8_t
+ *          Blended pixel value.
+ */
+__attribute__((always_inline)) static inline uint8_t blitBlendPixel(uint8_t _src, uint8_t _dst, uint8_t _mask)
+{
+    // Weighted sum with the rounding offset.
+    uint32_t _t = ((uint32_t)_src * _mask) + ((uint32_t)_dst * (255 - _mask)) + 128;
+
+    // Exact division by 255 for the 0 - 65025 range.
+    return (uint8_t)((_t + (_t >> 8)) >> 8);
+}
+
+#endif
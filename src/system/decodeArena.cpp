@@ -0,0 +1,173 @@
+/**
+ **************************************************
+ *
+ * @file        decodeArena.cpp
+ * @brief       Source file for the image decode memory arena. All
+ *              image decoders and the image processing allocate their
+ *              working memory from one fixed memory block which is
+ *              reset at the start of each decode.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include the header file.
+#include "decodeArena.h"
+
+// Standard C library for malloc() and memset().
+#include <stdlib.h>
+#include <string.h>
+
+// Memory for the arena.
+static uint8_t _decodeArenaMemory[DECODE_ARENA_SIZE] __attribute__((aligned(DECODE_ARENA_ALIGN)));
+
+// Offset of the first free byte in the arena.
+static size_t _decodeArenaTop = 0;
+
+// Offset of the last allocation (used to release it if it's freed before anything else is allocated).
+static size_t _decodeArenaLast = 0;
+
+// Usage statistics.
+static size_t _decodeArenaHighWaterMark = 0;
+static uint32_t _decodeArenaHeapFallbacks = 0;
+
+/**
+ * @brief   Check if the memory belongs to the arena.
+ *
+ * @param   void *_ptr
+ *          Pointer to the memory.
+ * @return  bool
+ *          true - Memory is inside the arena.
+ *          false - Memory is on the heap (or somewhere else).
+ */
+static bool decodeArenaContains(void *_ptr)
+{
+    return ((uint8_t *)_ptr >= _decodeArenaMemory) && ((uint8_t *)_ptr < (_decodeArenaMemory + DECODE_ARENA_SIZE));
+}
+
+/**
+ * @brief   Release everything allocated from the arena. All pointers from the arena are not valid after this.
+ *
+ */
+void decodeArenaReset()
+{
+    _decodeArenaTop = 0;
+    _decodeArenaLast = 0;
+}
+
+/**
+ * @brief   Allocate memory from the arena. If there is not enough free memory in the arena, heap is used.
+ *
+ * @param   size_t _size
+ *          Number of bytes that needs to be allocated.
+ * @return  void*
+ *          Pointer to the allocated memory (aligned to DECODE_ARENA_ALIGN), NULL if allocation failed.
+ */
+void *decodeArenaMalloc(size_t _size)
+{
+    // Round up the size to keep the next allocation aligned.
+    size_t _alignedSize = (_size + (DECODE_ARENA_ALIGN - 1)) & ~((size_t)DECODE_ARENA_ALIGN - 1);
+
+    // Does not fit? Use heap.
+    if (_alignedSize > (DECODE_ARENA_SIZE - _decodeArenaTop))
+    {
+        _decodeArenaHeapFallbacks++;
+        return malloc(_size);
+    }
+
+    // Take the memory from the top of the arena.
+    void *_ptr = _decodeArenaMemory + _decodeArenaTop;
+    _decodeArenaLast = _decodeArenaTop;
+    _decodeArenaTop += _alignedSize;
+
+    // Update the statistics.
+    if (_decodeArenaTop > _decodeArenaHighWaterMark)
+        _decodeArenaHighWaterMark = _decodeArenaTop;
+
+    return _ptr;
+}
+
+/**
+ * @brief   Allocate memory from the arena and set it to zero.
+ *
+ * @param   size_t _n
+ *          Number of elements.
+ * @param   size_t _size
+ *          Size of one element in bytes.
+ * @return  void*
+ *          Pointer to the allocated memory, NULL if allocation failed.
+ */
+void *decodeArenaCalloc(size_t _n, size_t _size)
+{
+    // Check for the overflow.
+    if ((_size != 0) && (_n > (SIZE_MAX / _size)))
+        return NULL;
+
+    // Allocate and clear it.
+    void *_ptr = decodeArenaMalloc(_n * _size);
+    if (_ptr != NULL)
+        memset(_ptr, 0, _n * _size);
+
+    return _ptr;
+}
+
+/**
+ * @brief   Release the memory. Heap memory is released immediately. Arena memory is released only if it's the
+ *          last allocation, otherwise it stays used until decodeArenaReset().
+ *
+ * @param   void *_ptr
+ *          Pointer to the memory returned by the decodeArenaMalloc() or decodeArenaCalloc(). Can be NULL.
+ */
+void decodeArenaFree(void *_ptr)
+{
+    // Nothing to release.
+    if (_ptr == NULL)
+        return;
+
+    // Not from the arena? Use heap.
+    if (!decodeArenaContains(_ptr))
+    {
+        free(_ptr);
+        return;
+    }
+
+    // Last allocation can be released right away.
+    if ((uint8_t *)_ptr == (_decodeArenaMemory + _decodeArenaLast))
+    {
+        _decodeArenaTop = _decodeArenaLast;
+    }
+}
+
+/**
+ * @brief   Get the number of bytes currently used in the arena.
+ *
+ * @return  size_t
+ *          Number of used bytes.
+ */
+size_t decodeArenaUsed()
+{
+    return _decodeArenaTop;
+}
+
+/**
+ * @brief   Get the max. number of bytes used in the arena since startup. Useful for tuning the DECODE_ARENA_SIZE.
+ *
+ * @return  size_t
+ *          High-water mark in bytes.
+ */
+size_t decodeArenaHighWaterMark()
+{
+    return _decodeArenaHighWaterMark;
+}
+
+/**
+ * @brief   Get the number of the allocations that did not fit into the arena since startup.
+ *
+ * @return  uint32_t
+ *          Number of the heap allocations. If it's not zero, DECODE_ARENA_SIZE should be increased.
+ */
+uint32_t decodeArenaHeapFallbacks()
+{
+    return _decodeArenaHeapFallbacks;
+}
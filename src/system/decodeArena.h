@@ -0,0 +1,65 @@
+/**
+ **************************************************
+ *
+ * @file        decodeArena.h
+ * @brief       Header file for the image decode memory arena. All
+ *              image decoders and the image processing allocate their
+ *              working memory from one fixed memory block which is
+ *              reset at the start of each decode, so there is no heap
+ *              fragmentation while drawing many images. If arena is
+ *              full, heap is used as fallback. Can be used from C code
+ *              as well (PNG decoder).
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add a header guard.
+#ifndef __INKPLATE_DECODE_ARENA_H__
+#define __INKPLATE_DECODE_ARENA_H__
+
+// Include only standard C headers, no Arduino or STM32 HAL here.
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of the arena in bytes. It's statically allocated in the internal RAM, since decoders (PNG inflate
+// dictionary especially) are too slow in the uncached SDRAM. Check decodeArenaHighWaterMark() before changing it.
+#ifndef DECODE_ARENA_SIZE
+#define DECODE_ARENA_SIZE (128 * 1024ULL)
+#endif
+
+// Every allocation is aligned to 8 bytes.
+#define DECODE_ARENA_ALIGN 8
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Release everything allocated from the arena. Called at the start of each image decode.
+    void decodeArenaReset();
+
+    // Allocate memory from the arena (or from the heap if arena is full).
+    void *decodeArenaMalloc(size_t _size);
+
+    // Allocate memory from the arena and set it to zero.
+    void *decodeArenaCalloc(size_t _n, size_t _size);
+
+    // Release the memory. Arena memory is released only on reset (or if it's the last allocation).
+    void decodeArenaFree(void *_ptr);
+
+    // Number of bytes currently used in the arena.
+    size_t decodeArenaUsed();
+
+    // Max. number of bytes used in the arena since startup.
+    size_t decodeArenaHighWaterMark();
+
+    // Number of the allocations that did not fit into the arena and were done on the heap since startup.
+    uint32_t decodeArenaHeapFallbacks();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -47,8 +47,8 @@
 #define INKPLATE_ROTARY_ENCODER_PERIPH 1
 #define INKPLATE_WS_LED_PERIPH         2
 
-// Typedef structure for the Inkplate Custom Waveform.
-typedef struct InkplateWaveform
+// Structure for the Inkplate Custom Waveform.
+struct InkplateWaveform
 {
     // INKPLATE_WF_1BIT or INKPLATE_WF_4BIT
     uint8_t mode;
@@ -95,13 +95,19 @@ bool inkplateImageDecodeHelpersBmp(BmpDecodeHandle *_bmpDecoder, InkplateImageDe
  * @param   void *_sessionHandler
  *          Session handler - Callback specific struct/typedef to access file, framebuffer, other classes etc from
  *          the callback itself.
+ * @param   bool _grayscale
+ *          true - Decoder outputs only luma (Y) as 8 bit grayscale; chroma IDCT and color conversion are skipped.
+ *          false - Decoder outputs RGB888.
+ * @param   uint8_t (*_scaleFunc)(JDEC *)
+ *          Optional callback called after the JPG header is parsed (image size is known). Returns the TJpgDec
+ *          output scale (0 - 1/1, 1 - 1/2, 2 - 1/4, 3 - 1/8). If NULL, image is not scaled.
  * @return  bool
  *          true - JPG image decoded succ.
  *          false -  JPG image decode failed.
  */
 bool inkplateImageDecodeHelpersJpg(JDEC *_jpgDecoder, size_t (*_inFunc)(JDEC *, uint8_t *, size_t),
                                    int (*_outFunc)(JDEC *, void *, JRECT *), InkplateImageDecodeErrors *_decodeError,
-                                   void *_sessionHandler)
+                                   void *_sessionHandler, bool _grayscale, uint8_t (*_scaleFunc)(JDEC *))
 {
     // Check for the wrong input parameters.
     if ((_jpgDecoder == NULL) || (_decodeError == NULL))
@@ -125,8 +131,8 @@ bool inkplateImageDecodeHelpersJpg(JDEC *_jpgDecoder, size_t (*_inFunc)(JDEC *,
     const size_t _workingBufferSize = 32768; // 32kB
     void *_workingBuffer;
 
-    // Allocate the memory for the buffer.
-    _workingBuffer = (void *)malloc(_workingBufferSize);
+    // Allocate the memory for the buffer from the decode arena.
+    _workingBuffer = decodeArenaMalloc(_workingBufferSize);
     if (_workingBuffer == NULL)
     {
         // Set the error.
@@ -141,14 +147,22 @@ bool inkplateImageDecodeHelpersJpg(JDEC *_jpgDecoder, size_t (*_inFunc)(JDEC *,
     // Check if JPG decoder prepare is ok. If not, return error.
     if (_result == JDR_OK)
     {
+        // Select the output format (jd_prepare clears the decoder, so it must be set here).
+        _jpgDecoder->grayscale = _grayscale ? 1 : 0;
+
+        // Get the output scale (if needed). TJpgDec supports max 1/8.
+        uint8_t _scale = (_scaleFunc != NULL) ? _scaleFunc(_jpgDecoder) : 0;
+        if (_scale > 3)
+            _scale = 3;
+
         // Set output callback and decode the image!
-        _result = jd_decomp(_jpgDecoder, _outFunc, 0);
+        _result = jd_decomp(_jpgDecoder, _outFunc, _scale);
 
         // If failed, free memory and return fail.
         if (_result != JDR_OK)
         {
             // Free allocated memory.
-            free(_workingBuffer);
+            decodeArenaFree(_workingBuffer);
 
             // Set the error.
             (*_decodeError) = INKPLATE_IMAGE_DECODE_ERR_JPG_DECODER_FAULT;
@@ -160,7 +174,7 @@ bool inkplateImageDecodeHelpersJpg(JDEC *_jpgDecoder, size_t (*_inFunc)(JDEC *,
     else
     {
         // Free allocated memory.
-        free(_workingBuffer);
+        decodeArenaFree(_workingBuffer);
         // Set the error.
         (*_decodeError) = INKPLATE_IMAGE_DECODE_ERR_JPG_DECODER_FAULT;
 
@@ -169,7 +183,7 @@ bool inkplateImageDecodeHelpersJpg(JDEC *_jpgDecoder, size_t (*_inFunc)(JDEC *,
     }
 
     // Free up the memory.
-    free(_workingBuffer);
+    decodeArenaFree(_workingBuffer);
 
     // If decode process was ok, return true for success.
     return true;
@@ -194,6 +208,9 @@ bool inkplateImageDecodeHelpersJpg(JDEC *_jpgDecoder, size_t (*_inFunc)(JDEC *,
  * @param   _sessionHandler
  *          Session handler - Callback specific struct/typedef to access file, framebuffer, other classes etc from
  *          the callback itself.
+ * @param   void (*_rowFunc)(pngle_t *pngle, uint32_t y, uint32_t w, const uint8_t *data)
+ *          Optional output callback for the whole decoded row in 8 bit grayscale. If set, it's used instead of
+ *          _outFunc for all non-interlaced images.
  * @return  bool
  *          true - Image decoded succ.
  *          false - Image decode failed.
@@ -202,7 +219,8 @@ bool inkplateImageDecodeHelpersPng(pngle_t *_pngDecoder, bool (*_inFunc)(pngle_t
                                    void (*_outFunc)(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h,
                                                     uint8_t rgba[4]),
                                    int *_imgW, int *_imgH, InkplateImageDecodeErrors *_decodeError,
-                                   void *_sessionHandler)
+                                   void *_sessionHandler,
+                                   void (*_rowFunc)(pngle_t *, uint32_t, uint32_t, const uint8_t *))
 {
     // Check for the wrong input parameters.
     if (_decodeError == NULL)
@@ -232,6 +250,10 @@ bool inkplateImageDecodeHelpersPng(pngle_t *_pngDecoder, bool (*_inFunc)(pngle_t
     // Set the callback for decoder.
     pngle_set_draw_callback(_pngDecoder, _outFunc);
 
+    // Set the row callback if used (interlaced images still use pixel callback).
+    if (_rowFunc != NULL)
+        pngle_set_scanline_callback(_pngDecoder, _rowFunc, PNGLE_SCANLINE_GRAY8);
+
     // Do a callback for the input data feed!
     if (!_inFunc(_pngDecoder))
     {
@@ -305,6 +327,10 @@ enum InkplateImageDecodeFormat inkplateImageDecodeHelpersDetectImageFormat(char
         {
             return INKPLATE_IMAGE_DECODE_FORMAT_PNG;
         }
+        else if (strstr(_extension, ".IPI"))
+        {
+            return INKPLATE_IMAGE_DECODE_FORMAT_NATIVE;
+        }
     }
 
     // First check if the file format signature needs to be skipped.
@@ -323,6 +349,10 @@ enum InkplateImageDecodeFormat inkplateImageDecodeHelpersDetectImageFormat(char
         {
             return INKPLATE_IMAGE_DECODE_FORMAT_PNG;
         }
+        else if (inkplateImageDecodeHelpersCheckHeaders((uint8_t *)_bytes, (uint8_t *)_helpersNativeSignature))
+        {
+            return INKPLATE_IMAGE_DECODE_FORMAT_NATIVE;
+        }
     }
 
     // If this also failed, then this may not be a vaild image format or both of the
@@ -407,4 +437,203 @@ bool inkplateImageDecodeHelpersIsWebPath(char *_path)
 
     // If nothing has been found, return false.
     return false;
-}
\ No newline at end of file
+}
+/**
+ * @brief   Calculates the size of the scaled image for the selected scale mode.
+ *
+ * @param   enum InkplateImageScaleMode _mode
+ *          Scale mode (none, fit, fill or stretch).
+ * @param   int _srcW
+ *          Width of the image.
+ * @param   int _srcH
+ *          Height of the image.
+ * @param   int _areaW
+ *          Width of the area where the image is drawn.
+ * @param   int _areaH
+ *          Height of the area where the image is drawn.
+ * @param   int *_dstW
+ *          Pointer to the variable where the width of the scaled image will be stored.
+ * @param   int *_dstH
+ *          Pointer to the variable where the height of the scaled image will be stored.
+ *
+ * @note    For the fill mode scaled image can be larger than the area, it needs to be cropped.
+ */
+void inkplateImageDecodeHelpersScaledSize(enum InkplateImageScaleMode _mode, int _srcW, int _srcH, int _areaW,
+                                          int _areaH, int *_dstW, int *_dstH)
+{
+    // By default, keep the size of the image.
+    (*_dstW) = _srcW;
+    (*_dstH) = _srcH;
+
+    // Check for the input parameters.
+    if ((_srcW <= 0) || (_srcH <= 0) || (_areaW <= 0) || (_areaH <= 0))
+        return;
+
+    // Compare aspect ratios of the image and the area (without division).
+    int64_t _srcByArea = (int64_t)_srcW * _areaH;
+    int64_t _areaBySrc = (int64_t)_areaW * _srcH;
+
+    switch (_mode)
+    {
+    case INKPLATE_IMAGE_SCALE_FIT: {
+        // Image is wider than the area? Width is limiting, otherwise height is.
+        if (_srcByArea >= _areaBySrc)
+        {
+            (*_dstW) = _areaW;
+            (*_dstH) = (int)(((int64_t)_srcH * _areaW + (_srcW / 2)) / _srcW);
+        }
+        else
+        {
+            (*_dstW) = (int)(((int64_t)_srcW * _areaH + (_srcH / 2)) / _srcH);
+            (*_dstH) = _areaH;
+        }
+        break;
+    }
+    case INKPLATE_IMAGE_SCALE_FILL: {
+        // Opposite of the fit - image must cover the whole area.
+        if (_srcByArea >= _areaBySrc)
+        {
+            (*_dstW) = (int)(((int64_t)_srcW * _areaH + (_srcH / 2)) / _srcH);
+            (*_dstH) = _areaH;
+        }
+        else
+        {
+            (*_dstW) = _areaW;
+            (*_dstH) = (int)(((int64_t)_srcH * _areaW + (_srcW / 2)) / _srcW);
+        }
+        break;
+    }
+    case INKPLATE_IMAGE_SCALE_STRETCH: {
+        (*_dstW) = _areaW;
+        (*_dstH) = _areaH;
+        break;
+    }
+    default: {
+        // No scaling.
+        break;
+    }
+    }
+
+    // Image must be at least one pixel in size.
+    if ((*_dstW) < 1)
+        (*_dstW) = 1;
+    if ((*_dstH) < 1)
+        (*_dstH) = 1;
+}
+
+/**
+ * @brief   Finds the largest JPG decoder (TJpgDec) scale that still keeps the image larger or equal than the
+ *          scaled image size. The rest of the scaling is done by the resampler in the image processing, but
+ *          decoding is much faster.
+ *
+ * @param   int _srcW
+ *          Width of the JPG image.
+ * @param   int _srcH
+ *          Height of the JPG image.
+ * @param   int _dstW
+ *          Width of the scaled image.
+ * @param   int _dstH
+ *          Height of the scaled image.
+ * @return  uint8_t
+ *          TJpgDec scale (0 - 1/1, 1 - 1/2, 2 - 1/4, 3 - 1/8).
+ */
+uint8_t inkplateImageDecodeHelpersJpgScale(int _srcW, int _srcH, int _dstW, int _dstH)
+{
+    uint8_t _scale = 0;
+
+    // Try the next scale as long as the image is not smaller than needed.
+    while ((_scale < 3) && ((_srcW >> (_scale + 1)) >= _dstW) && ((_srcH >> (_scale + 1)) >= _dstH))
+    {
+        _scale++;
+    }
+
+    return _scale;
+}
+
+/**
+ * @brief   Checks if the header of the native Inkplate image (.ipi) is valid and supported.
+ *
+ * @param   InkplateNativeImageHeader *_header
+ *          Pointer to the header read from the start of the file.
+ * @return  bool
+ *          true - Header is valid.
+ *          false - Not a native image, unsupported version or invalid size.
+ */
+bool inkplateImageDecodeHelpersNativeHeader(InkplateNativeImageHeader *_header)
+{
+    // Check for the null pointer.
+    if (_header == NULL)
+        return false;
+
+    // Check the signature and the version.
+    if (!inkplateImageDecodeHelpersCheckHeaders(_header->magic, (uint8_t *)_helpersNativeSignature) ||
+        (_header->version != INKPLATE_NATIVE_IMAGE_VERSION))
+        return false;
+
+    // Only 1, 2 and 4 bits per pixel are supported.
+    if ((_header->bpp != 1) && (_header->bpp != 2) && (_header->bpp != 4))
+        return false;
+
+    // Row must be large enough to hold all pixels and data must be after the header.
+    if ((_header->width == 0) || (_header->height == 0) ||
+        (_header->stride < (((uint32_t)(_header->width) * _header->bpp + 7) / 8)) ||
+        (_header->dataOffset < sizeof(InkplateNativeImageHeader)))
+        return false;
+
+    // Everything seems to be ok.
+    return true;
+}
+
+/**
+ * @brief   Decompresses one PackBits compressed row of the native Inkplate image. Control byte n from 0 to 127
+ *          is followed by n + 1 literal bytes, n from 129 to 255 is followed by one byte repeated 257 - n times.
+ *          Runs never cross the row boundary.
+ *
+ * @param   const uint8_t *_src
+ *          Pointer to the compressed row.
+ * @param   size_t _srcSize
+ *          Size of the compressed row in bytes.
+ * @param   uint8_t *_dst
+ *          Pointer to the buffer for the decompressed row (at least _stride bytes).
+ * @param   uint16_t _stride
+ *          Size of the decompressed row in bytes.
+ * @return  int
+ *          Number of compressed bytes used, or -1 if the compressed data is broken.
+ */
+int inkplateImageDecodeHelpersNativeUnpackRow(const uint8_t *_src, size_t _srcSize, uint8_t *_dst, uint16_t _stride)
+{
+    size_t _in = 0;
+    uint16_t _out = 0;
+
+    // Decompress until the whole row is filled.
+    while (_out < _stride)
+    {
+        // Compressed data ended too early.
+        if (_in >= _srcSize)
+            return -1;
+
+        uint8_t _control = _src[_in++];
+        if (_control < 128)
+        {
+            // Literal run.
+            uint16_t _n = _control + 1;
+            if (((_in + _n) > _srcSize) || ((_out + _n) > _stride))
+                return -1;
+            memcpy(_dst + _out, _src + _in, _n);
+            _in += _n;
+            _out += _n;
+        }
+        else if (_control > 128)
+        {
+            // Repeated byte.
+            uint16_t _n = 257 - _control;
+            if ((_in >= _srcSize) || ((_out + _n) > _stride))
+                return -1;
+            memset(_dst + _out, _src[_in++], _n);
+            _out += _n;
+        }
+        // 128 is no-op.
+    }
+
+    return _in;
+}
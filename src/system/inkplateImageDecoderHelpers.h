@@ -23,6 +23,9 @@
 #include "../libs/bmpDecode/bmpDecode.h"
 #include "../libs/pngle/pngle.h"
 
+// Memory arena for the decoders.
+#include "decodeArena.h"
+
 // Used by the image decoder for detecting different image formats.
 enum InkplateImageDecodeFormat
 {
@@ -31,6 +34,7 @@ enum InkplateImageDecodeFormat
     INKPLATE_IMAGE_DECODE_FORMAT_BMP,
     INKPLATE_IMAGE_DECODE_FORMAT_JPG,
     INKPLATE_IMAGE_DECODE_FORMAT_PNG,
+    INKPLATE_IMAGE_DECODE_FORMAT_NATIVE,
 };
 
 // Used for selecting (manual override) of the paths of the image.
@@ -41,6 +45,15 @@ enum InkplateImagePathType
     INKPLATE_IMAGE_DECODE_PATH_SD,
 };
 
+// Used for selecting how the image is scaled to the screen (or to the area from X, Y to the screen edge).
+enum InkplateImageScaleMode
+{
+    INKPLATE_IMAGE_SCALE_NONE = 0, // No scaling, image is cropped by the screen.
+    INKPLATE_IMAGE_SCALE_FIT,      // Whole image is visible, aspect ratio is kept.
+    INKPLATE_IMAGE_SCALE_FILL,     // Whole area is covered, aspect ratio is kept (image is cropped at the center).
+    INKPLATE_IMAGE_SCALE_STRETCH,  // Image is stretched to the area, aspect ratio is not kept.
+};
+
 // List of possible errors while decoding the image. Can be added if needed.
 // NOTE: do not add error from each decoder here since the have their own methods.
 enum InkplateImageDecodeErrors
@@ -54,23 +67,57 @@ enum InkplateImageDecodeErrors
     INKPLATE_IMAGE_DECODE_ERR_JPG_DECODER_FAULT,
     INKPLATE_IMAGE_DECODE_ERR_PNG_DECODER_FAULT,
     INKPLATE_IMAGE_DECODE_ERR_BMP_HARD_FAULT,
+    INKPLATE_IMAGE_DECODE_ERR_NATIVE_FAULT,
+    INKPLATE_IMAGE_DECODE_ERR_DOWNLOAD_FAIL,
 };
 
+// Version of the native Inkplate image format (.ipi) supported by this library.
+#define INKPLATE_NATIVE_IMAGE_VERSION 1
+
+// Native image flags.
+#define INKPLATE_NATIVE_IMAGE_FLAG_RLE 0x01 // Each row is PackBits compressed and starts with 16 bit compressed size.
+
+// Header of the native Inkplate image. Image data is already dithered and packed in the same way as in the
+// framebuffer, so it can be copied into the framebuffer without any processing:
+// 1 bit - MSB first, 1 = black.
+// 2 bit - first pixel in the lowest bits, 0 = black, 3 = white (expanded to 4 bit while loading).
+// 4 bit - first pixel in the lower nibble, 0 = black, 15 = white.
+// All multi-byte values are little endian.
+typedef struct __attribute__((packed))
+{
+    uint8_t magic[4];    // "IPIM".
+    uint8_t version;     // INKPLATE_NATIVE_IMAGE_VERSION.
+    uint8_t bpp;         // Bits per pixel (1, 2 or 4).
+    uint8_t flags;       // INKPLATE_NATIVE_IMAGE_FLAG_xxx.
+    uint8_t reserved;    // Must be zero.
+    uint16_t width;      // Image width in pixels.
+    uint16_t height;     // Image height in pixels.
+    uint16_t stride;     // Bytes per (uncompressed) row.
+    uint16_t dataOffset; // Offset of the first row from the start of the file.
+} InkplateNativeImageHeader;
+
 // First element = number of bytes in format signature. It's a hack, I know...
 static const uint8_t _helpersBmpSignature[3] = {2, 0x42, 0x4D};
 static const uint8_t _helpersJpgSignature[4] = {3, 0xFF, 0xD8, 0xFF};
 static const uint8_t _helpersPngSignature[9] = {8, 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A};
+static const uint8_t _helpersNativeSignature[5] = {4, 'I', 'P', 'I', 'M'};
 
 bool inkplateImageDecodeHelpersBmp(BmpDecodeHandle *_bmpDecoder, InkplateImageDecodeErrors *_decodeError);
 bool inkplateImageDecodeHelpersJpg(JDEC *_jpgDecoder, size_t (*_inFunc)(JDEC *, uint8_t *, size_t),
                                    int (*_outFunc)(JDEC *, void *, JRECT *), InkplateImageDecodeErrors *_decodeError,
-                                   void *_sessionHandler);
+                                   void *_sessionHandler, bool _grayscale = true, uint8_t (*_scaleFunc)(JDEC *) = NULL);
 bool inkplateImageDecodeHelpersPng(pngle_t *_pngDecoder, bool (*_inFunc)(pngle_t *_pngle),
                                    void (*_outFunc)(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h,
                                                     uint8_t rgba[4]),
                                    int *_imgW, int *_imgH, InkplateImageDecodeErrors *_decodeError,
-                                   void *_sessionHandler);
+                                   void *_sessionHandler,
+                                   void (*_rowFunc)(pngle_t *, uint32_t, uint32_t, const uint8_t *) = NULL);
 enum InkplateImageDecodeFormat inkplateImageDecodeHelpersDetectImageFormat(char *_filename, void *_bytes);
 bool inkplateImageDecodeHelpersCheckHeaders(void *_dataPtr, void *_headerSignature);
 bool inkplateImageDecodeHelpersIsWebPath(char *_path);
+void inkplateImageDecodeHelpersScaledSize(enum InkplateImageScaleMode _mode, int _srcW, int _srcH, int _areaW,
+                                          int _areaH, int *_dstW, int *_dstH);
+uint8_t inkplateImageDecodeHelpersJpgScale(int _srcW, int _srcH, int _dstW, int _dstH);
+bool inkplateImageDecodeHelpersNativeHeader(InkplateNativeImageHeader *_header);
+int inkplateImageDecodeHelpersNativeUnpackRow(const uint8_t *_src, size_t _srcSize, uint8_t *_dst, uint16_t _stride);
 #endif
\ No newline at end of file
@@ -0,0 +1,813 @@
+/**
+ **************************************************
+ *
+ * @file        jsonStreamParser.cpp
+ * @brief       Source file for the streaming (SAX style) JSON parser.
+ *              Values are matched with the path filters while the
+ *              document is received and sent to the callbacks.
+ *              It does not use any Arduino or STM32 code (WiFi data
+ *              sources are in jsonStreamParserWiFi.cpp).
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include the header file.
+#include "jsonStreamParser.h"
+
+// Include standard C library for sprintf().
+#include <stdio.h>
+
+/**
+ * @brief   Construct a new JsonStreamParser object.
+ *
+ */
+JsonStreamParser::JsonStreamParser()
+{
+    clearFilters();
+    begin();
+}
+
+/**
+ * @brief   Reset the parser for the new document. Filters are kept.
+ *
+ */
+void JsonStreamParser::begin()
+{
+    _state = STATE_VALUE;
+    _depth = 0;
+    _arrays = 0;
+    _pathLen = 0;
+    _path[0] = '\0';
+    _valueLen = 0;
+    _value[0] = '\0';
+    _highSurrogate = 0;
+}
+
+/**
+ * @brief   Add the path filter. Every value with the matching path is sent to the callback.
+ *
+ * @param   const char *_filter
+ *          Path of the value, for example "daily[0].temp.max". Use "[*]" for any array element and "*" for any
+ *          key, for example "daily[*].temp.max" or "current.*". Top-level array elements start with "[".
+ *          String is not copied, it must be valid while the parser is used.
+ * @param   JsonStreamCallback _callback
+ *          Function called for each matching value.
+ * @return  bool
+ *          true - Filter is added.
+ *          false - No more space for the filters (see JSON_STREAM_MAX_FILTERS) or wrong parameter.
+ */
+bool JsonStreamParser::addFilter(const char *_filter, JsonStreamCallback _callback)
+{
+    // Check for user mistake (null-pointer!) and for the free space.
+    if ((_filter == NULL) || (_callback == NULL) || (_filterCount >= JSON_STREAM_MAX_FILTERS))
+        return false;
+
+    _filters[_filterCount] = _filter;
+    _callbacks[_filterCount] = _callback;
+    _filterCount++;
+
+    return true;
+}
+
+/**
+ * @brief   Remove all path filters.
+ *
+ */
+void JsonStreamParser::clearFilters()
+{
+    _filterCount = 0;
+}
+
+/**
+ * @brief   Parse the next part of the document. Part can end anywhere (in the middle of the string or number).
+ *
+ * @param   const char *_data
+ *          Pointer to the data.
+ * @param   size_t _len
+ *          Length of the data in bytes.
+ * @return  bool
+ *          true - Data is parsed.
+ *          false - Document is not valid JSON (parser stays in the error state until begin()).
+ */
+bool JsonStreamParser::feed(const char *_data, size_t _len)
+{
+    // Check for user mistake (null-pointer!).
+    if (_data == NULL)
+        return false;
+
+    for (size_t i = 0; i < _len; i++)
+    {
+        if (!parseByte(_data[i]))
+        {
+            _state = STATE_ERROR;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief   End of the document (call it after the last feed()). Top-level number or literal (for example "42") can
+ *          end only here, since more digits could come with the next feed().
+ *
+ * @return  bool
+ *          true - Whole document is parsed.
+ *          false - Document is not valid or not complete (parser is in the error state until begin()).
+ */
+bool JsonStreamParser::finish()
+{
+    bool _ok = true;
+
+    // Top-level number or literal ends with the document.
+    if ((_depth == 0) && (_state == STATE_NUMBER))
+        _ok = numberEnd();
+    else if ((_depth == 0) && (_state == STATE_LITERAL))
+        _ok = literalEnd();
+
+    if (_ok && ((_state == STATE_NUMBER) || (_state == STATE_LITERAL)))
+        valueEnd();
+
+    // Anything else than the complete document is an error.
+    if (!_ok || (_state != STATE_DONE))
+        _state = STATE_ERROR;
+
+    return done();
+}
+
+/**
+ * @brief   Check if the whole document is parsed.
+ *
+ * @return  bool
+ *          true - Top-level value is complete (top-level number or literal is complete after finish()).
+ *          false - Document is not complete.
+ */
+bool JsonStreamParser::done()
+{
+    return (_state == STATE_DONE);
+}
+
+/**
+ * @brief   Check if the document is not valid JSON.
+ *
+ * @return  bool
+ *          true - Parse error.
+ *          false - No errors so far.
+ */
+bool JsonStreamParser::error()
+{
+    return (_state == STATE_ERROR);
+}
+
+/**
+ * @brief   Index of the element in the innermost array (for example, 2 for the "daily[2].temp.max"). Use it inside
+ *          the callback.
+ *
+ * @return  int
+ *          Index of the array element, -1 if the value is not inside an array.
+ */
+int JsonStreamParser::index()
+{
+    for (int i = _depth - 1; i >= 0; i--)
+    {
+        if (_arrays & (1UL << i))
+            return _index[i];
+    }
+
+    return -1;
+}
+
+/**
+ * @brief   Parse one byte of the document.
+ *
+ * @param   char _c
+ *          Byte of the document.
+ * @return  bool
+ *          true - Byte is parsed.
+ *          false - Syntax error.
+ */
+bool JsonStreamParser::parseByte(char _c)
+{
+    // Whitespace is allowed between all tokens.
+    bool _space = (_c == ' ') || (_c == '\t') || (_c == '\r') || (_c == '\n');
+
+    switch (_state)
+    {
+    case STATE_VALUE:
+        return _space || valueStart(_c);
+
+    case STATE_VALUE_OR_END:
+        if (_space)
+            return true;
+        if (_c == ']')
+            return containerEnd(true);
+        return valueStart(_c);
+
+    case STATE_KEY_OR_END:
+    case STATE_KEY:
+        if (_space)
+            return true;
+        if ((_c == '}') && (_state == STATE_KEY_OR_END))
+            return containerEnd(false);
+        if (_c != '"')
+            return false;
+
+        // Key is written directly into the path (after the path of the object).
+        _pathLen = _pathBase[_depth - 1];
+        if (_pathLen != 0)
+            pathPut('.');
+        _isKey = true;
+        _state = STATE_STRING;
+        return true;
+
+    case STATE_COLON:
+        if (_space)
+            return true;
+        if (_c != ':')
+            return false;
+        _state = STATE_VALUE;
+        return true;
+
+    case STATE_AFTER_VALUE:
+        return _space || afterValue(_c);
+
+    case STATE_STRING:
+    case STATE_ESCAPE:
+    case STATE_UNICODE:
+        return stringByte(_c);
+
+    case STATE_NUMBER:
+        if (((_c >= '0') && (_c <= '9')) || (_c == '-') || (_c == '+') || (_c == '.') || (_c == 'e') || (_c == 'E'))
+            return numberByte(_c);
+
+        // Number ends with the first other char (it belongs to the next token).
+        if (!numberEnd())
+            return false;
+        valueEnd();
+        return parseByte(_c);
+
+    case STATE_LITERAL:
+        if ((_c >= 'a') && (_c <= 'z'))
+        {
+            charPut(_c);
+            return true;
+        }
+
+        // Literal ends with the first other char (it belongs to the next token).
+        if (!literalEnd())
+            return false;
+        valueEnd();
+        return parseByte(_c);
+
+    case STATE_DONE:
+        return _space;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief   Start of the new value.
+ *
+ * @param   char _c
+ *          First char of the value.
+ * @return  bool
+ *          true - Value is started.
+ *          false - Not a valid value.
+ */
+bool JsonStreamParser::valueStart(char _c)
+{
+    // New value starts from the empty string.
+    _valueLen = 0;
+    _isKey = false;
+
+    switch (_c)
+    {
+    case '{':
+        return containerStart(false);
+
+    case '[':
+        return containerStart(true);
+
+    case '"':
+        _state = STATE_STRING;
+        return true;
+
+    case 't':
+    case 'f':
+    case 'n':
+        charPut(_c);
+        _state = STATE_LITERAL;
+        return true;
+
+    default:
+        if ((_c == '-') || ((_c >= '0') && (_c <= '9')))
+        {
+            // First part of the number (leading zero must not be followed by other digits).
+            charPut(_c);
+            _numberState = (_c == '-') ? NUMBER_SIGN : ((_c == '0') ? NUMBER_ZERO : NUMBER_INT);
+            _state = STATE_NUMBER;
+            return true;
+        }
+        return false;
+    }
+}
+
+/**
+ * @brief   Parse the char after the value (comma or end of the object or array).
+ *
+ * @param   char _c
+ *          Char after the value (not a whitespace).
+ * @return  bool
+ *          true - Char is parsed.
+ *          false - Syntax error.
+ */
+bool JsonStreamParser::afterValue(char _c)
+{
+    // Nothing can follow the top-level value.
+    if (_depth == 0)
+        return false;
+
+    bool _inArray = (_arrays & (1UL << (_depth - 1))) != 0;
+
+    if (_c == ',')
+    {
+        // Next array element or the next key.
+        if (_inArray)
+        {
+            _index[_depth - 1]++;
+            setArrayPath();
+            _state = STATE_VALUE;
+        }
+        else
+        {
+            _state = STATE_KEY;
+        }
+        return true;
+    }
+
+    if (_c == '}')
+        return containerEnd(false);
+
+    if (_c == ']')
+        return containerEnd(true);
+
+    return false;
+}
+
+/**
+ * @brief   End of the string, number or literal. Top-level value ends the document.
+ *
+ */
+void JsonStreamParser::valueEnd()
+{
+    _state = (_depth == 0) ? STATE_DONE : STATE_AFTER_VALUE;
+}
+
+/**
+ * @brief   Parse one char of the number (-?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?).
+ *
+ * @param   char _c
+ *          Digit, sign, dot or exponent.
+ * @return  bool
+ *          true - Char is parsed.
+ *          false - Not a valid number (for example "01", "1.e5" or "1e+-5").
+ */
+bool JsonStreamParser::numberByte(char _c)
+{
+    if ((_c >= '0') && (_c <= '9'))
+    {
+        switch (_numberState)
+        {
+        case NUMBER_SIGN:
+            _numberState = (_c == '0') ? NUMBER_ZERO : NUMBER_INT;
+            break;
+        case NUMBER_ZERO:
+            return false;
+        case NUMBER_INT:
+            break;
+        case NUMBER_DOT:
+        case NUMBER_FRACTION:
+            _numberState = NUMBER_FRACTION;
+            break;
+        default:
+            _numberState = NUMBER_EXP_DIGIT;
+            break;
+        }
+    }
+    else if (_c == '.')
+    {
+        // Dot only after the integer part.
+        if ((_numberState != NUMBER_ZERO) && (_numberState != NUMBER_INT))
+            return false;
+        _numberState = NUMBER_DOT;
+    }
+    else if ((_c == 'e') || (_c == 'E'))
+    {
+        // Exponent only after the integer part or the fraction.
+        if ((_numberState != NUMBER_ZERO) && (_numberState != NUMBER_INT) && (_numberState != NUMBER_FRACTION))
+            return false;
+        _numberState = NUMBER_EXP;
+    }
+    else
+    {
+        // Sign (of the exponent) only right after the 'e'.
+        if (_numberState != NUMBER_EXP)
+            return false;
+        _numberState = NUMBER_EXP_SIGN;
+    }
+
+    charPut(_c);
+    return true;
+}
+
+/**
+ * @brief   Check the end of the number and send it to the filters.
+ *
+ * @return  bool
+ *          true - Valid number.
+ *          false - Number is not complete (for example "-", "1." or "1e").
+ */
+bool JsonStreamParser::numberEnd()
+{
+    if ((_numberState != NUMBER_ZERO) && (_numberState != NUMBER_INT) && (_numberState != NUMBER_FRACTION) &&
+        (_numberState != NUMBER_EXP_DIGIT))
+        return false;
+
+    _value[_valueLen] = '\0';
+    emit(JSON_STREAM_TYPE_NUMBER);
+
+    return true;
+}
+
+/**
+ * @brief   Start of the object or array.
+ *
+ * @param   bool _isArray
+ *          true - Array.
+ *          false - Object.
+ * @return  bool
+ *          true - Container is started.
+ *          false - Nesting is too deep (see JSON_STREAM_MAX_DEPTH).
+ */
+bool JsonStreamParser::containerStart(bool _isArray)
+{
+    if (_depth >= JSON_STREAM_MAX_DEPTH)
+        return false;
+
+    // Save the path of the container, values inside it are added after it.
+    _pathBase[_depth] = _pathLen;
+    if (_isArray)
+        _arrays |= (1UL << _depth);
+    else
+        _arrays &= ~(1UL << _depth);
+    _depth++;
+
+    if (_isArray)
+    {
+        // First array element.
+        _index[_depth - 1] = 0;
+        setArrayPath();
+        _state = STATE_VALUE_OR_END;
+    }
+    else
+    {
+        _state = STATE_KEY_OR_END;
+    }
+
+    return true;
+}
+
+/**
+ * @brief   End of the object or array.
+ *
+ * @param   bool _isArray
+ *          true - Array end (']').
+ *          false - Object end ('}').
+ * @return  bool
+ *          true - Container is closed.
+ *          false - Container type does not match.
+ */
+bool JsonStreamParser::containerEnd(bool _isArray)
+{
+    if ((_depth == 0) || (((_arrays & (1UL << (_depth - 1))) != 0) != _isArray))
+        return false;
+
+    // Go back to the path of the container and let the filters know it's done.
+    _depth--;
+    _pathLen = _pathBase[_depth];
+    _valueLen = 0;
+    _value[0] = '\0';
+    emit(_isArray ? JSON_STREAM_TYPE_ARRAY_END : JSON_STREAM_TYPE_OBJECT_END);
+
+    _state = (_depth == 0) ? STATE_DONE : STATE_AFTER_VALUE;
+
+    return true;
+}
+
+/**
+ * @brief   Parse one char of the string or the key (with the escape sequences).
+ *
+ * @param   char _c
+ *          Char of the string.
+ * @return  bool
+ *          true - Char is parsed.
+ *          false - Not a valid string.
+ */
+bool JsonStreamParser::stringByte(char _c)
+{
+    if (_state == STATE_ESCAPE)
+    {
+        // Escaped char.
+        const char *_escapes = "\"\"\\\\//b\bf\fn\nr\rt\t";
+        for (int i = 0; _escapes[i] != '\0'; i += 2)
+        {
+            if (_escapes[i] == _c)
+            {
+                surrogateEnd();
+                charPut(_escapes[i + 1]);
+                _state = STATE_STRING;
+                return true;
+            }
+        }
+
+        // Unicode escape (\uXXXX).
+        if (_c != 'u')
+            return false;
+        _hexDigits = 0;
+        _codePoint = 0;
+        _state = STATE_UNICODE;
+        return true;
+    }
+
+    if (_state == STATE_UNICODE)
+    {
+        int _hex = hexValue(_c);
+        if (_hex < 0)
+            return false;
+        _codePoint = (_codePoint << 4) | _hex;
+        if (++_hexDigits < 4)
+            return true;
+
+        // Characters outside of the BMP are sent as two surrogates, join them. Surrogate without its pair is
+        // replaced with U+FFFD.
+        if ((_codePoint >= 0xD800) && (_codePoint <= 0xDBFF))
+        {
+            surrogateEnd();
+            _highSurrogate = _codePoint;
+        }
+        else if ((_codePoint >= 0xDC00) && (_codePoint <= 0xDFFF) && (_highSurrogate != 0))
+        {
+            stringPut(0x10000 + ((uint32_t)(_highSurrogate - 0xD800) << 10) + (_codePoint - 0xDC00));
+            _highSurrogate = 0;
+        }
+        else if ((_codePoint >= 0xDC00) && (_codePoint <= 0xDFFF))
+        {
+            stringPut(JSON_STREAM_REPLACEMENT_CHAR);
+        }
+        else
+        {
+            surrogateEnd();
+            stringPut(_codePoint);
+        }
+        _state = STATE_STRING;
+        return true;
+    }
+
+    // High surrogate must be followed by the low surrogate escape (string end or any other char ends it).
+    if (_c != '\\')
+        surrogateEnd();
+
+    // End of the string.
+    if (_c == '"')
+    {
+        if (_isKey)
+        {
+            _state = STATE_COLON;
+        }
+        else
+        {
+            _value[_valueLen] = '\0';
+            emit(JSON_STREAM_TYPE_STRING);
+            valueEnd();
+        }
+        return true;
+    }
+
+    // Start of the escape sequence.
+    if (_c == '\\')
+    {
+        _state = STATE_ESCAPE;
+        return true;
+    }
+
+    // Control chars must be escaped.
+    if ((uint8_t)_c < 0x20)
+        return false;
+
+    charPut(_c);
+    return true;
+}
+
+/**
+ * @brief   Add the unicode char to the string or the key (as UTF-8).
+ *
+ * @param   uint32_t _codePoint
+ *          Unicode code point.
+ */
+void JsonStreamParser::stringPut(uint32_t _codePoint)
+{
+    if (_codePoint < 0x80)
+    {
+        charPut(_codePoint);
+    }
+    else if (_codePoint < 0x800)
+    {
+        charPut(0xC0 | (_codePoint >> 6));
+        charPut(0x80 | (_codePoint & 0x3F));
+    }
+    else if (_codePoint < 0x10000)
+    {
+        charPut(0xE0 | (_codePoint >> 12));
+        charPut(0x80 | ((_codePoint >> 6) & 0x3F));
+        charPut(0x80 | (_codePoint & 0x3F));
+    }
+    else
+    {
+        charPut(0xF0 | (_codePoint >> 18));
+        charPut(0x80 | ((_codePoint >> 12) & 0x3F));
+        charPut(0x80 | ((_codePoint >> 6) & 0x3F));
+        charPut(0x80 | (_codePoint & 0x3F));
+    }
+}
+
+/**
+ * @brief   High surrogate was not followed by the low surrogate, replace it with U+FFFD.
+ *
+ */
+void JsonStreamParser::surrogateEnd()
+{
+    if (_highSurrogate != 0)
+        stringPut(JSON_STREAM_REPLACEMENT_CHAR);
+    _highSurrogate = 0;
+}
+
+/**
+ * @brief   Add one char to the key (path) or to the value. Long values are cut.
+ *
+ * @param   char _c
+ *          Char to add.
+ */
+void JsonStreamParser::charPut(char _c)
+{
+    if (_isKey)
+    {
+        pathPut(_c);
+        return;
+    }
+
+    if (_valueLen < (JSON_STREAM_VALUE_SIZE - 1))
+        _value[_valueLen++] = _c;
+}
+
+/**
+ * @brief   Add one char to the path. Length is counted even if the path does not fit into the buffer.
+ *
+ * @param   char _c
+ *          Char to add.
+ */
+void JsonStreamParser::pathPut(char _c)
+{
+    if (_pathLen < (JSON_STREAM_PATH_SIZE - 1))
+        _path[_pathLen] = _c;
+
+    if (_pathLen < UINT16_MAX)
+        _pathLen++;
+}
+
+/**
+ * @brief   Check the literal (true, false or null) and send it to the filters.
+ *
+ * @return  bool
+ *          true - Valid literal.
+ *          false - Unknown literal.
+ */
+bool JsonStreamParser::literalEnd()
+{
+    _value[_valueLen] = '\0';
+
+    if ((strcmp(_value, "true") == 0) || (strcmp(_value, "false") == 0))
+        emit(JSON_STREAM_TYPE_BOOL);
+    else if (strcmp(_value, "null") == 0)
+        emit(JSON_STREAM_TYPE_NULL);
+    else
+        return false;
+
+    return true;
+}
+
+/**
+ * @brief   Set the path for the current array element (for example "daily[2]").
+ *
+ */
+void JsonStreamParser::setArrayPath()
+{
+    char _number[8];
+
+    _pathLen = _pathBase[_depth - 1];
+    pathPut('[');
+    sprintf(_number, "%u", _index[_depth - 1]);
+    for (char *_n = _number; *_n != '\0'; _n++)
+        pathPut(*_n);
+    pathPut(']');
+}
+
+/**
+ * @brief   Send the value to the callbacks of all matching filters.
+ *
+ * @param   uint8_t _type
+ *          Type of the value (JSON_STREAM_TYPE_xxx).
+ */
+void JsonStreamParser::emit(uint8_t _type)
+{
+    // Path that does not fit into the buffer can't be matched.
+    if (_pathLen >= JSON_STREAM_PATH_SIZE)
+        return;
+    _path[_pathLen] = '\0';
+
+    for (int i = 0; i < _filterCount; i++)
+    {
+        if (pathMatch(_filters[i], _path))
+            _callbacks[i](_path, _value, _type);
+    }
+}
+
+/**
+ * @brief   Check if the path matches the filter. "[*]" in the filter matches any array index, "*" matches any key.
+ *
+ * @param   const char *_filter
+ *          Filter.
+ * @param   const char *_path
+ *          Path of the value.
+ * @return  bool
+ *          true - Path matches the filter.
+ *          false - Path does not match the filter.
+ */
+bool JsonStreamParser::pathMatch(const char *_filter, const char *_path)
+{
+    while (*_filter != '\0')
+    {
+        if ((_filter[0] == '[') && (_filter[1] == '*') && (_filter[2] == ']'))
+        {
+            // Any array index.
+            if (*_path != '[')
+                return false;
+            while ((*_path != '\0') && (*_path != ']'))
+                _path++;
+            if (*_path != ']')
+                return false;
+            _path++;
+            _filter += 3;
+        }
+        else if (*_filter == '*')
+        {
+            // Any key (up to the next key or array index).
+            if (*_path == '\0')
+                return false;
+            while ((*_path != '\0') && (*_path != '.') && (*_path != '['))
+                _path++;
+            _filter++;
+        }
+        else
+        {
+            if (*_filter != *_path)
+                return false;
+            _filter++;
+            _path++;
+        }
+    }
+
+    return (*_path == '\0');
+}
+
+/**
+ * @brief   Convert the hex digit into the number.
+ *
+ * @param   char _c
+ *          Hex digit.
+ * @return  int
+ *          Value of the digit, -1 if it's not a hex digit.
+ */
+int JsonStreamParser::hexValue(char _c)
+{
+    if ((_c >= '0') && (_c <= '9'))
+        return _c - '0';
+    if ((_c >= 'a') && (_c <= 'f'))
+        return _c - 'a' + 10;
+    if ((_c >= 'A') && (_c <= 'F'))
+        return _c - 'A' + 10;
+    return -1;
+}
@@ -0,0 +1,154 @@
+/**
+ **************************************************
+ *
+ * @file        jsonStreamParser.h
+ * @brief       Header file for the streaming (SAX style) JSON parser.
+ *              JSON is parsed byte by byte as it's received (from
+ *              WiFiClient or WiFiHTTPSession), so the document never
+ *              needs to be in the memory. Values are selected with
+ *              the path filters (for example "daily[*].temp.max")
+ *              and sent to the callback. It does not allocate any
+ *              memory, whole parser uses a few hundred bytes.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add headerguard do prevent multiple include.
+#ifndef __JSON_STREAM_PARSER_H__
+#define __JSON_STREAM_PARSER_H__
+
+// Include standard C libraries.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Max. length of the path of the current value (with null-terminating char). Longer paths are not matched.
+#define JSON_STREAM_PATH_SIZE 128
+
+// Max. length of the value (with null-terminating char). Longer strings are cut.
+#define JSON_STREAM_VALUE_SIZE 64
+
+// Max. nesting depth of the objects and arrays (max. 32).
+#define JSON_STREAM_MAX_DEPTH 32
+
+// Max. number of the path filters.
+#define JSON_STREAM_MAX_FILTERS 8
+
+// Size of the buffer used to read the data from the WiFi clients (on the stack).
+#define JSON_STREAM_READ_SIZE 64
+
+// Unicode replacement char, used for the surrogate escape without its pair.
+#define JSON_STREAM_REPLACEMENT_CHAR 0xFFFD
+
+// Value types sent to the callback. Object and array end are sent with empty value (useful for the filter like
+// "daily[*]" to know when all values of one array element are received).
+#define JSON_STREAM_TYPE_NULL       0
+#define JSON_STREAM_TYPE_BOOL       1
+#define JSON_STREAM_TYPE_NUMBER     2
+#define JSON_STREAM_TYPE_STRING     3
+#define JSON_STREAM_TYPE_OBJECT_END 4
+#define JSON_STREAM_TYPE_ARRAY_END  5
+
+// Callback for the value that matches the filter. Path and value are valid only inside the callback.
+typedef void (*JsonStreamCallback)(const char *_path, const char *_value, uint8_t _type);
+
+// Forward declarations of the WiFi classes (data source).
+class WiFiClient;
+class WiFiHTTPSession;
+
+class JsonStreamParser
+{
+  public:
+    JsonStreamParser();
+    void begin();
+    bool addFilter(const char *_filter, JsonStreamCallback _callback);
+    void clearFilters();
+    bool feed(const char *_data, size_t _len);
+    bool parse(WiFiClient *_client);
+    bool parse(WiFiHTTPSession *_session);
+    bool finish();
+    bool done();
+    bool error();
+    int index();
+
+  private:
+    bool parseByte(char _c);
+    bool valueStart(char _c);
+    bool afterValue(char _c);
+    void valueEnd();
+    bool numberByte(char _c);
+    bool numberEnd();
+    bool containerStart(bool _isArray);
+    bool containerEnd(bool _isArray);
+    bool stringByte(char _c);
+    void stringPut(uint32_t _codePoint);
+    void surrogateEnd();
+    void charPut(char _c);
+    void pathPut(char _c);
+    bool literalEnd();
+    void setArrayPath();
+    void emit(uint8_t _type);
+    static bool pathMatch(const char *_filter, const char *_path);
+    static int hexValue(char _c);
+
+    // Parser states.
+    enum
+    {
+        STATE_VALUE,
+        STATE_VALUE_OR_END,
+        STATE_KEY,
+        STATE_KEY_OR_END,
+        STATE_COLON,
+        STATE_AFTER_VALUE,
+        STATE_STRING,
+        STATE_ESCAPE,
+        STATE_UNICODE,
+        STATE_NUMBER,
+        STATE_LITERAL,
+        STATE_DONE,
+        STATE_ERROR
+    } _state = STATE_VALUE;
+
+    // Number states (what was the last part of the number), used to check the number grammar.
+    enum
+    {
+        NUMBER_SIGN,
+        NUMBER_ZERO,
+        NUMBER_INT,
+        NUMBER_DOT,
+        NUMBER_FRACTION,
+        NUMBER_EXP,
+        NUMBER_EXP_SIGN,
+        NUMBER_EXP_DIGIT
+    } _numberState = NUMBER_INT;
+
+    // Path filters and their callbacks.
+    const char *_filters[JSON_STREAM_MAX_FILTERS];
+    JsonStreamCallback _callbacks[JSON_STREAM_MAX_FILTERS];
+    uint8_t _filterCount = 0;
+
+    // Path of the current value (for example "daily[2].temp.max") and the path length of each container. Length is
+    // counted even if the path does not fit into the buffer (such path is not matched).
+    char _path[JSON_STREAM_PATH_SIZE];
+    uint16_t _pathLen = 0;
+    uint16_t _pathBase[JSON_STREAM_MAX_DEPTH];
+
+    // Container stack (bit set for the array) and the index of the current element in each array.
+    uint32_t _arrays = 0;
+    uint16_t _index[JSON_STREAM_MAX_DEPTH];
+    uint8_t _depth = 0;
+
+    // Current value (string, number or literal).
+    char _value[JSON_STREAM_VALUE_SIZE];
+    uint8_t _valueLen = 0;
+
+    // String is a key (written into the path) or a value. Unicode escape and the high surrogate.
+    bool _isKey = false;
+    uint8_t _hexDigits = 0;
+    uint32_t _codePoint = 0;
+    uint16_t _highSurrogate = 0;
+};
+
+#endif
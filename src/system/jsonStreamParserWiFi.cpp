@@ -0,0 +1,87 @@
+/**
+ **************************************************
+ *
+ * @file        jsonStreamParserWiFi.cpp
+ * @brief       Source file for the WiFi data sources of the streaming
+ *              JSON parser (WiFiClient and WiFiHTTPSession). Kept apart
+ *              from jsonStreamParser.cpp, so the parser itself can be
+ *              built without the WiFi library.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include the header file.
+#include "jsonStreamParser.h"
+
+// Include WiFi library (for the WiFiClient and WiFiHTTPSession as the data source).
+#include "wifi/esp32SpiAt.h"
+#include "wifi/esp32SpiAtHttpSession.h"
+
+/**
+ * @brief   Parse the response of the WiFiClient (call it after WiFiClient::GET() or WiFiClient::POST()). Data is
+ *          parsed as it's received. It stops at the end of the document, without waiting for the timeout.
+ *
+ * @param   WiFiClient *_client
+ *          Pointer to the WiFiClient object.
+ * @return  bool
+ *          true - Whole document is parsed.
+ *          false - Document is not valid or not complete.
+ */
+bool JsonStreamParser::parse(WiFiClient *_client)
+{
+    // Small buffer for the data.
+    char _buffer[JSON_STREAM_READ_SIZE];
+
+    // Check for user mistake (null-pointer!).
+    if (_client == NULL)
+        return false;
+
+    while (!done() && !error() && (_client->available() > 0))
+    {
+        uint16_t _len = _client->read(_buffer, sizeof(_buffer));
+        feed(_buffer, _len);
+    }
+
+    // Broken response (gzip) can't be parsed.
+    if (_client->error())
+    {
+        _state = STATE_ERROR;
+        return false;
+    }
+
+    // No more data, it's the end of the document.
+    return finish();
+}
+
+/**
+ * @brief   Parse the response body of the WiFiHTTPSession (call it after WiFiHTTPSession::GET() or
+ *          WiFiHTTPSession::POST()). Data is parsed as it's received. It stops at the end of the document.
+ *
+ * @param   WiFiHTTPSession *_session
+ *          Pointer to the WiFiHTTPSession object.
+ * @return  bool
+ *          true - Whole document is parsed.
+ *          false - Document is not valid or not complete.
+ */
+bool JsonStreamParser::parse(WiFiHTTPSession *_session)
+{
+    // Small buffer for the data.
+    char _buffer[JSON_STREAM_READ_SIZE];
+
+    // Check for user mistake (null-pointer!).
+    if (_session == NULL)
+        return false;
+
+    while (!done() && !error())
+    {
+        int _len = _session->read((uint8_t *)_buffer, sizeof(_buffer));
+        if (_len <= 0)
+            break;
+        feed(_buffer, _len);
+    }
+
+    // End of the body is the end of the document.
+    return finish();
+}
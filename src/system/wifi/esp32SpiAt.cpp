@@ -13,6 +13,9 @@
 // Include header file.
 #include "esp32SpiAt.h"
 
+// Include RTC library for the backup SRAM (cached AP data for the fast reconnect).
+#include "../../stm32System/STM32H7RTC.h"
+
 // Flag for the handshake for the ESP32. Use SPI MODE0, MSBFIRST data transfet with approx. SPI clock rate of 20MHz.
 static volatile bool _esp32HandshakePinFlag = false;
 
@@ -55,23 +58,7 @@ void WiFiClass::hwSetup(SPIClass *_spiClass)
 bool WiFiClass::init(bool _resetSettings)
 {
     // Set the hardware level stuff first.
-    // Initialize Arduino SPI Library.
-    _spi->begin();
-
-    // Set handshake pin.
-    pinMode(INKPLATE_ESP32_HANDSHAKE_PIN, INPUT_PULLUP);
-
-    // Set interrupt on handshake pin.
-    attachInterrupt(digitalPinToInterrupt(INKPLATE_ESP32_HANDSHAKE_PIN), esp32HandshakeISR, RISING);
-
-    // Set SPI CS Pin.
-    pinMode(INKPLATE_ESP32_CS_PIN, OUTPUT);
-
-    // Disable ESP32 SPI for now.
-    digitalWrite(INKPLATE_ESP32_CS_PIN, HIGH);
-
-    // Set ESP32 power switch pin.
-    pinMode(INKPLATE_ESP32_PWR_SWITCH_PIN, OUTPUT);
+    spiInit();
 
     // Try to power on the modem. Return false if failed.
     if (!power(true, _resetSettings))
@@ -178,6 +165,9 @@ bool WiFiClass::sendAtCommand(char *_atCommand, uint16_t _len)
     // Get the data size. Use lenght parameter if array is not a nul-terminated string.
     uint16_t _dataLen = _len != 0 ? _len : strlen(_atCommand);
 
+    // Commands with the data phase end with the ">" prompt (data itself is sent with the length).
+    _atPromptNeeded = (_len == 0) && AtResponseFramer::commandNeedsPrompt(_atCommand);
+
     // First make a request for data send.
     dataSendRequest(_dataLen, 0);
 
@@ -200,8 +190,10 @@ bool WiFiClass::sendAtCommand(char *_atCommand, uint16_t _len)
 
 /**
  * @brief   Methods waits the response from the ESP32. It check if the modem is
- *          requesting the data read from slave. After it received request,
- *          timeout triggers if the new data is not available after timeout value.
+ *          requesting the data read from slave. Every received packet is checked
+ *          for the final result code (OK, ERROR, SEND OK, FAIL, ">"...) and method
+ *          returns as soon as the response is complete. Otherwise, timeout
+ *          triggers if the new data is not available after timeout value.
  *          Timeout time is measured after the last received packet or char.
  *
  * @param   char *_response
@@ -210,10 +202,16 @@ bool WiFiClass::sendAtCommand(char *_atCommand, uint16_t _len)
  *          length of the buffer for the response (in bytes, counting the null-terminating char).
  * @param   unsigned long _timeout
  *          Timeout value from the last received char or packet in milliseconds.
+ * @param   uint16_t *_rxLen
+ *          Pointer to the variable where length of the received data will be stored (optional).
+ * @param   const char *_expectedResponse
+ *          If set, response is complete only if this is received together with the final result code.
+ *          This parameter is optional.
  * @return  bool
- *          true - Response has been received (no error handle for now).
+ *          true - Response has been received (no error handle for now, see getAtResult()).
  */
-bool WiFiClass::getAtResponse(char *_response, uint32_t _bufferLen, unsigned long _timeout, uint16_t *_rxLen)
+bool WiFiClass::getAtResponse(char *_response, uint32_t _bufferLen, unsigned long _timeout, uint16_t *_rxLen,
+                              const char *_expectedResponse)
 {
     // Timeout variable.
     unsigned long _timeoutCounter = 0;
@@ -221,11 +219,16 @@ bool WiFiClass::getAtResponse(char *_response, uint32_t _bufferLen, unsigned lon
     // Variable for the response array index offset.
     uint32_t _resposeArrayOffset = 0;
 
+    // Framer checks every new packet for the end of the response.
+    AtResponseFramer _framer;
+    _framer.begin(_response, _expectedResponse, _atPromptNeeded);
+    bool _responseComplete = false;
+
     // Capture the time!
     _timeoutCounter = millis();
 
-    // Now loop until the timeout occurs
-    while ((unsigned long)(millis() - _timeoutCounter) < _timeout)
+    // Now loop until the timeout occurs or until the whole response is received.
+    while (!_responseComplete && ((unsigned long)(millis() - _timeoutCounter) < _timeout))
     {
         // Wait for the response by checking the handshake pin.
         if (_esp32HandshakePinFlag)
@@ -256,10 +259,16 @@ bool WiFiClass::getAtResponse(char *_response, uint32_t _bufferLen, unsigned lon
 
                 // Clear the flag.
                 _esp32HandshakePinFlag = false;
+
+                // Check the new data (only after read done, DMA could still write into the buffer before that).
+                _responseComplete = _framer.feed(_resposeArrayOffset);
             }
         }
     }
 
+    // Save the final result code.
+    _lastAtResult = _framer.result();
+
     // Add null-terminating char.
     _response[_resposeArrayOffset] = '\0';
 
@@ -271,6 +280,18 @@ bool WiFiClass::getAtResponse(char *_response, uint32_t _bufferLen, unsigned lon
     return (_resposeArrayOffset != 0 ? true : false);
 }
 
+/**
+ * @brief   Get the final result code of the last response received with getAtResponse().
+ *
+ * @return  uint8_t
+ *          INKPLATE_ESP32_AT_RESULT_NONE (response ended with the timeout), INKPLATE_ESP32_AT_RESULT_OK,
+ *          INKPLATE_ESP32_AT_RESULT_ERROR or INKPLATE_ESP32_AT_RESULT_PROMPT.
+ */
+uint8_t WiFiClass::getAtResult()
+{
+    return _lastAtResult;
+}
+
 /**
  * @brief   Wait for the reponse form the modem. Method check if the modem is requesting a read from the
  *          master device. It will wait timeout value until for the response.
@@ -374,8 +395,10 @@ bool WiFiClass::sendAtCommandWithResponse(char *_atCommand, unsigned long _timeo
             if (((unsigned long)(millis() - _timeoutCounter) > _timeoutAtCommand))
                 return false;
 
-        // If something is received, read the response.
-        if (!getAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, _rxDataTimeoutAtCommand, &_respLen))
+        // If something is received, read the response. It returns as soon as the final result code (and the
+        // expected response) is received.
+        if (!getAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, _rxDataTimeoutAtCommand, &_respLen,
+                           _expectedResponseAtCmd))
             return false;
 
         // Try to parse if expected response exists.
@@ -424,8 +447,9 @@ bool WiFiClass::sendAtCommandWithResponse(char *_atCommand, unsigned long _timeo
 
                 // Heh, it this is so simple. Sometimes, modem can respond with the command but also with the OK or
                 // ERROR after that command. It's ok if there is no reponse, but it there is response and it's not ok,
-                // something is wrong!
-                if (getSimpleAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, 200ULL, &_respLen))
+                // something is wrong! No need to wait for it if the final result code is already received.
+                if ((_lastAtResult == INKPLATE_ESP32_AT_RESULT_NONE) &&
+                    getSimpleAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, 200ULL, &_respLen))
                 {
                     // Check of OK. If not found, return error.
                     if (strstr(_dataBuffer, "\r\nOK\r\n") == NULL)
@@ -745,6 +769,21 @@ void WiFiClass::flushBeforeCommand(bool _en)
     _flushEspBeforeCmdSend = _en;
 }
 
+/**
+ * @brief   Method enables or disables usage of the DMA for the SPI packets. With DMA, large packets are sent at
+ *          full SPI clock while the CPU sleeps. Short packets (status, request, end of transfer) are always sent by
+ *          the CPU.
+ *
+ * @param   bool _en
+ *          true - Use DMA for the SPI packets (default).
+ *          false - Send all SPI packets by the CPU.
+ */
+void WiFiClass::spiDma(bool _en)
+{
+    // Store the state of the setting internally.
+    _spiDmaEn = _en;
+}
+
 bool WiFiClass::defaultMsgFiltersEn()
 {
     // Enable message filter for the WiFi Connect.
@@ -899,6 +938,167 @@ bool WiFiClass::connected()
     // No response? Return false.
     return false;
 }
+/**
+ * @brief   Powers up the ESP32 and connects to the AP as fast as possible (use it instead of init(), setMode(),
+ *          begin() and connected() after the wake up from the deep sleep). BSSID and IP settings of the last
+ *          connection are cached in the backup SRAM, so the AP is joined by its BSSID and DHCP is skipped (static
+ *          IP settings from the last lease are used). If that fails, cache is cleared and the normal connection
+ *          (with the scan and DHCP) is used and cached for the next time.
+ *
+ * @param   char *_ssid
+ *          Char array/pointer to the AP name name.
+ * @param   char *_pass
+ *          Char array/pointer to the AP password.
+ * @param   STM32H7RTC *_rtc
+ *          Pointer to the RTC object (inkplate.rtc), used for the backup SRAM.
+ * @param   bool _useCachedIp
+ *          true - Use the IP settings from the last DHCP lease (renewed every
+ *          INKPLATE_ESP32_FAST_CONNECT_MAX_USES connections).
+ *          false - Always use DHCP.
+ * @param   unsigned long _timeout
+ *          Timeout for the connection to the AP in milliseconds.
+ * @return  bool
+ *          true - ESP32 is connected to the AP.
+ *          false - Modem init or the connection failed.
+ * @note    Cache uses the last 64 bytes of the backup SRAM (INKPLATE_ESP32_FAST_CONNECT_ADDR). ESP32 AT firmware
+ *          can't join the AP on the given channel, so the channel is only cached for the info, BSSID and fast scan
+ *          are used instead.
+ */
+bool WiFiClass::fastConnect(char *_ssid, char *_pass, STM32H7RTC *_rtc, bool _useCachedIp, unsigned long _timeout)
+{
+    // Check for user mistake (null-pointer!).
+    if ((_ssid == NULL) || (_pass == NULL) || (_rtc == NULL))
+        return false;
+
+    _fastConnectUsed = false;
+
+    // Power up the modem with the shorter setup (no factory reset).
+    spiInit();
+    digitalWrite(INKPLATE_ESP32_PWR_SWITCH_PIN, HIGH);
+    delay(50);
+    if (!isModemReady() || !fastModemSetup())
+        return false;
+
+    // Cached AP data is valid only for the same AP name and password.
+    struct spiAtFastConnectTypedef _cache;
+    _rtc->readFromBackupRAM(INKPLATE_ESP32_FAST_CONNECT_ADDR, &_cache, sizeof(_cache));
+    uint32_t _apHash = fastConnectHash(_pass, strlen(_pass) + 1, fastConnectHash(_ssid, strlen(_ssid) + 1));
+    bool _cacheValid = (_cache.magic == INKPLATE_ESP32_FAST_CONNECT_MAGIC) && (_cache.apHash == _apHash) &&
+                       (_cache.checksum == fastConnectHash(&_cache, offsetof(struct spiAtFastConnectTypedef, checksum)));
+
+    if (_cacheValid)
+    {
+        // Use the IP settings from the last lease (this disables DHCP).
+        bool _staticIp = _useCachedIp && (_cache.ip != 0) && (_cache.uses < INKPLATE_ESP32_FAST_CONNECT_MAX_USES);
+        if (_staticIp)
+        {
+            _staticIp = config(IPAddress(_cache.ip), IPAddress(_cache.gateway), IPAddress(_cache.subnet),
+                               IPAddress(_cache.dns1), IPAddress(_cache.dns2 != 0 ? _cache.dns2 : _cache.dns1));
+        }
+
+        // Join the AP by its BSSID, stop the scan on the first match (pci_en = 0, reconn_interval = 1,
+        // listen_interval = 3, scan_mode = 0).
+        sprintf(_dataBuffer, "AT+CWJAP=\"%s\",\"%s\",\"%02x:%02x:%02x:%02x:%02x:%02x\",0,1,3,0\r\n", _ssid, _pass,
+                _cache.bssid[0], _cache.bssid[1], _cache.bssid[2], _cache.bssid[3], _cache.bssid[4], _cache.bssid[5]);
+        if (joinAp(_timeout))
+        {
+            _fastConnectUsed = true;
+
+            // New lease? Get the new IP settings.
+            if (!_staticIp)
+            {
+                cacheApData(&_cache);
+                _cache.uses = 0;
+            }
+            else
+            {
+                _cache.uses++;
+            }
+
+            _cache.checksum = fastConnectHash(&_cache, offsetof(struct spiAtFastConnectTypedef, checksum));
+            _rtc->writeToBackupRAM(INKPLATE_ESP32_FAST_CONNECT_ADDR, &_cache, sizeof(_cache));
+
+            return true;
+        }
+
+        // AP is changed (or the IP is not valid anymore). Forget everything and use DHCP again.
+        clearFastConnect(_rtc);
+        if (_staticIp)
+            sendAtCommandWithResponse((char *)"AT+CWDHCP=1,1\r\n", 200ULL, 4ULL, (char *)esp32AtCmdResponseOK,
+                                      INKPLATE_ESP32_AT_EXPECTED_RESPONSE_START, true, NULL, 0, 0, NULL);
+    }
+
+    // Normal connection with the scan and DHCP.
+    sprintf(_dataBuffer, "AT+CWJAP=\"%s\",\"%s\"\r\n", _ssid, _pass);
+    if (!joinAp(_timeout))
+        return false;
+
+    // Cache the AP and the IP settings for the next time.
+    memset(&_cache, 0, sizeof(_cache));
+    if (cacheApData(&_cache))
+    {
+        _cache.magic = INKPLATE_ESP32_FAST_CONNECT_MAGIC;
+        _cache.apHash = _apHash;
+        _cache.checksum = fastConnectHash(&_cache, offsetof(struct spiAtFastConnectTypedef, checksum));
+        _rtc->writeToBackupRAM(INKPLATE_ESP32_FAST_CONNECT_ADDR, &_cache, sizeof(_cache));
+    }
+
+    return true;
+}
+
+/**
+ * @brief   Clears the cached AP data, so the next fastConnect() will use the normal connection.
+ *
+ * @param   STM32H7RTC *_rtc
+ *          Pointer to the RTC object (inkplate.rtc), used for the backup SRAM.
+ */
+void WiFiClass::clearFastConnect(STM32H7RTC *_rtc)
+{
+    struct spiAtFastConnectTypedef _cache;
+    memset(&_cache, 0, sizeof(_cache));
+    _rtc->writeToBackupRAM(INKPLATE_ESP32_FAST_CONNECT_ADDR, &_cache, sizeof(_cache));
+}
+
+/**
+ * @brief   Check if the last fastConnect() used the cached AP data.
+ *
+ * @return  bool
+ *          true - ESP32 is connected with the cached AP data.
+ *          false - Normal connection is used (or the connection failed).
+ */
+bool WiFiClass::fastConnectUsed()
+{
+    return _fastConnectUsed;
+}
+
+/**
+ * @brief   Process the non-blocking operations (WiFiOperation). It starts the queued operations and reads only the
+ *          data that ESP32 already has, so it does not block. It should be called from the loop() as often as
+ *          possible while operations are in progress.
+ *
+ * @return  bool
+ *          true - Some operation is still in progress.
+ *          false - There are no operations.
+ * @note    Do not use other (blocking) WiFi methods while operations are in progress, they share the data buffer
+ *          and ESP32 responses with the operations.
+ */
+bool WiFiClass::poll()
+{
+    return WiFiOperation::pollQueue();
+}
+
+/**
+ * @brief   Check if any non-blocking operation is queued or running.
+ *
+ * @return  bool
+ *          true - Operation is in progress.
+ *          false - There are no operations.
+ */
+bool WiFiClass::busy()
+{
+    return WiFiOperation::pending();
+}
+
 /**
  * @brief   Method executes command to the ESP32 to disconnects from the AP.
  *
@@ -1360,9 +1560,16 @@ uint8_t WiFiClass::requestSlaveStatus(uint16_t *_len)
  *          Pointer to the spiAtCommandTypedef to describe data packet.
  * @param   uint16_t _spiDataLen
  *          length of the data part only, excluding spiAtCommandTypedef (in bytes).
+ * @param   bool _wait
+ *          true - Return after the packet is sent (default).
+ *          false - Packet can be only queued for the DMA, data buffer must not be used until it's sent.
  */
-void WiFiClass::transferSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiDataLen)
+void WiFiClass::transferSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiDataLen, bool _wait)
 {
+    // Try to send it with the DMA first.
+    if (queueSpiPacket(_spiPacket, _spiDataLen, true, _wait))
+        return;
+
     // Get the SPI STM32 HAL Typedef Handle.
     SPI_HandleTypeDef *_spiHandle = _spi->getHandle();
 
@@ -1391,9 +1598,16 @@ void WiFiClass::transferSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spi
  *          Pointer to the spiAtCommandTypedef to describe data packet.
  * @param   uint16_t _spiDataLen
  *          length of the data part only, excluding spiAtCommandTypedef (in bytes).
+ * @param   bool _wait
+ *          true - Return after the packet is sent (default).
+ *          false - Packet can be only queued for the DMA, data buffer must not be used until it's sent.
  */
-void WiFiClass::sendSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiDataLen)
+void WiFiClass::sendSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiDataLen, bool _wait)
 {
+    // Try to send it with the DMA first.
+    if (queueSpiPacket(_spiPacket, _spiDataLen, false, _wait))
+        return;
+
     // Get the SPI STM32 HAL Typedef Handle.
     SPI_HandleTypeDef *_spiHandle = _spi->getHandle();
 
@@ -1415,6 +1629,65 @@ void WiFiClass::sendSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiData
     HAL_GPIO_WritePin(GPIOF, GPIO_PIN_6, GPIO_PIN_SET);
 }
 
+/**
+ * @brief   Puts the SPI packet into the DMA queue. Packets are sent one after another from the interrupts, so the
+ *          next packet can be prepared while the current one is still on the SPI. If the packet can't be sent by the
+ *          DMA, queue is emptied first, so the CPU sends it in the right order.
+ *
+ * @param   spiAtCommandTypedef *_spiPacket
+ *          Pointer to the spiAtCommandTypedef to describe data packet.
+ * @param   uint16_t _spiDataLen
+ *          length of the data part only, excluding spiAtCommandTypedef (in bytes).
+ * @param   bool _receive
+ *          true - Received data is stored into the packet data buffer.
+ *          false - Data is only sent.
+ * @param   bool _wait
+ *          true - Wait until all packets from the queue are sent.
+ *          false - Return right after the packet is queued.
+ * @return  bool
+ *          true - Packet is handled by the DMA.
+ *          false - Packet must be sent by the CPU.
+ */
+bool WiFiClass::queueSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiDataLen, bool _receive, bool _wait)
+{
+    // SPI settings are set once for all queued packets, transaction ends when the queue is sent.
+    if (_spiDmaEn && !_spiDmaTransaction)
+    {
+        _spi->beginTransaction(_esp32AtSpiSettings);
+        _spiDmaTransaction = true;
+    }
+
+    if (!_spiDmaEn || !stm32SpiDmaQueue(_spiPacket->cmd, _spiPacket->addr, _spiPacket->dummy,
+                                        (uint8_t *)_spiPacket->data, _spiDataLen, _receive))
+    {
+        // Queued packets must be sent before this one (CPU uses its own transaction).
+        flushSpiQueue();
+        return false;
+    }
+
+    // Wait for the transfer if needed.
+    if (_wait)
+        flushSpiQueue();
+
+    return true;
+}
+
+/**
+ * @brief   Waits until all SPI packets from the DMA queue are sent and ends the SPI transaction started by
+ *          WiFiClass::queueSpiPacket().
+ *
+ */
+void WiFiClass::flushSpiQueue()
+{
+    stm32SpiDmaWait();
+
+    if (_spiDmaTransaction)
+    {
+        _spi->endTransaction();
+        _spiDmaTransaction = false;
+    }
+}
+
 bool WiFiClass::commandEcho(bool _en)
 {
     // Turn the Echo on or off.
@@ -1444,10 +1717,6 @@ bool WiFiClass::dataSend(char *_dataBuffer, uint32_t _len)
     // 1. Make a request for data send
     // 2. Read and check slave status - It should return with INKPLATE_ESP32_SPI_SLAVE_STATUS_WRITEABLE.
 
-    // Calculate the number of chunks to send, since the max is 4092 bytes.
-    uint16_t _chunks = _len / INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER;
-    uint16_t _lastChunk = _chunks ? _len % INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER : _len;
-
     // Address offset for the data packet.
     uint32_t _dataPacketAddrOffset = 0;
 
@@ -1455,26 +1724,24 @@ bool WiFiClass::dataSend(char *_dataBuffer, uint32_t _len)
     struct spiAtCommandTypedef _spiDataSend = {
         .cmd = INKPLATE_ESP32_SPI_CMD_MASTER_SEND, .addr = 0x00, .dummy = 0x00, .data = (uint8_t *)(_dataBuffer)};
 
-    // Go trough the chunks.
-    while (_chunks--)
+    // Go trough the chunks, since the max is 4092 bytes. Chunks are only queued, dataSendEnd() waits for them.
+    do
     {
         // Calculate the chunk size.
-        uint16_t _chunkSize = _chunks != 0 ? INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER : _lastChunk;
+        uint32_t _remaining = _len - _dataPacketAddrOffset;
+        uint16_t _chunkSize = _remaining > INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER
+                                  ? INKPLATE_ESP32_SPI_MAX_MESAGE_DATA_BUFFER
+                                  : _remaining;
+
+        // Update the SPI ESP32 packer header.
+        _spiDataSend.data = (uint8_t *)(_dataBuffer + _dataPacketAddrOffset);
 
         // Transfer the data!
-        sendSpiPacket(&_spiDataSend, _chunkSize);
+        sendSpiPacket(&_spiDataSend, _chunkSize, false);
 
         // Update the address position.
         _dataPacketAddrOffset += _chunkSize;
-
-        // Update the SPI ESP32 packer header.
-        _spiDataSend.data = (uint8_t *)(_dataBuffer + _chunkSize);
-
-        // Data end cmd? Don't know...Needs to be checked!
-    }
-
-    // Write the last one chunk (or the only one if the _len < 4092).
-    sendSpiPacket(&_spiDataSend, _lastChunk);
+    } while (_dataPacketAddrOffset < _len);
 
     // Return true for success.
     return true;
@@ -1493,6 +1760,7 @@ bool WiFiClass::dataSendEnd()
     struct spiAtCommandTypedef _spiDataSend = {.cmd = INKPLATE_ESP32_SPI_CMD_MASTER_SEND_DONE, .addr = 0, .dummy = 0};
 
     // Transfer the packet! The re is not data field this time, so it's size is zero.
+    // This also waits for the data packets queued by dataSend().
     transferSpiPacket(&_spiDataSend, 0);
 
     // Return true for success.
@@ -1520,7 +1788,8 @@ bool WiFiClass::dataRead(char *_dataBuffer, uint16_t _len)
         .cmd = INKPLATE_ESP32_SPI_CMD_MASTER_READ_DATA, .addr = 0x00, .dummy = 0x00, .data = (uint8_t *)(_dataBuffer)};
 
     // Read the last one chunk (or the only one if the _len < 4092).
-    transferSpiPacket(&_spiDataSend, _len);
+    // Packet is only queued, dataReadEnd() waits for it, so data buffer must not be used before that.
+    transferSpiPacket(&_spiDataSend, _len, false);
 
     // Return true for success.
     return true;
@@ -1540,6 +1809,7 @@ bool WiFiClass::dataReadEnd()
     struct spiAtCommandTypedef _spiDataSend = {.cmd = INKPLATE_ESP32_SPI_CMD_MASTER_READ_DONE, .addr = 0, .dummy = 0};
 
     // Transfer the packet! The re is not data field this time, so it's size is zero.
+    // This also waits for the data packet queued by dataRead().
     transferSpiPacket(&_spiDataSend, 0);
 
     // Return true for success.
@@ -1632,6 +1902,150 @@ bool WiFiClass::flushModemReadReq()
     return _retValue;
 }
 
+/**
+ * @brief   Initializes the hardware used for the ESP32 (SPI, handshake interrupt, CS and power switch pins).
+ *
+ */
+void WiFiClass::spiInit()
+{
+    // Initialize Arduino SPI Library.
+    _spi->begin();
+
+    // Set handshake pin.
+    pinMode(INKPLATE_ESP32_HANDSHAKE_PIN, INPUT_PULLUP);
+
+    // Set interrupt on handshake pin.
+    attachInterrupt(digitalPinToInterrupt(INKPLATE_ESP32_HANDSHAKE_PIN), esp32HandshakeISR, RISING);
+
+    // Set SPI CS Pin.
+    pinMode(INKPLATE_ESP32_CS_PIN, OUTPUT);
+
+    // Disable ESP32 SPI for now.
+    digitalWrite(INKPLATE_ESP32_CS_PIN, HIGH);
+
+    // Link the DMA to the ESP32 SPI. If it fails, packets are sent by the CPU.
+    stm32SpiDmaInit(_spi->getHandle(), GPIOF, GPIO_PIN_6);
+
+    // Set ESP32 power switch pin.
+    pinMode(INKPLATE_ESP32_PWR_SWITCH_PIN, OUTPUT);
+}
+
+/**
+ * @brief   Shorter modem setup used by the fastConnect(). Factory reset, ping and WiFi radio init are skipped
+ *          (radio is initialized after the power up) and one message filter is used for all "WIFI ..." messages
+ *          instead of three.
+ *
+ * @return  bool
+ *          true - Modem is ready.
+ *          false - One of the setup commands failed.
+ */
+bool WiFiClass::fastModemSetup()
+{
+    // Disable echo, storing data in NVM and system messages.
+    if (!commandEcho(false) || !storeSettingsInNVM(false) || !systemMessages(0))
+        return false;
+
+    // Remove "WIFI CONNECTED", "WIFI DISCONNECT" and "WIFI GOT IP" with the one filter.
+    if (!messageFilter(true, "^WIFI [A-Z ]*\r\n", NULL) || !systemMsgFiltering(true))
+        return false;
+
+    // Set the station mode. No need to disconnect first, modem is just powered up.
+    if (!sendAtCommandWithResponse((char *)"AT+CWMODE=1\r\n", 200ULL, 4ULL, (char *)esp32AtCmdResponseOK,
+                                   INKPLATE_ESP32_AT_EXPECTED_RESPONSE_START, true, NULL, 0, 0, NULL))
+        return false;
+
+    return true;
+}
+
+/**
+ * @brief   Sends AT+CWJAP command from the data buffer and waits until the ESP32 is connected (or failed).
+ *
+ * @param   unsigned long _timeout
+ *          Timeout for the connection in milliseconds.
+ * @return  bool
+ *          true - ESP32 is connected to the AP and has the IP address.
+ *          false - Connection failed.
+ */
+bool WiFiClass::joinAp(unsigned long _timeout)
+{
+    if (!sendAtCommand(_dataBuffer))
+        return false;
+
+    // "WIFI CONNECTED" and "WIFI GOT IP" are filtered, so only OK or "+CWJAP:<error>" and FAIL are received.
+    getAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, _timeout);
+
+    return (getAtResult() == INKPLATE_ESP32_AT_RESULT_OK);
+}
+
+/**
+ * @brief   Gets the BSSID, channel and the IP settings of the current connection.
+ *
+ * @param   struct spiAtFastConnectTypedef *_cache
+ *          Pointer to the cached AP data where the connection data will be stored.
+ * @return  bool
+ *          true - Connection data is stored.
+ *          false - Failed to get the connection data.
+ */
+bool WiFiClass::cacheApData(struct spiAtFastConnectTypedef *_cache)
+{
+    // Get the BSSID and the channel. Response is +CWJAP:<ssid>,<bssid>,<channel>,<rssi>...
+    if (!sendAtCommandWithResponse((char *)"AT+CWJAP?\r\n", 200ULL, 4ULL, (char *)"+CWJAP:",
+                                   INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true, NULL, 0, 0, NULL))
+        return false;
+
+    // BSSID starts after the SSID.
+    char *_bssid = strstr(_dataBuffer, "+CWJAP:");
+    _bssid = (_bssid != NULL) ? strstr(_bssid, "\",\"") : NULL;
+    if (_bssid == NULL)
+        return false;
+
+    int _mac[6];
+    int _channel;
+    if (sscanf(_bssid, "\",\"%x:%x:%x:%x:%x:%x\",%d", &_mac[0], &_mac[1], &_mac[2], &_mac[3], &_mac[4], &_mac[5],
+               &_channel) != 7)
+        return false;
+
+    for (int i = 0; i < 6; i++)
+    {
+        _cache->bssid[i] = _mac[i];
+    }
+    _cache->channel = _channel;
+
+    // Get the IP settings from the DHCP.
+    _cache->ip = localIP();
+    _cache->gateway = gatewayIP();
+    _cache->subnet = subnetMask();
+    _cache->dns1 = dns(0);
+    _cache->dns2 = dns(1);
+
+    return true;
+}
+
+/**
+ * @brief   FNV-1a hash, used for the AP name and password and for the checksum of the cached AP data.
+ *
+ * @param   const void *_data
+ *          Pointer to the data.
+ * @param   uint32_t _len
+ *          Length of the data in bytes.
+ * @param   uint32_t _hash
+ *          Start value (hash of the previous data).
+ * @return  uint32_t
+ *          Hash of the data.
+ */
+uint32_t WiFiClass::fastConnectHash(const void *_data, uint32_t _len, uint32_t _hash)
+{
+    const uint8_t *_bytes = (const uint8_t *)_data;
+
+    for (uint32_t i = 0; i < _len; i++)
+    {
+        _hash ^= _bytes[i];
+        _hash *= 16777619UL;
+    }
+
+    return _hash;
+}
+
 /**
  * @brief   Method waits for the ESP32 module to be ready after power up.
  *
@@ -28,6 +28,12 @@
 // Include SPI AT Message typedefs.
 #include "esp32SpiAtTypedefs.h"
 
+// Include AT response framer (detects the end of the response).
+#include "esp32SpiAtFramer.h"
+
+// Include parser for the messages with the payload (+IPD, +HTTPCGET, +MQTTSUBRECV...).
+#include "esp32SpiAtParser.h"
+
 // Include file with all AT Commands.
 #include "esp32SpiAtAllCommands.h"
 
@@ -40,6 +46,15 @@
 // Include MQTT class for ESP32 AT Commands.
 #include "esp32SpiAtMqtt.h"
 
+// Include TCP class for ESP32 AT Commands.
+#include "esp32SpiAtTcp.h"
+
+// Include non-blocking operations (connect, HTTP GET) for ESP32 AT Commands.
+#include "esp32SpiAtAsync.h"
+
+// Include DMA transport for the ESP32 SPI.
+#include "../../stm32System/stm32SpiDma.h"
+
 // Data buffer for AT Commands (in bytes).
 #define INKPLATE_ESP32_AT_CMD_BUFFER_SIZE 8192ULL
 
@@ -56,6 +71,21 @@
 // Maximum networks that can be found.
 #define INKPLATE_ESP32_MAX_SCAN_AP 40
 
+// Address of the cached AP connection data in the backup SRAM (last 64 bytes, see STM32H7RTC::writeToBackupRAM()).
+#define INKPLATE_ESP32_FAST_CONNECT_ADDR 4032
+
+// Magic number of the cached AP connection data ("IWFC").
+#define INKPLATE_ESP32_FAST_CONNECT_MAGIC 0x43465749UL
+
+// Cached IP address is used that many times, after that DHCP is used again to refresh the lease.
+#define INKPLATE_ESP32_FAST_CONNECT_MAX_USES 100
+
+// Default timeout for the connection to the AP in milliseconds.
+#define INKPLATE_ESP32_FAST_CONNECT_TIMEOUT 10000ULL
+
+// Forward declaration of the STM32 RTC class (for the backup SRAM).
+class STM32H7RTC;
+
 // Create class for the AT commands over SPI
 
 class WiFiClass
@@ -68,7 +98,9 @@ class WiFiClass
     bool init(bool _resetSettings = true);
     bool power(bool _en, bool _resetSettings = true);
     bool sendAtCommand(char *_atCommand, uint16_t _len = 0);
-    bool getAtResponse(char *_response, uint32_t _bufferLen, unsigned long _timeout, uint16_t *_rxLen = NULL);
+    bool getAtResponse(char *_response, uint32_t _bufferLen, unsigned long _timeout, uint16_t *_rxLen = NULL,
+                       const char *_expectedResponse = NULL);
+    uint8_t getAtResult();
     bool getSimpleAtResponse(char *_response, uint32_t _bufferLen, unsigned long _timeout, uint16_t *_rxLen = NULL);
     bool sendAtCommandWithResponse(char *_atCommand = NULL, unsigned long _timeoutAtCommand = 0ULL,
                                    unsigned long _rxDataTimeoutAtCommand = 0ULL, char *_expectedResponseAtCmd = NULL,
@@ -86,6 +118,7 @@ class WiFiClass
     char *getDataBuffer();
     bool systemMessages(uint8_t _cfg);
     void flushBeforeCommand(bool _en);
+    void spiDma(bool _en);
     bool defaultMsgFiltersEn();
     bool systemMsgFiltering(bool _en);
 
@@ -106,6 +139,12 @@ class WiFiClass
     bool macAddress(char *_mac);
     bool config(IPAddress _staticIP = INADDR_NONE, IPAddress _gateway = INADDR_NONE, IPAddress _subnet = INADDR_NONE,
                 IPAddress _dns1 = INADDR_NONE, IPAddress _dns2 = INADDR_NONE);
+    bool fastConnect(char *_ssid, char *_pass, STM32H7RTC *_rtc, bool _useCachedIp = true,
+                     unsigned long _timeout = INKPLATE_ESP32_FAST_CONNECT_TIMEOUT);
+    void clearFastConnect(STM32H7RTC *_rtc);
+    bool fastConnectUsed();
+    bool poll();
+    bool busy();
     bool waitForHandshakePin(uint32_t _timeoutValue, bool _validState = HIGH);
     bool getHandshakePinState();
 
@@ -118,11 +157,18 @@ class WiFiClass
     bool dataRead(char *_dataBuffer, uint16_t _len);
     bool dataReadEnd();
     bool dataSendRequest(uint16_t _len, uint8_t _seqNumber);
-    void transferSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiPacketLen);
-    void sendSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiDataLen);
+    void transferSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiPacketLen, bool _wait = true);
+    void sendSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiDataLen, bool _wait = true);
+    bool queueSpiPacket(spiAtCommandTypedef *_spiPacket, uint16_t _spiDataLen, bool _receive, bool _wait);
+    void flushSpiQueue();
     // End of ESP32 SPI Communication Protocol methods.
 
     // Modem related methods.
+    void spiInit();
+    bool fastModemSetup();
+    bool joinAp(unsigned long _timeout);
+    bool cacheApData(struct spiAtFastConnectTypedef *_cache);
+    static uint32_t fastConnectHash(const void *_data, uint32_t _len, uint32_t _hash = 2166136261UL);
     bool flushModemReadReq();
     bool isModemReady();
     bool wiFiModemInit(bool _status);
@@ -147,8 +193,23 @@ class WiFiClass
     // Flag used for indicating that WiFi connection to the AP is currently in progress.
     bool _wifiConnectionInProgres = false;
 
+    // Flag if the last fastConnect() used the cached AP data.
+    bool _fastConnectUsed = false;
+
     // Flag for enabling/disabling flushing ESP32 from all read requests before AT Command send.
     bool _flushEspBeforeCmdSend = true;
+
+    // Flag for the last sent AT command with the data phase (its response must end with the ">" prompt).
+    bool _atPromptNeeded = false;
+
+    // Final result code of the last response received with getAtResponse().
+    uint8_t _lastAtResult = INKPLATE_ESP32_AT_RESULT_NONE;
+
+    // Flag for enabling/disabling usage of the DMA for the ESP32 SPI packets.
+    bool _spiDmaEn = true;
+
+    // Flag for the SPI transaction opened for the packets in the DMA queue.
+    bool _spiDmaTransaction = false;
 };
 
 // For easier user usage of the WiFi functionallity.
@@ -0,0 +1,474 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtAsync.cpp
+ * @brief       Source file for the non-blocking WiFi operations
+ *              (connect to the AP, HTTP GET).
+ *              This file is used with esp32SpiAt library.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include main header file for the non-blocking operations.
+#include "esp32SpiAtAsync.h"
+
+// First operation in the queue.
+WiFiOperation *WiFiOperation::_queueHead = NULL;
+
+// Parser for the responses of the running operation (only one operation runs at the time).
+static AtUrcParser _operationParser;
+
+/**
+ * @brief Construct for a new WiFiOperation object.
+ *
+ */
+WiFiOperation::WiFiOperation()
+{
+    // Empty constructor.
+}
+
+/**
+ * @brief Destroy the WiFiOperation object. Operation is removed from the queue.
+ *
+ */
+WiFiOperation::~WiFiOperation()
+{
+    removeFromQueue();
+}
+
+/**
+ * @brief   Start the non-blocking connection to the AP. Operation is executed in the WiFi.poll().
+ *
+ * @param   const char *_ssid
+ *          SSID of the AP (must be valid until the operation is finished).
+ * @param   const char *_pass
+ *          Password of the AP (must be valid until the operation is finished).
+ * @param   unsigned long _timeout
+ *          Timeout in milliseconds.
+ * @return  bool
+ *          true - Operation is queued.
+ *          false - Operation is already in progress or invalid parameters.
+ * @note    WiFi must be initialized with WiFi.init() and WiFi.setMode() before this.
+ */
+bool WiFiOperation::connect(const char *_ssid, const char *_pass, unsigned long _timeout)
+{
+    // Check for user mistake (null-pointer!).
+    if ((_ssid == NULL) || (_pass == NULL))
+        return false;
+
+    // Operation can't be changed while it's in progress.
+    if (busy())
+        return false;
+
+    _type = TYPE_CONNECT;
+    this->_ssid = _ssid;
+    this->_pass = _pass;
+
+    return enqueue(_timeout);
+}
+
+/**
+ * @brief   Start the non-blocking HTTP GET into the buffer. Operation is executed in the WiFi.poll().
+ *
+ * @param   const char *_url
+ *          URL of the file (must be valid until the operation is started).
+ * @param   volatile uint8_t *_buffer
+ *          Buffer for the data (can be in the SDRAM).
+ * @param   uint32_t _maxSize
+ *          Size of the buffer in bytes. If more data is received, operation ends with
+ *          INKPLATE_WIFI_OP_ERROR_OVERFLOW.
+ * @param   unsigned long _timeout
+ *          Timeout in milliseconds (max. time without any data from the ESP32).
+ * @return  bool
+ *          true - Operation is queued.
+ *          false - Operation is already in progress or invalid parameters.
+ */
+bool WiFiOperation::get(const char *_url, volatile uint8_t *_buffer, uint32_t _maxSize, unsigned long _timeout)
+{
+    // Check for user mistake (null-pointer!).
+    if ((_url == NULL) || (_buffer == NULL))
+        return false;
+
+    // Operation can't be changed while it's in progress.
+    if (busy())
+        return false;
+
+    _type = TYPE_GET;
+    this->_url = _url;
+    this->_buffer = _buffer;
+    this->_maxSize = _maxSize;
+    _callback = NULL;
+
+    return enqueue(_timeout);
+}
+
+/**
+ * @brief   Start the non-blocking HTTP GET with the callback. Callback is called from the WiFi.poll() for each
+ *          received part of the data.
+ *
+ * @param   const char *_url
+ *          URL of the file (must be valid until the operation is started).
+ * @param   WiFiOperationCallback _callback
+ *          Callback for the received data.
+ * @param   unsigned long _timeout
+ *          Timeout in milliseconds (max. time without any data from the ESP32).
+ * @return  bool
+ *          true - Operation is queued.
+ *          false - Operation is already in progress or invalid parameters.
+ */
+bool WiFiOperation::get(const char *_url, WiFiOperationCallback _callback, unsigned long _timeout)
+{
+    // Check for user mistake (null-pointer!).
+    if ((_url == NULL) || (_callback == NULL))
+        return false;
+
+    // Operation can't be changed while it's in progress.
+    if (busy())
+        return false;
+
+    _type = TYPE_GET;
+    this->_url = _url;
+    this->_callback = _callback;
+    _buffer = NULL;
+    _maxSize = 0;
+
+    return enqueue(_timeout);
+}
+
+/**
+ * @brief   Cancel the operation. Queued operation is removed from the queue. Running operation can't be stopped on
+ *          the ESP32, so received data is discarded until the ESP32 finishes the command.
+ *
+ */
+void WiFiOperation::cancel()
+{
+    if (_state == INKPLATE_WIFI_OP_QUEUED)
+    {
+        removeFromQueue();
+        _error = INKPLATE_WIFI_OP_ERROR_CANCELED;
+        _state = INKPLATE_WIFI_OP_ERROR;
+    }
+    else if (_state == INKPLATE_WIFI_OP_RUNNING)
+    {
+        _canceled = true;
+    }
+}
+
+/**
+ * @brief   Get the state of the operation.
+ *
+ * @return  uint8_t
+ *          INKPLATE_WIFI_OP_IDLE, INKPLATE_WIFI_OP_QUEUED, INKPLATE_WIFI_OP_RUNNING, INKPLATE_WIFI_OP_DONE or
+ *          INKPLATE_WIFI_OP_ERROR.
+ */
+uint8_t WiFiOperation::state()
+{
+    return _state;
+}
+
+/**
+ * @brief   Check if the operation is queued or running.
+ *
+ * @return  bool
+ *          true - Operation is in progress.
+ *          false - Operation is not started or it's finished.
+ */
+bool WiFiOperation::busy()
+{
+    return ((_state == INKPLATE_WIFI_OP_QUEUED) || (_state == INKPLATE_WIFI_OP_RUNNING));
+}
+
+/**
+ * @brief   Check if the operation is finished successfully.
+ *
+ * @return  bool
+ *          true - Operation is done.
+ *          false - Operation is in progress, not started or it failed.
+ */
+bool WiFiOperation::done()
+{
+    return (_state == INKPLATE_WIFI_OP_DONE);
+}
+
+/**
+ * @brief   Get the error of the operation.
+ *
+ * @return  uint8_t
+ *          INKPLATE_WIFI_OP_ERROR_xxx, INKPLATE_WIFI_OP_ERROR_NONE if there is no error.
+ */
+uint8_t WiFiOperation::error()
+{
+    return _error;
+}
+
+/**
+ * @brief   Get the number of received bytes of the HTTP GET (total size is known only when the operation is done).
+ *
+ * @return  uint32_t
+ *          Number of received bytes.
+ */
+uint32_t WiFiOperation::bytesReceived()
+{
+    return _received;
+}
+
+/**
+ * @brief   Process the queued operations. Start the first one or handle the response of the running one. It reads
+ *          only data that is already received by the ESP32, so it does not block.
+ *
+ * @return  bool
+ *          true - Some operation is still in progress.
+ *          false - Queue is empty.
+ * @note    Called from the WiFi.poll().
+ */
+bool WiFiOperation::pollQueue()
+{
+    WiFiOperation *_op = _queueHead;
+
+    // Nothing to do?
+    if (_op == NULL)
+        return false;
+
+    if (_op->_state == INKPLATE_WIFI_OP_QUEUED)
+    {
+        // Start the operation, the response is handled with the next poll.
+        if (!_op->start())
+            _op->finish(INKPLATE_WIFI_OP_ERROR, INKPLATE_WIFI_OP_ERROR_COMMAND);
+    }
+    else
+    {
+        _op->process();
+    }
+
+    return (_queueHead != NULL);
+}
+
+/**
+ * @brief   Check if any operation is queued or running.
+ *
+ * @return  bool
+ *          true - Queue is not empty.
+ *          false - Queue is empty.
+ */
+bool WiFiOperation::pending()
+{
+    return (_queueHead != NULL);
+}
+
+/**
+ * @brief   Add the operation at the end of the queue.
+ *
+ * @param   unsigned long _timeout
+ *          Timeout of the operation in milliseconds.
+ * @return  bool
+ *          Always true.
+ */
+bool WiFiOperation::enqueue(unsigned long _timeout)
+{
+    this->_timeout = _timeout;
+    _received = 0;
+    _canceled = false;
+    _error = INKPLATE_WIFI_OP_ERROR_NONE;
+    _state = INKPLATE_WIFI_OP_QUEUED;
+    _next = NULL;
+
+    // Find the end of the queue.
+    WiFiOperation **_last = &_queueHead;
+    while (*_last != NULL)
+        _last = &((*_last)->_next);
+
+    *_last = this;
+
+    return true;
+}
+
+/**
+ * @brief   Send the AT command of the operation. It does not wait for the final response.
+ *
+ * @return  bool
+ *          true - Command is sent.
+ *          false - ESP32 did not accept the command.
+ */
+bool WiFiOperation::start()
+{
+    char *_dataBuffer = WiFi.getDataBuffer();
+
+    // Response of this operation starts from the new line.
+    _operationParser.begin();
+    _lastActivity = millis();
+    _state = INKPLATE_WIFI_OP_RUNNING;
+
+    if (_type == TYPE_CONNECT)
+    {
+        // Create string for AT comamnd. Result (OK or FAIL) is sent when the ESP32 connects.
+        sprintf(_dataBuffer, "AT+CWJAP=\"%s\",\"%s\"\r\n", _ssid, _pass);
+        return WiFi.sendAtCommand(_dataBuffer);
+    }
+
+    if (_type == TYPE_GET)
+    {
+        // Set the URL since HTTPCGET has limitations on the URL size and on characters. This is done locally on the
+        // ESP32, so it's quick.
+        sprintf(_dataBuffer, "AT+HTTPURLCFG=%d\r\n", strlen(_url));
+        if (!WiFi.sendAtCommandWithResponse(_dataBuffer, 200ULL, 4ULL, (char *)"\r\nOK\r\n\r\n>",
+                                            INKPLATE_ESP32_AT_EXPECTED_RESPONSE_START, true, (char *)_url,
+                                            strlen(_url), 20ULL, "SET OK"))
+            return false;
+
+        // Start the GET. Network timeout of the ESP32 can be max. 180 seconds.
+        unsigned long _networkTimeout = _timeout > 180000ULL ? 180000ULL : _timeout;
+        sprintf(_dataBuffer, "AT+HTTPCGET=\"\",4096,4096,%lu\r\n", _networkTimeout);
+        return WiFi.sendAtCommand(_dataBuffer);
+    }
+
+    return false;
+}
+
+/**
+ * @brief   Read the data that ESP32 already has and parse it. Frames are parsed with the AtUrcParser (not with the
+ *          message filters), so the payload can't be mistaken for the final response.
+ *
+ */
+void WiFiOperation::process()
+{
+    char *_dataBuffer = WiFi.getDataBuffer();
+    AtUrcEvent _event;
+
+    for (int i = 0; i < INKPLATE_WIFI_OP_MAX_POLL_PACKETS; i++)
+    {
+        // Get only the data that is ready (zero timeout).
+        uint16_t _len = 0;
+        if (!WiFi.getSimpleAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, 0, &_len))
+            break;
+
+        _lastActivity = millis();
+
+        uint32_t _pos = 0;
+        while (_pos < _len)
+        {
+            _pos += _operationParser.parse((const uint8_t *)_dataBuffer + _pos, _len - _pos, &_event);
+
+            if (_event.event == INKPLATE_ESP32_URC_EVENT_LINE)
+            {
+                handleLine(_event.data, _event.len);
+            }
+            else if ((_event.event == INKPLATE_ESP32_URC_EVENT_PAYLOAD) &&
+                     (_event.type == INKPLATE_ESP32_URC_TYPE_HTTPCGET))
+            {
+                handleData(_event.data, _event.len);
+            }
+
+            // Operation is finished, rest of the data is not used.
+            if (_state != INKPLATE_WIFI_OP_RUNNING)
+                return;
+        }
+    }
+
+    // Check for the timeout.
+    if ((unsigned long)(millis() - _lastActivity) > _timeout)
+        finish(INKPLATE_WIFI_OP_ERROR, _canceled ? INKPLATE_WIFI_OP_ERROR_CANCELED : INKPLATE_WIFI_OP_ERROR_TIMEOUT);
+}
+
+/**
+ * @brief   Handle one text line of the response. Only final responses are used.
+ *
+ * @param   const uint8_t *_line
+ *          Text line (without CRLF, not null-terminated).
+ * @param   uint32_t _len
+ *          Length of the line.
+ */
+void WiFiOperation::handleLine(const uint8_t *_line, uint32_t _len)
+{
+    if ((_len == 2) && (memcmp(_line, "OK", 2) == 0))
+    {
+        if (_canceled)
+        {
+            finish(INKPLATE_WIFI_OP_ERROR, INKPLATE_WIFI_OP_ERROR_CANCELED);
+        }
+        else if (_error != INKPLATE_WIFI_OP_ERROR_NONE)
+        {
+            // Buffer overflow.
+            finish(INKPLATE_WIFI_OP_ERROR, _error);
+        }
+        else
+        {
+            finish(INKPLATE_WIFI_OP_DONE, INKPLATE_WIFI_OP_ERROR_NONE);
+        }
+    }
+    else if (((_len == 5) && (memcmp(_line, "ERROR", 5) == 0)) || ((_len == 4) && (memcmp(_line, "FAIL", 4) == 0)))
+    {
+        finish(INKPLATE_WIFI_OP_ERROR, _canceled ? INKPLATE_WIFI_OP_ERROR_CANCELED : INKPLATE_WIFI_OP_ERROR_FAILED);
+    }
+}
+
+/**
+ * @brief   Handle the part of the received HTTP data.
+ *
+ * @param   const uint8_t *_data
+ *          Received data.
+ * @param   uint32_t _len
+ *          Length of the data.
+ */
+void WiFiOperation::handleData(const uint8_t *_data, uint32_t _len)
+{
+    // Data of the canceled operation is discarded.
+    if (_canceled || (_type != TYPE_GET))
+        return;
+
+    if (_callback != NULL)
+    {
+        _callback(this, _data, _len);
+    }
+    else if (_buffer != NULL)
+    {
+        // Copy only what fits into the buffer, operation fails when the ESP32 finishes.
+        uint32_t _copyLen = _len;
+        if ((_received + _len) > _maxSize)
+        {
+            _copyLen = _received < _maxSize ? (_maxSize - _received) : 0;
+            _error = INKPLATE_WIFI_OP_ERROR_OVERFLOW;
+        }
+
+        memcpy((uint8_t *)_buffer + _received, _data, _copyLen);
+    }
+
+    _received += _len;
+}
+
+/**
+ * @brief   Finish the operation and remove it from the queue (next operation is started with the next poll).
+ *
+ * @param   uint8_t _state
+ *          New state (INKPLATE_WIFI_OP_DONE or INKPLATE_WIFI_OP_ERROR).
+ * @param   uint8_t _error
+ *          Error code.
+ */
+void WiFiOperation::finish(uint8_t _state, uint8_t _error)
+{
+    removeFromQueue();
+    this->_error = _error;
+    this->_state = _state;
+}
+
+/**
+ * @brief   Remove the operation from the queue (if it's in the queue).
+ *
+ */
+void WiFiOperation::removeFromQueue()
+{
+    WiFiOperation **_op = &_queueHead;
+    while (*_op != NULL)
+    {
+        if (*_op == this)
+        {
+            *_op = _next;
+            break;
+        }
+
+        _op = &((*_op)->_next);
+    }
+
+    _next = NULL;
+}
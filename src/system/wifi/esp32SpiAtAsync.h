@@ -0,0 +1,125 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtAsync.h
+ * @brief       Header file for the non-blocking WiFi operations
+ *              (connect to the AP, HTTP GET). Operation only sends the
+ *              AT command, response is handled later in the WiFi.poll()
+ *              (called from the loop()), so the UI can be updated
+ *              while the data is received. Operations are queued and
+ *              executed one by one, each one reports its state, number
+ *              of received bytes and the error.
+ *              This file is used with esp32SpiAt library.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add headerguard do prevent multiple include.
+#ifndef __ESP32_SPI_AT_ASYNC_H__
+#define __ESP32_SPI_AT_ASYNC_H__
+
+// Include main Arduino header file.
+#include <Arduino.h>
+
+// Include main ESP32-C3 AT SPI library.
+#include "esp32SpiAt.h"
+
+// States of the operation.
+#define INKPLATE_WIFI_OP_IDLE    0
+#define INKPLATE_WIFI_OP_QUEUED  1
+#define INKPLATE_WIFI_OP_RUNNING 2
+#define INKPLATE_WIFI_OP_DONE    3
+#define INKPLATE_WIFI_OP_ERROR   4
+
+// Operation errors.
+#define INKPLATE_WIFI_OP_ERROR_NONE     0
+#define INKPLATE_WIFI_OP_ERROR_COMMAND  1
+#define INKPLATE_WIFI_OP_ERROR_FAILED   2
+#define INKPLATE_WIFI_OP_ERROR_TIMEOUT  3
+#define INKPLATE_WIFI_OP_ERROR_OVERFLOW 4
+#define INKPLATE_WIFI_OP_ERROR_CANCELED 5
+
+// Default timeout of the operation in milliseconds (time without any data from the ESP32).
+#define INKPLATE_WIFI_OP_DEFAULT_TIMEOUT 20000ULL
+
+// Max. number of the SPI packets read from the ESP32 with one WiFi.poll() call.
+#define INKPLATE_WIFI_OP_MAX_POLL_PACKETS 4
+
+// Callback for the received HTTP data. Data is valid only inside the callback.
+class WiFiOperation;
+typedef void (*WiFiOperationCallback)(WiFiOperation *_op, const uint8_t *_data, uint16_t _len);
+
+// Non-blocking WiFi operation (handle). Object must stay valid until the operation is finished.
+class WiFiOperation
+{
+  public:
+    // Class constructor and destructor (removes the operation from the queue).
+    WiFiOperation();
+    ~WiFiOperation();
+
+    // Connect to the AP (WiFi must be initialized with WiFi.init() and WiFi.setMode()).
+    bool connect(const char *_ssid, const char *_pass, unsigned long _timeout = INKPLATE_WIFI_OP_DEFAULT_TIMEOUT);
+
+    // HTTP GET into the buffer or with the callback for each received part of the data.
+    bool get(const char *_url, volatile uint8_t *_buffer, uint32_t _maxSize,
+             unsigned long _timeout = INKPLATE_WIFI_OP_DEFAULT_TIMEOUT);
+    bool get(const char *_url, WiFiOperationCallback _callback,
+             unsigned long _timeout = INKPLATE_WIFI_OP_DEFAULT_TIMEOUT);
+
+    // Cancel the operation.
+    void cancel();
+
+    // Operation status.
+    uint8_t state();
+    bool busy();
+    bool done();
+    uint8_t error();
+    uint32_t bytesReceived();
+
+    // Process the queued operations (called from the WiFi.poll()) and check if any operation is queued.
+    static bool pollQueue();
+    static bool pending();
+
+  private:
+    // Types of the operations.
+    enum
+    {
+        TYPE_NONE,
+        TYPE_CONNECT,
+        TYPE_GET
+    } _type = TYPE_NONE;
+
+    bool enqueue(unsigned long _timeout);
+    bool start();
+    void process();
+    void handleLine(const uint8_t *_line, uint32_t _len);
+    void handleData(const uint8_t *_data, uint32_t _len);
+    void finish(uint8_t _state, uint8_t _error);
+    void removeFromQueue();
+
+    // Parameters of the operation.
+    const char *_ssid = NULL;
+    const char *_pass = NULL;
+    const char *_url = NULL;
+    volatile uint8_t *_buffer = NULL;
+    uint32_t _maxSize = 0;
+    WiFiOperationCallback _callback = NULL;
+    unsigned long _timeout = INKPLATE_WIFI_OP_DEFAULT_TIMEOUT;
+
+    // Status of the operation.
+    volatile uint8_t _state = INKPLATE_WIFI_OP_IDLE;
+    volatile uint8_t _error = INKPLATE_WIFI_OP_ERROR_NONE;
+    volatile uint32_t _received = 0;
+    bool _canceled = false;
+    unsigned long _lastActivity = 0;
+
+    // Next operation in the queue.
+    WiFiOperation *_next = NULL;
+
+    // First operation in the queue (the one that is running).
+    static WiFiOperation *_queueHead;
+};
+
+#endif
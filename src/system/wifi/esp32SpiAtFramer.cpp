@@ -0,0 +1,235 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtFramer.cpp
+ * @brief       Main source file for the AT response framer. It checks
+ *              the response as the packets arrive and detects the final
+ *              result code (OK, ERROR, SEND OK, FAIL, ">" prompt...),
+ *              so the response can be returned as soon as it's
+ *              complete, without waiting for the timeout.
+ *              It does not use any Arduino or STM32 code.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include header file.
+#include "esp32SpiAtFramer.h"
+
+// Final result codes of the ESP32-AT and their meaning.
+static const struct
+{
+    const char *line;
+    uint8_t result;
+} esp32AtFinalResults[] = {
+    {"OK", INKPLATE_ESP32_AT_RESULT_OK},
+    {"SEND OK", INKPLATE_ESP32_AT_RESULT_OK},
+    {"SET OK", INKPLATE_ESP32_AT_RESULT_OK},
+    {"ERROR", INKPLATE_ESP32_AT_RESULT_ERROR},
+    {"SEND FAIL", INKPLATE_ESP32_AT_RESULT_ERROR},
+    {"FAIL", INKPLATE_ESP32_AT_RESULT_ERROR},
+};
+
+// Commands with the data phase. ESP32 responds with OK and then with ">" when it's ready for the data.
+// AT+CIPSEND also covers AT+CIPSENDEX and AT+CIPSENDL.
+static const char *esp32AtPromptCommands[] = {
+    "AT+CIPSEND",
+    "AT+HTTPCPOST=",
+    "AT+HTTPCPUT=",
+    "AT+HTTPURLCFG=",
+    "AT+HTTPCHEAD=",
+    "AT+MQTTPUBRAW=",
+    "AT+MQTTLONGCLIENTID=",
+    "AT+MQTTLONGUSERNAME=",
+    "AT+MQTTLONGPASSWORD=",
+    "AT+SYSMSGFILTERCFG=",
+};
+
+/**
+ * @brief Construct a new AT Response Framer object.
+ *
+ */
+AtResponseFramer::AtResponseFramer()
+{
+    // Empty...for now.
+}
+
+/**
+ * @brief   Starts checking the new response.
+ *
+ * @param   const char *_buffer
+ *          Buffer where the response is stored (packets one after another).
+ * @param   const char *_expectedResponse
+ *          Response the command must have. If set, response is complete only when this is received
+ *          together with the final result code. This parameter is optional (NULL = any final result code).
+ * @param   bool _promptNeeded
+ *          true - Command has the data phase, response is complete only with the ">" prompt (or the error). See
+ *          AtResponseFramer::commandNeedsPrompt().
+ *          false - Any final result code completes the response (default).
+ */
+void AtResponseFramer::begin(const char *_buffer, const char *_expectedResponse, bool _promptNeeded)
+{
+    _responseBuffer = _buffer;
+    _expected = _expectedResponse;
+    _expectedLen = (_expectedResponse != NULL) ? strlen(_expectedResponse) : 0;
+    _checkedLen = 0;
+    _lineStart = 0;
+    _result = INKPLATE_ESP32_AT_RESULT_NONE;
+    _expectedFound = false;
+    this->_promptNeeded = _promptNeeded;
+}
+
+/**
+ * @brief   Checks the newly received data. Only the part of the buffer that is not checked yet is used, so the
+ *          response can be checked after every packet. Data does not need to be null-terminated.
+ *
+ * @param   uint32_t _len
+ *          Total number of bytes in the response buffer (all received packets).
+ * @return  bool
+ *          true - Response is complete.
+ *          false - More data is needed.
+ */
+bool AtResponseFramer::feed(uint32_t _len)
+{
+    // Nothing new?
+    if ((_responseBuffer == NULL) || (_len <= _checkedLen))
+        return done();
+
+    // Search for the expected response. It could start in the previous packet.
+    if ((_expected != NULL) && !_expectedFound && (_len >= _expectedLen))
+    {
+        uint32_t _searchStart = (_checkedLen >= _expectedLen) ? (_checkedLen - _expectedLen + 1) : 0;
+        for (uint32_t i = _searchStart; (i + _expectedLen) <= _len; i++)
+        {
+            if (memcmp(_responseBuffer + i, _expected, _expectedLen) == 0)
+            {
+                _expectedFound = true;
+                break;
+            }
+        }
+    }
+
+    // Check every finished line.
+    for (uint32_t i = _checkedLen; i < _len; i++)
+    {
+        if (_responseBuffer[i] == '\n')
+        {
+            // Remove CR at the end of the line.
+            uint32_t _lineLen = i - _lineStart;
+            if ((_lineLen != 0) && (_responseBuffer[i - 1] == '\r'))
+                _lineLen--;
+
+            // Save the final result code. Error is kept even if something else comes after it.
+            uint8_t _lineResult = checkLine(_responseBuffer + _lineStart, _lineLen);
+            if ((_lineResult != INKPLATE_ESP32_AT_RESULT_NONE) && (_result != INKPLATE_ESP32_AT_RESULT_ERROR))
+                _result = _lineResult;
+
+            // Next line starts here.
+            _lineStart = i + 1;
+        }
+    }
+    _checkedLen = _len;
+
+    // Prompt for the data (">") is not followed by the new line.
+    uint32_t _restLen = _len - _lineStart;
+    if (((_restLen == 1) || ((_restLen == 2) && (_responseBuffer[_lineStart + 1] == ' '))) &&
+        (_responseBuffer[_lineStart] == '>') && (_result != INKPLATE_ESP32_AT_RESULT_ERROR))
+        _result = INKPLATE_ESP32_AT_RESULT_PROMPT;
+
+    return done();
+}
+
+/**
+ * @brief   Check if the response is complete. Error ends the response immediately. Otherwise, the response is
+ *          complete when the final result code is received (and the expected response, if it's set). Commands with
+ *          the data phase need the ">" prompt, OK before it is not enough.
+ *
+ * @return  bool
+ *          true - Response is complete.
+ *          false - More data is needed.
+ */
+bool AtResponseFramer::done()
+{
+    if (_result == INKPLATE_ESP32_AT_RESULT_ERROR)
+        return true;
+
+    if (_promptNeeded && (_result != INKPLATE_ESP32_AT_RESULT_PROMPT))
+        return false;
+
+    return (_result != INKPLATE_ESP32_AT_RESULT_NONE) && ((_expected == NULL) || _expectedFound);
+}
+
+/**
+ * @brief   Get the last final result code of the response.
+ *
+ * @return  uint8_t
+ *          INKPLATE_ESP32_AT_RESULT_NONE, INKPLATE_ESP32_AT_RESULT_OK, INKPLATE_ESP32_AT_RESULT_ERROR or
+ *          INKPLATE_ESP32_AT_RESULT_PROMPT.
+ */
+uint8_t AtResponseFramer::result()
+{
+    return _result;
+}
+
+/**
+ * @brief   Check if the expected response has been received.
+ *
+ * @return  bool
+ *          true - Expected response is received (or it's not set at all).
+ *          false - Expected response is not received.
+ */
+bool AtResponseFramer::expectedFound()
+{
+    return (_expected == NULL) || _expectedFound;
+}
+
+/**
+ * @brief   Check if the AT command has the data phase (ESP32 sends OK and then the ">" prompt for the data).
+ *
+ * @param   const char *_command
+ *          AT command (null-terminated string).
+ * @return  bool
+ *          true - Response of this command must end with the ">" prompt.
+ *          false - Any final result code ends the response.
+ */
+bool AtResponseFramer::commandNeedsPrompt(const char *_command)
+{
+    if (_command == NULL)
+        return false;
+
+    for (uint8_t i = 0; i < sizeof(esp32AtPromptCommands) / sizeof(esp32AtPromptCommands[0]); i++)
+    {
+        uint32_t _prefixLen = strlen(esp32AtPromptCommands[i]);
+        if (strncmp(_command, esp32AtPromptCommands[i], _prefixLen) == 0)
+        {
+            // Only parameter is zero length (for example AT+HTTPCHEAD=0 removes the headers)? No data phase.
+            const char *_params = _command + _prefixLen;
+            return !((_params[0] == '0') && ((_params[1] == '\0') || (_params[1] == '\r')));
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief   Check if the line is one of the final result codes.
+ *
+ * @param   const char *_line
+ *          Pointer to the start of the line.
+ * @param   uint32_t _lineLen
+ *          Length of the line without CRLF.
+ * @return  uint8_t
+ *          Result code of the line (INKPLATE_ESP32_AT_RESULT_NONE if it's not a final result code).
+ */
+uint8_t AtResponseFramer::checkLine(const char *_line, uint32_t _lineLen)
+{
+    for (uint8_t i = 0; i < sizeof(esp32AtFinalResults) / sizeof(esp32AtFinalResults[0]); i++)
+    {
+        if ((strlen(esp32AtFinalResults[i].line) == _lineLen) &&
+            (memcmp(_line, esp32AtFinalResults[i].line, _lineLen) == 0))
+            return esp32AtFinalResults[i].result;
+    }
+
+    return INKPLATE_ESP32_AT_RESULT_NONE;
+}
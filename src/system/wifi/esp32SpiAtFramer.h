@@ -0,0 +1,61 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtFramer.h
+ * @brief       Header file for the AT response framer. It checks the
+ *              response as the packets arrive and detects the final
+ *              result code (OK, ERROR, SEND OK, FAIL, ">" prompt...),
+ *              so the response can be returned as soon as it's
+ *              complete, without waiting for the timeout.
+ *              It does not use any Arduino or STM32 code.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add headerguard do prevent multiple include.
+#ifndef __ESP32_SPI_AT_FRAMER_H__
+#define __ESP32_SPI_AT_FRAMER_H__
+
+// Include standard C libraries.
+#include <stdint.h>
+#include <string.h>
+
+// Include SPI AT Message typedefs (for the result codes).
+#include "esp32SpiAtTypedefs.h"
+
+class AtResponseFramer
+{
+  public:
+    AtResponseFramer();
+    void begin(const char *_buffer, const char *_expectedResponse = NULL, bool _promptNeeded = false);
+    bool feed(uint32_t _len);
+    bool done();
+    uint8_t result();
+    bool expectedFound();
+    static bool commandNeedsPrompt(const char *_command);
+
+  private:
+    uint8_t checkLine(const char *_line, uint32_t _lineLen);
+
+    // Buffer with the response (all packets one after another).
+    const char *_responseBuffer = NULL;
+
+    // Expected response (can be NULL).
+    const char *_expected = NULL;
+    uint32_t _expectedLen = 0;
+
+    // Number of bytes already checked and start of the current (not finished) line.
+    uint32_t _checkedLen = 0;
+    uint32_t _lineStart = 0;
+
+    // Last final result code and flag for the expected response.
+    uint8_t _result = INKPLATE_ESP32_AT_RESULT_NONE;
+    bool _expectedFound = false;
+
+    // Flag for the commands with the data phase (OK comes before the ">" prompt, so OK does not end the response).
+    bool _promptNeeded = false;
+};
+
+#endif
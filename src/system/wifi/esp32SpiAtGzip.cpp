@@ -0,0 +1,208 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtGzip.cpp
+ * @brief       Main source file for the streaming gzip decoder used for
+ *              the compressed HTTP responses.
+ *              It does not use any Arduino or STM32 code.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include header file.
+#include "esp32SpiAtGzip.h"
+
+/**
+ * @brief   Reset the decoder for the new gzip stream. Call it after the gzip header is skipped (see
+ *          GzipInflater::headerSize()).
+ *
+ */
+void GzipInflater::begin()
+{
+    tinfl_init(&_inflator);
+    _dictOfs = 0;
+    _crc = MZ_CRC32_INIT;
+    _size = 0;
+    _trailerLen = 0;
+    _state = STATE_DATA;
+}
+
+/**
+ * @brief   Decode the next part of the compressed data. Call it again with the rest of the input until all input is
+ *          used and no more data is decoded, then with the next chunk of the compressed data.
+ *
+ * @param   const uint8_t *_in
+ *          Pointer to the compressed data (deflate data and the gzip trailer).
+ * @param   uint32_t *_inLen
+ *          Number of the compressed bytes. Number of the used bytes is stored here.
+ * @param   const uint8_t **_out
+ *          Pointer to the decoded data is stored here (it's in the decoder, valid until the next call).
+ * @param   uint32_t *_outLen
+ *          Number of the decoded bytes is stored here (0 if there is no new decoded data).
+ * @return  bool
+ *          true - Data is decoded.
+ *          false - Data is broken (deflate error, or CRC32 or size in the gzip trailer do not match), decoded data
+ *          must not be used.
+ */
+bool GzipInflater::decode(const uint8_t *_in, uint32_t *_inLen, const uint8_t **_out, uint32_t *_outLen)
+{
+    uint32_t _used = 0;
+
+    // No new data by default.
+    *_out = _dict + _dictOfs;
+    *_outLen = 0;
+
+    if (_state == STATE_DATA)
+    {
+        // Decode as much as possible. Dictionary is the output buffer as well (it wraps around).
+        size_t _inBytes = *_inLen;
+        size_t _outBytes = TINFL_LZ_DICT_SIZE - _dictOfs;
+        tinfl_status _status = tinfl_decompress(&_inflator, _in, &_inBytes, _dict, _dict + _dictOfs, &_outBytes,
+                                                TINFL_FLAG_HAS_MORE_INPUT);
+        _used = _inBytes;
+
+        // Broken data? Nothing decoded from it can be used.
+        if (_status < TINFL_STATUS_DONE)
+        {
+            _state = STATE_ERROR;
+            *_inLen = _used;
+            return false;
+        }
+
+        // Return the decoded data and add it to the CRC32 and size for the trailer check.
+        *_outLen = _outBytes;
+        _crc = mz_crc32(_crc, _dict + _dictOfs, _outBytes);
+        _size += _outBytes;
+        _dictOfs = (_dictOfs + _outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (_status == TINFL_STATUS_DONE)
+        {
+            // Decoder reads the input ahead, so the whole bytes left in its bit buffer (after the end of the last
+            // deflate byte) are the start of the gzip trailer.
+            uint32_t _bits = _inflator.m_num_bits;
+            uint64_t _bitBuf = (uint64_t)_inflator.m_bit_buf >> (_bits & 7);
+            for (uint32_t i = 0; (i < (_bits >> 3)) && (_trailerLen < GZIP_TRAILER_SIZE); i++)
+            {
+                _trailer[_trailerLen++] = _bitBuf & 0xFF;
+                _bitBuf >>= 8;
+            }
+            _state = STATE_TRAILER;
+        }
+    }
+
+    if (_state == STATE_TRAILER)
+    {
+        // Collect the rest of the trailer (it can be split between the chunks).
+        while ((_used < *_inLen) && (_trailerLen < GZIP_TRAILER_SIZE))
+            _trailer[_trailerLen++] = _in[_used++];
+
+        if (_trailerLen == GZIP_TRAILER_SIZE)
+            checkTrailer();
+    }
+
+    // Data after the end of the gzip stream is ignored.
+    *_inLen = _used;
+
+    // Last decoded data can't be used if the trailer does not match.
+    if (_state == STATE_ERROR)
+    {
+        *_outLen = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief   Check if the whole gzip stream is decoded (with the valid trailer).
+ *
+ * @return  bool
+ *          true - gzip stream is complete.
+ *          false - More data is needed (or data is broken).
+ */
+bool GzipInflater::done()
+{
+    return (_state == STATE_DONE);
+}
+
+/**
+ * @brief   Check if the gzip stream is broken.
+ *
+ * @return  bool
+ *          true - Deflate data is broken, or CRC32 or size in the trailer does not match the decoded data.
+ *          false - No errors so far.
+ */
+bool GzipInflater::error()
+{
+    return (_state == STATE_ERROR);
+}
+
+/**
+ * @brief   Check for the gzip header at the start of the data and get its size.
+ *
+ * @param   const uint8_t *_data
+ *          Pointer to the start of the gzip data.
+ * @param   uint32_t _len
+ *          Size of the data in bytes.
+ * @return  uint16_t
+ *          Size of the gzip header in bytes. 0 if the data is not gzip (or the header is not complete).
+ */
+uint16_t GzipInflater::headerSize(const uint8_t *_data, uint32_t _len)
+{
+    // Check the signature, compression method (deflate) and reserved flags.
+    if ((_data == NULL) || (_len < 10) || (_data[0] != 0x1F) || (_data[1] != 0x8B) || (_data[2] != 8) ||
+        (_data[3] & 0xE0))
+        return 0;
+
+    // Fixed part of the header is 10 bytes long, optional fields are after it.
+    uint8_t _flags = _data[3];
+    uint32_t _pos = 10;
+
+    // Skip extra field (FEXTRA).
+    if (_flags & 0x04)
+    {
+        if ((_pos + 2) > _len)
+            return 0;
+        _pos += 2 + (_data[_pos] | (_data[_pos + 1] << 8));
+    }
+
+    // Skip file name (FNAME) and comment (FCOMMENT), both are null-terminated.
+    for (uint8_t _mask = 0x08; _mask <= 0x10; _mask <<= 1)
+    {
+        if (_flags & _mask)
+        {
+            while ((_pos < _len) && (_data[_pos] != 0))
+                _pos++;
+            _pos++;
+        }
+    }
+
+    // Skip header CRC (FHCRC).
+    if (_flags & 0x02)
+        _pos += 2;
+
+    // Whole header must be in the data (and it can't be larger than the return type).
+    if ((_pos > _len) || (_pos > UINT16_MAX))
+        return 0;
+
+    return _pos;
+}
+
+/**
+ * @brief   Compare the gzip trailer with the CRC32 and the size (modulo 2^32) of the decoded data.
+ *
+ */
+void GzipInflater::checkTrailer()
+{
+    uint32_t _trailerCrc = 0;
+    uint32_t _trailerSize = 0;
+    for (int i = 3; i >= 0; i--)
+    {
+        _trailerCrc = (_trailerCrc << 8) | _trailer[i];
+        _trailerSize = (_trailerSize << 8) | _trailer[i + 4];
+    }
+
+    _state = ((_trailerCrc == _crc) && (_trailerSize == _size)) ? STATE_DONE : STATE_ERROR;
+}
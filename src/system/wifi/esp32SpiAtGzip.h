@@ -0,0 +1,65 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtGzip.h
+ * @brief       Header file for the streaming gzip decoder used for the
+ *              compressed HTTP responses. Compressed data can be split
+ *              into chunks anywhere (also inside the gzip trailer), the
+ *              decoded data is returned from the decoder dictionary. CRC32
+ *              and size from the gzip trailer are checked at the end.
+ *              It does not use any Arduino or STM32 code.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add headerguard do prevent multiple include.
+#ifndef __ESP32_SPI_AT_GZIP_H__
+#define __ESP32_SPI_AT_GZIP_H__
+
+// Include standard C libraries.
+#include <stdint.h>
+#include <stddef.h>
+
+// Include inflate from the miniz library (used by the PNG decoder).
+#include "../../libs/pngle/miniz.h"
+
+// Size of the gzip trailer (CRC32 and size of the decoded data, both little endian).
+#define GZIP_TRAILER_SIZE 8
+
+// Decoder is large (around 43kB with the dictionary), so allocate it only when it's needed.
+class GzipInflater
+{
+  public:
+    void begin();
+    bool decode(const uint8_t *_in, uint32_t *_inLen, const uint8_t **_out, uint32_t *_outLen);
+    bool done();
+    bool error();
+    static uint16_t headerSize(const uint8_t *_data, uint32_t _len);
+
+  private:
+    void checkTrailer();
+
+    // Decoder states.
+    enum
+    {
+        STATE_DATA,
+        STATE_TRAILER,
+        STATE_DONE,
+        STATE_ERROR
+    } _state = STATE_DATA;
+
+    // Inflate decoder and its dictionary (also used as the output buffer, it wraps around).
+    tinfl_decompressor _inflator;
+    uint8_t _dict[TINFL_LZ_DICT_SIZE];
+    uint32_t _dictOfs = 0;
+
+    // CRC32 and size of the decoded data, checked against the gzip trailer.
+    uint32_t _crc = 0;
+    uint32_t _size = 0;
+    uint8_t _trailer[GZIP_TRAILER_SIZE];
+    uint8_t _trailerLen = 0;
+};
+
+#endif
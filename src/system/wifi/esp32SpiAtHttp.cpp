@@ -13,6 +13,15 @@
 // Innclude main header file.
 #include "esp32SpiAt.h"
 
+// Include ring buffer from the SdFat library.
+#include "../../features/SdFat/RingBuf.h"
+
+// Include streaming gzip decoder.
+#include "esp32SpiAtGzip.h"
+
+// Buffer between the WiFi and the microSD card, shared by all clients (only one download can run at the time).
+static RingBuf<File, INKPLATE_ESP32_HTTP_FILE_BUFFER_SIZE> _fileRingBuffer;
+
 // WiFiClient constructor - for HTTP.
 /**
  * @brief Construct a WiFiClient constructor - for HTTP.
@@ -22,6 +31,10 @@ WiFiClient::WiFiClient()
 {
     // Get the RX Buffer Data Buffer pointer from the WiFi library.
     _dataBuffer = WiFi.getDataBuffer();
+
+    // No validators yet.
+    _etag[0] = '\0';
+    _lastModified[0] = '\0';
 }
 
 /**
@@ -38,10 +51,19 @@ bool WiFiClient::begin(const char *_url)
     // Set data len to zero. And also file size.
     _bufferLen = 0;
     _fileSize = 0;
+    _received = 0;
+
+    // Release the gzip decoder from the previous response.
+    stopInflate();
+    _inflateError = false;
 
     // Save the address of the URL.
     _urlStr = (char *)_url;
 
+    // Validators belong to the previous URL.
+    _etag[0] = '\0';
+    _lastModified[0] = '\0';
+
     // Set the URL since HTTPCGET has limitations on the URL size and on characters.
     sprintf(_dataBuffer, "AT+HTTPURLCFG=%d\r\n", strlen(_url));
 
@@ -68,6 +90,15 @@ bool WiFiClient::begin(const char *_url)
  */
 bool WiFiClient::GET()
 {
+    // Allow the server to send the compressed response (it's decoded on the fly). Header must be added before the
+    // message filters, since the filter below removes the OK that addHeader() waits for.
+    if (_acceptGzip && !_gzipHeaderAdded)
+    {
+        if (!addHeader((char *)INKPLATE_ESP32_HTTP_ACCEPT_GZIP))
+            return false;
+        _gzipHeaderAdded = true;
+    }
+
     // First set the message filter to set the modem in pass-trough mode.
     // Remove the header and "enter" at the end.
     if (!WiFi.messageFilter(true, "^+HTTPCGET:[0-9]*,", "\r\n$"))
@@ -92,6 +123,13 @@ bool WiFiClient::GET()
     // Increment position and set current new position of the pointer for data read.
     _bufferLen += _len;
     _currentPos = _dataBuffer;
+    _received += _len;
+
+    // gzip response? Only if it was asked for with this request (gzip signature alone could also be a .gz file sent
+    // as it is). Start the decoder (first decoded data is available after this).
+    _inflateError = false;
+    if (_acceptGzip && _gzipHeaderAdded && (GzipInflater::headerSize((uint8_t *)_dataBuffer, _len) != 0))
+        return startInflate(_len);
 
     // Return ok for success.
     return true;
@@ -128,9 +166,148 @@ bool WiFiClient::POST(const char *_body, uint16_t _bodyLen)
     return true;
 }
 
+/**
+ * @brief   Send HTTP HEAD request to the URL set with WiFiClient::begin(). Only the response headers are
+ *          received, ETag and Last-Modified values are saved (see WiFiClient::getETag() and
+ *          WiFiClient::getLastModified()). Headers added with WiFiClient::addHeader() are sent as well.
+ *
+ * @return  bool
+ *          true - Response received.
+ *          false - Request failed (no connection, timeout, HTTP error or headers larger than the AT buffer).
+ */
+bool WiFiClient::HEAD()
+{
+    // Clear validators from the previous response.
+    _etag[0] = '\0';
+    _lastModified[0] = '\0';
+
+    // Use the URL set by the AT+HTTPURLCFG. Transport type depends on the URL (1 = TCP, 2 = SSL).
+    sprintf(_dataBuffer, "AT+HTTPCLIENT=1,0,\"\",,,%d\r\n", (strncmp(_urlStr, "https", 5) == 0) ? 2 : 1);
+    if (!WiFi.sendAtCommand(_dataBuffer))
+        return false;
+
+    // Each header is sent as +HTTPCLIENT:<len>,<header>, maybe in more than one packet. Collect all
+    // of them until OK or ERROR is received.
+    uint32_t _offset = 0;
+    uint16_t _len = 0;
+    unsigned long _timer = millis();
+    _dataBuffer[0] = '\0';
+    while ((strstr(_dataBuffer, "\r\nOK\r\n") == NULL) && (strstr(_dataBuffer, "\r\nERROR\r\n") == NULL))
+    {
+        // Check for the timeout.
+        if ((unsigned long)(millis() - _timer) > INKPLATE_ESP32_HTTP_HEAD_TIMEOUT)
+            return false;
+
+        // Headers do not fit into the buffer (only the null-terminating char is left)? Fail.
+        if (_offset >= (INKPLATE_ESP32_AT_CMD_BUFFER_SIZE - 1))
+            return false;
+
+        // Get the next part of the response. Buffer length counts the null-terminating char, so the buffer is always
+        // null-terminated for the search.
+        if (WiFi.getAtResponse(_dataBuffer + _offset, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE - _offset, 200ULL, &_len))
+            _offset += _len;
+    }
+
+    // HTTP error (4xx or 5xx)?
+    if (strstr(_dataBuffer, "\r\nERROR\r\n") != NULL)
+        return false;
+
+    // Find the ETag and Last-Modified.
+    parseValidators(_dataBuffer, _offset);
+
+    // Return true for success.
+    return true;
+}
+
+/**
+ * @brief   Check if the file on the server has been changed since the last download. Sends the conditional
+ *          HEAD request (If-None-Match and If-Modified-Since) with the validators saved from the last download.
+ *          New validators are available with WiFiClient::getETag() and WiFiClient::getLastModified().
+ *
+ * @param   const char *_etag
+ *          ETag of the saved copy. Can be NULL or empty string if unknown.
+ * @param   const char *_lastModified
+ *          Last-Modified of the saved copy. Can be NULL or empty string if unknown.
+ * @return  bool
+ *          true - File is not modified (304 Not Modified or same validators), saved copy can be used.
+ *          false - File is modified, or server did not send the validators, validators are longer than
+ *          INKPLATE_ESP32_HTTP_VALIDATOR_SIZE - 1 characters, or request failed.
+ * @note    Call WiFiClient::begin() first. All added HTTP headers are removed here.
+ */
+bool WiFiClient::notModified(const char *_etag, const char *_lastModified)
+{
+    // Buffer for the conditional headers.
+    char _header[INKPLATE_ESP32_HTTP_VALIDATOR_SIZE + 24];
+
+    // Check what validators are known.
+    bool _hasEtag = (_etag != NULL) && (_etag[0] != '\0');
+    bool _hasLastModified = (_lastModified != NULL) && (_lastModified[0] != '\0');
+
+    // Nothing to compare with? File must be downloaded.
+    if (!_hasEtag && !_hasLastModified)
+        return false;
+
+    // Validators longer than the saved ones can't match the response, so the file must be downloaded.
+    if ((_hasEtag && (strlen(_etag) >= INKPLATE_ESP32_HTTP_VALIDATOR_SIZE)) ||
+        (_hasLastModified && (strlen(_lastModified) >= INKPLATE_ESP32_HTTP_VALIDATOR_SIZE)))
+        return false;
+
+    // Add the conditional headers.
+    if (_hasEtag)
+    {
+        snprintf(_header, sizeof(_header), "If-None-Match: %s", _etag);
+        if (!addHeader(_header))
+            return false;
+    }
+    if (_hasLastModified)
+    {
+        snprintf(_header, sizeof(_header), "If-Modified-Since: %s", _lastModified);
+        if (!addHeader(_header))
+        {
+            addHeader(NULL);
+            return false;
+        }
+    }
+
+    // Send the request and remove the headers (so they are not sent with the next GET).
+    bool _ok = HEAD();
+    addHeader(NULL);
+    if (!_ok)
+        return false;
+
+    // Server responds with 304 and the same validators if the file is not changed (servers that ignore
+    // conditional headers respond with 200, but also with the same validators). ETag is stronger, use it if known.
+    if (_hasEtag)
+        return (strcmp(_etag, this->_etag) == 0);
+
+    return (strcmp(_lastModified, this->_lastModified) == 0);
+}
+
+/**
+ * @brief   Returns the ETag from the last HEAD response.
+ *
+ * @return  char*
+ *          ETag (with quotes, as sent by the server). Empty string if the server did not send it.
+ */
+char *WiFiClient::getETag()
+{
+    return _etag;
+}
+
+/**
+ * @brief   Returns the Last-Modified from the last HEAD response.
+ *
+ * @return  char*
+ *          Last-Modified date (as sent by the server). Empty string if the server did not send it.
+ */
+char *WiFiClient::getLastModified()
+{
+    return _lastModified;
+}
 
 /**
  * @brief   Method returns available bytes to read (and also checks for the new data).
+ *          gzip response is decoded here, so only the decoded data is returned.
  *
  * @param   bool _blocking
  *          Checking for new data can be done with blocking method. If blocking method is used,
@@ -138,13 +315,18 @@ bool WiFiClient::POST(const char *_body, uint16_t _bodyLen)
  *          non-blocking method is used, it's up to the user to ensure timeout and data receive
  *          end event.
  * @return  int
- *          Number of bytes available for read.
+ *          Number of bytes available for read. 0 if there is no more data or the gzip response is broken
+ *          (check with WiFiClient::error()).
  */
 int WiFiClient::available(bool _blocking)
 {
     // Only get new data if the current buffer is empty.
     if (_bufferLen == 0)
     {
+        // gzip response? Decode the next part of it.
+        if (_inflate != NULL)
+            return inflateChunk(_blocking);
+
         // Calculate the timeout value for new data. If blocking method is enabled,
         // use longer timeout value. Otherwise, use shorter timeout value (but in this case user
         // must create some kind of mechanism to know when all data has been received).
@@ -158,6 +340,12 @@ int WiFiClient::available(bool _blocking)
         {
             _bufferLen += _len;
             _currentPos = _dataBuffer;
+            _received += _len;
+        }
+        else if (_blocking && (_fileSize == 0))
+        {
+            // No more data and the server did not send the size (chunked response)? Now the size is known.
+            _fileSize = _received;
         }
     }
 
@@ -169,7 +357,8 @@ int WiFiClient::available(bool _blocking)
  * @brief   Copy chunk of received data into the user-defined buffer.
  *
  * @param   char *_buffer
- *          Pointer to the user-defined buffer.
+ *          Pointer to the user-defined buffer. If NULL, bytes are skipped (removed from
+ *          the internal buffer without copying).
  * @param   uint16_t _len
  *          Number of bytes needed to be copied to the user defined buffer.
  * @return  uint16_t
@@ -189,8 +378,9 @@ uint16_t WiFiClient::read(char *_buffer, uint16_t _len)
     if (_len > _bufferLen)
         _len = _bufferLen;
 
-    // Copy data from internal buffer to the provided oone.
-    memcpy(_buffer, _currentPos, _len);
+    // Copy data from internal buffer to the provided oone (if there is one).
+    if (_buffer != NULL)
+        memcpy(_buffer, _currentPos, _len);
 
     // Update the variables for offset and data length.
     _bufferLen -= _len;
@@ -226,6 +416,36 @@ char WiFiClient::read()
     return _c;
 }
 
+/**
+ * @brief   Copy received data into the user-defined buffer without removing it from the internal
+ *          buffer. Next read() will return the same data. Used for checking the file signature
+ *          before deciding how to handle the rest of the file.
+ *
+ * @param   char *_buffer
+ *          Pointer to the user-defined buffer.
+ * @param   uint16_t _len
+ *          Number of bytes needed to be copied to the user defined buffer.
+ * @return  uint16_t
+ *          Actual number of bytes copied (only data already received is copied, no new data is
+ *          requested from the modem).
+ */
+uint16_t WiFiClient::peek(char *_buffer, uint16_t _len)
+{
+    // If there is no new data, return 0.
+    if ((_currentPos == NULL) || (_buffer == NULL))
+        return 0;
+
+    // Constrain the length to the received data length.
+    if (_len > _bufferLen)
+        _len = _bufferLen;
+
+    // Copy the data, but do not move the read position.
+    memcpy(_buffer, _currentPos, _len);
+
+    // Return the actual length.
+    return _len;
+}
+
 /**
  * @brief   End HTTP transfer. Disable all message filters enabled in WiFi::connect() and
  *          turn on echo on commands (in other words, set everything back to normal).
@@ -248,7 +468,11 @@ bool WiFiClient::end()
     // Clear HTTP POST Send Ok message filter.
     WiFi.messageFilter(false, NULL, "\r\nSEND OK\r\n");
 
+    // Release the gzip decoder.
+    stopInflate();
+
     // Clear all HTTP headers.
+    _gzipHeaderAdded = false;
     if (!addHeader(NULL))
         return false;
 
@@ -258,9 +482,11 @@ bool WiFiClient::end()
 
 /**
  * @brief   Method returns file sizue in bytes (if available).
- *          Some clients do not report file size.
+ *          Some clients do not report file size (chunked response). For chunked and gzip responses size is
+ *          known (size of the decoded data) after the whole response is read.
  *
- * @return int
+ * @return  int
+ *          File size in bytes, 0 if it's not known (yet).
  */
 int WiFiClient::size()
 {
@@ -295,6 +521,76 @@ bool WiFiClient::addHeader(char *_header)
     return true;
 }
 
+/**
+ * @brief   Find ETag and Last-Modified in the HEAD response (+HTTPCLIENT:<len>,<header> lines) and save
+ *          their values. Values that are too long are ignored.
+ *
+ * @param   char *_response
+ *          Response from the modem.
+ * @param   uint32_t _len
+ *          Length of the response in bytes.
+ */
+void WiFiClient::parseValidators(char *_response, uint32_t _len)
+{
+    AtUrcParser _parser;
+    AtUrcEvent _event;
+
+    // Go through all headers.
+    const uint8_t *_data = (const uint8_t *)_response;
+    while (_len != 0)
+    {
+        uint32_t _used = _parser.parse(_data, _len, &_event);
+        _data += _used;
+        _len -= _used;
+
+        // Only complete headers in one piece are used (they are never split, whole response is in the buffer).
+        if ((_event.event != INKPLATE_ESP32_URC_EVENT_PAYLOAD) || (_event.type != INKPLATE_ESP32_URC_TYPE_HTTPCLIENT) ||
+            (_event.len != _event.frameLen))
+            continue;
+        char *_header = (char *)_event.data;
+        int _headerLen = _event.len;
+
+        // Check the header name.
+        char *_dst = NULL;
+        int _nameLen = 0;
+        if ((_headerLen >= 5) && (strncasecmp(_header, "ETag:", 5) == 0))
+        {
+            _dst = _etag;
+            _nameLen = 5;
+        }
+        else if ((_headerLen >= 14) && (strncasecmp(_header, "Last-Modified:", 14) == 0))
+        {
+            _dst = _lastModified;
+            _nameLen = 14;
+        }
+
+        // Not needed or broken header? Skip it.
+        if ((_dst == NULL) || (_headerLen < _nameLen))
+            continue;
+
+        // Skip the spaces after the name and copy the value.
+        char *_value = _header + _nameLen;
+        int _valueLen = _headerLen - _nameLen;
+        while ((_valueLen > 0) && (*_value == ' '))
+        {
+            _value++;
+            _valueLen--;
+        }
+
+        // Also remove spaces and line endings at the end (if they are counted in the length).
+        while ((_valueLen > 0) && ((_value[_valueLen - 1] == ' ') || (_value[_valueLen - 1] == '\r') ||
+                                   (_value[_valueLen - 1] == '\n')))
+        {
+            _valueLen--;
+        }
+        if (_valueLen < INKPLATE_ESP32_HTTP_VALIDATOR_SIZE)
+        {
+            memcpy(_dst, _value, _valueLen);
+            _dst[_valueLen] = '\0';
+        }
+    }
+}
+
 /**
  * @brief   Execute AT command for getting file size (in bytes).
  *          It also can be used as client connection. Call it before HTTP Get.
@@ -319,10 +615,10 @@ int WiFiClient::getFileSize(char *_url, uint32_t _timeout)
                                         INKPLATE_ESP32_AT_EXPECTED_RESPONSE_START, true, NULL, 0, 0, NULL))
         return false;
 
-    // Parse the reponse. Return 0 if something failed.
+    // Parse the reponse. Return 0 if something failed or if the size is not known (negative for chunked response).
     if (strstr(_dataBuffer, "+HTTPGETSIZE:"))
     {
-        if (sscanf(_dataBuffer, "+HTTPGETSIZE:%d", &_size) != 1)
+        if ((sscanf(_dataBuffer, "+HTTPGETSIZE:%d", &_size) != 1) || (_size < 0))
             return 0;
     }
 
@@ -348,55 +644,26 @@ int WiFiClient::getFileSize(char *_url, uint32_t _timeout)
  */
 int WiFiClient::cleanHttpGetResponse(char *_response, uint16_t *_cleanedSize)
 {
-    // Set the pointer for search.
-    char *_startOfResponse = _response;
+    AtUrcParser _parser;
+    AtUrcEvent _event;
 
     // Set the variable for the complete length of the cleaned data.
     *_cleanedSize = 0;
 
-    char *_writePointer = _response;
-
-    while (_startOfResponse != NULL)
+    // Data parts are moved to the start of the response (write position is never after the read position).
+    const uint8_t *_data = (const uint8_t *)_response;
+    uint32_t _len = strlen(_response);
+    while (_len != 0)
     {
-        // Variable that holds the data part legnth of each chunk.
-        int _dataChunkLen = 0;
-
-        // Try to find the start of the HTTP response (+HTTPCGET:<len>,<data>CRLF).
-        _startOfResponse = strstr(_startOfResponse, "+HTTPCGET:");
+        uint32_t _used = _parser.parse(_data, _len, &_event);
+        _data += _used;
+        _len -= _used;
 
-        // If nothing is found, stop the clean process.
-        if (_startOfResponse == NULL)
-            break;
-
-        // Try to parse the length of the data part. If failed, move the pointer and keep looking.
-        if (sscanf(_startOfResponse, "+HTTPCGET:%d,", &_dataChunkLen) == 1)
+        if ((_event.event == INKPLATE_ESP32_URC_EVENT_PAYLOAD) && (_event.type == INKPLATE_ESP32_URC_TYPE_HTTPCGET))
         {
-            // Try to find the comma fter the length.
-            char *_commaPos = strstr(_startOfResponse, ",");
-
-            // If is found and it's 12 to 15 places after the start position it is valid.
-            if ((_commaPos != NULL) && (_commaPos - _startOfResponse) <= 15)
-            {
-                // Check if is vaild. It must find \r\n at the end of the data.
-                char _crChar = *(_commaPos + 1 + _dataChunkLen);
-                char _lfChar = *(_commaPos + 1 + _dataChunkLen + 1);
-
-                if ((_crChar == '\r') && (_lfChar == '\n'))
-                {
-                    // Move all data at proper position.
-                    memmove(_writePointer, _commaPos + 1, _dataChunkLen);
-
-                    // Update the variable for the cleaned data length.
-                    (*_cleanedSize) += _dataChunkLen;
-
-                    // Move the write pointer.
-                    _writePointer += _dataChunkLen;
-                }
-            }
+            memmove(_response + *_cleanedSize, _event.data, _event.len);
+            (*_cleanedSize) += _event.len;
         }
-
-        // move the pointer.
-        _startOfResponse++;
     }
 
     if (*_cleanedSize == 0)
@@ -423,33 +690,389 @@ uint32_t WiFiClient::downloadFile(const char *_url, volatile uint8_t *_downloade
     if (!begin(_url))
         return 0;
 
-    // Now make a GET request
-    if (!GET())
+    // Now make a GET request. File is saved as it is, so the compressed response is not allowed here.
+    bool _gzip = _acceptGzip;
+    _acceptGzip = false;
+    bool _getOk = GET();
+    _acceptGzip = _gzip;
+    if (!_getOk)
+    {
+        end();
         return 0;
+    }
+
+    // Copy the whole response into the buffer.
+    return readToBuffer(_downloadedFile, _maxFileSize);
+}
+
+/**
+ * @brief   Read the rest of the HTTP response (started with WiFiClient::GET()) into the given buffer
+ *          and end the transfer. Data is copied from the internal buffer directly into the destination
+ *          buffer, chunk by chunk.
+ *
+ * @param   volatile uint8_t* _downloadedFile
+ *          Pointer to the volatile memory buffer where the file will be stored
+ * @param   uint32_t _maxFileSize
+ *          Maximum allowable size for the downloaded file
+ * @return  uint32_t
+ *          The size of the downloaded file in bytes, or 0 if an error occurred (or file is too big)
+ */
+uint32_t WiFiClient::readToBuffer(volatile uint8_t *_downloadedFile, uint32_t _maxFileSize)
+{
+    // Number of bytes copied so far.
+    uint32_t _totalDownloaded = 0;
 
-    // Check if file size exceeds buffer size
+    // Check if file size exceeds buffer size.
     if (_fileSize > _maxFileSize)
+    {
+        end();
+        return 0;
+    }
+
+    // Copy every received chunk into the download file buffer.
+    while (available() > 0)
+    {
+        // Check if the file still fits into the buffer.
+        if ((_totalDownloaded + _bufferLen) > _maxFileSize)
+        {
+            end();
+            return 0;
+        }
+
+        // No need for the temp. buffer, copy it to the destination (casting to non-volatile for memcpy).
+        _totalDownloaded += read((char *)_downloadedFile + _totalDownloaded, _bufferLen);
+    }
+
+    // Disable message filters.
+    end();
+
+    // Broken gzip response? File is not complete.
+    if (_inflateError)
+        return 0;
+
+    // Return the file size.
+    return _totalDownloaded;
+}
+
+/**
+ * @brief   Download a file over HTTP/HTTPS directly into the file on the microSD card (file size is not limited
+ *          by the RAM or SDRAM). Received data is collected in the RAM buffer and written to the card in
+ *          512 byte aligned multi-sector writes while the card is not busy, so writing to the card does not slow
+ *          down the download. File is preallocated (contiguous) if the server sends the file size.
+ *
+ * @param   const char* _url
+ *          URL of the file to be downloaded.
+ * @param   SdFat *_sd
+ *          Pointer to the initialized SdFat object (inkplate.sdFat).
+ * @param   const char *_path
+ *          Path of the file on the microSD card.
+ * @param   bool _resume
+ *          true - If the file already exists, download only the rest of it (HTTP Range request). If the server does
+ *          not support Range, already downloaded part is skipped.
+ *          false - Always download the whole file (existing file is overwritten).
+ * @param   WiFiDownloadCallback _progressCallback
+ *          Function called after each received data chunk with the number of bytes in the file and the file size.
+ *          Can be NULL.
+ * @return  uint32_t
+ *          Size of the file on the microSD card in bytes, or 0 if an error occurred (or download is incomplete).
+ * @note    Incomplete file stays on the microSD card, so the download can be resumed with the next call.
+ */
+uint32_t WiFiClient::downloadToFile(const char *_url, SdFat *_sd, const char *_path, bool _resume,
+                                    WiFiDownloadCallback _progressCallback)
+{
+    // Check for user mistake (null-pointer!).
+    if ((_url == NULL) || (_sd == NULL) || (_path == NULL))
+        return 0;
+
+    // Begin HTTP with the given URL.
+    if (!begin(_url))
+        return 0;
+
+    // Get the size of the whole file (zero if the server does not send it).
+    uint32_t _total = getFileSize(_urlStr, 30000ULL);
+
+    // Open the file (or create it if it does not exist).
+    File _file = _sd->open(_path, O_RDWR | O_CREAT);
+    if (!_file)
         return 0;
 
-    uint32_t totalDownloaded = 0;
+    // Check how much of the file is already downloaded. Resume is possible only if the file size is known.
+    uint32_t _offset = _resume ? _file.fileSize() : 0;
+    if ((_offset > _total) || (_total == 0))
+        _offset = 0;
 
-    // Let's now copy the file to the download file buffer
-    while (available())
+    // Whole file is already on the card? Nothing to download.
+    if ((_offset != 0) && (_offset == _total))
     {
-        if (available() > 0)
+        _file.close();
+        if (_progressCallback != NULL)
+            _progressCallback(_total, _total);
+        return _total;
+    }
+
+    if (_offset == 0)
+    {
+        // Start from scratch. Preallocate the file for the faster write (if it fails, card is too fragmented,
+        // but the download still can be done).
+        _file.truncate(0);
+        if (_total != 0)
+            _file.preAllocate(_total);
+    }
+    else
+    {
+        // Continue at the end of the file, ask only for the rest of it.
+        char _header[40];
+        sprintf(_header, "Range: bytes=%lu-", (unsigned long)_offset);
+        if (!_file.seekSet(_offset) || !addHeader(_header))
         {
-            char myBuffer[2000];
-            int n = read(myBuffer, sizeof(myBuffer));
+            end();
+            _file.close();
+            return 0;
+        }
+    }
 
-            if (totalDownloaded + n > _maxFileSize)
-                return 0;
+    // Make a GET request. It also gets the size of the response (with the Range header). File must be saved as it is,
+    // so the compressed response is not allowed here.
+    bool _gzip = _acceptGzip;
+    _acceptGzip = false;
+    bool _getOk = GET();
+    _acceptGzip = _gzip;
+    if (!_getOk)
+    {
+        end();
+        _file.close();
+        return 0;
+    }
 
-            // Copy the chunk to _downloadedFile, casting to non-volatile for memcpy
-            memcpy((uint8_t *)_downloadedFile + totalDownloaded, myBuffer, n);
-            totalDownloaded += n;
+    // Check if the server sent only the rest of the file. If it ignored the Range header, whole file is sent, so skip
+    // the part that is already on the card. Anything else means the file is changed, start again with the next call.
+    uint32_t _skip = 0;
+    if ((_offset != 0) && (_fileSize != (_total - _offset)))
+    {
+        if (_fileSize != _total)
+        {
+            end();
+            _file.truncate(0);
+            _file.close();
+            return 0;
+        }
+        _skip = _offset;
+    }
+
+    // Use the ring buffer with this file.
+    _fileRingBuffer.begin(&_file);
+
+    // Number of bytes in the file (on the card and in the buffer) and position of the last file sync.
+    uint32_t _downloaded = _offset;
+    uint32_t _lastSync = _offset;
+    bool _ok = true;
+
+    // Copy every received chunk into the buffer, write it to the card when the card is not busy.
+    while (_ok && (available() > 0))
+    {
+        // Drop the data that is already on the card.
+        if (_skip != 0)
+        {
+            _skip -= read(NULL, (_skip < _bufferLen) ? _skip : _bufferLen);
+            continue;
+        }
+
+        // Not enough space in the buffer? Card is too slow, write to the card until there is enough space.
+        while (_ok && (_fileRingBuffer.bytesFree() < _bufferLen))
+        {
+            // Write size is shorter for the first write after resume, so all next writes start at the sector start.
+            _ok = (_fileRingBuffer.writeOut(INKPLATE_ESP32_HTTP_FILE_WRITE_SIZE - (_file.curPosition() % 512)) != 0);
+        }
+        if (!_ok)
+            break;
+
+        // Move the data chunk into the buffer.
+        _fileRingBuffer.write(_currentPos, _bufferLen);
+        _downloaded += read(NULL, _bufferLen);
+
+        // Write enough data for the multi-sector write, but only if the card is not busy with the previous write.
+        if ((_fileRingBuffer.bytesUsed() >= INKPLATE_ESP32_HTTP_FILE_WRITE_SIZE) && !_file.isBusy())
+        {
+            _ok = (_fileRingBuffer.writeOut(INKPLATE_ESP32_HTTP_FILE_WRITE_SIZE - (_file.curPosition() % 512)) != 0);
+        }
+
+        // Save the file size on the card from time to time, so the download can be resumed after reset.
+        if (_ok && ((uint32_t)_file.curPosition() - _lastSync) >= INKPLATE_ESP32_HTTP_FILE_SYNC_SIZE)
+        {
+            _lastSync = _file.curPosition();
+            _ok = _file.sync();
         }
+
+        // Report the progress.
+        if (_progressCallback != NULL)
+            _progressCallback(_downloaded, _total);
     }
+
+    // Disable message filters and remove the Range header.
     end();
 
-    return totalDownloaded;
+    // Write the rest of the data and remove the unused preallocated space.
+    _ok = _ok && _fileRingBuffer.sync();
+    _file.truncate();
+    _ok = _file.close() && _ok;
+
+    // Check if the download is complete (if the file size is known).
+    if (!_ok || (_skip != 0) || ((_total != 0) && (_downloaded != _total)) || (_downloaded == 0))
+        return 0;
+
+    // Return the file size.
+    return _downloaded;
+}
+
+/**
+ * @brief   Enable or disable the gzip compressed responses for the GET requests (disabled by default). Compressed
+ *          response is decoded on the fly, so read() and available() return the decoded data. Text responses
+ *          (JSON, HTML, SVG) are usually 5 to 10 times smaller when compressed. WiFiClient::downloadFile() and
+ *          WiFiClient::downloadToFile() always save the file as it is.
+ *
+ * @param   bool _enable
+ *          true - Send "Accept-Encoding: gzip" with the request and decode the gzip response.
+ *          false - Do not send it, data is returned as it is.
+ * @note    Server response headers are not available, so only responses to the requests that asked for gzip are
+ *          decoded, and only if they start with the gzip signature. Keep it disabled for the URLs of the .gz files,
+ *          otherwise they will be decompressed.
+ */
+void WiFiClient::acceptGzip(bool _enable)
+{
+    _acceptGzip = _enable;
+}
+
+/**
+ * @brief   Check if the response data is broken (gzip response that can't be decoded, that ended too early, or
+ *          whose CRC32 or size in the gzip trailer do not match the decoded data). available() and read() return 0
+ *          after the error.
+ *
+ * @return  bool
+ *          true - Response is broken, data read so far must not be used.
+ *          false - No error.
+ */
+bool WiFiClient::error()
+{
+    return _inflateError;
+}
+
+/**
+ * @brief   Start the gzip decoder for the response. First data chunk (with gzip header) is already in the buffer.
+ *
+ * @param   uint16_t _len
+ *          Size of the first data chunk in bytes.
+ * @return  bool
+ *          true - Decoder is started.
+ *          false - Not enough memory for the decoder.
+ */
+bool WiFiClient::startInflate(uint16_t _len)
+{
+    // Allocate memory for the decoder (it's around 43kB, so it's allocated only when it's needed).
+    if (_inflate == NULL)
+        _inflate = (GzipInflater *)malloc(sizeof(GzipInflater));
+    if (_inflate == NULL)
+        return false;
+
+    // Skip the gzip header, rest of the chunk is compressed data.
+    uint16_t _headerSize = GzipInflater::headerSize((uint8_t *)_dataBuffer, _len);
+    _inflatePos = _dataBuffer + _headerSize;
+    _inflateLen = _len - _headerSize;
+
+    // Init the decoder.
+    _inflate->begin();
+
+    // Size of the decoded data is not known until the end.
+    _fileSize = 0;
+    _received = 0;
+    _bufferLen = 0;
+
+    // Decode the first part of the data.
+    inflateChunk(true);
+
+    return true;
+}
+
+/**
+ * @brief   Decode the next part of the gzip response. Compressed data is received from the modem if needed.
+ *
+ * @param   bool _blocking
+ *          true - Wait up to 2.5 seconds for the new data.
+ *          false - Wait only 20 milliseconds for the new data.
+ * @return  uint16_t
+ *          Number of the decoded bytes available for read. 0 if there is no more data (or data is broken, see
+ *          WiFiClient::error()).
+ */
+uint16_t WiFiClient::inflateChunk(bool _blocking)
+{
+    while (!_inflate->done() && !_inflateError)
+    {
+        // Get the next part of the compressed data if everything is already decoded.
+        if (_inflateLen == 0)
+        {
+            uint16_t _len = 0;
+            if (!WiFi.getSimpleAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, _blocking ? 2500ULL : 20ULL,
+                                          &_len) ||
+                (_len == 0))
+            {
+                // Compressed data or the trailer ended before the end of the stream? Response is not complete.
+                if (_blocking)
+                    _inflateError = true;
+                return 0;
+            }
+
+            _inflatePos = _dataBuffer;
+            _inflateLen = _len;
+        }
+
+        // Decode as much as possible. Decoded data is used directly from the decoder.
+        uint32_t _inBytes = _inflateLen;
+        const uint8_t *_out = NULL;
+        uint32_t _outBytes = 0;
+        bool _ok = _inflate->decode((const uint8_t *)_inflatePos, &_inBytes, &_out, &_outBytes);
+        _inflatePos += _inBytes;
+        _inflateLen -= _inBytes;
+
+        // Broken data, or CRC32 or size in the gzip trailer do not match? Decoded data must not be used.
+        if (!_ok)
+        {
+            _inflateError = true;
+            _bufferLen = 0;
+            return 0;
+        }
+
+        _currentPos = (char *)_out;
+        _bufferLen = _outBytes;
+        _received += _outBytes;
+
+        // End of the gzip stream (with the valid trailer)? Now the size is known. Data after it is ignored.
+        if (_inflate->done())
+        {
+            _fileSize = _received;
+            _inflateLen = 0;
+        }
+
+        // Return new decoded data (if there is any).
+        if (_bufferLen != 0)
+            return _bufferLen;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Stop the gzip decoder and release its memory.
+ *
+ */
+void WiFiClient::stopInflate()
+{
+    // Nothing to do if the decoder is not used.
+    if (_inflate == NULL)
+        return;
+
+    // Decoded data in the dictionary is gone as well.
+    free(_inflate);
+    _inflate = NULL;
+    _inflateLen = 0;
+    _bufferLen = 0;
+    _currentPos = NULL;
 }
@@ -20,6 +20,35 @@
 // Include main ESP32-C3 AT SPI library.
 #include "esp32SpiAt.h"
 
+// Include SdFat library for the download directly into the file.
+#include "../../features/SdFat/SdFat.h"
+
+// Max. size of the HTTP validator (ETag or Last-Modified header value) with null-terminating char.
+#define INKPLATE_ESP32_HTTP_VALIDATOR_SIZE 64
+
+// Timeout for the HTTP HEAD request (in milliseconds).
+#define INKPLATE_ESP32_HTTP_HEAD_TIMEOUT 30000ULL
+
+// Size of the RAM buffer between the WiFi and the microSD card for WiFiClient::downloadToFile() (two halves, each
+// one can hold the largest data chunk received from the modem).
+#define INKPLATE_ESP32_HTTP_FILE_BUFFER_SIZE (2 * INKPLATE_ESP32_AT_CMD_BUFFER_SIZE)
+
+// Size of one multi-sector write to the microSD card (must be multiple of 512 bytes).
+#define INKPLATE_ESP32_HTTP_FILE_WRITE_SIZE 8192ULL
+
+// Downloaded file is synced (file size saved on the microSD card for resume) after this many bytes.
+#define INKPLATE_ESP32_HTTP_FILE_SYNC_SIZE (256 * 1024ULL)
+
+// Header sent with every GET request if the gzip response is allowed.
+#define INKPLATE_ESP32_HTTP_ACCEPT_GZIP "Accept-Encoding: gzip"
+
+// gzip decoder (see esp32SpiAtGzip.h, allocated only while gzip response is read).
+class GzipInflater;
+
+
+// Callback for the download progress. Total size is zero if server did not send the file size.
+typedef void (*WiFiDownloadCallback)(uint32_t _downloaded, uint32_t _total);
+
 // Class for HTTP over SPI AT commands.
 class WiFiClient
 {
@@ -29,23 +58,52 @@ class WiFiClient
     // bool connect(const char *_url);
     bool GET();
     bool POST(const char *_body = NULL, uint16_t _bodyLen = 0);
+    bool HEAD();
+    bool notModified(const char *_etag, const char *_lastModified);
+    char *getETag();
+    char *getLastModified();
     int available(bool _blocking = true);
     uint16_t read(char *_buffer, uint16_t _len);
     char read();
+    uint16_t peek(char *_buffer, uint16_t _len);
     bool end();
     int size();
     bool addHeader(char *_header);
     uint32_t downloadFile(const char *_url, volatile uint8_t *_downloadedFile, uint32_t _maxFileSize);
+    uint32_t readToBuffer(volatile uint8_t *_downloadedFile, uint32_t _maxFileSize);
+    uint32_t downloadToFile(const char *_url, SdFat *_sd, const char *_path, bool _resume = true,
+                            WiFiDownloadCallback _progressCallback = NULL);
+    void acceptGzip(bool _enable);
+    bool error();
 
   private:
     int cleanHttpGetResponse(char *_buffer, uint16_t *_len);
     int getFileSize(char *_url, uint32_t _timeout);
+    void parseValidators(char *_response, uint32_t _len);
+    bool startInflate(uint16_t _len);
+    uint16_t inflateChunk(bool _blocking);
+    void stopInflate();
 
     uint16_t _bufferLen = 0;
     char *_currentPos = NULL;
     char *_dataBuffer = NULL;
     uint32_t _fileSize = 0;
     char *_urlStr = NULL;
+
+    // Number of bytes of the response body received so far (after gzip decoding).
+    uint32_t _received = 0;
+
+    // gzip decoding. Compressed data waits in the WiFi data buffer, decoded data is in the decoder dictionary.
+    bool _acceptGzip = false;
+    bool _gzipHeaderAdded = false;
+    GzipInflater *_inflate = NULL;
+    char *_inflatePos = NULL;
+    uint16_t _inflateLen = 0;
+    bool _inflateError = false;
+
+    // Validators from the last HEAD response (empty if server did not send them).
+    char _etag[INKPLATE_ESP32_HTTP_VALIDATOR_SIZE];
+    char _lastModified[INKPLATE_ESP32_HTTP_VALIDATOR_SIZE];
 };
 
 #endif
\ No newline at end of file
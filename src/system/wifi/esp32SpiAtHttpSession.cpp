@@ -0,0 +1,681 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtHttpSession.cpp
+ * @brief       Source file for the HTTP/1.1 requests over the raw
+ *              TCP/SSL connection (WiFiTCP). Connection is kept open
+ *              (keep-alive) and used for all requests to the same host.
+ *              Response body can be sent with Content-Length, chunked
+ *              or until the connection is closed.
+ *              This file is used with esp32SpiAt library.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include main header file for the HTTP session.
+#include "esp32SpiAtHttpSession.h"
+
+/**
+ * @brief   Check if the header value has the word in it (case insensitive).
+ *
+ * @param   const char *_value
+ *          Null-terminated header value.
+ * @param   const char *_word
+ *          Word to look for.
+ * @return  bool
+ *          true - Word is found.
+ *          false - Word is not found.
+ */
+static bool esp32HttpHeaderHas(const char *_value, const char *_word)
+{
+    size_t _wordLen = strlen(_word);
+    for (; *_value != '\0'; _value++)
+    {
+        if (strncasecmp(_value, _word, _wordLen) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Construct for a new WiFiHTTPSession object.
+ *
+ */
+WiFiHTTPSession::WiFiHTTPSession()
+{
+    _host[0] = '\0';
+}
+
+/**
+ * @brief   Set the host for all requests of the session. Connection is opened with the first request and kept
+ *          open until end() is called (or until the host closes it, then it's opened again on the next request).
+ *
+ * @param   const char *_hostName
+ *          Host name or IP address (without "http://").
+ * @param   uint16_t _hostPort
+ *          Host port (80 for HTTP, 443 for HTTPS).
+ * @param   bool _useSsl
+ *          true - Use SSL (HTTPS).
+ *          false - Use plain TCP (HTTP).
+ * @return  bool
+ *          true - Host is set.
+ *          false - Host name is too long.
+ */
+bool WiFiHTTPSession::begin(const char *_hostName, uint16_t _hostPort, bool _useSsl)
+{
+    // Check the host name length.
+    if (strlen(_hostName) >= sizeof(_host))
+        return false;
+
+    // New host, close the connection to the old one.
+    end();
+
+    // Save the host.
+    strcpy(_host, _hostName);
+    _port = _hostPort;
+    _ssl = _useSsl;
+
+    return true;
+}
+
+/**
+ * @brief   Send the GET request and read the response header. Body is read with read().
+ *
+ * @param   const char *_path
+ *          Path of the resource (for example "/index.html").
+ * @param   const char *_headers
+ *          Additional request headers, each ending with "\r\n" (optional).
+ * @return  int
+ *          HTTP status code or -1 if the request failed.
+ */
+int WiFiHTTPSession::GET(const char *_path, const char *_headers)
+{
+    return request("GET", _path, _headers, NULL, 0);
+}
+
+/**
+ * @brief   Send the POST request and read the response header. Body is read with read().
+ *
+ * @param   const char *_path
+ *          Path of the resource.
+ * @param   const uint8_t *_body
+ *          Body of the request.
+ * @param   uint32_t _bodyLen
+ *          Length of the body in bytes.
+ * @param   const char *_headers
+ *          Additional request headers, each ending with "\r\n" (optional, for example Content-Type).
+ * @return  int
+ *          HTTP status code or -1 if the request failed.
+ */
+int WiFiHTTPSession::POST(const char *_path, const uint8_t *_body, uint32_t _bodyLen, const char *_headers)
+{
+    return request("POST", _path, _headers, _body, _bodyLen);
+}
+
+/**
+ * @brief   Send the HEAD request and read the response header.
+ *
+ * @param   const char *_path
+ *          Path of the resource.
+ * @param   const char *_headers
+ *          Additional request headers, each ending with "\r\n" (optional).
+ * @return  int
+ *          HTTP status code or -1 if the request failed.
+ */
+int WiFiHTTPSession::HEAD(const char *_path, const char *_headers)
+{
+    return request("HEAD", _path, _headers, NULL, 0);
+}
+
+/**
+ * @brief   Get the status code of the last response.
+ *
+ * @return  int
+ *          HTTP status code or -1 if there is no response.
+ */
+int WiFiHTTPSession::statusCode()
+{
+    return _statusCode;
+}
+
+/**
+ * @brief   Get the Content-Length of the last response.
+ *
+ * @return  int32_t
+ *          Length of the body in bytes or -1 if it's not known (chunked or until the connection is closed).
+ */
+int32_t WiFiHTTPSession::contentLength()
+{
+    return _contentLength;
+}
+
+/**
+ * @brief   Read the response body. Chunked body is decoded. Method waits for the data (up to the timeout) until
+ *          the buffer is full or until the end of the body.
+ *
+ * @param   uint8_t *_buffer
+ *          Pointer to buffer where to store data.
+ * @param   uint32_t _len
+ *          Size of the buffer.
+ * @return  int
+ *          How many bytes are read (0 - end of the body).
+ */
+int WiFiHTTPSession::read(uint8_t *_buffer, uint32_t _len)
+{
+    uint32_t _total = 0;
+
+    while ((_total < _len) && !_bodyDone)
+    {
+        // Start of the next chunk?
+        if ((_bodyMode == BODY_CHUNKED) && (_bodyLeft == 0))
+        {
+            if (!nextChunk())
+                break;
+            continue;
+        }
+
+        // Do not read after the end of the body (or the current chunk).
+        uint32_t _partLen = _len - _total;
+        if ((_bodyMode != BODY_CLOSE) && (_partLen > _bodyLeft))
+            _partLen = _bodyLeft;
+
+        // Use the data received with the header first, then read straight into the buffer.
+        int _readLen = 0;
+        if (_pendingLen != 0)
+        {
+            _readLen = _partLen < _pendingLen ? _partLen : _pendingLen;
+            memcpy(_buffer + _total, _sessionBuffer + _pendingStart, _readLen);
+            _pendingStart += _readLen;
+            _pendingLen -= _readLen;
+        }
+        else
+        {
+            _readLen = readTcp(_buffer + _total, _partLen);
+        }
+
+        // No more data. It's the end of the body only if the body is sent until the connection is closed.
+        if (_readLen <= 0)
+        {
+            if (_bodyMode != BODY_CLOSE)
+                _keepAlive = false;
+            _bodyDone = true;
+            break;
+        }
+
+        _total += _readLen;
+        if (_bodyMode != BODY_CLOSE)
+        {
+            _bodyLeft -= _readLen;
+            if ((_bodyMode == BODY_LENGTH) && (_bodyLeft == 0))
+                _bodyDone = true;
+        }
+    }
+
+    return _total;
+}
+
+/**
+ * @brief   Check if the whole response body has been read.
+ *
+ * @return  bool
+ *          true - Whole body is read (or the response has no body).
+ *          false - There is more body data.
+ */
+bool WiFiHTTPSession::bodyDone()
+{
+    return _bodyDone;
+}
+
+/**
+ * @brief   Close the connection to the host.
+ *
+ */
+void WiFiHTTPSession::end()
+{
+    _tcp.stop();
+    _keepAlive = false;
+    _bodyDone = true;
+    _pendingLen = 0;
+}
+
+/**
+ * @brief   Get the number of connections opened so far. With keep-alive, many requests use one connection.
+ *
+ * @return  uint32_t
+ *          Number of opened connections.
+ */
+uint32_t WiFiHTTPSession::connectionCount()
+{
+    return _connections;
+}
+
+/**
+ * @brief   Sets response timeout in milliseconds.
+ *
+ * @param   uint32_t _responseTimeout
+ *          Max. time without any response data in milliseconds.
+ */
+void WiFiHTTPSession::setTimeout(uint32_t _responseTimeout)
+{
+    _timeout = _responseTimeout;
+}
+
+/**
+ * @brief   Sends the request and reads the response header. Open connection is used if possible. If the host closed
+ *          it in the meantime, new connection is opened and the request is sent again.
+ *
+ * @param   const char *_method
+ *          HTTP method ("GET", "POST", "HEAD"...).
+ * @param   const char *_path
+ *          Path of the resource.
+ * @param   const char *_headers
+ *          Additional request headers (can be NULL).
+ * @param   const uint8_t *_body
+ *          Body of the request (can be NULL).
+ * @param   uint32_t _bodyLen
+ *          Length of the body in bytes.
+ * @return  int
+ *          HTTP status code or -1 if the request failed.
+ */
+int WiFiHTTPSession::request(const char *_method, const char *_path, const char *_headers, const uint8_t *_body,
+                             uint32_t _bodyLen)
+{
+    // Host must be set.
+    if (_host[0] == '\0')
+        return -1;
+
+    // Read the rest of the last response, so the new response starts at the right place.
+    skipBody();
+
+    // Host asked to close the connection after the last response.
+    if (!_keepAlive)
+        _tcp.stop();
+
+    // Session buffer is used for the request, anything left from the last response is dropped (requests are not
+    // pipelined, so there should not be anything).
+    _pendingStart = 0;
+    _pendingLen = 0;
+
+    // Response to the HEAD request never has a body.
+    bool _noBody = (strcmp(_method, "HEAD") == 0);
+
+    // Two tries - open connection could be closed by the host in the meantime.
+    for (int i = 0; i < 2; i++)
+    {
+        bool _reused = (_tcp.linkId() >= 0);
+
+        // Open the new connection if needed.
+        if (!_reused)
+        {
+            if (!_tcp.connect(_host, _port, _ssl))
+                break;
+            _connections++;
+        }
+
+        // Send the request and get the response header.
+        if (sendRequest(_method, _path, _headers, _body, _bodyLen) && readHeader(_noBody))
+            return _statusCode;
+
+        // Failed, close the connection. Try again only if the old connection was used.
+        _tcp.stop();
+        if (!_reused)
+            break;
+    }
+
+    // Request failed.
+    _statusCode = -1;
+    _bodyDone = true;
+    return -1;
+}
+
+/**
+ * @brief   Creates the request header and sends it together with the body.
+ *
+ * @param   const char *_method
+ *          HTTP method.
+ * @param   const char *_path
+ *          Path of the resource.
+ * @param   const char *_headers
+ *          Additional request headers (can be NULL).
+ * @param   const uint8_t *_body
+ *          Body of the request (can be NULL).
+ * @param   uint32_t _bodyLen
+ *          Length of the body in bytes.
+ * @return  bool
+ *          true - Request is sent.
+ *          false - Request is too long or send failed.
+ */
+bool WiFiHTTPSession::sendRequest(const char *_method, const char *_path, const char *_headers,
+                                  const uint8_t *_body, uint32_t _bodyLen)
+{
+    int _len = 0;
+
+    // Request line and the host (port is added only if it's not the default one).
+    if (((_port == 80) && !_ssl) || ((_port == 443) && _ssl))
+        _len = snprintf(_sessionBuffer, sizeof(_sessionBuffer), "%s %s HTTP/1.1\r\nHost: %s\r\n", _method, _path,
+                        _host);
+    else
+        _len = snprintf(_sessionBuffer, sizeof(_sessionBuffer), "%s %s HTTP/1.1\r\nHost: %s:%d\r\n", _method,
+                        _path, _host, _port);
+
+    // Keep the connection open. Length of the body, if there is any.
+    if ((_len > 0) && (_len < (int)sizeof(_sessionBuffer)))
+        _len += snprintf(_sessionBuffer + _len, sizeof(_sessionBuffer) - _len, "Connection: keep-alive\r\n");
+    if (((_body != NULL) || (strcmp(_method, "POST") == 0)) && (_len > 0) && (_len < (int)sizeof(_sessionBuffer)))
+        _len += snprintf(_sessionBuffer + _len, sizeof(_sessionBuffer) - _len, "Content-Length: %lu\r\n",
+                         (unsigned long)_bodyLen);
+
+    // Additional headers and the end of the header.
+    if ((_len > 0) && (_len < (int)sizeof(_sessionBuffer)))
+        _len += snprintf(_sessionBuffer + _len, sizeof(_sessionBuffer) - _len, "%s\r\n",
+                         _headers != NULL ? _headers : "");
+
+    // Check if everything fits into the buffer.
+    if ((_len <= 0) || (_len >= (int)sizeof(_sessionBuffer)))
+        return false;
+
+    // Send the header and the body.
+    if (!_tcp.write((const uint8_t *)_sessionBuffer, _len))
+        return false;
+    if ((_body != NULL) && (_bodyLen != 0))
+        return _tcp.write(_body, _bodyLen);
+
+    return true;
+}
+
+/**
+ * @brief   Reads the response header and gets the status code and the body transfer mode. Body data received
+ *          together with the header is kept in the session buffer.
+ *
+ * @param   bool _noBody
+ *          true - Response has no body (HEAD request).
+ * @return  bool
+ *          true - Header is received.
+ *          false - Header is not received (timeout, connection closed or header is too long).
+ */
+bool WiFiHTTPSession::readHeader(bool _noBody)
+{
+    uint32_t _len = 0;
+    char *_headerEnd = NULL;
+
+    _pendingStart = 0;
+    _pendingLen = 0;
+
+    // Read until the empty line.
+    while (_headerEnd == NULL)
+    {
+        // Header must fit into the buffer.
+        if (_len >= (sizeof(_sessionBuffer) - 1))
+            return false;
+
+        int _readLen = readTcp((uint8_t *)_sessionBuffer + _len, sizeof(_sessionBuffer) - 1 - _len);
+        if (_readLen <= 0)
+            return false;
+
+        // Empty line could start in the last read.
+        uint32_t _searchStart = _len > 3 ? _len - 3 : 0;
+        _len += _readLen;
+        _sessionBuffer[_len] = '\0';
+        _headerEnd = strstr(_sessionBuffer + _searchStart, "\r\n\r\n");
+    }
+
+    // Body data starts after the empty line.
+    _pendingStart = (_headerEnd + 4) - _sessionBuffer;
+    _pendingLen = _len - _pendingStart;
+
+    // Parse the header (without the empty line).
+    _headerEnd[2] = '\0';
+    bool _chunked = parseHeader(_sessionBuffer);
+
+    // Find out how the body is sent.
+    _bodyLeft = 0;
+    _bodyDone = false;
+    if (_noBody || ((_statusCode >= 100) && (_statusCode < 200)) || (_statusCode == 204) || (_statusCode == 304))
+    {
+        _bodyMode = BODY_NONE;
+        _bodyDone = true;
+    }
+    else if (_chunked)
+    {
+        _bodyMode = BODY_CHUNKED;
+    }
+    else if (_contentLength >= 0)
+    {
+        _bodyMode = BODY_LENGTH;
+        _bodyLeft = _contentLength;
+        _bodyDone = (_contentLength == 0);
+    }
+    else
+    {
+        // Body ends when the host closes the connection.
+        _bodyMode = BODY_CLOSE;
+        _keepAlive = false;
+    }
+
+    return (_statusCode > 0);
+}
+
+/**
+ * @brief   Parses the response header (status code, Content-Length, Transfer-Encoding and Connection).
+ *
+ * @param   char *_header
+ *          Null-terminated response header.
+ * @return  bool
+ *          true - Body is chunked.
+ *          false - Body is not chunked.
+ */
+bool WiFiHTTPSession::parseHeader(char *_header)
+{
+    bool _chunked = false;
+
+    _statusCode = -1;
+    _contentLength = -1;
+
+    // Status line: HTTP/1.1 200 OK. HTTP/1.0 closes the connection by default.
+    if (strncmp(_header, "HTTP/1.", 7) != 0)
+        return false;
+    _keepAlive = (_header[7] == '1');
+    char *_status = strchr(_header, ' ');
+    if (_status != NULL)
+        _statusCode = atoi(_status + 1);
+
+    // Check every header line.
+    char *_line = strstr(_header, "\r\n");
+    while (_line != NULL)
+    {
+        _line += 2;
+
+        // Get the end of the line.
+        char *_lineEnd = strstr(_line, "\r\n");
+        if (_lineEnd == NULL)
+            break;
+        *_lineEnd = '\0';
+
+        if (strncasecmp(_line, "Content-Length:", 15) == 0)
+        {
+            _contentLength = strtol(_line + 15, NULL, 10);
+        }
+        else if (strncasecmp(_line, "Transfer-Encoding:", 18) == 0)
+        {
+            _chunked = (esp32HttpHeaderHas(_line + 18, "chunked"));
+        }
+        else if (strncasecmp(_line, "Connection:", 11) == 0)
+        {
+            if (esp32HttpHeaderHas(_line + 11, "close"))
+                _keepAlive = false;
+            else if (esp32HttpHeaderHas(_line + 11, "keep-alive"))
+                _keepAlive = true;
+        }
+
+        // Restore the line end and move to the next line.
+        *_lineEnd = '\r';
+        _line = _lineEnd;
+    }
+
+    return _chunked;
+}
+
+/**
+ * @brief   Reads the size of the next chunk (and CRLF after the last chunk data). After the last (zero size) chunk,
+ *          the trailer is skipped and the body is done.
+ *
+ * @return  bool
+ *          true - Chunk size is read (or the body is done).
+ *          false - Chunk size is not valid or there is no more data.
+ */
+bool WiFiHTTPSession::nextChunk()
+{
+    uint32_t _size = 0;
+    bool _sizeFound = false;
+    uint8_t _emptyLines = 0;
+    uint8_t _c = 0;
+
+    // Size line is hex number (with optional extensions after ';'). CRLF after the last chunk data comes first.
+    while (!_sizeFound)
+    {
+        bool _inSize = true;
+        bool _digits = false;
+        _c = 0;
+        while (getByte(&_c) && (_c != '\n'))
+        {
+            int _digit = -1;
+            if ((_c >= '0') && (_c <= '9'))
+                _digit = _c - '0';
+            else if ((_c >= 'a') && (_c <= 'f'))
+                _digit = _c - 'a' + 10;
+            else if ((_c >= 'A') && (_c <= 'F'))
+                _digit = _c - 'A' + 10;
+
+            if (_inSize && (_digit >= 0) && (_size < 0x10000000))
+            {
+                _size = (_size << 4) | _digit;
+                _digits = true;
+            }
+            else
+            {
+                _inSize = false;
+            }
+        }
+
+        // No more data?
+        if (_c != '\n')
+            break;
+
+        _sizeFound = _digits;
+        if (!_digits && (++_emptyLines > 1))
+            break;
+    }
+
+    if (!_sizeFound)
+    {
+        // Broken body, connection can't be used anymore.
+        _keepAlive = false;
+        _bodyDone = true;
+        return false;
+    }
+
+    // Last chunk? Skip the trailer (header lines until the empty line).
+    if (_size == 0)
+    {
+        uint16_t _lineLen = 0;
+        while (getByte(&_c))
+        {
+            if (_c == '\n')
+            {
+                if (_lineLen == 0)
+                    break;
+                _lineLen = 0;
+            }
+            else if (_c != '\r')
+            {
+                _lineLen++;
+            }
+        }
+        _bodyDone = true;
+        return true;
+    }
+
+    _bodyLeft = _size;
+    return true;
+}
+
+/**
+ * @brief   Gets one byte of the response. Session buffer is filled from the connection when it's empty.
+ *
+ * @param   uint8_t *_c
+ *          Pointer to the variable for the byte.
+ * @return  bool
+ *          true - Byte is read.
+ *          false - There is no more data.
+ */
+bool WiFiHTTPSession::getByte(uint8_t *_c)
+{
+    if (_pendingLen == 0)
+    {
+        int _readLen = readTcp((uint8_t *)_sessionBuffer, sizeof(_sessionBuffer));
+        if (_readLen <= 0)
+            return false;
+        _pendingStart = 0;
+        _pendingLen = _readLen;
+    }
+
+    *_c = _sessionBuffer[_pendingStart++];
+    _pendingLen--;
+    return true;
+}
+
+/**
+ * @brief   Reads the data from the connection. Waits for the data up to the timeout.
+ *
+ * @param   uint8_t *_buffer
+ *          Pointer to buffer where to store data.
+ * @param   uint32_t _len
+ *          Max. number of bytes to read.
+ * @return  int
+ *          Number of bytes read (0 - timeout or the connection is closed).
+ */
+int WiFiHTTPSession::readTcp(uint8_t *_buffer, uint32_t _len)
+{
+    if (_len > INKPLATE_ESP32_TCP_MAX_READ)
+        _len = INKPLATE_ESP32_TCP_MAX_READ;
+
+    unsigned long _timeoutCounter = millis();
+    while ((unsigned long)(millis() - _timeoutCounter) < _timeout)
+    {
+        int _readLen = _tcp.read(_buffer, _len);
+        if (_readLen > 0)
+            return _readLen;
+
+        // Closed connection will not get any new data.
+        if (!_tcp.connected())
+            return 0;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Reads and drops the rest of the response body, so the connection can be used for the next request.
+ *          Body that is sent until the connection is closed is not read, connection is closed instead.
+ *
+ */
+void WiFiHTTPSession::skipBody()
+{
+    uint8_t _dropBuffer[256];
+
+    if (_bodyDone)
+        return;
+
+    if (_bodyMode == BODY_CLOSE)
+    {
+        _tcp.stop();
+        _bodyDone = true;
+        return;
+    }
+
+    while (!_bodyDone && (read(_dropBuffer, sizeof(_dropBuffer)) > 0))
+        ;
+}
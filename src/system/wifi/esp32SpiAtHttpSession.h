@@ -0,0 +1,120 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtHttpSession.h
+ * @brief       Header file for the HTTP/1.1 requests over the raw
+ *              TCP/SSL connection (WiFiTCP). Connection is kept open
+ *              (keep-alive) and used for all requests to the same host,
+ *              so only the first request pays the TCP/TLS handshake.
+ *              This file is used with esp32SpiAt library.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add headerguard do prevent multiple include.
+#ifndef __ESP32_SPI_AT_HTTP_SESSION_H__
+#define __ESP32_SPI_AT_HTTP_SESSION_H__
+
+// Include main Arduino header file.
+#include <Arduino.h>
+
+// Include main ESP32-C3 AT SPI library.
+#include "esp32SpiAt.h"
+
+// Include TCP class for ESP32 AT Commands.
+#include "esp32SpiAtTcp.h"
+
+// Max. length of the host name (with null-terminating char).
+#define INKPLATE_ESP32_HTTP_SESSION_HOST_SIZE 128
+
+// Size of the buffer for the request and the response header (response header must fit into it).
+#define INKPLATE_ESP32_HTTP_SESSION_BUFFER_SIZE 2048
+
+// Timeout for the response data (in milliseconds).
+#define INKPLATE_ESP32_HTTP_SESSION_TIMEOUT 10000ULL
+
+// Class for the HTTP/1.1 keep-alive requests.
+class WiFiHTTPSession
+{
+  public:
+    // Class constructor.
+    WiFiHTTPSession();
+
+    // Set the host for all requests (connection is opened with the first request).
+    bool begin(const char *_hostName, uint16_t _hostPort = 80, bool _useSsl = false);
+
+    // Send the request and read the response header. Returns HTTP status code or -1.
+    int GET(const char *_path, const char *_headers = NULL);
+    int POST(const char *_path, const uint8_t *_body, uint32_t _bodyLen, const char *_headers = NULL);
+    int HEAD(const char *_path, const char *_headers = NULL);
+
+    // Info from the response header.
+    int statusCode();
+    int32_t contentLength();
+
+    // Read the response body.
+    int read(uint8_t *_buffer, uint32_t _len);
+    bool bodyDone();
+
+    // Close the connection.
+    void end();
+
+    // Number of connections opened so far (with keep-alive, one for many requests).
+    uint32_t connectionCount();
+
+    // Sets response timeout in milliseconds.
+    void setTimeout(uint32_t _responseTimeout);
+
+  private:
+    int request(const char *_method, const char *_path, const char *_headers, const uint8_t *_body,
+                uint32_t _bodyLen);
+    bool sendRequest(const char *_method, const char *_path, const char *_headers, const uint8_t *_body,
+                     uint32_t _bodyLen);
+    bool readHeader(bool _noBody);
+    bool parseHeader(char *_header);
+    bool nextChunk();
+    bool getByte(uint8_t *_c);
+    int readTcp(uint8_t *_buffer, uint32_t _len);
+    void skipBody();
+
+    // Body transfer modes.
+    enum
+    {
+        BODY_NONE,
+        BODY_LENGTH,
+        BODY_CHUNKED,
+        BODY_CLOSE
+    } _bodyMode = BODY_NONE;
+
+    // TCP connection to the host.
+    WiFiTCP _tcp;
+
+    // Host of the session.
+    char _host[INKPLATE_ESP32_HTTP_SESSION_HOST_SIZE];
+    uint16_t _port = 80;
+    bool _ssl = false;
+
+    // Buffer for the request and the response header. Body data received with the header stays in it.
+    char _sessionBuffer[INKPLATE_ESP32_HTTP_SESSION_BUFFER_SIZE];
+    uint32_t _pendingStart = 0;
+    uint32_t _pendingLen = 0;
+
+    // Response info.
+    int _statusCode = -1;
+    int32_t _contentLength = -1;
+    bool _keepAlive = false;
+
+    // Bytes left in the body (or in the current chunk) and flag for the end of the body.
+    uint32_t _bodyLeft = 0;
+    bool _bodyDone = true;
+
+    // Number of opened connections.
+    uint32_t _connections = 0;
+
+    // Response timeout in milliseconds.
+    uint32_t _timeout = INKPLATE_ESP32_HTTP_SESSION_TIMEOUT;
+};
+
+#endif
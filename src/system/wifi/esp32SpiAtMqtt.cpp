@@ -65,6 +65,12 @@ bool WiFiMQTT::begin(uint16_t _rxBufferSize)
         // Copy buffer size locally in the class.
         _maxRxBufferSize = _rxBufferSize;
 
+        // Start with the empty queue.
+        _rxTail = _rxHead = _rxWrite = 0;
+        _rxKeep = _rxReading = false;
+        _rxQueued = 0;
+        _dataAvailable = 0;
+
         // Return true for success.
         return true;
     }
@@ -99,6 +105,12 @@ bool WiFiMQTT::begin(uint8_t *_rxBuffer, uint16_t _rxBufferSize)
     // Set the flag.
     _allocated = false;
 
+    // Start with the empty queue.
+    _rxTail = _rxHead = _rxWrite = 0;
+    _rxKeep = _rxReading = false;
+    _rxQueued = 0;
+    _dataAvailable = 0;
+
     // Return true for success.
     return true;
 }
@@ -221,7 +233,7 @@ bool WiFiMQTT::subscribe(const char *_topic)
     }
 
     // Try to parse the data sent by the MQTT while subscribe.
-    parseMQTTData("+MQTTSUBRECV:");
+    parseMQTTData(strlen(_atCommandBuffer));
 
     // Return _retValue (true - subscribed to the topic).
     return _retValue;
@@ -422,6 +434,10 @@ uint16_t WiFiMQTT::read(uint8_t *_buffer, uint16_t _len)
     _dataAvailable -= _len;
     _currentPosition += _len;
 
+    // Whole message is read, remove it from the queue.
+    if ((_dataAvailable == 0) && _rxReading)
+        popMessage();
+
     // Return the actual length.
     return _len;
 }
@@ -446,6 +462,10 @@ char WiFiMQTT::read()
 
         // Update number of available bytes.
         _dataAvailable--;
+
+        // Whole message is read, remove it from the queue.
+        if ((_dataAvailable == 0) && _rxReading)
+            popMessage();
     }
 
     // Return byte.
@@ -453,77 +473,451 @@ char WiFiMQTT::read()
 }
 
 /**
- * @brief   Returns number of received bytes from MQTT.
+ * @brief   Returns number of bytes left in the current message. If the current message is read, next message
+ *          from the queue becomes the current message (and topic() returns its topic).
  *
  * @return  uint16_t
  *          Number of received bytes available for read.
  */
 uint16_t WiFiMQTT::available()
 {
+    uint32_t _msgStart;
+    uint16_t _topicLen;
+    uint16_t _payloadLen;
+
+    // Get the next message from the queue (messages without payload are skipped).
+    while (!_rxReading && (_dataAvailable == 0) && nextMessage(&_msgStart, &_topicLen, &_payloadLen))
+    {
+
+        // Copy the topic.
+        memcpy(_lastRxTopic, _rxDataBuffer + _msgStart + INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE, _topicLen);
+        _lastRxTopic[_topicLen] = '\0';
+
+        // Payload is read straight from the queue.
+        _currentPosition = _rxDataBuffer + _msgStart + INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE + _topicLen;
+        _dataAvailable = _payloadLen;
+        _rxTail = _msgStart;
+        _rxCurrentEnd = _msgStart + INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE + _topicLen + _payloadLen;
+        _rxReading = true;
+
+        // Nothing to read?
+        if (_payloadLen == 0)
+            popMessage();
+    }
+
     // Return the bytes available.
     return _dataAvailable;
 }
 
 /**
- * @brief   Loop method that checks for new incomming data. Needs to be checked periodically.
+ * @brief   Loop method that checks for new incomming data. Needs to be checked periodically. All received
+ *          messages are stored in the queue (if there is space for them), then the messages with the callback are
+ *          sent to the callbacks.
  *
  * @note    It's recommended to not to use any other protocol while using MQTT since it can leda to loss of data.
  */
 void WiFiMQTT::loop()
 {
-    // Get new data only if buffer is empty.
-    if (!_dataAvailable)
+    // Get all data the ESP32 has (but limit it, so the loop does not block).
+    for (int i = 0; i < INKPLATE_ESP32_MQTT_MAX_LOOP_PACKETS; i++)
     {
         uint16_t _len = 0;
-        if (WiFi.getSimpleAtResponse(_atCommandBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, 1ULL, &_len))
+        if (!WiFi.getSimpleAtResponse(_atCommandBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, 1ULL, &_len))
+            break;
+
+        // Try to parse the data. Command is sent by the ESP32 as soon as topic is changed.
+        // Response: +MQTTSUBRECV:0,"solderedTest/soldered",10,test_36570
+        parseMQTTData(_len);
+    }
+
+    // Send the messages to the callbacks.
+    dispatchMessages();
+}
+
+/**
+ * @brief   Add the callback for the messages of the topic. Callbacks are called from the loop(). Messages without
+ *          the callback stay in the queue and can be read with available(), topic() and read().
+ *
+ * @param   const char *_topicFilter
+ *          Topic filter, MQTT wildcards can be used ("sensors/+/temp", "display/#"). The string must stay valid
+ *          (it's not copied). Use NULL for the callback of all topics without their own callback.
+ * @param   WiFiMQTTCallback _callback
+ *          Callback function.
+ * @return  bool
+ *          true - Callback is added.
+ *          false - There is no space for more callbacks (see INKPLATE_ESP32_MQTT_MAX_CALLBACKS).
+ */
+bool WiFiMQTT::onMessage(const char *_topicFilter, WiFiMQTTCallback _callback)
+{
+    if ((_callback == NULL) || (_callbackCount >= INKPLATE_ESP32_MQTT_MAX_CALLBACKS))
+        return false;
+
+    _callbackFilters[_callbackCount] = _topicFilter;
+    _callbacks[_callbackCount] = _callback;
+    _callbackCount++;
+
+    return true;
+}
+
+/**
+ * @brief   Remove all callbacks.
+ *
+ */
+void WiFiMQTT::clearCallbacks()
+{
+    _callbackCount = 0;
+}
+
+/**
+ * @brief   Get the number of messages waiting in the queue.
+ *
+ * @return  uint16_t
+ *          Number of messages in the queue (with the message that is currently read).
+ */
+uint16_t WiFiMQTT::queuedMessages()
+{
+    return _rxQueued;
+}
+
+/**
+ * @brief   Get the number of messages stored in the queue since the last resetStats().
+ *
+ * @return  uint32_t
+ *          Number of received messages.
+ */
+uint32_t WiFiMQTT::receivedMessages()
+{
+    return _rxReceived;
+}
+
+/**
+ * @brief   Get the number of messages dropped since the last resetStats() because the queue was full (or the
+ *          message is larger than the RX buffer).
+ *
+ * @return  uint32_t
+ *          Number of dropped messages.
+ */
+uint32_t WiFiMQTT::droppedMessages()
+{
+    return _rxDropped;
+}
+
+/**
+ * @brief   Get the max. number of bytes used in the queue since the last resetStats(). Use it to set the size of
+ *          the RX buffer.
+ *
+ * @return  uint16_t
+ *          Max. queue usage in bytes.
+ */
+uint16_t WiFiMQTT::queueHighWater()
+{
+    return _rxHighWater;
+}
+
+/**
+ * @brief   Reset the statistics of the RX queue.
+ *
+ */
+void WiFiMQTT::resetStats()
+{
+    _rxReceived = 0;
+    _rxDropped = 0;
+    _rxHighWater = 0;
+}
+
+/**
+ * @brief   Stores the topic and the payload from the received +MQTTSUBRECV frames into the queue. Payload is
+ *          copied straight from the SPI data into the queue (it can be binary). If there is no space for the whole
+ *          message, message is dropped.
+ *
+ * @param   uint16_t _len
+ *          Number of received bytes in the AT command buffer.
+ */
+void WiFiMQTT::parseMQTTData(uint16_t _len)
+{
+    AtUrcEvent _event;
+    const uint8_t *_data = (const uint8_t *)_atCommandBuffer;
+
+    while (_len != 0)
+    {
+        uint32_t _used = _parser.parse(_data, _len, &_event);
+        _data += _used;
+        _len -= _used;
+
+        if (_event.type != INKPLATE_ESP32_URC_TYPE_MQTTSUBRECV)
+            continue;
+
+        if (_event.event == INKPLATE_ESP32_URC_EVENT_FRAME)
         {
-            // Try to parse the data. Command is sent by the ESP32 as soon as topic is changed.
-            // Response: +MQTTSUBRECV:0,"solderedTest/soldered",10,test_36570
+            // Topic is limited to the size of the topic buffer.
+            uint16_t _topicLen = _event.topicLen;
+            if (_topicLen > (sizeof(_lastRxTopic) - 1))
+                _topicLen = sizeof(_lastRxTopic) - 1;
+
+            // Reserve the space for the whole message.
+            uint32_t _msgLen = INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE + _topicLen + _event.frameLen;
+            _rxKeep = (_rxDataBuffer != NULL) && (_event.frameLen <= 0xFFFF) && reserveMessage(_msgLen);
+            if (!_rxKeep)
+            {
+                _rxDropped++;
+                continue;
+            }
+
+            // Message header (little endian) and the topic.
+            uint8_t *_msg = (uint8_t *)_rxDataBuffer + _rxWrite;
+            _msg[0] = _topicLen & 0xFF;
+            _msg[1] = _topicLen >> 8;
+            _msg[2] = _event.frameLen & 0xFF;
+            _msg[3] = _event.frameLen >> 8;
+            if (_topicLen != 0)
+                memcpy(_msg + INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE, _event.topic, _topicLen);
+            _rxWrite += INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE + _topicLen;
+
+            // Message without payload is complete.
+            if (_event.frameLen == 0)
+                _event.last = true;
+        }
+        else if ((_event.event == INKPLATE_ESP32_URC_EVENT_PAYLOAD) && _rxKeep)
+        {
+            // Copy the payload part (space is already reserved).
+            memcpy(_rxDataBuffer + _rxWrite, _event.data, _event.len);
+            _rxWrite += _event.len;
+        }
 
-            // Add nul-terminating char at the end.
-            _atCommandBuffer[_len] = '\0';
+        // Whole message received? Add it to the queue.
+        if (_event.last && _rxKeep)
+        {
+            _rxHead = (_rxWrite >= _maxRxBufferSize) ? 0 : _rxWrite;
+            _rxKeep = false;
+            _rxQueued++;
+            _rxReceived++;
+
+            // Update the max. queue usage.
+            uint32_t _used = (_rxHead >= _rxTail) ? (_rxHead - _rxTail) : (_maxRxBufferSize - _rxTail + _rxHead);
+            if (_used > _rxHighWater)
+                _rxHighWater = _used;
+        }
+    }
+}
+
+/**
+ * @brief   Finds the space for the new message in the queue. Message is always stored in one piece, if it does
+ *          not fit at the end of the buffer, it's stored at the start (end of the buffer is marked as unused).
+ *
+ * @param   uint32_t _len
+ *          Size of the message with the header.
+ * @return  bool
+ *          true - Space is found, message is written from _rxWrite.
+ *          false - Queue is full.
+ */
+bool WiFiMQTT::reserveMessage(uint32_t _len)
+{
+    // Empty queue can start from the beginning of the buffer.
+    if ((_rxTail == _rxHead) && !_rxReading)
+        _rxTail = _rxHead = 0;
+
+    uint32_t _pos = _rxHead;
 
-            // Try to parse MQTT data.
-            parseMQTTData("+MQTTSUBRECV:");
+    if (_pos >= _rxTail)
+    {
+        // Free space is at the end and at the start of the buffer. Head must not come to the tail (that means empty
+        // queue), so with the tail at the start, the end of the buffer can't be used completely.
+        if ((_pos + _len < _maxRxBufferSize) || ((_pos + _len == _maxRxBufferSize) && (_rxTail != 0)))
+        {
+            _rxMsgStart = _pos;
+        }
+        else if (_len < _rxTail)
+        {
+            // Mark the end of the buffer as unused (if there is space for the mark at all).
+            if ((_maxRxBufferSize - _pos) >= INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE)
+            {
+                _rxDataBuffer[_pos] = 0xFF;
+                _rxDataBuffer[_pos + 1] = 0xFF;
+            }
+            _rxMsgStart = 0;
+        }
+        else
+        {
+            return false;
         }
     }
+    else
+    {
+        // Free space is between the head and the tail.
+        if ((_pos + _len) >= _rxTail)
+            return false;
+        _rxMsgStart = _pos;
+    }
+
+    _rxWrite = _rxMsgStart;
+    return true;
 }
 
-void WiFiMQTT::parseMQTTData(char *_cmdHeader)
+/**
+ * @brief   Get the oldest message in the queue.
+ *
+ * @param   uint32_t *_msgStart
+ *          Pointer to the variable for the start of the message in the buffer (can be NULL).
+ * @param   uint16_t *_topicLen
+ *          Pointer to the variable for the topic length (can be NULL).
+ * @param   uint16_t *_payloadLen
+ *          Pointer to the variable for the payload length (can be NULL).
+ * @return  bool
+ *          true - There is a message in the queue.
+ *          false - Queue is empty.
+ */
+bool WiFiMQTT::nextMessage(uint32_t *_msgStart, uint16_t *_topicLen, uint16_t *_payloadLen)
 {
-    // Try to catck start of the command response (if response exists at all).
-    char *_strCmd = strstr(_atCommandBuffer, _cmdHeader);
+    if ((_rxDataBuffer == NULL) || (_rxTail == _rxHead))
+        return false;
 
-    // Command must be at the start of the response. Otherwise ignore it.
-    if ((_strCmd != NULL) && ((_strCmd - _atCommandBuffer) < 2))
+    // Unused end of the buffer? Message is at the start.
+    uint32_t _pos = _rxTail;
+    const uint8_t *_msg = (const uint8_t *)_rxDataBuffer + _pos;
+    if (((_maxRxBufferSize - _pos) < INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE) || ((_msg[0] == 0xFF) && (_msg[1] == 0xFF)))
     {
-        // Parse the id.
-        int _id = 0;
-        sscanf(_strCmd, "%d", &_id);
+        _pos = 0;
+        _msg = (const uint8_t *)_rxDataBuffer;
+    }
 
-        // Move to the next part after the first comma.
-        _strCmd = strchr(_strCmd, ',') + 1;
+    if (_msgStart != NULL)
+        *_msgStart = _pos;
+    if (_topicLen != NULL)
+        *_topicLen = _msg[0] | (_msg[1] << 8);
+    if (_payloadLen != NULL)
+        *_payloadLen = _msg[2] | (_msg[3] << 8);
 
-        // Parse the topic
-        sscanf(_strCmd, "\"%[^\"]\"", _lastRxTopic);
+    return true;
+}
 
-        // Move to the next part after the second comma.
-        _strCmd = strchr(_strCmd, ',') + 1;
+/**
+ * @brief   Removes the message that is currently read from the queue.
+ *
+ * @return  bool
+ *          true - Message is removed.
+ *          false - No message is read.
+ */
+bool WiFiMQTT::popMessage()
+{
+    if (!_rxReading)
+        return false;
 
-        // Parse the size.
-        sscanf(_strCmd, "%d", &_dataAvailable);
+    _rxTail = (_rxCurrentEnd >= _maxRxBufferSize) ? 0 : _rxCurrentEnd;
+    _rxReading = false;
+    _dataAvailable = 0;
+    if (_rxQueued != 0)
+        _rxQueued--;
 
-        // Check the size.
-        if (_dataAvailable >= _maxRxBufferSize)
-            _dataAvailable = _maxRxBufferSize - 1;
+    return true;
+}
 
-        // Move to the next part after the third comma.
-        _strCmd = strchr(_strCmd, ',') + 1;
+/**
+ * @brief   Sends the messages from the queue to their callbacks. It stops at the first message without the
+ *          callback (it stays in the queue for the read()) or if the message is currently read.
+ *
+ */
+void WiFiMQTT::dispatchMessages()
+{
+    uint32_t _msgStart;
+    uint16_t _topicLen;
+    uint16_t _payloadLen;
+
+    for (int i = 0; (i < INKPLATE_ESP32_MQTT_MAX_LOOP_PACKETS) && (_callbackCount != 0) && !_rxReading; i++)
+    {
+        if (!nextMessage(&_msgStart, &_topicLen, &_payloadLen))
+            break;
+
+        // Find the callback for the topic.
+        const char *_topic = _rxDataBuffer + _msgStart + INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE;
+        WiFiMQTTCallback _callback = findCallback(_topic, _topicLen);
+        if (_callback == NULL)
+            break;
+
+        // Null-terminated topic.
+        memcpy(_lastRxTopic, _topic, _topicLen);
+        _lastRxTopic[_topicLen] = '\0';
+
+        // Message stays in the queue while the callback is running (it can call loop() again).
+        _rxTail = _msgStart;
+        _rxCurrentEnd = _msgStart + INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE + _topicLen + _payloadLen;
+        _rxReading = true;
+        _callback(_lastRxTopic, (const uint8_t *)_topic + _topicLen, _payloadLen);
+        popMessage();
+    }
+}
+
+/**
+ * @brief   Finds the callback for the topic. Callback with the matching filter is used first, then the callback for
+ *          all other topics (NULL filter).
+ *
+ * @param   const char *_topic
+ *          Topic (not null-terminated).
+ * @param   uint16_t _topicLen
+ *          Length of the topic.
+ * @return  WiFiMQTTCallback
+ *          Callback or NULL if there is no callback for the topic.
+ */
+WiFiMQTTCallback WiFiMQTT::findCallback(const char *_topic, uint16_t _topicLen)
+{
+    WiFiMQTTCallback _default = NULL;
+
+    for (int i = 0; i < _callbackCount; i++)
+    {
+        if (_callbackFilters[i] == NULL)
+        {
+            if (_default == NULL)
+                _default = _callbacks[i];
+        }
+        else if (topicMatches(_callbackFilters[i], _topic, _topicLen))
+        {
+            return _callbacks[i];
+        }
+    }
+
+    return _default;
+}
 
-        // Parse the payload.
-        strncpy(_rxDataBuffer, _strCmd, _dataAvailable);
+/**
+ * @brief   Check if the topic matches the MQTT topic filter (+ matches one level, # matches all levels below).
+ *
+ * @param   const char *_filter
+ *          Null-terminated topic filter.
+ * @param   const char *_topic
+ *          Topic (not null-terminated).
+ * @param   uint16_t _topicLen
+ *          Length of the topic.
+ * @return  bool
+ *          true - Topic matches the filter.
+ *          false - Topic does not match the filter.
+ */
+bool WiFiMQTT::topicMatches(const char *_filter, const char *_topic, uint16_t _topicLen)
+{
+    uint16_t i = 0;
 
-        // Update pointer position.
-        _currentPosition = _rxDataBuffer;
+    while (*_filter != '\0')
+    {
+        if (*_filter == '#')
+            return true;
+
+        if (*_filter == '+')
+        {
+            // Skip one level.
+            while ((i < _topicLen) && (_topic[i] != '/'))
+                i++;
+            _filter++;
+            continue;
+        }
+
+        // "a/#" also matches "a".
+        if ((i == _topicLen) && (_filter[0] == '/') && (_filter[1] == '#') && (_filter[2] == '\0'))
+            return true;
+
+        if ((i >= _topicLen) || (_topic[i] != *_filter))
+            return false;
+
+        i++;
+        _filter++;
     }
-}
\ No newline at end of file
+
+    return (i == _topicLen);
+}
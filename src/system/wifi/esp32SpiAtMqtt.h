@@ -20,6 +20,19 @@
 // Include main ESP32-C3 AT SPI library.
 #include "esp32SpiAt.h"
 
+// Max. number of the topic callbacks.
+#define INKPLATE_ESP32_MQTT_MAX_CALLBACKS 8
+
+// Size of the message header in the RX queue (topic length and payload length, 16 bits each).
+#define INKPLATE_ESP32_MQTT_MSG_HEADER_SIZE 4
+
+// Max. number of messages delivered by the loop() from the queue and max. number of the packets read from the ESP32
+// in one loop() call.
+#define INKPLATE_ESP32_MQTT_MAX_LOOP_PACKETS 16
+
+// Callback for the received MQTT message. Payload is not null-terminated and it's valid only inside the callback.
+typedef void (*WiFiMQTTCallback)(const char *_topic, const uint8_t *_payload, uint16_t _len);
+
 // Class for MQTT over SPI AT commands.
 class WiFiMQTT
 {
@@ -69,14 +82,62 @@ class WiFiMQTT
     uint16_t read(uint8_t *_buffer, uint16_t _len);
     char read();
 
-    // Returns how many data have been received.
+    // Returns how many data have been received (in the current message).
     uint16_t available();
 
     // This needs to be in the loop to check incomming data. This method is responable for the data receive.
     void loop();
 
+    // Add the callback for the topic filter (MQTT wildcards + and # can be used, NULL for all other topics).
+    bool onMessage(const char *_topicFilter, WiFiMQTTCallback _callback);
+
+    // Remove all callbacks.
+    void clearCallbacks();
+
+    // Statistics of the RX message queue.
+    uint16_t queuedMessages();
+    uint32_t receivedMessages();
+    uint32_t droppedMessages();
+    uint16_t queueHighWater();
+    void resetStats();
+
   private:
-    void parseMQTTData(char *_cmdHeader);
+    void parseMQTTData(uint16_t _len);
+    bool reserveMessage(uint32_t _len);
+    bool nextMessage(uint32_t *_msgStart, uint16_t *_topicLen, uint16_t *_payloadLen);
+    bool popMessage();
+    void dispatchMessages();
+    WiFiMQTTCallback findCallback(const char *_topic, uint16_t _topicLen);
+    static bool topicMatches(const char *_filter, const char *_topic, uint16_t _topicLen);
+
+    // Parser for the +MQTTSUBRECV frames (message can be split between the reads).
+    AtUrcParser _parser;
+
+    // RX buffer is used as the queue of messages. Each message is stored in one piece: topic length, payload length,
+    // topic and payload. If the message does not fit at the end of the buffer, it's stored at the start.
+    // Read position, end of the stored messages and the write position of the message that is being received.
+    uint32_t _rxTail = 0;
+    uint32_t _rxHead = 0;
+    uint32_t _rxWrite = 0;
+
+    // Start of the message that is being received and flag if it's stored (it's dropped if the queue is full).
+    uint32_t _rxMsgStart = 0;
+    bool _rxKeep = false;
+
+    // End of the message that is currently read by read() (it's removed from the queue when it's read).
+    uint32_t _rxCurrentEnd = 0;
+    bool _rxReading = false;
+
+    // Statistics.
+    uint16_t _rxQueued = 0;
+    uint32_t _rxReceived = 0;
+    uint32_t _rxDropped = 0;
+    uint16_t _rxHighWater = 0;
+
+    // Topic filters and their callbacks.
+    const char *_callbackFilters[INKPLATE_ESP32_MQTT_MAX_CALLBACKS];
+    WiFiMQTTCallback _callbacks[INKPLATE_ESP32_MQTT_MAX_CALLBACKS];
+    uint8_t _callbackCount = 0;
 
     // Buffer for storing last received topic. Limited to the first 256 chars.
     char _lastRxTopic[256];
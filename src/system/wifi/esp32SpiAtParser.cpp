@@ -0,0 +1,403 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtParser.cpp
+ * @brief       Main source file for the streaming parser of the ESP32 AT
+ *              messages with the payload (+IPD, +HTTPCGET, +HTTPCLIENT,
+ *              +MQTTSUBRECV, +CIPRECVDATA). Data is parsed byte by byte, so frames can
+ *              be split between SPI packets. Payload is not copied, parser
+ *              returns the pointer and the length of each payload part
+ *              inside the received data. Payload can be binary.
+ *              It does not use any Arduino or STM32 code.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include header file.
+#include "esp32SpiAtParser.h"
+
+// Start of the each frame type.
+static const struct
+{
+    const char *prefix;
+    uint8_t type;
+} esp32AtUrcPrefixes[] = {
+    {"+IPD,", INKPLATE_ESP32_URC_TYPE_IPD},
+    {"+HTTPCGET:", INKPLATE_ESP32_URC_TYPE_HTTPCGET},
+    {"+HTTPCLIENT:", INKPLATE_ESP32_URC_TYPE_HTTPCLIENT},
+    {"+MQTTSUBRECV:", INKPLATE_ESP32_URC_TYPE_MQTTSUBRECV},
+    {"+CIPRECVDATA:", INKPLATE_ESP32_URC_TYPE_CIPRECVDATA},
+};
+
+/**
+ * @brief Construct a new AT URC Parser object.
+ *
+ */
+AtUrcParser::AtUrcParser()
+{
+    begin();
+}
+
+/**
+ * @brief   Resets the parser (partially received frame is dropped).
+ *
+ */
+void AtUrcParser::begin()
+{
+    _state = STATE_LINE;
+    _remaining = 0;
+    _frameLen = 0;
+    _linkId = -1;
+    _topicStart = 0;
+    _topicLen = 0;
+    newLine();
+}
+
+/**
+ * @brief   Parses the received data until the first event. Call it again with the rest of the data (use
+ *          the return value) until all data is used. Data can be split anywhere, the parser keeps the state
+ *          between calls.
+ *
+ * @param   const uint8_t *_data
+ *          Pointer to the received data.
+ * @param   uint32_t _len
+ *          Number of bytes in the received data.
+ * @param   AtUrcEvent *_event
+ *          Pointer to the event. If there is no event, event type is INKPLATE_ESP32_URC_EVENT_NONE.
+ *          INKPLATE_ESP32_URC_EVENT_FRAME - Header of the frame is parsed (type, link ID, topic, length).
+ *          INKPLATE_ESP32_URC_EVENT_PAYLOAD - Part of the payload (pointer into the _data).
+ *          INKPLATE_ESP32_URC_EVENT_LINE - Text line that is not a frame (without CRLF).
+ * @return  uint32_t
+ *          Number of bytes used from the data.
+ */
+uint32_t AtUrcParser::parse(const uint8_t *_data, uint32_t _len, AtUrcEvent *_event)
+{
+    // No event by default.
+    fillEvent(_event, INKPLATE_ESP32_URC_EVENT_NONE);
+
+    uint32_t i = 0;
+    while (i < _len)
+    {
+        switch (_state)
+        {
+        case STATE_PAYLOAD: {
+            // Return as much payload as possible, without copying it.
+            uint32_t _partLen = (_len - i) < _remaining ? (_len - i) : _remaining;
+            _remaining -= _partLen;
+            fillEvent(_event, INKPLATE_ESP32_URC_EVENT_PAYLOAD);
+            _event->data = _data + i;
+            _event->len = _partLen;
+            _event->last = (_remaining == 0);
+
+            // Payload is followed by CRLF (not in all frames).
+            if (_remaining == 0)
+            {
+                _state = STATE_TRAILER;
+                _trailerLen = 0;
+            }
+
+            return i + _partLen;
+        }
+
+        case STATE_TRAILER:
+            // Skip CRLF after the payload. Anything else is a new line.
+            if ((_trailerLen < 2) && ((_data[i] == '\r') || (_data[i] == '\n')))
+            {
+                _trailerLen++;
+                i++;
+            }
+            else
+            {
+                _state = STATE_LINE;
+                newLine();
+            }
+            break;
+
+        case STATE_SKIP_LINE:
+            // Broken header, skip everything until the end of the line.
+            if (_data[i++] == '\n')
+            {
+                _state = STATE_LINE;
+                newLine();
+            }
+            break;
+
+        case STATE_LINE: {
+            uint8_t _c = _data[i++];
+
+            // Store the char (text lines longer than the buffer are cut).
+            bool _stored = false;
+            if (_headerLen < (INKPLATE_ESP32_URC_HEADER_SIZE - 1))
+            {
+                _header[_headerLen++] = _c;
+                _stored = true;
+            }
+
+            // Frame header?
+            if (_type != INKPLATE_ESP32_URC_TYPE_NONE)
+            {
+                // Header must fit into the buffer and it must not have a new line.
+                if (!_stored || (_c == '\n'))
+                {
+                    _state = (_c == '\n') ? STATE_LINE : STATE_SKIP_LINE;
+                    newLine();
+                    break;
+                }
+
+                // Header is complete? Parse it and start the payload.
+                if (headerComplete(_c))
+                {
+                    if (!parseHeader())
+                    {
+                        _state = STATE_SKIP_LINE;
+                        newLine();
+                        break;
+                    }
+
+                    _remaining = _frameLen;
+                    _state = (_remaining != 0) ? STATE_PAYLOAD : STATE_TRAILER;
+                    _trailerLen = 0;
+                    fillEvent(_event, INKPLATE_ESP32_URC_EVENT_FRAME);
+                    return i;
+                }
+                break;
+            }
+
+            // Check if the line still can be one of the frames.
+            if (_maybeFrame && _stored)
+            {
+                _maybeFrame = false;
+                for (uint8_t j = 0; j < sizeof(esp32AtUrcPrefixes) / sizeof(esp32AtUrcPrefixes[0]); j++)
+                {
+                    uint16_t _prefixLen = strlen(esp32AtUrcPrefixes[j].prefix);
+                    if ((_headerLen <= _prefixLen) && (memcmp(_header, esp32AtUrcPrefixes[j].prefix, _headerLen) == 0))
+                    {
+                        _maybeFrame = true;
+                        if (_headerLen == _prefixLen)
+                            _type = esp32AtUrcPrefixes[j].type;
+                    }
+                }
+            }
+
+            // End of the text line?
+            if (_c == '\n')
+            {
+                // Remove CRLF.
+                uint16_t _lineLen = _headerLen;
+                while ((_lineLen != 0) && ((_header[_lineLen - 1] == '\r') || (_header[_lineLen - 1] == '\n')))
+                    _lineLen--;
+
+                newLine();
+
+                // Empty lines are not reported.
+                if (_lineLen != 0)
+                {
+                    fillEvent(_event, INKPLATE_ESP32_URC_EVENT_LINE);
+                    _event->data = (const uint8_t *)_header;
+                    _event->len = _lineLen;
+                    return i;
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    return i;
+}
+
+/**
+ * @brief   Check if the parser is inside the payload of the frame.
+ *
+ * @return  bool
+ *          true - Payload is not complete, more data is needed.
+ *          false - Parser is between frames.
+ */
+bool AtUrcParser::inFrame()
+{
+    return (_state == STATE_PAYLOAD);
+}
+
+/**
+ * @brief   Starts the new line (header or text).
+ *
+ */
+void AtUrcParser::newLine()
+{
+    _headerLen = 0;
+    _type = INKPLATE_ESP32_URC_TYPE_NONE;
+    _maybeFrame = true;
+    _commas = 0;
+    _inQuotes = false;
+}
+
+/**
+ * @brief   Check if the last char ends the header of the current frame type.
+ *
+ * @param   uint8_t _c
+ *          Last char of the header.
+ * @return  bool
+ *          true - Header is complete, payload starts after this char.
+ *          false - Header is not complete.
+ */
+bool AtUrcParser::headerComplete(uint8_t _c)
+{
+    // Topic and IP address are in quotes, they can have any char.
+    if (_c == '"')
+        _inQuotes = !_inQuotes;
+    if (_inQuotes)
+        return false;
+
+    switch (_type)
+    {
+    case INKPLATE_ESP32_URC_TYPE_IPD:
+        // +IPD,[<link ID>,]<len>[,"<ip>",<port>]:
+        return (_c == ':');
+
+    case INKPLATE_ESP32_URC_TYPE_HTTPCGET:
+    case INKPLATE_ESP32_URC_TYPE_HTTPCLIENT:
+    case INKPLATE_ESP32_URC_TYPE_CIPRECVDATA:
+        // +HTTPCGET:<len>, or +CIPRECVDATA:<len>,
+        return (_c == ',');
+
+    case INKPLATE_ESP32_URC_TYPE_MQTTSUBRECV:
+        // +MQTTSUBRECV:<link ID>,"<topic>",<len>,
+        if (_c == ',')
+            _commas++;
+        return (_commas == 3);
+    }
+
+    return false;
+}
+
+/**
+ * @brief   Parses the complete header of the frame (link ID, topic and payload length).
+ *
+ * @return  bool
+ *          true - Header is valid.
+ *          false - Header is broken.
+ */
+bool AtUrcParser::parseHeader()
+{
+    // Skip the prefix (header is complete, so the prefix matches).
+    const char *_str = _header;
+    const char *_end = _header + _headerLen;
+    while ((_str < _end) && (*_str != ',') && (*_str != ':'))
+        _str++;
+    _str++;
+
+    int32_t _first = 0;
+    int32_t _second = 0;
+    _linkId = -1;
+    _topicStart = 0;
+    _topicLen = 0;
+
+    switch (_type)
+    {
+    case INKPLATE_ESP32_URC_TYPE_IPD:
+        if (!parseNumber(&_str, _end, &_first))
+            return false;
+
+        // Two numbers mean link ID and length (multiple connections).
+        if ((*_str == ',') && ((_str + 1) < _end) && (_str[1] >= '0') && (_str[1] <= '9'))
+        {
+            _str++;
+            if (!parseNumber(&_str, _end, &_second))
+                return false;
+            _linkId = _first;
+            _frameLen = _second;
+        }
+        else
+        {
+            _frameLen = _first;
+        }
+        return true;
+
+    case INKPLATE_ESP32_URC_TYPE_HTTPCGET:
+    case INKPLATE_ESP32_URC_TYPE_HTTPCLIENT:
+    case INKPLATE_ESP32_URC_TYPE_CIPRECVDATA:
+        if (!parseNumber(&_str, _end, &_first))
+            return false;
+        _frameLen = _first;
+        return true;
+
+    case INKPLATE_ESP32_URC_TYPE_MQTTSUBRECV: {
+        if (!parseNumber(&_str, _end, &_first) || (*_str != ',') || (_str[1] != '"'))
+            return false;
+        _linkId = _first;
+
+        // Topic is between the quotes.
+        _str += 2;
+        const char *_topicEnd = _str;
+        while ((_topicEnd < _end) && (*_topicEnd != '"'))
+            _topicEnd++;
+        if ((_topicEnd >= _end) || (_topicEnd[1] != ','))
+            return false;
+        _topicStart = _str - _header;
+        _topicLen = _topicEnd - _str;
+
+        // Payload length.
+        _str = _topicEnd + 2;
+        if (!parseNumber(&_str, _end, &_first))
+            return false;
+        _frameLen = _first;
+        return true;
+    }
+    }
+
+    return false;
+}
+
+/**
+ * @brief   Fills the event with the current frame info.
+ *
+ * @param   AtUrcEvent *_event
+ *          Pointer to the event.
+ * @param   uint8_t _eventType
+ *          Event type (INKPLATE_ESP32_URC_EVENT_xxx).
+ */
+void AtUrcParser::fillEvent(AtUrcEvent *_event, uint8_t _eventType)
+{
+    bool _frame = (_eventType == INKPLATE_ESP32_URC_EVENT_FRAME) || (_eventType == INKPLATE_ESP32_URC_EVENT_PAYLOAD);
+
+    _event->event = _eventType;
+    _event->type = _frame ? _type : INKPLATE_ESP32_URC_TYPE_NONE;
+    _event->linkId = _frame ? _linkId : -1;
+    _event->topic = (_frame && (_topicLen != 0)) ? (_header + _topicStart) : NULL;
+    _event->topicLen = _frame ? _topicLen : 0;
+    _event->frameLen = _frame ? _frameLen : 0;
+    _event->data = NULL;
+    _event->len = 0;
+    _event->last = false;
+}
+
+/**
+ * @brief   Parses the decimal number (without sign).
+ *
+ * @param   const char **_str
+ *          Pointer to the string pointer. It's moved after the number.
+ * @param   const char *_end
+ *          End of the string.
+ * @param   int32_t *_value
+ *          Pointer to the variable for the number.
+ * @return  bool
+ *          true - Number is parsed.
+ *          false - There is no number.
+ */
+bool AtUrcParser::parseNumber(const char **_str, const char *_end, int32_t *_value)
+{
+    const char *_p = *_str;
+    int32_t _number = 0;
+
+    while ((_p < _end) && (*_p >= '0') && (*_p <= '9') && (_number < 100000000))
+        _number = (_number * 10) + (*_p++ - '0');
+
+    if (_p == *_str)
+        return false;
+
+    *_str = _p;
+    *_value = _number;
+    return true;
+}
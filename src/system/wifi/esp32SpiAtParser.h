@@ -0,0 +1,107 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtParser.h
+ * @brief       Header file for the streaming parser of the ESP32 AT
+ *              messages with the payload (+IPD, +HTTPCGET, +HTTPCLIENT,
+ *              +MQTTSUBRECV, +CIPRECVDATA). Data is parsed byte by byte, so frames can
+ *              be split between SPI packets. Payload is not copied, parser
+ *              returns the pointer and the length of each payload part
+ *              inside the received data. Payload can be binary.
+ *              It does not use any Arduino or STM32 code.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add headerguard do prevent multiple include.
+#ifndef __ESP32_SPI_AT_PARSER_H__
+#define __ESP32_SPI_AT_PARSER_H__
+
+// Include standard C libraries.
+#include <stdint.h>
+#include <string.h>
+
+// Include SPI AT Message typedefs (for the event and frame types).
+#include "esp32SpiAtTypedefs.h"
+
+// Max. size of the frame header or text line kept by the parser (longer lines are cut).
+#define INKPLATE_ESP32_URC_HEADER_SIZE 320
+
+// One event from the parser.
+struct AtUrcEvent
+{
+    // Event type (INKPLATE_ESP32_URC_EVENT_xxx).
+    uint8_t event;
+
+    // Frame type (INKPLATE_ESP32_URC_TYPE_xxx).
+    uint8_t type;
+
+    // Link ID (+IPD in multiple connection mode, +MQTTSUBRECV), -1 if not used.
+    int16_t linkId;
+
+    // Topic of the MQTT message (not null-terminated, valid until the next frame).
+    const char *topic;
+    uint16_t topicLen;
+
+    // Whole payload length of the frame.
+    uint32_t frameLen;
+
+    // Part of the payload (EVENT_PAYLOAD) or the text line (EVENT_LINE, valid until the next line). Points into
+    // the data given to the parse().
+    const uint8_t *data;
+    uint32_t len;
+
+    // Set on the last part of the payload.
+    bool last;
+};
+
+class AtUrcParser
+{
+  public:
+    AtUrcParser();
+    void begin();
+    uint32_t parse(const uint8_t *_data, uint32_t _len, AtUrcEvent *_event);
+    bool inFrame();
+
+  private:
+    void newLine();
+    bool headerComplete(uint8_t _c);
+    bool parseHeader();
+    void fillEvent(AtUrcEvent *_event, uint8_t _eventType);
+    static bool parseNumber(const char **_str, const char *_end, int32_t *_value);
+
+    // Parser states.
+    enum
+    {
+        STATE_LINE,
+        STATE_PAYLOAD,
+        STATE_TRAILER,
+        STATE_SKIP_LINE
+    } _state = STATE_LINE;
+
+    // Header of the frame or the text line.
+    char _header[INKPLATE_ESP32_URC_HEADER_SIZE];
+    uint16_t _headerLen = 0;
+
+    // Type of the frame that matches the header and flag if the header can still be one of the frames.
+    uint8_t _type = INKPLATE_ESP32_URC_TYPE_NONE;
+    bool _maybeFrame = true;
+
+    // Number of commas outside the quotes (for the +MQTTSUBRECV header) and the quote flag.
+    uint8_t _commas = 0;
+    bool _inQuotes = false;
+
+    // Info of the current frame (for the payload events).
+    uint32_t _frameLen = 0;
+    int16_t _linkId = -1;
+    uint16_t _topicStart = 0;
+    uint16_t _topicLen = 0;
+
+    // Payload bytes left in the current frame and number of CR/LF bytes skipped after it.
+    uint32_t _remaining = 0;
+    uint8_t _trailerLen = 0;
+};
+
+#endif
@@ -0,0 +1,438 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtTcp.cpp
+ * @brief       Source file for the raw TCP/SSL socket communication
+ *              with the ESP32 (AT+CIPSTART, AT+CIPSEND, AT+CIPRECVDATA).
+ *              Received data is kept in the ESP32 (passive receive mode)
+ *              until it's read, so it's not lost if the other AT commands
+ *              are sent in the meantime.
+ *              This file is used with esp32SpiAt library.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Include main header file for the TCP.
+#include "esp32SpiAtTcp.h"
+
+// Links used by all TCP objects.
+uint8_t WiFiTCP::_usedLinks = 0;
+
+// ESP32 is not set to the multiple connections yet.
+bool WiFiTCP::_muxReady = false;
+
+// Older ESP32 AT firmware sets the passive receive mode for all links (AT+CIPRECVMODE), newer for each link
+// (AT+CIPRECVTYPE).
+bool WiFiTCP::_recvTypePerLink = false;
+
+/**
+ * @brief Construct for a new WiFiTCP object.
+ *
+ */
+WiFiTCP::WiFiTCP()
+{
+    // Get the pointer address of the data buffer of the WiFi library.
+    _dataBuffer = WiFi.getDataBuffer();
+}
+
+/**
+ * @brief   Destructor for the WiFiTCP object. It closes the connection (if it's still open), so the link can be
+ *          used by another object.
+ *
+ */
+WiFiTCP::~WiFiTCP()
+{
+    stop();
+}
+
+/**
+ * @brief   Open the TCP (or SSL) connection to the host. Connection stays open until stop() is called or until
+ *          the host closes it, so many requests can be sent over the same connection.
+ *
+ * @param   const char *_host
+ *          Host name or IP address.
+ * @param   uint16_t _port
+ *          Host port.
+ * @param   bool _ssl
+ *          true - Use SSL (TLS) connection.
+ *          false - Use plain TCP connection.
+ * @param   uint16_t _keepAlive
+ *          TCP keep-alive interval in seconds (0 - disabled, max. 7200).
+ * @return  bool
+ *          true - Connection is open.
+ *          false - Connection failed (or there is no free link).
+ *
+ * @note    ESP32 is set to multiple connections mode (AT+CIPMUX=1), so WiFiUDP can't be used at the same time.
+ */
+bool WiFiTCP::connect(const char *_host, uint16_t _port, bool _ssl, uint16_t _keepAlive)
+{
+    // Close the previous connection of this object.
+    stop();
+
+    // Set the ESP32 to multiple connections and passive receive mode.
+    if (!muxInit())
+        return false;
+
+    // Get the free link.
+    _linkId = allocLink();
+    if (_linkId < 0)
+        return false;
+
+    // Create AT commands with parameters.
+    sprintf(_dataBuffer, "AT+CIPSTART=%d,\"%s\",\"%s\",%d,%d\r\n", _linkId, _ssl ? "SSL" : "TCP", _host, _port,
+            _keepAlive);
+
+    // Send command and check response. It should respond with CONNECT. Otherwise free the link and return false.
+    if (!WiFi.sendAtCommandWithResponse(_dataBuffer, _connectionTimeoutValue, 100ULL, (char *)"CONNECT",
+                                        INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true))
+    {
+        freeLink();
+
+        // ESP32 may have been restarted or set to single connection mode by the UDP. Check it again next time.
+        _muxReady = false;
+
+        return false;
+    }
+
+    // Newer firmware sets the passive receive mode for each link.
+    if (_recvTypePerLink)
+    {
+        sprintf(_dataBuffer, "AT+CIPRECVTYPE=%d,1\r\n", _linkId);
+        WiFi.sendAtCommandWithResponse(_dataBuffer, 200ULL, 10ULL, (char *)esp32AtCmdResponseOK,
+                                       INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true);
+    }
+
+    // Nothing is received yet.
+    _rxAvailable = 0;
+
+    // If you got here, everything went ok, return true.
+    return true;
+}
+
+/**
+ * @brief   Check if the connection is still open.
+ *
+ * @return  bool
+ *          true - Connection is open (or there is still received data to read).
+ *          false - Connection is closed.
+ */
+bool WiFiTCP::connected()
+{
+    // No link, no connection.
+    if (_linkId < 0)
+        return false;
+
+    // Received data can still be read.
+    if (_rxAvailable != 0)
+        return true;
+
+    // Get the state of all links.
+    if (!WiFi.sendAtCommandWithResponse((char *)"AT+CIPSTATE?\r\n", 200ULL, 10ULL, (char *)esp32AtCmdResponseOK,
+                                        INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true))
+        return false;
+
+    // Every open link is listed as +CIPSTATE:<link ID>,...
+    char _linkState[16];
+    sprintf(_linkState, "+CIPSTATE:%d,", _linkId);
+    return (strstr(_dataBuffer, _linkState) != NULL);
+}
+
+/**
+ * @brief   Send data to the host. Data is split into the parts of INKPLATE_ESP32_TCP_MAX_SEND bytes.
+ *
+ * @param   const uint8_t *_data
+ *          Pointer to the data.
+ * @param   uint32_t _len
+ *          Number of bytes to send.
+ * @return  bool
+ *          true - All data is sent.
+ *          false - Send failed (connection is closed?).
+ */
+bool WiFiTCP::write(const uint8_t *_data, uint32_t _len)
+{
+    // Buffer for the AT command (data buffer of the WiFi library is used for the response).
+    char _atCommand[32];
+
+    // Check for the link.
+    if (_linkId < 0)
+        return false;
+
+    while (_len != 0)
+    {
+        uint16_t _partLen = _len > INKPLATE_ESP32_TCP_MAX_SEND ? INKPLATE_ESP32_TCP_MAX_SEND : _len;
+
+        // Ask for the data send. ESP32 responds with OK and ">".
+        sprintf(_atCommand, "AT+CIPSEND=%d,%d\r\n", _linkId, _partLen);
+        if (!WiFi.sendAtCommandWithResponse(_atCommand, 2000ULL, 100ULL, (char *)">",
+                                            INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true))
+            return false;
+
+        // Send the data and wait for SEND OK (or SEND FAIL).
+        if (!WiFi.sendAtCommand((char *)_data, _partLen))
+            return false;
+        WiFi.getAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, INKPLATE_ESP32_TCP_TIMEOUT, NULL,
+                           "SEND OK");
+        if (WiFi.getAtResult() != INKPLATE_ESP32_AT_RESULT_OK)
+            return false;
+
+        // Move to the next part.
+        _data += _partLen;
+        _len -= _partLen;
+    }
+
+    // If you got here, everything went ok, return true.
+    return true;
+}
+
+/**
+ * @brief   Send the string to the host.
+ *
+ * @param   const char *_str
+ *          Null-terminated string.
+ * @return  bool
+ *          true - String is sent.
+ *          false - Send failed.
+ */
+bool WiFiTCP::print(const char *_str)
+{
+    return write((const uint8_t *)_str, strlen(_str));
+}
+
+/**
+ * @brief   Returns how many bytes are received from the host and waiting in the ESP32.
+ *
+ * @return  uint32_t
+ *          Number of bytes available for read.
+ */
+uint32_t WiFiTCP::available()
+{
+    // Check for the link.
+    if (_linkId < 0)
+        return 0;
+
+    // Get the number of received bytes for all links.
+    // Response: +CIPRECVLEN:<len link 0>,<len link 1>,<len link 2>,<len link 3>,<len link 4>
+    if (!WiFi.sendAtCommandWithResponse((char *)"AT+CIPRECVLEN?\r\n", 200ULL, 10ULL, (char *)"+CIPRECVLEN:",
+                                        INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true))
+        return _rxAvailable = 0;
+
+    // Find the length of this link.
+    char *_lenStr = strstr(_dataBuffer, "+CIPRECVLEN:") + strlen("+CIPRECVLEN:");
+    for (int i = 0; (i < _linkId) && (_lenStr != NULL); i++)
+    {
+        _lenStr = strchr(_lenStr, ',');
+        if (_lenStr != NULL)
+            _lenStr++;
+    }
+    if (_lenStr == NULL)
+        return _rxAvailable = 0;
+
+    // Closed links have negative length.
+    long _len = strtol(_lenStr, NULL, 10);
+    _rxAvailable = _len > 0 ? _len : 0;
+
+    return _rxAvailable;
+}
+
+/**
+ * @brief   Read bytes received from the host. Payload is copied straight from the SPI packets into the buffer
+ *          (it can be binary).
+ *
+ * @param   uint8_t *_buffer
+ *          Pointer to buffer where to store data.
+ * @param   uint16_t _len
+ *          Max. number of bytes to read (max. INKPLATE_ESP32_TCP_MAX_READ bytes per call).
+ * @return  int
+ *          How many bytes are actually read (0 if there is no data).
+ */
+int WiFiTCP::read(uint8_t *_buffer, uint16_t _len)
+{
+    // Buffer for the AT command (data buffer of the WiFi library is used for the response).
+    char _atCommand[32];
+
+    // Check for the link and the data.
+    if ((_linkId < 0) || (_len == 0))
+        return 0;
+    if ((_rxAvailable == 0) && (available() == 0))
+        return 0;
+
+    // Do not read more than available.
+    if (_len > INKPLATE_ESP32_TCP_MAX_READ)
+        _len = INKPLATE_ESP32_TCP_MAX_READ;
+    if (_len > _rxAvailable)
+        _len = _rxAvailable;
+
+    // Ask for the data. Response: +CIPRECVDATA:<actual len>,<data>\r\nOK\r\n
+    sprintf(_atCommand, "AT+CIPRECVDATA=%d,%d\r\n", _linkId, _len);
+    if (!WiFi.sendAtCommand(_atCommand))
+        return 0;
+
+    AtUrcParser _parser;
+    AtUrcEvent _event;
+    uint16_t _rxLen = 0;
+    uint16_t _copied = 0;
+    bool _done = false;
+
+    // Read the response packet by packet until OK or ERROR (data can have any char, so the parser is used).
+    unsigned long _timeoutCounter = millis();
+    while (!_done && ((unsigned long)(millis() - _timeoutCounter) < INKPLATE_ESP32_TCP_TIMEOUT))
+    {
+        if (!WiFi.getSimpleAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, 10ULL, &_rxLen))
+            continue;
+
+        // Update the timeout!
+        _timeoutCounter = millis();
+
+        const uint8_t *_data = (const uint8_t *)_dataBuffer;
+        while ((_rxLen != 0) && !_done)
+        {
+            uint32_t _used = _parser.parse(_data, _rxLen, &_event);
+            _data += _used;
+            _rxLen -= _used;
+
+            if ((_event.event == INKPLATE_ESP32_URC_EVENT_PAYLOAD) &&
+                (_event.type == INKPLATE_ESP32_URC_TYPE_CIPRECVDATA))
+            {
+                // Copy the payload, but check the size.
+                uint32_t _partLen = _event.len;
+                if ((_copied + _partLen) > _len)
+                    _partLen = _len - _copied;
+                memcpy(_buffer + _copied, _event.data, _partLen);
+                _copied += _partLen;
+            }
+            else if (_event.event == INKPLATE_ESP32_URC_EVENT_LINE)
+            {
+                // Final result code ends the response.
+                _done = ((_event.len == 2) && (memcmp(_event.data, "OK", 2) == 0)) ||
+                        ((_event.len == 5) && (memcmp(_event.data, "ERROR", 5) == 0));
+            }
+        }
+    }
+
+    // Update the number of bytes left in the ESP32.
+    _rxAvailable = (_copied < _rxAvailable) ? (_rxAvailable - _copied) : 0;
+
+    // Return the actual length.
+    return _copied;
+}
+
+/**
+ * @brief   Close the connection and free the link.
+ *
+ * @return  bool
+ *          true - Connection is closed.
+ *          false - ESP32 failed to close the connection (it was probably closed by the host).
+ */
+bool WiFiTCP::stop()
+{
+    // Nothing to close.
+    if (_linkId < 0)
+        return true;
+
+    // Disconnect from the host. Response: <link ID>,CLOSED
+    sprintf(_dataBuffer, "AT+CIPCLOSE=%d\r\n", _linkId);
+    bool _retValue = WiFi.sendAtCommandWithResponse(_dataBuffer, 2000ULL, 10ULL, (char *)esp32AtCmdResponseOK,
+                                                    INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true);
+
+    // Link can be used again.
+    freeLink();
+    _rxAvailable = 0;
+
+    return _retValue;
+}
+
+/**
+ * @brief   Get the link ID used by this connection.
+ *
+ * @return  int8_t
+ *          Link ID (0 - 4) or -1 if not connected.
+ */
+int8_t WiFiTCP::linkId()
+{
+    return _linkId;
+}
+
+/**
+ * @brief   Sets connection timeout in milliseconds.
+ *
+ * @param   uint16_t _connectionTimeout
+ *          Connection timeout in milliseconds.
+ *
+ * @note    Must be called before connect!
+ */
+void WiFiTCP::setConnectionTimeout(uint16_t _connectionTimeout)
+{
+    _connectionTimeoutValue = _connectionTimeout;
+}
+
+/**
+ * @brief   Sets the ESP32 to the multiple connections mode and passive receive mode (only once).
+ *
+ * @return  bool
+ *          true - ESP32 is ready for the TCP connections.
+ *          false - ESP32 failed to set the mode (there is an open single connection?).
+ */
+bool WiFiTCP::muxInit()
+{
+    // Already set?
+    if (_muxReady)
+        return true;
+
+    // Allow multiple connections. It fails if there is a connection open in the single connection mode.
+    if (!WiFi.sendAtCommandWithResponse((char *)"AT+CIPMUX=1\r\n", 200ULL, 10ULL, (char *)esp32AtCmdResponseOK,
+                                        INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true))
+    {
+        // If there are TCP connections already open, mode is already set.
+        if (_usedLinks == 0)
+            return false;
+    }
+
+    // Do not send remote IP and port with the received data.
+    WiFi.sendAtCommandWithResponse((char *)"AT+CIPDINFO=0\r\n", 200ULL, 10ULL, (char *)esp32AtCmdResponseOK,
+                                   INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true);
+
+    // Passive receive mode - data is kept in the ESP32 until it's read with AT+CIPRECVDATA. Older firmware sets it
+    // for all links, newer for each link after the connection is open.
+    _recvTypePerLink =
+        !WiFi.sendAtCommandWithResponse((char *)"AT+CIPRECVMODE=1\r\n", 200ULL, 10ULL, (char *)esp32AtCmdResponseOK,
+                                        INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY, true);
+
+    // Set the flag.
+    _muxReady = true;
+
+    return true;
+}
+
+/**
+ * @brief   Finds the free link.
+ *
+ * @return  int8_t
+ *          Link ID or -1 if all links are used.
+ */
+int8_t WiFiTCP::allocLink()
+{
+    for (int8_t i = 0; i < INKPLATE_ESP32_TCP_MAX_LINKS; i++)
+    {
+        if (!(_usedLinks & (1 << i)))
+        {
+            _usedLinks |= (1 << i);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief   Frees the link of this object.
+ *
+ */
+void WiFiTCP::freeLink()
+{
+    if (_linkId >= 0)
+        _usedLinks &= ~(1 << _linkId);
+
+    _linkId = -1;
+}
@@ -0,0 +1,108 @@
+/**
+ **************************************************
+ *
+ * @file        esp32SpiAtTcp.h
+ * @brief       Header file for the raw TCP/SSL socket communication
+ *              with the ESP32 (AT+CIPSTART, AT+CIPSEND, AT+CIPRECVDATA).
+ *              Multiple connections are used (AT+CIPMUX=1), so each
+ *              object has its own link and connection stays open
+ *              between requests.
+ *              This file is used with esp32SpiAt library.
+ *
+ *
+ * @copyright   GNU General Public License v3.0
+ * @authors     Borna Biro for soldered.com
+ ***************************************************/
+
+// Add headerguard do prevent multiple include.
+#ifndef __ESP32_SPI_AT_TCP_H__
+#define __ESP32_SPI_AT_TCP_H__
+
+// Include main Arduino header file.
+#include <Arduino.h>
+
+// Include main ESP32-C3 AT SPI library.
+#include "esp32SpiAt.h"
+
+// Max. number of the links (connections) the ESP32 AT firmware supports.
+#define INKPLATE_ESP32_TCP_MAX_LINKS 5
+
+// Default TCP keep-alive interval in seconds (0 = disabled, max. 7200).
+#define INKPLATE_ESP32_TCP_KEEP_ALIVE 60
+
+// Max. number of bytes sent with one AT+CIPSEND command.
+#define INKPLATE_ESP32_TCP_MAX_SEND 2048
+
+// Max. number of bytes read with one AT+CIPRECVDATA command.
+#define INKPLATE_ESP32_TCP_MAX_READ 4096
+
+// Timeout for the data send and receive (in milliseconds).
+#define INKPLATE_ESP32_TCP_TIMEOUT 5000ULL
+
+// Class for the ESP32 SPI TCP/SSL client.
+class WiFiTCP
+{
+  public:
+    // Class constructor.
+    WiFiTCP();
+
+    // Class destructor - closes the connection and frees the link.
+    ~WiFiTCP();
+
+    // Open the TCP (or SSL) connection to the host.
+    bool connect(const char *_host, uint16_t _port, bool _ssl = false,
+                 uint16_t _keepAlive = INKPLATE_ESP32_TCP_KEEP_ALIVE);
+
+    // Check if the connection is still open.
+    bool connected();
+
+    // Send data to the host.
+    bool write(const uint8_t *_data, uint32_t _len);
+    bool print(const char *_str);
+
+    // Returns how many bytes are received and waiting in the ESP32.
+    uint32_t available();
+
+    // Read bytes received from the host.
+    int read(uint8_t *_buffer, uint16_t _len);
+
+    // Close the connection.
+    bool stop();
+
+    // Get the link ID used by this connection (-1 if not connected).
+    int8_t linkId();
+
+    // Sets connection timeout in milliseconds.
+    void setConnectionTimeout(uint16_t _connectionTimeout);
+
+  private:
+    bool muxInit();
+    int8_t allocLink();
+    void freeLink();
+
+    // Link ID of the connection (-1 if not used).
+    int8_t _linkId = -1;
+
+    // Number of bytes waiting in the ESP32 (from the last AT+CIPRECVLEN? check).
+    uint32_t _rxAvailable = 0;
+
+    // Connection timeout in milliseconds.
+    uint16_t _connectionTimeoutValue = 20000ULL;
+
+    // Pointer to the data buffer of the WiFi library.
+    char *_dataBuffer = NULL;
+
+    // Links used by all TCP objects (one bit for each link).
+    static uint8_t _usedLinks;
+
+    // Flag if the ESP32 is set to multiple connections and passive receive mode.
+    static bool _muxReady;
+
+    // Flag if the passive receive mode is set for each link (AT+CIPRECVTYPE) instead for all links.
+    static bool _recvTypePerLink;
+};
+
+// Include HTTP keep-alive session class for ESP32 AT Commands (it uses the TCP class).
+#include "esp32SpiAtHttpSession.h"
+
+#endif
@@ -40,6 +40,26 @@
 #define INKPLATE_ESP32_AT_EXPECTED_RESPONSE_ANY   1
 #define INKPLATE_ESP32_AT_EXPECTED_RESPONSE_END   2
 
+// Final result codes of the AT command response (see AtResponseFramer).
+#define INKPLATE_ESP32_AT_RESULT_NONE   0
+#define INKPLATE_ESP32_AT_RESULT_OK     1
+#define INKPLATE_ESP32_AT_RESULT_ERROR  2
+#define INKPLATE_ESP32_AT_RESULT_PROMPT 3
+
+// Events of the URC parser (see AtUrcParser).
+#define INKPLATE_ESP32_URC_EVENT_NONE    0
+#define INKPLATE_ESP32_URC_EVENT_LINE    1
+#define INKPLATE_ESP32_URC_EVENT_FRAME   2
+#define INKPLATE_ESP32_URC_EVENT_PAYLOAD 3
+
+// Types of the frames with the payload (see AtUrcParser).
+#define INKPLATE_ESP32_URC_TYPE_NONE        0
+#define INKPLATE_ESP32_URC_TYPE_IPD         1
+#define INKPLATE_ESP32_URC_TYPE_HTTPCGET    2
+#define INKPLATE_ESP32_URC_TYPE_HTTPCLIENT  3
+#define INKPLATE_ESP32_URC_TYPE_MQTTSUBRECV 4
+#define INKPLATE_ESP32_URC_TYPE_CIPRECVDATA 5
+
 // Typedef struct used for SPI ESP32 message format.
 struct spiAtCommandTypedef
 {
@@ -57,6 +77,23 @@ struct spiAtWiFiScanTypedef
     char ssidName[65];
 };
 
+// Connection data of the last AP cached in the backup SRAM for the fast reconnect (see WiFiClass::fastConnect()).
+struct spiAtFastConnectTypedef
+{
+    uint32_t magic;
+    uint32_t apHash;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint16_t uses;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns1;
+    uint32_t dns2;
+    uint32_t checksum;
+};
+
 // Typedef/union used for data write request to the ESP32.
 union spiAtCommandDataInfoTypedef {
     struct dataInfoStruct
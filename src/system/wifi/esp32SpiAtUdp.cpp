@@ -44,6 +44,9 @@ bool WiFiUDP::begin(uint16_t _localPort)
 
     // Reset number of available bytes (in case of the re-usage of the object).
     _availableData = 0;
+    _packetLeft = 0;
+    _packetLen = 0;
+    _parser.begin();
 
     // Return true if you got here.
     return true;
@@ -85,6 +88,9 @@ bool WiFiUDP::beginPacket()
 {
     // Reset number of available bytes (in case of the re-usage of the object).
     _availableData = 0;
+    _packetLeft = 0;
+    _packetLen = 0;
+    _parser.begin();
 
     // Enable the message filter for the response.
     // Remove "Recv XY bytes\r\n"
@@ -95,9 +101,8 @@ bool WiFiUDP::beginPacket()
     if (!WiFi.messageFilter(true, NULL, "\r\nSEND OK\r\n"))
         return false;
 
-    // Remove "+IPD,XY".
-    if (!WiFi.messageFilter(true, "^+IPD,[0-9]*:", "\r\n$"))
-        return false;
+    // "+IPD,XY:" is not filtered on the ESP32, it's removed by the parser (filter would also remove CRLF at the
+    // end of the packet data).
 
     // If you got here, everything went ok, return true.
     return true;
@@ -124,8 +129,8 @@ bool WiFiUDP::write(uint8_t *_packet, uint16_t _len)
                                         20000ULL, NULL, &_availableData))
         return false;
 
-    // Set the current positon pointer at the start of the RX buffer.
-    _currentPosition = _dataBuffer;
+    // Get the UDP data from the response (also sets the current position pointer).
+    _availableData = parsePackets(_availableData);
 
     // If you got here and you got some data, everything went ok, return ture.
     return _availableData != 0 ? true : false;
@@ -158,8 +163,7 @@ uint16_t WiFiUDP::available(bool _blocking)
         // Try to get new data. If new data is available, update the size and current pointer for the data.
         if (WiFi.getSimpleAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, _timeoutValue, &_len))
         {
-            _availableData += _len;
-            _currentPosition = _dataBuffer;
+            _availableData += parsePackets(_len);
         }
     }
 
@@ -201,6 +205,115 @@ int WiFiUDP::read(uint8_t *_data, uint16_t _len)
     return _len;
 }
 
+/**
+ * @brief   Get one received packet. Unlike available() and read(), packet boundaries are kept, so this is used
+ *          when each packet has its own header. Data of one SPI read can have many packets, rest of them is kept
+ *          for the next call.
+ *
+ * @param   uint8_t *_packet
+ *          Pointer to buffer where to store the packet. Packet can be split between the SPI reads, so the same
+ *          buffer must be used until the packet is received.
+ * @param   uint16_t _maxLen
+ *          Size of the buffer. Larger packets are dropped.
+ * @param   bool _blocking
+ *          true - use blocking (wait for new packets).
+ *          false - Do not wait for new packets, just check.
+ * @return  uint16_t
+ *          Length of the received packet or 0 if there is no new packet.
+ *
+ * @note    Do not mix it with the available() and read(), they are using the same parser.
+ */
+uint16_t WiFiUDP::readPacket(uint8_t *_packet, uint16_t _maxLen, bool _blocking)
+{
+    AtUrcEvent _event;
+
+    // Only get new data if everything from the last read is parsed.
+    if (_packetLeft == 0)
+    {
+        uint16_t _len = 0;
+        if (!WiFi.getSimpleAtResponse(_dataBuffer, INKPLATE_ESP32_AT_CMD_BUFFER_SIZE, _blocking ? 2500ULL : 1ULL,
+                                      &_len))
+            return 0;
+
+        _packetData = _dataBuffer;
+        _packetLeft = _len;
+    }
+
+    while (_packetLeft != 0)
+    {
+        uint32_t _used = _parser.parse((const uint8_t *)_packetData, _packetLeft, &_event);
+        _packetData += _used;
+        _packetLeft -= _used;
+
+        // Only the +IPD frames are used.
+        if (_event.type != INKPLATE_ESP32_URC_TYPE_IPD)
+            continue;
+
+        // New packet. Check if it fits into the buffer.
+        if (_event.event == INKPLATE_ESP32_URC_EVENT_FRAME)
+        {
+            _packetLen = 0;
+            _packetDrop = (_event.frameLen > _maxLen);
+            continue;
+        }
+
+        if (_event.event != INKPLATE_ESP32_URC_EVENT_PAYLOAD)
+            continue;
+
+        // Copy the part of the packet.
+        if (!_packetDrop && ((_packetLen + _event.len) <= _maxLen))
+        {
+            memcpy(_packet + _packetLen, _event.data, _event.len);
+            _packetLen += _event.len;
+        }
+        else
+        {
+            _packetDrop = true;
+        }
+
+        // Whole packet is received?
+        if (_event.last)
+        {
+            uint16_t _len = _packetDrop ? 0 : _packetLen;
+            _packetLen = 0;
+            _packetDrop = false;
+
+            if (_len != 0)
+                return _len;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Send the packet to the current remote (with UDP mode 2 it's the sender of the last received packet).
+ *          Method does not wait for the response, "SEND OK" is skipped by the next read.
+ *
+ * @param   const uint8_t *_packet
+ *          Pointer to the packet.
+ * @param   uint16_t _len
+ *          Length of the packet in bytes.
+ * @return  bool
+ *          true - Packet is sent to the ESP32.
+ *          false - ESP32 did not accept the packet.
+ *
+ * @note    Data in the data buffer (also packets not read by readPacket()) is lost.
+ */
+bool WiFiUDP::send(const uint8_t *_packet, uint16_t _len)
+{
+    // Everything left in the data buffer will be overwritten, also the response can have the part of the packet.
+    // Start parsing from the new line.
+    _packetLeft = 0;
+    _packetLen = 0;
+    _parser.begin();
+
+    // Send the UDP packet, but do not wait for the "SEND OK".
+    sprintf(_dataBuffer, "AT+CIPSEND=%d\r\n", _len);
+    return WiFi.sendAtCommandWithResponse(_dataBuffer, 200ULL, 4ULL, "\r\nOK\r\n\r\n>",
+                                          INKPLATE_ESP32_AT_EXPECTED_RESPONSE_START, true, (char *)_packet, _len, 0);
+}
+
 /**
  * @brief   End UDP connection. Also remove all filters for data transfer.
  *
@@ -212,11 +325,11 @@ bool WiFiUDP::end()
 {
     _availableData = 0;
     _currentPosition = NULL;
+    _packetLeft = 0;
 
-    // Re-enable filters
-    WiFi.messageFilter(true, "^Recv [0-9]* bytes", "\r\n$");
-    WiFi.messageFilter(true, NULL, "\r\nSEND OK\r\n");
-    WiFi.messageFilter(true, "^+IPD,[0-9]*:", "\r\n$");
+    // Remove filters.
+    WiFi.messageFilter(false, "^Recv [0-9]* bytes", "\r\n$");
+    WiFi.messageFilter(false, NULL, "\r\nSEND OK\r\n");
 
     // Disconnect from the server.
     if (!WiFi.sendAtCommandWithResponse("AT+CIPCLOSE\r\n", 2000ULL, 4ULL, (char *)("CLOSED"),
@@ -240,4 +353,47 @@ bool WiFiUDP::end()
 void WiFiUDP::setConnectionTimeout(uint16_t _connectionTimeout)
 {
     _connectionTimeoutValue = _connectionTimeout;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief   Gets the UDP data from the received +IPD frames. Data of the first frame is used where it's
+ *          received, data of the next frames is moved right after it (so one packet is never copied).
+ *
+ * @param   uint16_t _len
+ *          Number of received bytes in the data buffer.
+ * @return  uint16_t
+ *          Number of UDP data bytes. Current position pointer is set at the start of the data.
+ */
+uint16_t WiFiUDP::parsePackets(uint16_t _len)
+{
+    AtUrcEvent _event;
+    const uint8_t *_data = (const uint8_t *)_dataBuffer;
+    char *_start = NULL;
+    uint16_t _dataLen = 0;
+
+    while (_len != 0)
+    {
+        uint32_t _used = _parser.parse(_data, _len, &_event);
+        _data += _used;
+        _len -= _used;
+
+        // Only the data of the +IPD frames is used.
+        if ((_event.event != INKPLATE_ESP32_URC_EVENT_PAYLOAD) || (_event.type != INKPLATE_ESP32_URC_TYPE_IPD))
+            continue;
+
+        if (_start == NULL)
+        {
+            _start = (char *)_event.data;
+        }
+        else if ((_start + _dataLen) != (const char *)_event.data)
+        {
+            memmove(_start + _dataLen, _event.data, _event.len);
+        }
+        _dataLen += _event.len;
+    }
+
+    // Set the current position pointer at the start of the UDP data.
+    _currentPosition = (_start != NULL) ? _start : _dataBuffer;
+
+    return _dataLen;
+}
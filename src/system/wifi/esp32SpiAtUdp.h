@@ -45,6 +45,12 @@ class WiFiUDP
     // read bytes from the RX buffer.
     int read(uint8_t *_data, uint16_t _len);
 
+    // Get one received packet (packet boundaries are kept, unlike with available() and read()).
+    uint16_t readPacket(uint8_t *_packet, uint16_t _maxLen, bool _blocking = false);
+
+    // Send the packet to the current remote without waiting for the response.
+    bool send(const uint8_t *_packet, uint16_t _len);
+
     // End UDP connection. Also remove all filters for data transfer.
     bool end();
 
@@ -52,6 +58,19 @@ class WiFiUDP
     void setConnectionTimeout(uint16_t _connectionTimeout);
 
   private:
+    // Gets the UDP data from the received +IPD frames.
+    uint16_t parsePackets(uint16_t _len);
+
+    // Parser for the +IPD frames (packet can be split between the reads).
+    AtUrcParser _parser;
+
+    // Received data not parsed yet by the readPacket(), length of the packet received so far and flag if the packet
+    // does not fit into the buffer (it will be dropped).
+    char *_packetData = NULL;
+    uint16_t _packetLeft = 0;
+    uint16_t _packetLen = 0;
+    bool _packetDrop = false;
+
     uint16_t _localUdpPort = 0;
     uint16_t _availableData = 0;
     char *_currentPosition = 0;